@@ -15,6 +15,8 @@
 #include "RaylibWrapper.h"
 #include "RenderableTexture.h"
 #include "ShadowManager.h"
+#include "RenderCulling.h"
+#include "RenderQueue.h"
 #include "Material.h"
 #include "MenuManager.h"
 #ifdef WINDOWS
@@ -34,11 +36,15 @@
 #include <vector>
 
 #include "CollisionListener2D.h"
+#include "CollisionLayers.h"
+#include "PhysicsSnapshot.h"
+#include "Components/Rigidbody2D.h"
 #include "Physics2DDebugDraw.h"
 
 #ifdef IS3D
 #define JPH_DEBUG_RENDERER
 #include <thread>
+#include <algorithm>
 #include "Jolt/Jolt.h"
 #include "Jolt/Core/Factory.h"
 #include "Jolt/Core/TempAllocator.h"
@@ -46,13 +52,15 @@
 #include "Jolt/Renderer/DebugRenderer.h"
 #include "Jolt/Physics/Body/BodyManager.h"
 #include "Components/Rigidbody3D.h"
+#include "Components/Collider3D.h"
 #include "Physics3DDebugDraw.h"
 #include "CollisionListener3D.h"
+#include "PhysicsMemory.h"
 JPH_SUPPRESS_WARNINGS
 
 JPH::PhysicsSystem physicsSystem;
 CollisionListener3D collisionListener3D;
-JPH::TempAllocatorMalloc* tempAllocator;
+JPH::TempAllocator* tempAllocator;
 Physics3DDebugDraw* debugRenderer;
 JPH::JobSystemThreadPool jobSystem;
 JPH::BodyManager::DrawSettings bodyDrawSettings;
@@ -75,6 +83,17 @@ float timeStep = 1.0f / 60.0f;
 int32 velocityIterations = 8; // For 2D physics
 int32 positionIterations = 3; // For 2D physics
 int physicsIterations = 5; // For 3D physics
+bool mergeStaticColliders = false; // For 3D physics
+float staticMergeRegionSize = 64.0f; // For 3D physics
+int physicsTempMemory = 16; // For 3D physics. Megabytes preallocated for each step's temporary data
+int physicsMaxBodies = 65536; // For 3D physics
+int physicsMaxBodyPairs = 65536; // For 3D physics
+int physicsMaxContactConstraints = 20480; // For 3D physics
+int physicsMaxJobs = 2048; // For 3D physics
+int physicsMaxBarriers = 16; // For 3D physics
+int physicsThreads = 0; // For 3D physics. 0 uses one per core
+std::vector<std::string> collisionLayerNames = { "Default" };
+std::vector<uint32_t> collisionLayerMasks = { 0xFFFFFFFF }; // Bit n is set if the layer collides with layer n
 float timeSinceLastUpdate = 0.0f;
 
 #ifdef IS3D
@@ -84,29 +103,25 @@ class ObjectLayerPairFilterImpl : public JPH::ObjectLayerPairFilter
 public:
 	virtual bool					ShouldCollide(JPH::ObjectLayer inObject1, JPH::ObjectLayer inObject2) const override
 	{
-		switch (inObject1)
-		{
-		case Layers::NON_MOVING:
-			return inObject2 == Layers::MOVING; // Non moving only collides with moving
-		case Layers::MOVING:
-			return true; // Moving collides with everything
-		default:
-			JPH_ASSERT(false);
+		// Static bodies and static triggers are never tested against each other
+		if (Layers::GetMotion(inObject1) != Layers::MOVING && Layers::GetMotion(inObject2) != Layers::MOVING)
 			return false;
-		}
+
+		return CollisionLayers::Collides(Layers::GetCollisionLayer(inObject1), Layers::GetCollisionLayer(inObject2));
 	}
 };
 
 // Each broadphase layer results in a separate bounding volume tree in the broad phase. You at least want to have
 // a layer for non-moving and moving objects to avoid having to update a tree full of static objects every frame.
-// You can have a 1-on-1 mapping between object layers and broadphase layers (like in this case) but if you have
-// many object layers you'll be creating many broad phase trees, which is not efficient. If you want to fine tune
-// your broadphase layers define JPH_TRACK_BROADPHASE_STATS and look at the stats reported on the TTY.
+// Object layers are mapped by how they move, not by their collision layer, since many broad phase trees aren't efficient.
+// Static triggers get their own tree so moving bodies only pay for them when they overlap one.
+// If you want to fine tune your broadphase layers define JPH_TRACK_BROADPHASE_STATS and look at the stats reported on the TTY.
 namespace BroadPhaseLayers
 {
 	static constexpr JPH::BroadPhaseLayer NON_MOVING(0);
 	static constexpr JPH::BroadPhaseLayer MOVING(1);
-	static constexpr unsigned int NUM_LAYERS(2);
+	static constexpr JPH::BroadPhaseLayer SENSOR(2);
+	static constexpr unsigned int NUM_LAYERS(3);
 };
 
 // BroadPhaseLayerInterface implementation
@@ -117,8 +132,9 @@ public:
 	BPLayerInterfaceImpl()
 	{
 		// Create a mapping table from object to broad phase layer
-		mObjectToBroadPhase[Layers::NON_MOVING] = BroadPhaseLayers::NON_MOVING;
-		mObjectToBroadPhase[Layers::MOVING] = BroadPhaseLayers::MOVING;
+		mMotionToBroadPhase[Layers::NON_MOVING] = BroadPhaseLayers::NON_MOVING;
+		mMotionToBroadPhase[Layers::MOVING] = BroadPhaseLayers::MOVING;
+		mMotionToBroadPhase[Layers::SENSOR] = BroadPhaseLayers::SENSOR;
 	}
 
 	virtual unsigned int					GetNumBroadPhaseLayers() const override
@@ -128,8 +144,8 @@ public:
 
 	virtual JPH::BroadPhaseLayer			GetBroadPhaseLayer(JPH::ObjectLayer inLayer) const override
 	{
-		JPH_ASSERT(inLayer < Layers::NUM_LAYERS);
-		return mObjectToBroadPhase[inLayer];
+		JPH_ASSERT(inLayer < Layers::NUM_LAYERS && Layers::GetMotion(inLayer) <= Layers::SENSOR);
+		return mMotionToBroadPhase[Layers::GetMotion(inLayer)];
 	}
 
 #if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
@@ -139,13 +155,14 @@ public:
 		{
 		case (JPH::BroadPhaseLayer::Type)BroadPhaseLayers::NON_MOVING:	return "NON_MOVING";
 		case (JPH::BroadPhaseLayer::Type)BroadPhaseLayers::MOVING:		return "MOVING";
+		case (JPH::BroadPhaseLayer::Type)BroadPhaseLayers::SENSOR:		return "SENSOR";
 		default:													JPH_ASSERT(false); return "INVALID";
 		}
 	}
 #endif // JPH_EXTERNAL_PROFILE || JPH_PROFILE_ENABLED
 
 private:
-	JPH::BroadPhaseLayer					mObjectToBroadPhase[Layers::NUM_LAYERS];
+	JPH::BroadPhaseLayer					mMotionToBroadPhase[Layers::SENSOR + 1];
 };
 
 /// Class that determines if an object layer can collide with a broadphase layer
@@ -154,9 +171,10 @@ class ObjectVsBroadPhaseLayerFilterImpl : public JPH::ObjectVsBroadPhaseLayerFil
 public:
 	virtual bool				ShouldCollide(JPH::ObjectLayer inLayer1, JPH::BroadPhaseLayer inLayer2) const override
 	{
-		switch (inLayer1)
+		switch (Layers::GetMotion(inLayer1))
 		{
 		case Layers::NON_MOVING:
+		case Layers::SENSOR:
 			return inLayer2 == BroadPhaseLayers::MOVING;
 		case Layers::MOVING:
 			return true;
@@ -169,6 +187,7 @@ public:
 #endif
 
 void MainLoop();
+void StepPhysics();
 
 int main(int argc, char* argv[])
 {
@@ -218,9 +237,12 @@ int main(int argc, char* argv[])
 	RaylibWrapper::ImGui_ImplRaylib_Init();
 
 	// Setup playmode
+	bool checkPhysicsDeterminism = false;
 	if (argc > 1) {
 		for (int i = 1; i < argc; ++i) {
-			if (std::strcmp(argv[i], "playmode") == 0)
+			if (std::strcmp(argv[i], "checkphysicsdeterminism") == 0)
+				checkPhysicsDeterminism = true;
+			else if (std::strcmp(argv[i], "playmode") == 0)
 			{
 				isPlayMode = true;
 				playModeRenderTexture = RaylibWrapper::LoadRenderTexture(RaylibWrapper::GetScreenWidth(), RaylibWrapper::GetScreenHeight());
@@ -237,41 +259,46 @@ int main(int argc, char* argv[])
 	FontManager::InitFontManager();
 
 	// Physics setup. Must go before scene loading
+	CollisionLayers::SetLayers(collisionLayerNames, collisionLayerMasks);
+
 #ifdef IS3D
 	JPH::RegisterDefaultAllocator();
 	JPH::Factory::sInstance = new JPH::Factory();
 	JPH::RegisterTypes();
 
-	const unsigned int cMaxBodies = 65536;
+	const unsigned int cMaxBodies = std::max(1, physicsMaxBodies);
 	const unsigned int cNumBodyMutexes = 0;
-	const unsigned int cMaxBodyPairs = 65536;
-	const unsigned int cMaxContactConstraints = 20480;
+	const unsigned int cMaxBodyPairs = std::max(1, physicsMaxBodyPairs);
+	const unsigned int cMaxContactConstraints = std::max(1, physicsMaxContactConstraints);
 
 	BPLayerInterfaceImpl broadPhaseLayerInterface;
 	ObjectVsBroadPhaseLayerFilterImpl objectVsBroadphaseLayerFilter;
 	ObjectLayerPairFilterImpl objectVsObjectLayerFilter;
 
 	physicsSystem.Init(cMaxBodies, cNumBodyMutexes, cMaxBodyPairs, cMaxContactConstraints, broadPhaseLayerInterface, objectVsBroadphaseLayerFilter, objectVsObjectLayerFilter);
+	PhysicsMemory::SetCapacities(cMaxBodyPairs, cMaxContactConstraints);
 
-	//MyBodyActivationListener bodyActivationListener;
-	//physicsSystem.SetBodyActivationListener(&body_activationListener);
+	physicsSystem.SetBodyActivationListener(&Rigidbody3D::activationListener);
 
 	physicsSystem.SetContactListener(&collisionListener3D);
 
 	JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
+	Rigidbody3D::physicsSystem = &physicsSystem;
 	Rigidbody3D::bodyInterface = &physicsSystem.GetBodyInterface();
 
 	Rigidbody3D::bodyLockInterface = &physicsSystem.GetBodyLockInterface();
 
+	Collider3D::mergeStaticColliders = mergeStaticColliders;
+	Collider3D::mergeRegionSize = staticMergeRegionSize;
+
 	debugRenderer = new Physics3DDebugDraw();
 	//JPH::DebugRenderer::sInstance = debugRenderer;
 	bodyDrawSettings.mDrawGetSupportFunction = true;
 	bodyDrawSettings.mDrawShape = true;
 	bodyDrawSettings.mDrawShapeWireframe = true;
 	bodyDrawSettings.mDrawBoundingBox = true;
-	jobSystem.Init(2048, 16, std::thread::hardware_concurrency());
-	//JPH::TempAllocatorImpl tempAllocator(100 * 1024 * 1024);
-	tempAllocator = new JPH::TempAllocatorMalloc();
+	jobSystem.Init(std::max(1, physicsMaxJobs), std::max(1, physicsMaxBarriers), physicsThreads > 0 ? physicsThreads : static_cast<int>(std::thread::hardware_concurrency()));
+	tempAllocator = PhysicsMemory::CreateTempAllocator(static_cast<size_t>(std::max(1, physicsTempMemory)) * 1024 * 1024);
 #endif
 
 	b2Vec2 gravity(0.0f, -9.8f);
@@ -296,6 +323,10 @@ int main(int argc, char* argv[])
 		SceneManager::LoadScene(exeParent / "Resources" / "Assets" / "Scenes" / "Default.scene");
 	SceneManager::SetActiveScene(&SceneManager::GetScenes()->back());
 
+	// Re-simulates the start of the default scene from a snapshot and reports if it ended bit-identical
+	if (checkPhysicsDeterminism)
+		PhysicsSnapshot::CheckDeterminism(300, StepPhysics);
+
 #ifdef WEB
 	emscripten_set_main_loop(MainLoop, 60, 1);
 #else
@@ -338,17 +369,29 @@ int main(int argc, char* argv[])
 	return 0;
 }
 
+void StepPhysics()
+{
+#ifdef IS3D
+	Rigidbody3D::SyncMovedTransforms();
+	Collider3D::UpdateStaticBatches();
+	JPH::EPhysicsUpdateError physicsErrors = physicsSystem.Update(timeStep, physicsIterations, tempAllocator, &jobSystem);
+	PhysicsMemory::RecordStep(physicsSystem, physicsErrors);
+	Rigidbody3D::SyncActiveBodies();
+	collisionListener3D.DispatchContacts();
+#else
+	Rigidbody2D::SyncMovedTransforms();
+	world->Step(timeStep, velocityIterations, positionIterations);
+	Rigidbody2D::SyncAwakeBodies();
+	collisionListener.ContinueContact(); // Todo: Should this go after the loop?
+#endif
+}
+
 void MainLoop()
 {
 	timeSinceLastUpdate += RaylibWrapper::GetFrameTime();
 	while (timeSinceLastUpdate >= timeStep)
 	{
-#ifdef IS3D
-		physicsSystem.Update(timeStep, physicsIterations, tempAllocator, &jobSystem);
-#else
-		world->Step(timeStep, velocityIterations, positionIterations);
-		collisionListener.ContinueContact(); // Todo: Should this go after the loop?
-#endif
+		StepPhysics();
 		timeSinceLastUpdate -= timeStep;
 
 		fixedDeltaTime = timeStep;
@@ -437,6 +480,7 @@ void MainLoop()
 #endif
 
 	CameraComponent::main->raylibCamera.BeginMode3D();
+	RenderCulling::BeginPass();
 
 	// Shadows
 	//RaylibWrapper::rlEnableShader(shadowManager.shader.id);
@@ -485,6 +529,10 @@ void MainLoop()
 #endif
 		}
 	}
+#ifdef IS3D
+	// Must be drawn before deleting anything since the draws reference their MeshRenderers
+	RenderQueue::Flush();
+#endif
 	GameObject::markForDeletion = false;
 
 	for (GameObject* gameObject : GameObject::markedForDeletion)
@@ -39,6 +39,8 @@
 #include "Utilities/IconManager.h"
 #include "Systems/Rendering/ShaderManager.h"
 #include "Systems/Rendering/ShadowManager.h"
+#include "Systems/Rendering/RenderCulling.h"
+#include "Systems/Rendering/RenderQueue.h"
 #include "ProjectManager.h"
 #include "Raylib/RaylibModelWrapper.h"
 #include "Raylib/RaylibDrawWrapper.h"
@@ -931,6 +933,7 @@ void Editor::UpdateViewport()
     //RaylibWrapper::SetShaderValueTexture(shadowManager.shader, RaylibWrapper::GetShaderLocation(shadowManager.shader, "texture_shadowmap"), shadowManager.shadowMapTexture.depth); // Todo: should the last be depth or texture
 
     RaylibWrapper::BeginMode3D(camera);
+    RenderCulling::BeginPass();
 
     // Handle 3D movement arrows
     if (selectedObject != nullptr && ProjectManager::projectData.is3D)
@@ -1145,6 +1148,7 @@ void Editor::UpdateViewport()
             component->Render();
         }
     }
+    RenderQueue::Flush();
 
     for (RenderableTexture* texture : RenderableTexture::textures) // Renders Sprites and Tilemaps
         if (texture)
@@ -1177,6 +1181,8 @@ void Editor::UpdateViewport()
 
             if (RaylibWrapper::IsMouseButtonDown(RaylibWrapper::MOUSE_LEFT_BUTTON))
             {
+                selectedTerrain->gameObject->dirty = true;
+
                 switch (currentTerrainTool)
                 {
 				case TerrainTool::Raise:
@@ -1507,7 +1513,7 @@ void Editor::RenderContentBrowser() // Todo: Handle if path is in a now deleted
                         if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left) && SceneManager::GetActiveScene()->GetPath() != entry.path())
                         {
                             objectInProperties = std::monostate{};
-                            SceneManager::SaveScene(SceneManager::GetActiveScene());
+                            SceneManager::SaveSceneIncremental(SceneManager::GetActiveScene());
                             SceneManager::LoadScene(entry.path());
                         }
                     }}}
@@ -3522,6 +3528,14 @@ void Editor::RenderProjectSettings()
                 ProjectManager::SaveProjectData(ProjectManager::projectData);
         };
 
+        auto RenderInputFloat = [](const char* label, float& value, float width = 50.0f) {
+            ImGui::Text("%s", label);
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(width);
+            if (ImGui::InputFloat(("##" + std::string(label)).c_str(), &value, 0.0f, 0.0f, "%.05g"))
+                ProjectManager::SaveProjectData(ProjectManager::projectData);
+        };
+
         auto RenderInputFloat2 = [](const char* label, Vector2& value, float width = 70.0f) {
             ImGui::Text("%s", label);
             ImGui::SameLine();
@@ -3570,6 +3584,100 @@ void Editor::RenderProjectSettings()
             RenderInputFloat2("Timestep", ProjectManager::projectData.physicsTimeStep);
             RenderInputInt("Velocity Iterations", ProjectManager::projectData.velocityIterations);
             RenderInputInt("Position Iterations", ProjectManager::projectData.positionIterations);
+            if (ProjectManager::projectData.is3D)
+            {
+                RenderCheckBox("Merge Static Colliders", ProjectManager::projectData.mergeStaticColliders);
+                if (ProjectManager::projectData.mergeStaticColliders)
+                    RenderInputFloat("Merge Region Size", ProjectManager::projectData.staticMergeRegionSize);
+
+                // Capacities Jolt preallocates. The game warns in the console when one is too small.
+                RenderInputInt("Temp Memory (MB)", ProjectManager::projectData.physicsTempMemory, 50.0f);
+                ProjectManager::projectData.physicsTempMemory = std::clamp(ProjectManager::projectData.physicsTempMemory, 1, 4095); // Jolt's temp arena size is 32 bits
+                RenderInputInt("Max Bodies", ProjectManager::projectData.physicsMaxBodies, 70.0f);
+                RenderInputInt("Max Body Pairs", ProjectManager::projectData.physicsMaxBodyPairs, 70.0f);
+                RenderInputInt("Max Contacts", ProjectManager::projectData.physicsMaxContactConstraints, 70.0f);
+                RenderInputInt("Max Jobs", ProjectManager::projectData.physicsMaxJobs, 70.0f);
+                RenderInputInt("Max Job Barriers", ProjectManager::projectData.physicsMaxBarriers, 50.0f);
+                RenderInputInt("Physics Threads", ProjectManager::projectData.physicsThreads, 50.0f);
+            }
+
+            // Box2D only has 16 filter category bits
+            std::vector<std::string>& layerNames = ProjectManager::projectData.collisionLayerNames;
+            std::vector<uint32_t>& layerMasks = ProjectManager::projectData.collisionLayerMasks;
+            int maxLayers = ProjectManager::projectData.is3D ? 32 : 16;
+
+            ImGui::Text("Collision Layers");
+            for (int i = 0; i < static_cast<int>(layerNames.size()); i++)
+            {
+                ImGui::PushID(i);
+                ImGui::Text("%2d", i);
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(150);
+                char buffer[64];
+                strcpy_s(buffer, layerNames[i].c_str());
+                // Default can't be renamed or removed since it's what components use when their layer is missing
+                if (ImGui::InputText("##LayerName", buffer, sizeof(buffer), i == 0 ? ImGuiInputTextFlags_ReadOnly : 0))
+                {
+                    layerNames[i] = buffer;
+                    ProjectManager::SaveProjectData(ProjectManager::projectData);
+                }
+                if (i > 0)
+                {
+                    ImGui::SameLine();
+                    if (ImGui::Button("Remove"))
+                    {
+                        // Layers above it move down one, and so do their bits
+                        uint32_t lowerBits = (1u << i) - 1;
+                        layerNames.erase(layerNames.begin() + i);
+                        layerMasks.erase(layerMasks.begin() + i);
+                        for (uint32_t& mask : layerMasks)
+                            mask = (mask & lowerBits) | ((mask >> 1) & ~lowerBits) | 0x80000000;
+                        ProjectManager::SaveProjectData(ProjectManager::projectData);
+                        ImGui::PopID();
+                        break;
+                    }
+                }
+                ImGui::PopID();
+            }
+            if (static_cast<int>(layerNames.size()) < maxLayers && ImGui::Button("Add Layer"))
+            {
+                // New layers collide with everything
+                layerNames.push_back("Layer " + std::to_string(layerNames.size()));
+                layerMasks.push_back(0xFFFFFFFF);
+                for (uint32_t& mask : layerMasks)
+                    mask |= 1u << (layerNames.size() - 1);
+                ProjectManager::SaveProjectData(ProjectManager::projectData);
+            }
+
+            // Each pair has one checkbox, which sets both layers' bits so the matrix stays symmetric
+            ImGui::Text("Collision Matrix");
+            int layerCount = std::min(static_cast<int>(layerNames.size()), maxLayers);
+            for (int i = 0; i < layerCount; i++)
+            {
+                ImGui::PushID(i);
+                ImGui::Text("%s", layerNames[i].c_str());
+                for (int j = 0; j < layerCount - i; j++)
+                {
+                    int other = layerCount - 1 - j;
+                    bool collides = (layerMasks[i] >> other) & 1;
+                    ImGui::SameLine(160.0f + j * 24.0f);
+                    ImGui::PushID(other);
+                    if (ImGui::Checkbox("##Collides", &collides))
+                    {
+                        layerMasks[i] = collides ? layerMasks[i] | (1u << other) : layerMasks[i] & ~(1u << other);
+                        layerMasks[other] = collides ? layerMasks[other] | (1u << i) : layerMasks[other] & ~(1u << i);
+                        ProjectManager::SaveProjectData(ProjectManager::projectData);
+                    }
+                    if (ImGui::IsItemHovered())
+                        ImGui::SetTooltip("%s / %s", layerNames[i].c_str(), layerNames[other].c_str());
+                    ImGui::PopID();
+                }
+                ImGui::PopID();
+            }
+            });
+
+        RenderSection("Editor", [&]() {
+            RenderInputInt("Autosave Interval (Seconds)", ProjectManager::projectData.autosaveInterval, 40.0f);
             });
     }
     ImGui::End();
@@ -4368,6 +4476,14 @@ void Editor::RenderTerrainToolsWin()
 							ImGui::Text("Random Position Offset");
 							ImGui::SliderFloat("##RandomOffset", &rule->randomOffset, 0.0f, 5.0f, "%.2f");
 
+							// Seed
+							ImGui::Text("Seed");
+							int seed = static_cast<int>(rule->seed);
+							if (ImGui::InputInt("##Seed", &seed))
+								rule->seed = static_cast<unsigned int>(seed);
+							if (ImGui::IsItemHovered())
+								ImGui::SetTooltip("Generating with the same seed places the same meshes");
+
 							ImGui::Spacing();
 							ImGui::Separator();
 							ImGui::Spacing();
@@ -4560,6 +4676,10 @@ void Editor::RenderTerrainToolsWin()
 
 				ImGui::Unindent(10.0f);
 			}
+
+			// Layer and mesh changes are stored in the terrain's data, so the terrain needs to be written by the next save
+			if (ImGui::IsWindowFocused(ImGuiFocusedFlags_ChildWindows) && ImGui::IsAnyItemActive())
+				selectedTerrain->gameObject->dirty = true;
 		}
 		else
 		{
@@ -4620,6 +4740,7 @@ void Editor::RenderCameraView()
     RaylibWrapper::ClearBackground(ProjectManager::projectData.is3D ? RaylibWrapper::Color{ 135, 206, 235, 255 } : RaylibWrapper::Color{128, 128, 128, 255});
 
     camera->raylibCamera.BeginMode3D();
+    RenderCulling::BeginPass();
 
     deltaTime = RaylibWrapper::GetFrameTime();
 
@@ -4629,7 +4750,7 @@ void Editor::RenderCameraView()
     for (GameObject* gameObject : SceneManager::GetActiveScene()->GetGameObjects()) // Todo: This is different from the main editor camera. Check if this needs to be updated.
     {
         if (!gameObject->IsActive() || !gameObject->IsGlobalActive())
-            return;
+            continue;
 
         for (Component* component : gameObject->GetComponents())
         {
@@ -4640,6 +4761,7 @@ void Editor::RenderCameraView()
             }
         }
     }
+    RenderQueue::Flush();
 
     for (RenderableTexture* texture : RenderableTexture::textures) // Renders Sprites and Tilemaps
         if (texture)
@@ -5257,6 +5379,10 @@ void Editor::RenderProperties()
                 }
                 dragData.second["HoveringValidElement"] = true; // This lets the code in the Content Browser know its hovering something it can be placed in, so it can change the cursor icon
             }
+
+            // Edits made in the properties window aren't tracked individually, so any interaction marks the game object to be written by the next save
+            if ((ImGui::IsWindowFocused(ImGuiFocusedFlags_ChildWindows) && ImGui::IsAnyItemActive()) || (ImGui::IsWindowHovered(ImGuiHoveredFlags_ChildWindows) && ImGui::IsMouseReleased(ImGuiMouseButton_Left)))
+                (*propertiesGameObject)->dirty = true;
         }
         // Data File
         else if (std::holds_alternative<DataFile>(objectInProperties))
@@ -5978,6 +6104,15 @@ void Editor::ExitPlayMode()
     asyncPBODisplay.Disconnect();
 }
 
+// Shown once the save has been written, since incremental saves are written on a background thread
+static void ShowProjectSavedToast(bool saved)
+{
+    ImGuiToast toast(saved ? ImGuiToastType::Success : ImGuiToastType::Error, saved ? 1500 : 2500, true);
+    toast.setTitle(saved ? "Project Saved" : "Save failed", "");
+    toast.setContent(saved ? "The project has successfully saved." : "The project failed to save. Check the console for details.");
+    ImGui::InsertNotification(toast);
+}
+
 void Editor::Render()
 {
     // Todo: Put this in RenderDockSpace()
@@ -6085,11 +6220,7 @@ void Editor::Render()
         if (ImGui::BeginMenu("File", !ImGuiPopup::IsActive())) {
             if (ImGui::MenuItem("Save Project", "Ctrl+S"))
             {
-                SceneManager::SaveScene(SceneManager::GetActiveScene());
-                ImGuiToast toast(ImGuiToastType::Success, 1500, true);
-                toast.setTitle("Project Saved", "");
-                toast.setContent("The project has successfully saved.");
-                ImGui::InsertNotification(toast);
+                SceneManager::SaveSceneIncremental(SceneManager::GetActiveScene(), ShowProjectSavedToast);
             }
 
             if (playModeActive)
@@ -6223,11 +6354,15 @@ void Editor::Render()
     {
         if (ImGui::IsKeyPressed(ImGuiKey_S) && ImGui::IsKeyDown(ImGuiKey_LeftCtrl))
         {
-            SceneManager::SaveScene(SceneManager::GetActiveScene());
-            ImGuiToast toast(ImGuiToastType::Success, 1500, true);
-            toast.setTitle("Project Saved", "");
-            toast.setContent("The project has successfully saved.");
-            ImGui::InsertNotification(toast);
+            SceneManager::SaveSceneIncremental(SceneManager::GetActiveScene(), ShowProjectSavedToast);
+        }
+
+        // Autosave. Only changed game objects are written, and the writing happens on a background thread.
+        static double lastAutosaveTime = RaylibWrapper::GetTime();
+        if (ProjectManager::projectData.autosaveInterval > 0 && RaylibWrapper::GetTime() - lastAutosaveTime >= ProjectManager::projectData.autosaveInterval)
+        {
+            SceneManager::SaveSceneIncremental(SceneManager::GetActiveScene());
+            lastAutosaveTime = RaylibWrapper::GetTime();
         }
     }
 
@@ -6267,6 +6402,7 @@ void Editor::Render()
 
 
     // Notifications
+    SceneManager::ReportFinishedSaves();
     ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, 10);
     ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 0.f);
     ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0.10f, 0.10f, 0.10f, 1.00f));
@@ -6487,6 +6623,7 @@ void Editor::CleanupCache()
 
 void Editor::Cleanup()
 {
+    SceneManager::WaitForPendingSaves();
     IconManager::Cleanup();
     ShaderManager::Cleanup();
     AssetManager::Cleanup();
@@ -6615,6 +6752,7 @@ void Editor::Init()
     while (!closeEditor)
     {
         MainThreadQueue::Process();
+        AssetManager::CookQueuedModels();
 
         oneSecondDelay -= RaylibWrapper::GetFrameTime();
         FontManager::UpdateFonts();
@@ -319,6 +319,38 @@ bool ProjectManager::SetGameSettings(std::filesystem::path gameFile)
             outputFile << "int32 velocityIterations = " + std::to_string(projectData.velocityIterations) + ";";
         else if (line.find("int32 positionIterations = 3;") != std::string::npos)
             outputFile << "int32 positionIterations = " + std::to_string(projectData.positionIterations) + ";";
+        else if (line.find("bool mergeStaticColliders = false;") != std::string::npos)
+            outputFile << "bool mergeStaticColliders = " + std::string(projectData.mergeStaticColliders ? "true" : "false") + ";";
+        else if (line.find("float staticMergeRegionSize = 64.0f;") != std::string::npos)
+            outputFile << "float staticMergeRegionSize = " + std::to_string(projectData.staticMergeRegionSize) + "f;";
+        else if (line.find("int physicsTempMemory = 16;") != std::string::npos)
+            outputFile << "int physicsTempMemory = " + std::to_string(projectData.physicsTempMemory) + ";";
+        else if (line.find("int physicsMaxBodies = 65536;") != std::string::npos)
+            outputFile << "int physicsMaxBodies = " + std::to_string(projectData.physicsMaxBodies) + ";";
+        else if (line.find("int physicsMaxBodyPairs = 65536;") != std::string::npos)
+            outputFile << "int physicsMaxBodyPairs = " + std::to_string(projectData.physicsMaxBodyPairs) + ";";
+        else if (line.find("int physicsMaxContactConstraints = 20480;") != std::string::npos)
+            outputFile << "int physicsMaxContactConstraints = " + std::to_string(projectData.physicsMaxContactConstraints) + ";";
+        else if (line.find("int physicsMaxJobs = 2048;") != std::string::npos)
+            outputFile << "int physicsMaxJobs = " + std::to_string(projectData.physicsMaxJobs) + ";";
+        else if (line.find("int physicsMaxBarriers = 16;") != std::string::npos)
+            outputFile << "int physicsMaxBarriers = " + std::to_string(projectData.physicsMaxBarriers) + ";";
+        else if (line.find("int physicsThreads = 0;") != std::string::npos)
+            outputFile << "int physicsThreads = " + std::to_string(projectData.physicsThreads) + ";";
+        else if (line.find("std::vector<std::string> collisionLayerNames = { \"Default\" };") != std::string::npos)
+        {
+            outputFile << "std::vector<std::string> collisionLayerNames = {";
+            for (size_t i = 0; i < projectData.collisionLayerNames.size(); i++)
+                outputFile << (i > 0 ? ", " : " ") + nlohmann::json(projectData.collisionLayerNames[i]).dump();
+            outputFile << " };";
+        }
+        else if (line.find("std::vector<uint32_t> collisionLayerMasks = { 0xFFFFFFFF };") != std::string::npos)
+        {
+            outputFile << "std::vector<uint32_t> collisionLayerMasks = {";
+            for (size_t i = 0; i < projectData.collisionLayerMasks.size(); i++)
+                outputFile << (i > 0 ? ", " : " ") + std::to_string(projectData.collisionLayerMasks[i]) + "u";
+            outputFile << " };";
+        }
         else if (line.find("RaylibWrapper::SetTargetFPS(60);") != std::string::npos)
             outputFile << "RaylibWrapper::SetTargetFPS(" + std::to_string(projectData.maxFPS) + ");";
         else if (line.find("RaylibWrapper::SetWindowMinSize(100, 100);") != std::string::npos)
@@ -619,6 +651,13 @@ bool ProjectManager::PrepareBuild(std::string platform, std::string& projectName
     try {
         // Todo: Copy the default GUI font too. Will also need to initialize it in the the FontManager
         std::filesystem::copy("resources/shaders", buildPath / "Resources" / "shaders", std::filesystem::copy_options::recursive);
+
+        // Models the editor cooked, which the game loads instead of the model files
+        if (std::filesystem::exists(projectData.path / "Cache" / "Meshes"))
+        {
+            std::filesystem::create_directories(buildPath / "Resources" / "Cache");
+            std::filesystem::copy(projectData.path / "Cache" / "Meshes", buildPath / "Resources" / "Cache" / "Meshes", std::filesystem::copy_options::recursive | std::filesystem::copy_options::overwrite_existing);
+        }
     }
     catch (const std::exception& e) {
         ConsoleLogger::ErrorLog("Build - Failed to copy resource files: " + (std::string)e.what());
@@ -1479,6 +1518,19 @@ void ProjectManager::SaveProjectData(ProjectData projectData) // Todo: Encode Fi
     projectDataJson["physicsTimeStep"].push_back(projectData.physicsTimeStep.y);
     projectDataJson["velocityIterations"] = projectData.velocityIterations;
     projectDataJson["positionIterations"] = projectData.positionIterations;
+    projectDataJson["mergeStaticColliders"] = projectData.mergeStaticColliders;
+    projectDataJson["staticMergeRegionSize"] = projectData.staticMergeRegionSize;
+    projectDataJson["physicsTempMemory"] = projectData.physicsTempMemory;
+    projectDataJson["physicsMaxBodies"] = projectData.physicsMaxBodies;
+    projectDataJson["physicsMaxBodyPairs"] = projectData.physicsMaxBodyPairs;
+    projectDataJson["physicsMaxContactConstraints"] = projectData.physicsMaxContactConstraints;
+    projectDataJson["physicsMaxJobs"] = projectData.physicsMaxJobs;
+    projectDataJson["physicsMaxBarriers"] = projectData.physicsMaxBarriers;
+    projectDataJson["physicsThreads"] = projectData.physicsThreads;
+    projectDataJson["collisionLayerNames"] = projectData.collisionLayerNames;
+    projectDataJson["collisionLayerMasks"] = projectData.collisionLayerMasks;
+
+    projectDataJson["autosaveInterval"] = projectData.autosaveInterval;
     
     std::filesystem::path path = (projectData.path / "ProjectSettings.cry");
 
@@ -1728,6 +1780,98 @@ ProjectData ProjectManager::LoadProjectData(std::filesystem::path projectPath) /
         saveProjectData = true;
     }
 
+    try {
+        projectData.mergeStaticColliders = projectDataJson.at("mergeStaticColliders").get<bool>();
+    }
+    catch (const std::exception& e) {
+        projectData.mergeStaticColliders = false;
+        saveProjectData = true;
+    }
+
+    try {
+        projectData.staticMergeRegionSize = projectDataJson.at("staticMergeRegionSize").get<float>();
+    }
+    catch (const std::exception& e) {
+        projectData.staticMergeRegionSize = 64.0f;
+        saveProjectData = true;
+    }
+
+    try {
+        projectData.physicsTempMemory = projectDataJson.at("physicsTempMemory").get<int>();
+    }
+    catch (const std::exception& e) {
+        projectData.physicsTempMemory = 16;
+        saveProjectData = true;
+    }
+
+    try {
+        projectData.physicsMaxBodies = projectDataJson.at("physicsMaxBodies").get<int>();
+    }
+    catch (const std::exception& e) {
+        projectData.physicsMaxBodies = 65536;
+        saveProjectData = true;
+    }
+
+    try {
+        projectData.physicsMaxBodyPairs = projectDataJson.at("physicsMaxBodyPairs").get<int>();
+    }
+    catch (const std::exception& e) {
+        projectData.physicsMaxBodyPairs = 65536;
+        saveProjectData = true;
+    }
+
+    try {
+        projectData.physicsMaxContactConstraints = projectDataJson.at("physicsMaxContactConstraints").get<int>();
+    }
+    catch (const std::exception& e) {
+        projectData.physicsMaxContactConstraints = 20480;
+        saveProjectData = true;
+    }
+
+    try {
+        projectData.physicsMaxJobs = projectDataJson.at("physicsMaxJobs").get<int>();
+    }
+    catch (const std::exception& e) {
+        projectData.physicsMaxJobs = 2048;
+        saveProjectData = true;
+    }
+
+    try {
+        projectData.physicsMaxBarriers = projectDataJson.at("physicsMaxBarriers").get<int>();
+    }
+    catch (const std::exception& e) {
+        projectData.physicsMaxBarriers = 16;
+        saveProjectData = true;
+    }
+
+    try {
+        projectData.physicsThreads = projectDataJson.at("physicsThreads").get<int>();
+    }
+    catch (const std::exception& e) {
+        projectData.physicsThreads = 0;
+        saveProjectData = true;
+    }
+
+    try {
+        projectData.collisionLayerNames = projectDataJson.at("collisionLayerNames").get<std::vector<std::string>>();
+        projectData.collisionLayerMasks = projectDataJson.at("collisionLayerMasks").get<std::vector<uint32_t>>();
+        if (projectData.collisionLayerNames.empty() || projectData.collisionLayerMasks.size() != projectData.collisionLayerNames.size())
+            throw std::runtime_error("Invalid collision layers");
+    }
+    catch (const std::exception& e) {
+        projectData.collisionLayerNames = { "Default" };
+        projectData.collisionLayerMasks = { 0xFFFFFFFF };
+        saveProjectData = true;
+    }
+
+    try {
+        projectData.autosaveInterval = projectDataJson.at("autosaveInterval").get<int>();
+    }
+    catch (const std::exception& e) {
+        projectData.autosaveInterval = 120;
+        saveProjectData = true;
+    }
+
     if (saveProjectData)
     {
         projectData.path = projectPath;
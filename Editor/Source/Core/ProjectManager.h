@@ -57,6 +57,20 @@ struct ProjectData
     Vector2 physicsTimeStep = {1, 60};
     int velocityIterations = 8;
     int positionIterations = 3;
+    bool mergeStaticColliders = false; // Merges static 3D colliders into one body per region when the scene starts
+    float staticMergeRegionSize = 64.0f;
+    int physicsTempMemory = 16; // Megabytes preallocated for each 3D physics step's temporary data
+    int physicsMaxBodies = 65536;
+    int physicsMaxBodyPairs = 65536;
+    int physicsMaxContactConstraints = 20480;
+    int physicsMaxJobs = 2048;
+    int physicsMaxBarriers = 16;
+    int physicsThreads = 0; // 0 uses one per core
+    std::vector<std::string> collisionLayerNames = { "Default" }; // Up to 32, or 16 in 2D projects
+    std::vector<uint32_t> collisionLayerMasks = { 0xFFFFFFFF }; // One per layer, bit n is set if it collides with layer n. Kept symmetric.
+
+    // Editor
+    int autosaveInterval = 120; // Seconds between scene autosaves. 0 disables autosaving.
 };
 
 class ProjectManager {
@@ -10,6 +10,11 @@
 #include <filesystem>
 #include "Core/ProjectManager.h"
 #include "ThirdParty/imgui/ImGuiNotify.hpp"
+#include "Raylib/RaylibModelWrapper.h"
+#include "Resources/CookedMesh.h"
+#include "Systems/FileWatcher/FileWatcher.h"
+#include <mutex>
+#include <algorithm>
 
 namespace AssetManager
 {
@@ -30,6 +35,9 @@ namespace AssetManager
     bool assetsCached = false;
     bool connectedToInternet = true;
 
+    std::mutex cookQueueMutex; // The FileWatcher queues models from its own thread
+    std::vector<std::filesystem::path> cookQueue; // Relative to the Assets folder
+
     size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* data)
     {
         data->append((char*)contents, size * nmemb);
@@ -665,11 +673,67 @@ namespace AssetManager
         return true;
     }
 
+    bool IsModelFile(const std::filesystem::path& path)
+    {
+        std::string extension = path.extension().string();
+        return extension == ".gltf" || extension == ".glb" || extension == ".obj" || extension == ".m3d";
+    }
+
+    void QueueModel(const std::filesystem::path& path)
+    {
+        std::filesystem::path relativePath = std::filesystem::relative(path, ProjectManager::projectData.path / "Assets");
+        std::lock_guard<std::mutex> lock(cookQueueMutex);
+        if (std::find(cookQueue.begin(), cookQueue.end(), relativePath) == cookQueue.end())
+            cookQueue.push_back(relativePath);
+    }
+
+    void QueueModelCooking()
+    {
+        if (!ProjectManager::projectData.is3D)
+            return;
+
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(ProjectManager::projectData.path / "Assets", error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+            if (it->is_regular_file() && IsModelFile(it->path()))
+                QueueModel(it->path());
+    }
+
+    void CookQueuedModels()
+    {
+        std::filesystem::path path;
+        {
+            std::lock_guard<std::mutex> lock(cookQueueMutex);
+            if (cookQueue.empty())
+                return;
+
+            path = cookQueue.front();
+            cookQueue.erase(cookQueue.begin());
+        }
+
+        // Cooked on the main thread since the model's textures are read back from the GPU
+        std::filesystem::path assetsPath = ProjectManager::projectData.path / "Assets";
+        std::filesystem::path sourcePath = assetsPath / path;
+        std::filesystem::path cookedPath = RaylibModel::GetCookedPath(path, assetsPath);
+        if (!std::filesystem::exists(sourcePath) || CookedMeshFile::IsUpToDate(cookedPath, sourcePath, true))
+            return;
+
+        // A model that can't be cooked anymore loses its old cooked file, so builds don't ship it
+        std::error_code error;
+        if (!RaylibModel::CookModel(sourcePath, cookedPath))
+            std::filesystem::remove(cookedPath, error);
+    }
+
     void Init(ImGuiWindowClass* winClass)
     {
         windowClass = winClass;
         curl_global_init(CURL_GLOBAL_ALL); // This would be called in Editor.cpp, but including Curl causes some issues
 
+        QueueModelCooking();
+        FileWatcher::AddGlobalModifyCallback("AssetManager", [](const std::filesystem::path path) {
+            if (ProjectManager::projectData.is3D && IsModelFile(path))
+                QueueModel(path);
+        });
+
         std::ifstream file(ProjectManager::projectData.path / "assets.json");
         if (!file.is_open())
             return;
@@ -12,6 +12,10 @@ namespace AssetManager
 	bool FetchAssets();
 	void Init(ImGuiWindowClass* windowClass);
 	void Cleanup();
+	// Queues every model in the project's assets to be cooked. Models are queued again when they're modified.
+	void QueueModelCooking();
+	// Cooks the next queued model if its cooked file is missing or older than it. Called every frame, and only cooks one model so the editor doesn't stall.
+	void CookQueuedModels();
 
 	extern bool open;
 }
\ No newline at end of file
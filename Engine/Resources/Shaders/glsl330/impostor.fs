@@ -0,0 +1,29 @@
+#version 330
+
+in vec2 fragTexCoord;
+in vec4 fragColor;
+
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+
+out vec4 finalColor;
+
+// 4x4 ordered dither threshold, used to fade impostors in without sorting them
+float DitherThreshold(vec2 position) {
+    int x = int(mod(position.x, 4.0));
+    int y = int(mod(position.y, 4.0));
+    int index = x + y * 4;
+    int matrix[16] = int[16](0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5);
+    return (float(matrix[index]) + 0.5) / 16.0;
+}
+
+void main() {
+    vec4 texel = texture(texture0, fragTexCoord);
+    if (texel.a < 0.5)
+        discard;
+
+    if (fragColor.a < DitherThreshold(gl_FragCoord.xy))
+        discard;
+
+    finalColor = vec4(texel.rgb * colDiffuse.rgb * fragColor.rgb, 1.0);
+}
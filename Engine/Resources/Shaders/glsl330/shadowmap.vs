@@ -5,11 +5,13 @@ in vec3 vertexPosition;
 in vec2 vertexTexCoord;
 in vec3 vertexNormal;
 in vec4 vertexColor;
+in mat4 instanceTransform;
 
 // Input uniform values
 uniform mat4 mvp;
 uniform mat4 matModel;
 uniform mat4 matNormal;
+uniform int useInstancing; // Set while drawing with DrawMeshInstanced(), which passes the model matrix per instance instead
 
 // Output vertex attributes (to fragment shader)
 out vec3 fragPosition;
@@ -19,6 +21,16 @@ out vec3 fragNormal;
 
 void main()
 {
+    if (useInstancing == 1)
+    {
+        fragPosition = vec3(instanceTransform * vec4(vertexPosition, 1.0));
+        fragTexCoord = vertexTexCoord;
+        fragColor = vertexColor;
+        fragNormal = normalize(transpose(inverse(mat3(instanceTransform))) * vertexNormal);
+        gl_Position = mvp * instanceTransform * vec4(vertexPosition, 1.0);
+        return;
+    }
+
     // Calculate world space position
     fragPosition = vec3(matModel * vec4(vertexPosition, 1.0));
     
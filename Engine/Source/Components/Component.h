@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <type_traits>
 #include "Core/GameObject.h"
 //class GameObject;
 #if defined(EDITOR)
@@ -43,6 +44,18 @@ public:
     // Hide in API
     bool initialized = false; // Whether the component is ready to call functions like Start, Awake, Enable, Disable, etc.
     // Hide in API
+    enum CollisionEvent : uint8_t
+    {
+        CollisionEnter2D = 1 << 0,
+        CollisionExit2D = 1 << 1,
+        CollisionStay2D = 1 << 2,
+        CollisionEnter3D = 1 << 3,
+        CollisionExit3D = 1 << 4,
+        CollisionStay3D = 1 << 5
+    };
+    // Hide in API
+    uint8_t collisionEvents = 0; // The OnCollision functions this component overrides. Collisions are only sent to components that handle them.
+    // Hide in API
     bool valid = true; // Used in component construcors to let AddComponent<>() know if it should continue with adding the component. Used in Rigidbody2D
 
 #if defined(EDITOR)
@@ -135,3 +148,23 @@ public:
 
     GameObject* gameObject;
 };
+
+// A member function pointer to a function T doesn't override still has Component's type
+template <typename T>
+uint8_t GetCollisionEvents()
+{
+    uint8_t events = 0;
+    if constexpr (!std::is_same_v<decltype(&T::OnCollisionEnter2D), void (Component::*)(Collider2D*)>)
+        events |= Component::CollisionEnter2D;
+    if constexpr (!std::is_same_v<decltype(&T::OnCollisionExit2D), void (Component::*)(Collider2D*)>)
+        events |= Component::CollisionExit2D;
+    if constexpr (!std::is_same_v<decltype(&T::OnCollisionStay2D), void (Component::*)(Collider2D*)>)
+        events |= Component::CollisionStay2D;
+    if constexpr (!std::is_same_v<decltype(&T::OnCollisionEnter3D), void (Component::*)(Collider3D*)>)
+        events |= Component::CollisionEnter3D;
+    if constexpr (!std::is_same_v<decltype(&T::OnCollisionExit3D), void (Component::*)(Collider3D*)>)
+        events |= Component::CollisionExit3D;
+    if constexpr (!std::is_same_v<decltype(&T::OnCollisionStay3D), void (Component::*)(Collider3D*)>)
+        events |= Component::CollisionStay3D;
+    return events;
+}
@@ -4,6 +4,8 @@
 #include "Systems/Events/EventSystem.h"
 #if !defined(EDITOR)
 #include "Game.h"
+#include "Systems/Physics/CollisionLayers.h"
+#include <algorithm>
 #else
 #include "Core/Editor.h"
 #endif
@@ -44,6 +46,12 @@ Collider2D::Collider2D(GameObject* obj, int id) : Component(obj, id) {
                     "size",
                     [1,1],
                     "Size"
+                ],
+                [
+                    "string",
+                    "collisionLayer",
+                    "Default",
+                    "Collision Layer"
                 ]
             ]
         ]
@@ -67,6 +75,7 @@ void Collider2D::Createb2Fixture()
 	//else // Assumes its a texture or doesn't have a sprite
 	//	shape.SetAsBox(gameObject->transform.GetScale().x * 3 * size.x / 2, gameObject->transform.GetScale().y * 3 * size.y / 2, b2Vec2(offset.x, offset.y), 0.0f);
 
+	fixtureScale = gameObject->transform.GetScale();
 	switch (shape)
 	{
 		default:
@@ -89,6 +98,26 @@ void Collider2D::Createb2Fixture()
 		}
 	}
 }
+
+void Collider2D::SyncScale()
+{
+	// The scale is baked into the fixture, so a scaled game object needs a new one
+	Vector3 scale = gameObject->transform.GetScale();
+	if (!body || !fixture || (scale.x == fixtureScale.x && scale.y == fixtureScale.y))
+		return;
+
+	body->DestroyFixture(fixture);
+	Createb2Fixture();
+}
+
+b2Filter Collider2D::GetFilter()
+{
+	// Box2D tests (maskA & categoryB) and (categoryA & maskB), so the layer's row of the matrix is its mask
+	b2Filter filter = fixtureDef.filter;
+	filter.categoryBits = static_cast<uint16>(1u << layer);
+	filter.maskBits = static_cast<uint16>(CollisionLayers::GetMask(layer));
+	return filter;
+}
 #endif
 
 void Collider2D::Start()
@@ -97,6 +126,14 @@ void Collider2D::Start()
 	if (body && fixture)
 		return;
 
+	layer = CollisionLayers::GetLayer(collisionLayer);
+	if (layer == -1 || layer >= CollisionLayers::maxLayers2D)
+	{
+		ConsoleLogger::WarningLog("The Collider2D on " + gameObject->GetName() + " uses the collision layer \"" + collisionLayer + "\", which doesn't exist or isn't one of the first 16. It will use Default instead.");
+		layer = 0;
+	}
+	fixtureDef.filter = GetFilter();
+
 	// Putting this in Start() instead of Awake() to ensure the rigidbody component gets set up first
 
 	Rigidbody2D* rb = gameObject->GetComponent<Rigidbody2D>();
@@ -238,18 +275,16 @@ void Collider2D::Enable()
 #if !defined(EDITOR)
 	if (!fixture) // This is needed since the fixture is setup in Start(), and Enable() runs before Start()
 		return;
-	b2Filter filter = fixture->GetFilterData();
-	filter.categoryBits = 0x0001;
-	filter.maskBits = 0xFFFF;
-	fixture->SetFilterData(filter);
+	fixture->SetFilterData(GetFilter());
 #endif
 }
 
 void Collider2D::Disable()
 {
 #if !defined(EDITOR)
+	// No category bits means no other fixture's mask can match it
 	b2Filter filter = fixture->GetFilterData();
-	filter.categoryBits = 0x8000;
+	filter.categoryBits = 0x0000;
 	filter.maskBits = 0x0000;
 	fixture->SetFilterData(filter);
 #endif
@@ -320,6 +355,45 @@ void Collider2D::RemoveRigidbody()
 #endif
 }
 
+void Collider2D::SetCollisionLayer(int layer)
+{
+#if !defined(EDITOR)
+	if (layer < 0 || layer >= std::min(CollisionLayers::GetLayerCount(), CollisionLayers::maxLayers2D))
+	{
+		ConsoleLogger::WarningLog("Failed to set the collision layer of " + gameObject->GetName() + "'s Collider2D. There's no layer " + std::to_string(layer) + " in 2D.");
+		return;
+	}
+
+	this->layer = layer;
+	collisionLayer = CollisionLayers::GetLayerName(layer);
+	fixtureDef.filter = GetFilter();
+	if (fixture && IsActive() && gameObject->IsGlobalActive())
+		fixture->SetFilterData(fixtureDef.filter);
+#endif
+}
+
+void Collider2D::SetCollisionLayer(std::string name)
+{
+#if !defined(EDITOR)
+	int layer = CollisionLayers::GetLayer(name);
+	if (layer == -1)
+	{
+		ConsoleLogger::WarningLog("Failed to set the collision layer of " + gameObject->GetName() + "'s Collider2D. There's no layer named \"" + name + "\".");
+		return;
+	}
+	SetCollisionLayer(layer);
+#endif
+}
+
+int Collider2D::GetCollisionLayer()
+{
+#if !defined(EDITOR)
+	return layer;
+#else
+	return 0;
+#endif
+}
+
 Collider2D::Shape Collider2D::GetShape()
 {
 	return shape;
@@ -41,23 +41,35 @@ public:
     Vector2 GetOffset();
     void SetSize(Vector2 size);
     Vector2 GetSize();
+    // Only the first 16 layers can be used in 2D, since they're Box2D's filter category bits
+    void SetCollisionLayer(int layer);
+    void SetCollisionLayer(std::string name);
+    int GetCollisionLayer();
 
     // Hide in API
     bool highlight = false;
+#if !defined(EDITOR)
+    // Hide in API
+    // Recreates the fixture if the game object was scaled. Called by Rigidbody2D::SyncMovedTransforms() only for game objects that moved.
+    void SyncScale();
+#endif
 
 private:
     Shape shape;
     bool trigger;
     Vector2 offset;
     Vector2 size = {1, 1};
-
+    std::string collisionLayer = "Default"; // The layer's name, so scenes keep working when layers are reordered
+    int layer = 0;
 
 #if !defined(EDITOR)
     void Createb2Fixture();
+    b2Filter GetFilter();
 
     b2FixtureDef fixtureDef;
     b2Body* body = nullptr;
     b2Fixture* fixture = nullptr;
     bool ownBody = false;
+    Vector3 fixtureScale = { 1, 1, 1 }; // The game object's scale when the fixture was created
 #endif
 };
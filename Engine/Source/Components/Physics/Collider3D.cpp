@@ -3,10 +3,29 @@
 #include "Systems/Events/EventSystem.h"
 #if !defined(EDITOR)
 #include "Game.h"
+#include "Components/Rendering/Terrain.h"
+#include "Components/Rendering/MeshRenderer.h"
+#include "Systems/Physics/ShapeCache.h"
+#include "Systems/Physics/CollisionListener3D.h"
+#include "Utilities/ConsoleLogger.h"
+#include "ThirdParty/Jolt/Core/TempAllocator.h"
+#include "ThirdParty/Jolt/Physics/Collision/PhysicsMaterialSimple.h"
+#include "ThirdParty/Jolt/Physics/Collision/Shape/StaticCompoundShape.h"
+#include <algorithm>
+#include <cmath>
 #else
 #include "Core/Editor.h"
 #endif
 
+bool Collider3D::mergeStaticColliders = false;
+float Collider3D::mergeRegionSize = 64.0f;
+#if !defined(EDITOR)
+bool Collider3D::collectingStaticColliders = false;
+std::vector<Collider3D*> Collider3D::pendingStaticColliders;
+std::unordered_map<int64_t, Collider3D::StaticBatch> Collider3D::staticBatches;
+std::unordered_set<int64_t> Collider3D::dirtyStaticBatches;
+#endif
+
 Collider3D::Collider3D(GameObject* obj, int id) : Component(obj, id) {
 	name = "Collider3D";
 	iconUnicode = "\xef\x89\x8d";
@@ -26,7 +45,10 @@ Collider3D::Collider3D(GameObject* obj, int id) : Component(obj, id) {
                         "Sphere",
 						"Plane",
 						"Cylinder",
-						"Cone"
+						"Cone",
+						"Terrain",
+						"Mesh",
+						"ConvexHull"
                     ]
                 ],
                 [
@@ -46,6 +68,12 @@ Collider3D::Collider3D(GameObject* obj, int id) : Component(obj, id) {
                     "size",
                     [1,1,1],
                     "Size"
+                ],
+                [
+                    "string",
+                    "collisionLayer",
+                    "Default",
+                    "Collision Layer"
                 ]
             ]
         ]
@@ -54,30 +82,81 @@ Collider3D::Collider3D(GameObject* obj, int id) : Component(obj, id) {
 #endif
 }
 
+#if !defined(EDITOR)
+static const JPH::uint terrainBlockSize = 4; // Jolt culls and compresses the height field in blocks of this many samples per side
+
+// Copies a rect of the terrain's heights in the height field's layout. Samples past the terrain's edges only pad the field to its square size, so they don't collide.
+static void CopyTerrainHeights(const std::vector<float>& heights, int width, int depth, int minX, int minZ, int sizeX, int sizeZ, float* samples)
+{
+	for (int z = 0; z < sizeZ; z++)
+	{
+		for (int x = 0; x < sizeX; x++)
+		{
+			int sampleX = minX + x;
+			int sampleZ = minZ + z;
+			samples[z * sizeX + x] = (sampleX < width && sampleZ < depth) ? heights[static_cast<size_t>(sampleZ) * width + sampleX] : JPH::HeightFieldShapeConstants::cNoCollisionValue;
+		}
+	}
+}
+
+// Each cell takes the material of the terrain layer with the most weight across its corners
+static void CopyTerrainMaterials(const Terrain* terrain, int minX, int minZ, int sizeX, int sizeZ, JPH::uint8* materials)
+{
+	int width = terrain->GetWidth();
+	int depth = terrain->GetDepth();
+	for (int z = 0; z < sizeZ; z++)
+	{
+		for (int x = 0; x < sizeX; x++)
+		{
+			int cellX = minX + x;
+			int cellZ = minZ + z;
+			JPH::uint8 material = 0;
+			if (cellX < width - 1 && cellZ < depth - 1)
+			{
+				size_t corner = static_cast<size_t>(cellZ) * width + cellX;
+				float bestWeight = -1.0f;
+				for (int layer = 0; layer < terrain->GetLayerCount(); layer++)
+				{
+					const std::vector<float>& splatmap = terrain->GetLayer(layer)->splatmap;
+					float weight = splatmap[corner] + splatmap[corner + 1] + splatmap[corner + width] + splatmap[corner + width + 1];
+					if (weight > bestWeight)
+					{
+						bestWeight = weight;
+						material = static_cast<JPH::uint8>(layer);
+					}
+				}
+			}
+			materials[z * sizeX + x] = material;
+		}
+	}
+}
+#endif
+
 // Todo: Check if the game object or component is enabled/disabled, if it is then body->SetActive(). Also check if Rigidbody3D is destroyed, if it is then look for a new one, or create one. (Check when its destroyed in the Rigidbody3D Destroy() )
 
 void Collider3D::CreateShape()
 {
 #if !defined(EDITOR)
+	// Shapes come from ShapeCache, so colliders with the same dimensions share one
+	ShapeCache::Release(joltShape);
+	shapeScale = gameObject->transform.GetScale();
+
 	switch (shape)
 	{
 		default:
 		case Box:
 		{
-			JPH::BoxShapeSettings shape({ (gameObject->transform.GetScale().x * 3 * size.x / 2) / 3, (gameObject->transform.GetScale().y * 3 * size.y / 2) / 3, (gameObject->transform.GetScale().z * 3 * size.z / 2) / 3 });
-			joltShape = shape.Create().Get();
+			joltShape = ShapeCache::GetBoxShape((gameObject->transform.GetScale().x * 3 * size.x / 2) / 3, (gameObject->transform.GetScale().y * 3 * size.y / 2) / 3, (gameObject->transform.GetScale().z * 3 * size.z / 2) / 3);
 			break;
 		}
 		case Sphere:
 		{
-			JPH::SphereShapeSettings shape((gameObject->transform.GetScale().x * size.x) / 2.0f);
-			joltShape = shape.Create().Get();
+			joltShape = ShapeCache::GetSphereShape((gameObject->transform.GetScale().x * size.x) / 2.0f);
 			break;
 		}
 		case Plane:
 		{
-			JPH::BoxShapeSettings shape({ (gameObject->transform.GetScale().x * 3 * size.x / 2) / 3, 0.06f, (gameObject->transform.GetScale().z * 3 * size.z / 2) / 3 });
-			joltShape = shape.Create().Get();
+			joltShape = ShapeCache::GetBoxShape((gameObject->transform.GetScale().x * 3 * size.x / 2) / 3, 0.06f, (gameObject->transform.GetScale().z * 3 * size.z / 2) / 3);
 			// Todo: Implementan actual plane
 			//JPH::Plane plane({ 0.0f, 1.0f, 0.0f }, distanceFromOrigin); // First parameter is the plane normal, the second parameter is confusing
 			//plane = plane.Scaled({ (gameObject->transform.GetScale().x * 3 * size.x / 2) / 3, 1, (gameObject->transform.GetScale().z * 3 * size.z / 2) / 3 });
@@ -90,8 +169,7 @@ void Collider3D::CreateShape()
 			float radius = (gameObject->transform.GetScale().x * size.x) / 2;
 			float height = gameObject->transform.GetScale().y * size.y;
 
-			JPH::CylinderShapeSettings shape(height, radius);
-			joltShape = shape.Create().Get();
+			joltShape = ShapeCache::GetCylinderShape(height, radius);
 			break;
 		}
 		case Cone: // Todo: This needs to be changed to use a mesh shape
@@ -99,44 +177,380 @@ void Collider3D::CreateShape()
 			float radius = (gameObject->transform.GetScale().x * size.x) / 2;
 			float height = gameObject->transform.GetScale().y * size.y / 2; 
 
-			JPH::CylinderShapeSettings shape(height, radius);
-			joltShape = shape.Create().Get();
+			joltShape = ShapeCache::GetCylinderShape(height, radius);
+			break;
+		}
+		case Terrain:
+			CreateTerrainShape();
+			break;
+		case Mesh:
+		case ConvexHull:
+		{
+			joltShape = nullptr;
+			MeshRenderer* meshRenderer = gameObject->GetComponent<MeshRenderer>();
+			std::vector<float> positions;
+			std::vector<unsigned int> indices;
+			if (!meshRenderer || !meshRenderer->GetModel().GetCollisionGeometry(positions, indices))
+			{
+				ConsoleLogger::WarningLog(gameObject->GetName() + "'s Collider3D uses the " + (shape == Mesh ? "Mesh" : "ConvexHull") + " shape, but it has no MeshRenderer with a model.");
+				break;
+			}
+
+			// The scale is baked into the geometry like the other shapes, so each scale is cooked separately
+			Vector3 scale = gameObject->transform.GetScale();
+			for (size_t i = 0; i + 2 < positions.size(); i += 3)
+			{
+				positions[i] *= scale.x * size.x;
+				positions[i + 1] *= scale.y * size.y;
+				positions[i + 2] *= scale.z * size.z;
+			}
+
+			joltShape = ShapeCache::GetMeshShape(positions, indices, shape == ConvexHull);
 			break;
 		}
 	}
 #endif
 }
 
+void Collider3D::CreateTerrainShape()
+{
+#if !defined(EDITOR)
+	joltShape = nullptr;
+	heightField = nullptr;
+
+	terrain = gameObject->GetComponent<::Terrain>();
+	if (!terrain)
+	{
+		ConsoleLogger::WarningLog(gameObject->GetName() + "'s Collider3D uses the Terrain shape, but it has no Terrain.");
+		return;
+	}
+
+	// This builds from the terrain's current data, so anything changed before now is already included
+	int dirtyMinX, dirtyMinZ, dirtyMaxX, dirtyMaxZ;
+	bool fullRebuild;
+	terrain->TakeCollisionChanges(dirtyMinX, dirtyMinZ, dirtyMaxX, dirtyMaxZ, fullRebuild);
+
+	int width = terrain->GetWidth();
+	int depth = terrain->GetDepth();
+	const std::vector<float>& heights = terrain->GetHeightData();
+	if (width < 2 || depth < 2 || heights.size() != static_cast<size_t>(width) * depth)
+		return;
+
+	// Jolt's height fields are square, with a multiple of the block size samples per side
+	JPH::uint sampleCount = std::max((static_cast<JPH::uint>(std::max(width, depth)) + terrainBlockSize - 1) / terrainBlockSize * terrainBlockSize, terrainBlockSize * 2);
+
+	JPH::HeightFieldShapeSettings settings;
+	settings.mOffset = JPH::Vec3(-width * 0.5f, 0.0f, -depth * 0.5f); // Centered on the game object, like the chunks in Terrain::Render()
+	settings.mScale = JPH::Vec3::sReplicate(1.0f);
+	settings.mSampleCount = sampleCount;
+	settings.mBlockSize = terrainBlockSize;
+	settings.mHeightSamples.resize(static_cast<size_t>(sampleCount) * sampleCount);
+	CopyTerrainHeights(heights, width, depth, 0, 0, sampleCount, sampleCount, settings.mHeightSamples.data());
+
+	// The samples are quantized within this range, so it leaves room to sculpt above and below the current heights without rebuilding the shape
+	auto [lowest, highest] = std::minmax_element(heights.begin(), heights.end());
+	float minHeight = std::min(*lowest, 0.0f);
+	float maxHeight = std::max(*highest, terrain->GetTerrainHeight() * terrain->GetHeightScale());
+	float headroom = std::max(maxHeight - minHeight, 1.0f) * 0.5f;
+	settings.mMinHeightValue = minHeight - headroom;
+	settings.mMaxHeightValue = maxHeight + headroom;
+
+	// A material per terrain layer, so contacts can tell which layer they're on
+	bool splatmapsMatch = terrain->GetLayerCount() <= 256;
+	for (int i = 0; i < terrain->GetLayerCount(); i++)
+		splatmapsMatch = splatmapsMatch && terrain->GetLayer(i)->splatmap.size() == heights.size();
+	if (terrain->GetLayerCount() > 0 && splatmapsMatch)
+	{
+		for (int i = 0; i < terrain->GetLayerCount(); i++)
+			settings.mMaterials.push_back(new JPH::PhysicsMaterialSimple(terrain->GetLayer(i)->name, JPH::Color::sGrey));
+		settings.mMaterialIndices.resize(static_cast<size_t>(sampleCount - 1) * (sampleCount - 1));
+		CopyTerrainMaterials(terrain, 0, 0, sampleCount - 1, sampleCount - 1, settings.mMaterialIndices.data());
+	}
+
+	JPH::ShapeSettings::ShapeResult result = settings.Create();
+	if (result.HasError())
+	{
+		ConsoleLogger::ErrorLog(gameObject->GetName() + "'s terrain collider failed to be created. " + std::string(result.GetError().c_str()));
+		return;
+	}
+
+	heightField = static_cast<JPH::HeightFieldShape*>(result.Get().GetPtr());
+	joltShape = heightField;
+#endif
+}
+
+void Collider3D::UpdateTerrainShape()
+{
+#if !defined(EDITOR)
+	if (!terrain || !heightField)
+		return;
+
+	int minX, minZ, maxX, maxZ;
+	bool fullRebuild;
+	if (!terrain->TakeCollisionChanges(minX, minZ, maxX, maxZ, fullRebuild))
+		return;
+
+	int width = terrain->GetWidth();
+	int depth = terrain->GetDepth();
+	const std::vector<float>& heights = terrain->GetHeightData();
+	JPH::uint sampleCount = heightField->GetSampleCount();
+	if (static_cast<JPH::uint>(std::max(width, depth)) > sampleCount || heights.size() != static_cast<size_t>(width) * depth)
+		fullRebuild = true;
+	else if (heightField->GetMaterialList().size() != static_cast<size_t>(terrain->GetLayerCount()))
+		fullRebuild = true;
+
+	// Heights outside the range the shape was built with would be clamped
+	float minHeight = heightField->GetMinHeightValue();
+	float maxHeight = heightField->GetMaxHeightValue();
+	for (int z = minZ; z <= maxZ && !fullRebuild; z++)
+	{
+		for (int x = minX; x <= maxX; x++)
+		{
+			float height = heights[static_cast<size_t>(z) * width + x];
+			if (height < minHeight || height > maxHeight)
+			{
+				fullRebuild = true;
+				break;
+			}
+		}
+	}
+
+	if (fullRebuild)
+	{
+		CreateTerrainShape();
+		if (joltShape != nullptr)
+			Rigidbody3D::bodyInterface->SetShape(body->GetID(), joltShape, false, JPH::EActivation::DontActivate);
+		return;
+	}
+
+	// Only the blocks the changed samples are in are recompressed
+	JPH::TempAllocatorMalloc allocator;
+	int blockMinX = minX / terrainBlockSize * terrainBlockSize;
+	int blockMinZ = minZ / terrainBlockSize * terrainBlockSize;
+	int blockSizeX = std::min((maxX / terrainBlockSize + 1) * terrainBlockSize, sampleCount) - blockMinX;
+	int blockSizeZ = std::min((maxZ / terrainBlockSize + 1) * terrainBlockSize, sampleCount) - blockMinZ;
+	std::vector<float> samples(static_cast<size_t>(blockSizeX) * blockSizeZ);
+	CopyTerrainHeights(heights, width, depth, blockMinX, blockMinZ, blockSizeX, blockSizeZ, samples.data());
+	heightField->SetHeights(blockMinX, blockMinZ, blockSizeX, blockSizeZ, samples.data(), blockSizeX, allocator);
+
+	if (!heightField->GetMaterialList().empty())
+	{
+		// A sample is a corner of the cells before and after it
+		int cellMinX = std::max(minX - 1, 0);
+		int cellMinZ = std::max(minZ - 1, 0);
+		int cellSizeX = std::min(maxX, static_cast<int>(sampleCount) - 2) - cellMinX + 1;
+		int cellSizeZ = std::min(maxZ, static_cast<int>(sampleCount) - 2) - cellMinZ + 1;
+		std::vector<JPH::uint8> materials(static_cast<size_t>(cellSizeX) * cellSizeZ);
+		CopyTerrainMaterials(terrain, cellMinX, cellMinZ, cellSizeX, cellSizeZ, materials.data());
+		heightField->SetMaterials(cellMinX, cellMinZ, cellSizeX, cellSizeZ, materials.data(), cellSizeX, nullptr, allocator);
+	}
+
+	// Updates the body's bounds in the broad phase, then wakes anything resting on the changed region so it doesn't float or sink
+	Rigidbody3D::bodyInterface->NotifyShapeChanged(body->GetID(), heightField->GetCenterOfMass(), false, JPH::EActivation::DontActivate);
+	JPH::AABox region(JPH::Vec3(blockMinX - width * 0.5f, minHeight, blockMinZ - depth * 0.5f),
+		JPH::Vec3(blockMinX + blockSizeX - width * 0.5f, maxHeight, blockMinZ + blockSizeZ - depth * 0.5f));
+	Rigidbody3D::bodyInterface->ActivateBodiesInAABox(region.Transformed(body->GetWorldTransform()), {}, {});
+#endif
+}
+
+Collider3D* Collider3D::FromBody(const JPH::Body& body, const JPH::SubShapeID& subShape)
+{
+	if (body.GetUserData() != 0)
+		return reinterpret_cast<Collider3D*>(body.GetUserData());
+
+	// find() instead of [] so worker threads never insert into the map
+	auto it = Rigidbody3D::colliderMap.find(static_cast<uint32_t>(body.GetShape()->GetSubShapeUserData(subShape)));
+	return it != Rigidbody3D::colliderMap.end() ? it->second : nullptr;
+}
+
+#if !defined(EDITOR)
+void Collider3D::CreateOwnBody()
+{
+	Vector3 goPosition = gameObject->transform.GetPosition() + offset;
+	Quaternion goRotation = gameObject->transform.GetRotation();
+	JPH::BodyCreationSettings bodySettings(joltShape, { goPosition.x, goPosition.y, goPosition.z }, { goRotation.x, goRotation.y, goRotation.z, goRotation.w }, JPH::EMotionType::Static, GetObjectLayer());
+	bodySettings.mGravityFactor = 0;
+	bodySettings.mIsSensor = trigger;
+	bodySettings.mMotionQuality = (continuousDetection ? JPH::EMotionQuality::LinearCast : JPH::EMotionQuality::Discrete);
+	bodySettings.mUserData = reinterpret_cast<uint64_t>(this);
+	body = Rigidbody3D::bodyInterface->CreateBody(bodySettings);
+	Rigidbody3D::AddBody(body, JPH::EActivation::Activate);
+	gameObject->hasPhysicsBody = true;
+	ownBody = true;
+}
+
+JPH::ObjectLayer Collider3D::GetObjectLayer()
+{
+	return Layers::Get(layer, trigger ? Layers::SENSOR : Layers::NON_MOVING);
+}
+
+void Collider3D::BeginStaticMerge()
+{
+	collectingStaticColliders = mergeStaticColliders;
+}
+
+void Collider3D::MergeStaticColliders()
+{
+	collectingStaticColliders = false;
+
+	// Groups the colliders by the region of the XZ grid they're in and their collision layer, since a body only has one layer
+	for (Collider3D* collider : pendingStaticColliders)
+	{
+		Vector3 position = collider->gameObject->transform.GetPosition() + collider->offset;
+		int64_t cellX = static_cast<int64_t>(std::floor(position.x / mergeRegionSize));
+		int64_t cellZ = static_cast<int64_t>(std::floor(position.z / mergeRegionSize));
+		int64_t key = (cellX << 37) | (static_cast<int64_t>(static_cast<uint32_t>(cellZ)) << 5) | collider->layer;
+
+		collider->pendingMerge = false;
+		collider->merged = true;
+		collider->staticBatchKey = key;
+		staticBatches[key].colliders.push_back(collider);
+	}
+	pendingStaticColliders.clear();
+
+	std::vector<int64_t> keys;
+	keys.reserve(staticBatches.size());
+	for (auto& [key, batch] : staticBatches)
+		keys.push_back(key);
+	for (int64_t key : keys)
+		RebuildStaticBatch(key);
+}
+
+void Collider3D::UpdateStaticBatches()
+{
+	for (int64_t key : dirtyStaticBatches)
+		RebuildStaticBatch(key);
+	dirtyStaticBatches.clear();
+}
+
+void Collider3D::RebuildStaticBatch(int64_t key)
+{
+	auto it = staticBatches.find(key);
+	if (it == staticBatches.end())
+		return;
+
+	StaticBatch& batch = it->second;
+	if (batch.body)
+	{
+		Rigidbody3D::RemoveBody(batch.body);
+		Rigidbody3D::bodyInterface->DestroyBody(batch.body->GetID());
+		batch.body = nullptr;
+	}
+
+	// A compound of one shape isn't worth it, and Jolt turns it into a RotatedTranslatedShape without the sub shape's user data
+	if (batch.colliders.size() < 2)
+	{
+		for (Collider3D* collider : batch.colliders)
+		{
+			collider->merged = false;
+			collider->CreateOwnBody();
+		}
+		staticBatches.erase(it);
+		return;
+	}
+
+	// Sub shapes are placed relative to the first collider so the compound's coordinates stay small
+	Vector3 origin = batch.colliders[0]->gameObject->transform.GetPosition() + batch.colliders[0]->offset;
+	JPH::StaticCompoundShapeSettings compoundSettings;
+	for (Collider3D* collider : batch.colliders)
+	{
+		Vector3 position = collider->gameObject->transform.GetPosition() + collider->offset - origin;
+		Quaternion rotation = collider->gameObject->transform.GetRotation();
+		compoundSettings.AddShape({ position.x, position.y, position.z }, { rotation.x, rotation.y, rotation.z, rotation.w }, collider->joltShape, collider->id);
+		Rigidbody3D::colliderMap[collider->id] = collider;
+	}
+
+	JPH::ShapeSettings::ShapeResult result = compoundSettings.Create();
+	if (result.HasError())
+	{
+		ConsoleLogger::WarningLog("Failed to merge static colliders: " + std::string(result.GetError().c_str()));
+		for (Collider3D* collider : batch.colliders)
+		{
+			collider->merged = false;
+			collider->CreateOwnBody();
+		}
+		staticBatches.erase(it);
+		return;
+	}
+
+	// User data is left at 0 so contacts look the collider up by the sub shape, the same as colliders on a Rigidbody3D
+	JPH::BodyCreationSettings bodySettings(result.Get(), { origin.x, origin.y, origin.z }, JPH::Quat::sIdentity(), JPH::EMotionType::Static, batch.colliders[0]->GetObjectLayer());
+	bodySettings.mGravityFactor = 0;
+	batch.body = Rigidbody3D::bodyInterface->CreateBody(bodySettings);
+	Rigidbody3D::AddBody(batch.body, JPH::EActivation::DontActivate);
+
+	for (Collider3D* collider : batch.colliders)
+	{
+		collider->body = batch.body;
+		collider->ownBody = false;
+	}
+}
+
+void Collider3D::LeaveStaticBatch()
+{
+	merged = false;
+	body = nullptr;
+	Rigidbody3D::colliderMap.erase(id);
+
+	auto it = staticBatches.find(staticBatchKey);
+	if (it == staticBatches.end())
+		return;
+
+	StaticBatch& batch = it->second;
+	batch.colliders.erase(std::remove(batch.colliders.begin(), batch.colliders.end(), this), batch.colliders.end());
+	if (!batch.colliders.empty())
+	{
+		// Rebuilt once per physics step however many colliders leave it
+		dirtyStaticBatches.insert(staticBatchKey);
+		return;
+	}
+
+	if (batch.body)
+	{
+		Rigidbody3D::RemoveBody(batch.body);
+		Rigidbody3D::bodyInterface->DestroyBody(batch.body->GetID());
+	}
+	dirtyStaticBatches.erase(staticBatchKey);
+	staticBatches.erase(it);
+}
+#endif
+
 void Collider3D::Start()
 {
 #if !defined(EDITOR)
-	if (body)
+	if (body || pendingMerge)
 		return;
 
+	layer = CollisionLayers::GetLayer(collisionLayer);
+	if (layer == -1)
+	{
+		ConsoleLogger::WarningLog("The Collider3D on " + gameObject->GetName() + " uses the collision layer \"" + collisionLayer + "\", which doesn't exist. It will use Default instead.");
+		layer = 0;
+	}
+
 	// Putting this in Start() instead of Awake() to ensure the rigidbody component gets set up first
 
 	Rigidbody3D* rb = gameObject->GetComponent<Rigidbody3D>();
-	if (!trigger && rb != nullptr && rb->IsActive() && rb->gameObject->IsActive() && rb->gameObject->IsGlobalActive())
+	if (!trigger && shape != Terrain && rb != nullptr && rb->IsActive() && rb->gameObject->IsActive() && rb->gameObject->IsGlobalActive())
 		SetRigidbody(rb);
 	else
 	{
 		//fixtureDef.density = rb->GetMass();
 		//fixtureDef.friction = 0.3f;
 		CreateShape();
-		Vector3 goPosition = gameObject->transform.GetPosition() + offset;
-		Quaternion goRotation = gameObject->transform.GetRotation();
 		if (joltShape == nullptr)
 			return;
 
-		JPH::BodyCreationSettings bodySettings(joltShape, { goPosition.x, goPosition.y, goPosition.z }, { goRotation.x, goRotation.y, goRotation.z, goRotation.w }, JPH::EMotionType::Static, 0); // Last parameter is the layer
-		bodySettings.mGravityFactor = 0;
-		bodySettings.mIsSensor = trigger;
-		bodySettings.mMotionQuality = (continuousDetection ? JPH::EMotionQuality::LinearCast : JPH::EMotionQuality::Discrete);
-		bodySettings.mUserData = reinterpret_cast<uint64_t>(this);
-		body = Rigidbody3D::bodyInterface->CreateBody(bodySettings);
-		Rigidbody3D::bodyInterface->AddBody(body->GetID(), JPH::EActivation::Activate);
+		// Static colliders started with the scene are merged into their region's body by MergeStaticColliders() once they all have
+		if (collectingStaticColliders && !trigger && shape != Terrain)
+		{
+			gameObject->hasPhysicsBody = true; // So moving it is noticed once it's merged
+			pendingStaticColliders.push_back(this);
+			pendingMerge = true;
+			return;
+		}
 
-		ownBody = true;
+		CreateOwnBody();
 	}
 	SetTrigger(trigger);
 #endif
@@ -162,46 +576,41 @@ void Collider3D::Start()
 void Collider3D::FixedUpdate()
 {
 #if !defined(EDITOR)
-	if (!ownBody)
-		return;
-
-	// Todo: Use SetPositionAndRotation() when possible
-	
-	// Update position if the game object has moved
-	Vector3 position = gameObject->transform.GetPosition();
-	if (lastGOPosition != position)
-	{
-		// Update physics body position (with offset if needed)
-		Rigidbody3D::bodyInterface->SetPosition(body->GetID(), { position.x + offset.x, position.y + offset.y, position.z + offset.z }, JPH::EActivation::DontActivate);
-		lastGOPosition = position;
-	}
-
-	// Update rotation if the game object has rotated
-	Quaternion rotation = gameObject->transform.GetRotation();
-	if (lastGORotation != rotation)
-	{
-		// Update physics body rotation (correct method: SetRotation)
-		Rigidbody3D::bodyInterface->SetRotation(body->GetID(), { rotation.x, rotation.y, rotation.z, rotation.w }, JPH::EActivation::DontActivate);
-		lastGORotation = rotation;
+	if (ownBody && shape == Terrain)
+		UpdateTerrainShape();
+#endif
 }
 
-	// Update the game object's position if the physics body moved
-	JPH::Vec3 physicsPosition = Rigidbody3D::bodyInterface->GetPosition(body->GetID());
-	if (lastPhysicsPosition != physicsPosition)
+#if !defined(EDITOR)
+void Collider3D::SyncTransform()
+{
+	// The scale is baked into the shape, so a scaled game object needs a new one
+	Vector3 scale = gameObject->transform.GetScale();
+	if (scale.x != shapeScale.x || scale.y != shapeScale.y || scale.z != shapeScale.z)
 	{
-		gameObject->transform.SetPosition({ physicsPosition.GetX() - offset.x, physicsPosition.GetY() - offset.y, physicsPosition.GetZ() - offset.z});
-		lastPhysicsPosition = physicsPosition;
+		CreateShape();
+		if (ownBody)
+			Rigidbody3D::bodyInterface->SetShape(body->GetID(), joltShape, true, JPH::EActivation::DontActivate);
+		else if (rb && !merged)
+			rb->UpdateShape(this);
 	}
 
-	// Update the game object's rotation if the physics body rotated
-	JPH::Quat physicsRotation = Rigidbody3D::bodyInterface->GetRotation(body->GetID());
-	if (lastPhysicsRotation != physicsRotation)
+	// A merged collider's region body can't move, so it takes its own body again once its game object does
+	if (merged)
 	{
-		gameObject->transform.SetRotation({ physicsRotation.GetX(), physicsRotation.GetY(), physicsRotation.GetZ(), physicsRotation.GetW() });
-		lastPhysicsRotation = physicsRotation;
+		LeaveStaticBatch();
+		CreateOwnBody();
+		return;
 	}
-#endif
+
+	if (!ownBody)
+		return;
+
+	Vector3 position = gameObject->transform.GetPosition() + offset;
+	Quaternion rotation = gameObject->transform.GetRotation();
+	Rigidbody3D::bodyInterface->SetPositionAndRotation(body->GetID(), { position.x, position.y, position.z }, { rotation.x, rotation.y, rotation.z, rotation.w }, JPH::EActivation::DontActivate);
 }
+#endif
 
 void Collider3D::Highlight(Color color, bool highlightChildren)
 {
@@ -277,24 +686,40 @@ void Collider3D::EditorUpdate()
 void Collider3D::Destroy()
 {
 #if !defined(EDITOR)
+	CollisionListener3D::RemoveCollider(this);
+
+	if (pendingMerge)
+	{
+		pendingStaticColliders.erase(std::remove(pendingStaticColliders.begin(), pendingStaticColliders.end(), this), pendingStaticColliders.end());
+		pendingMerge = false;
+	}
+
+	if (merged)
+		LeaveStaticBatch();
+
 	if (!body)
+	{
+		ShapeCache::Release(joltShape);
 		return;
+	}
 
-	const JPH::BodyID& bodyID = ownBody ? body->GetID() : rb->body->GetID();
+	JPH::Body* removedBody = ownBody ? body : rb->body;
+	const JPH::BodyID bodyID = removedBody->GetID();
 
-	Rigidbody3D::bodyInterface->RemoveBody(bodyID);
+	Rigidbody3D::RemoveBody(removedBody);
 	Rigidbody3D::bodyInterface->DestroyBody(bodyID);
+	ShapeCache::Release(joltShape);
 #endif
 }
 
 void Collider3D::Enable()
 {
 #if !defined(EDITOR)
-	if (!body) // This is needed since the body is set in Start(), and Enable() runs before Start()
+	if (!body || merged) // This is needed since the body is set in Start(), and Enable() runs before Start()
 		return;
 
 	if (ownBody)
-		Rigidbody3D::bodyInterface->AddBody(body->GetID(), JPH::EActivation::Activate);
+		Rigidbody3D::AddBody(body, JPH::EActivation::Activate);
 	else
 		rb->AddCollider(this);
 #endif
@@ -303,8 +728,23 @@ void Collider3D::Enable()
 void Collider3D::Disable()
 {
 #if !defined(EDITOR)
+	// Taking its own body lets Enable() add it back like any other static collider
+	if (pendingMerge)
+	{
+		pendingStaticColliders.erase(std::remove(pendingStaticColliders.begin(), pendingStaticColliders.end(), this), pendingStaticColliders.end());
+		pendingMerge = false;
+		CreateOwnBody();
+	}
+	else if (merged)
+	{
+		LeaveStaticBatch();
+		CreateOwnBody();
+	}
+	else if (!body)
+		return;
+
 	if (ownBody)
-		Rigidbody3D::bodyInterface->RemoveBody(body->GetID());
+		Rigidbody3D::RemoveBody(body);
 	else
 		rb->RemoveCollider(this);
 #endif
@@ -313,11 +753,13 @@ void Collider3D::Disable()
 void Collider3D::SetRigidbody(Rigidbody3D* rigidbody)
 {
 #if !defined(EDITOR)
-	if (body)
+	if (merged)
+		LeaveStaticBatch();
+	else if (body)
 	{
 		if (ownBody)
 		{
-			Rigidbody3D::bodyInterface->RemoveBody(body->GetID());
+			Rigidbody3D::RemoveBody(body);
 			Rigidbody3D::bodyInterface->DestroyBody(body->GetID());
 			ownBody = false;
 		}
@@ -346,7 +788,7 @@ void Collider3D::RemoveRigidbody()
 
 	if (ownBody)
 	{
-		Rigidbody3D::bodyInterface->RemoveBody(body->GetID());
+		Rigidbody3D::RemoveBody(body);
 		Rigidbody3D::bodyInterface->DestroyBody(body->GetID());
 		ownBody = false;
 	}
@@ -366,16 +808,7 @@ void Collider3D::RemoveRigidbody()
 	//bodyDef.type = b2_staticBody;
 	//bodyDef.position.Set(gameObject->transform.GetPosition().x, gameObject->transform.GetPosition().y);
 	//body = world->CreateBody(&bodyDef);
-	Vector3 goPosition = gameObject->transform.GetPosition() + offset;
-	Quaternion goRotation = gameObject->transform.GetRotation();
-	JPH::BodyCreationSettings bodySettings(joltShape, { goPosition.x, goPosition.y, goPosition.z }, { goRotation.x, goRotation.y, goRotation.z, goRotation.w }, JPH::EMotionType::Static, Layers::NON_MOVING);
-	bodySettings.mGravityFactor = 0;
-	bodySettings.mIsSensor = trigger;
-	bodySettings.mMotionQuality = (continuousDetection ? JPH::EMotionQuality::LinearCast : JPH::EMotionQuality::Discrete);
-	bodySettings.mUserData = reinterpret_cast<uint64_t>(this);
-	body = Rigidbody3D::bodyInterface->CreateBody(bodySettings);
-	Rigidbody3D::bodyInterface->AddBody(body->GetID(), JPH::EActivation::Activate);
-	ownBody = true;
+	CreateOwnBody();
 
 	// Setting the density and friction in case a Rigidbody3D is added to the game object
 	//fixtureDef.density = 1.0f;
@@ -414,13 +847,69 @@ void Collider3D::SetTrigger(bool value)
 	if (!body)
 		return;
 
-	if (ownBody)
+	if (merged)
+	{
+		// Triggers aren't merged
+		LeaveStaticBatch();
+		CreateOwnBody();
+	}
+	else if (ownBody)
+	{
 		body->SetIsSensor(trigger);
+		Rigidbody3D::bodyInterface->SetObjectLayer(body->GetID(), GetObjectLayer());
+	}
 	else
 		RemoveRigidbody();
 #endif
 }
 
+void Collider3D::SetCollisionLayer(int layer)
+{
+#if !defined(EDITOR)
+	if (layer < 0 || layer >= CollisionLayers::GetLayerCount())
+	{
+		ConsoleLogger::WarningLog("Failed to set the collision layer of " + gameObject->GetName() + "'s Collider3D. There's no layer " + std::to_string(layer) + ".");
+		return;
+	}
+
+	this->layer = layer;
+	collisionLayer = CollisionLayers::GetLayerName(layer);
+	if (!body)
+		return;
+
+	if (merged)
+	{
+		// The region's body is on the old layer
+		LeaveStaticBatch();
+		CreateOwnBody();
+	}
+	else if (ownBody)
+		Rigidbody3D::bodyInterface->SetObjectLayer(body->GetID(), GetObjectLayer());
+#endif
+}
+
+void Collider3D::SetCollisionLayer(std::string name)
+{
+#if !defined(EDITOR)
+	int layer = CollisionLayers::GetLayer(name);
+	if (layer == -1)
+	{
+		ConsoleLogger::WarningLog("Failed to set the collision layer of " + gameObject->GetName() + "'s Collider3D. There's no layer named \"" + name + "\".");
+		return;
+	}
+	SetCollisionLayer(layer);
+#endif
+}
+
+int Collider3D::GetCollisionLayer()
+{
+#if !defined(EDITOR)
+	return layer;
+#else
+	return 0;
+#endif
+}
+
 bool Collider3D::IsTrigger()
 {
 #if !defined(EDITOR)
@@ -437,7 +926,12 @@ void Collider3D::SetOffset(Vector3 offset)
 	exposedVariables[1][2][2] = { offset.x, offset.y, offset.z };
 #else
 	CreateShape();
-	if (ownBody)
+	if (merged)
+	{
+		LeaveStaticBatch();
+		CreateOwnBody();
+	}
+	else if (ownBody)
 	{
 		Vector3 goPosition = gameObject->transform.GetPosition();
 		Rigidbody3D::bodyInterface->SetPosition(body->GetID(), { goPosition.x + offset.x, goPosition.y + offset.y, goPosition.z + offset.z }, JPH::EActivation::DontActivate);
@@ -457,7 +951,12 @@ void Collider3D::SetSize(Vector3 size)
 	this->size = size;
 #if !defined(EDITOR)
 	CreateShape();
-	if (ownBody)
+	if (merged)
+	{
+		LeaveStaticBatch();
+		CreateOwnBody();
+	}
+	else if (ownBody)
 		Rigidbody3D::bodyInterface->SetShape(body->GetID(), joltShape, true, JPH::EActivation::DontActivate);
 	else
 		rb->UpdateShape(this);
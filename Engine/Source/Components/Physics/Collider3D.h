@@ -13,10 +13,15 @@
 #include "ThirdParty/Jolt/Physics/Collision/Shape/CompoundShape.h"
 #include "ThirdParty/Jolt/Geometry/Plane.h"
 #include "ThirdParty/Jolt/Physics/Collision/Shape/PlaneShape.h"
+#include "ThirdParty/Jolt/Physics/Collision/Shape/HeightFieldShape.h"
 #include "ThirdParty/Jolt/Physics/Body/BodyCreationSettings.h"
 #include "ThirdParty/Jolt/Physics/Body/BodyActivationListener.h"
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 class Rigidbody3D;
+class Terrain;
 
 class Collider3D : public Component {
 public:
@@ -32,7 +37,10 @@ public:
         Sphere,
         Plane,
         Cylinder,
-        Cone
+        Cone,
+        Terrain, // A height field built from the game object's Terrain. Always static, so it's never attached to a Rigidbody3D.
+        Mesh, // The MeshRenderer's triangles. Only collides properly on static and kinematic bodies, use ConvexHull for dynamic ones.
+        ConvexHull // The convex hull around the MeshRenderer's vertices
     };
 
     // Hide in API
@@ -42,6 +50,19 @@ public:
     // Hide in API
     void RemoveRigidbody();
 
+    // Static colliders that start with the scene are merged into one body per mergeRegionSize square of the XZ plane and collision layer, which keeps the broad phase small.
+    // A merged collider takes its own body again when it's moved, resized, disabled, or made a trigger.
+    static bool mergeStaticColliders;
+    static float mergeRegionSize;
+#if !defined(EDITOR)
+    // Hide in API
+    static void BeginStaticMerge();
+    // Hide in API
+    static void MergeStaticColliders();
+    // Hide in API
+    static void UpdateStaticBatches();
+#endif
+
     void Start() override;
     void FixedUpdate() override;
     void EditorUpdate() override;
@@ -49,6 +70,16 @@ public:
     void Enable() override;
     void Disable() override;
 
+#if !defined(EDITOR)
+    // Hide in API
+    // Moves the collider's own body to its game object and rebuilds the shape if the game object was scaled. Called by Rigidbody3D::SyncMovedTransforms() only for game objects that moved.
+    void SyncTransform();
+#endif
+    // Hide in API
+    // The collider a contact or query hit. Bodies shared by several colliders, like a Rigidbody3D's or a merged region's, are looked up by the sub shape.
+    // Safe to call from Jolt's worker threads. Returns nullptr for bodies without a collider.
+    static Collider3D* FromBody(const JPH::Body& body, const JPH::SubShapeID& subShape);
+
     Shape GetShape();
     void SetTrigger(bool value);
     bool IsTrigger();
@@ -56,6 +87,10 @@ public:
     Vector3 GetOffset();
     void SetSize(Vector3 size);
     Vector3 GetSize();
+    // Only used by colliders with their own body. Colliders on a Rigidbody3D collide as the rigidbody's layer.
+    void SetCollisionLayer(int layer);
+    void SetCollisionLayer(std::string name);
+    int GetCollisionLayer();
 
     // Hide in API
 #if defined(EDITOR)
@@ -70,14 +105,40 @@ private:
     bool trigger;
     Vector3 offset;
     Vector3 size = { 1, 1 };
+    Vector3 shapeScale = { 1, 1, 1 }; // The game object's scale when the shape was created
     bool continuousDetection;
-    Vector3 lastGOPosition;
-    Quaternion lastGORotation;
-    JPH::Vec3 lastPhysicsPosition;
-    JPH::Quat lastPhysicsRotation;
+    std::string collisionLayer = "Default"; // The layer's name, so scenes keep working when layers are reordered
+    int layer = 0;
 
     void CreateShape();
+    void CreateTerrainShape();
+    void UpdateTerrainShape();
 
     JPH::Body* body = nullptr;
     bool ownBody = false;
+
+    bool merged = false;
+    bool pendingMerge = false;
+    int64_t staticBatchKey = 0;
+
+#if !defined(EDITOR)
+    struct StaticBatch
+    {
+        std::vector<Collider3D*> colliders;
+        JPH::Body* body = nullptr;
+    };
+
+    void CreateOwnBody();
+    JPH::ObjectLayer GetObjectLayer();
+    void LeaveStaticBatch();
+    static void RebuildStaticBatch(int64_t key);
+
+    static bool collectingStaticColliders;
+    static std::vector<Collider3D*> pendingStaticColliders;
+    static std::unordered_map<int64_t, StaticBatch> staticBatches;
+    static std::unordered_set<int64_t> dirtyStaticBatches;
+#endif
+
+    ::Terrain* terrain = nullptr;
+    JPH::Ref<JPH::HeightFieldShape> heightField; // Same shape as joltShape, kept mutable so sculpting can update its heights in place
 };
\ No newline at end of file
@@ -70,9 +70,6 @@ Rigidbody2D::Rigidbody2D(GameObject* obj, int id) : Component(obj, id) {
 void Rigidbody2D::Awake()
 {
 #if !defined(EDITOR)
-    lastGameObjectPosition = gameObject->transform.GetPosition();
-    lastGameObjectRotation = gameObject->transform.GetRotation();
-
     b2BodyDef bodyDef;
     // Todo: Change this to a switch case
     if (bodyType == Dynamic)
@@ -82,7 +79,10 @@ void Rigidbody2D::Awake()
     else
         bodyDef.type = b2_staticBody;
     bodyDef.position.Set(gameObject->transform.GetPosition().x, gameObject->transform.GetPosition().y);
+    bodyDef.angle = DEG2RAD * gameObject->transform.GetRotationEuler().z;
+    bodyDef.userData.pointer = reinterpret_cast<uintptr_t>(this);
     body = world->CreateBody(&bodyDef);
+    gameObject->hasPhysicsBody = true;
 
     SetGravityScale(gravityScale);
     SetContinuous(continuousDetection);
@@ -289,70 +289,67 @@ float Rigidbody2D::GetAngularDamping()
 #endif
 }
 
-void Rigidbody2D::FixedUpdate() // Todo: This most likely needs to be updated like Rigidbody3D to ensure physics & setting the game object's transform work together. This needs to be done in Collider2D too
+void Rigidbody2D::FixedUpdate()
 {
     // Todo: Check if the game object or component is enabled/disabled, if it is then body->SetActive()
 #if !defined(EDITOR)
+    // Transforms are synced for every body at once by SyncMovedTransforms() and SyncAwakeBodies()
     if (bodyType != oldBodyType)
         SetBodyType(bodyType);
 
-    // Todo: Change this to a switch case
-    if (bodyType == Dynamic)
-    {
-        // Todo: Change this to if-else and make one checking if they were both changed
-        // Todo: This will update the body's rotation and position when it doesn't need to.
-        if (gameObject->transform.GetPosition() == lastGameObjectPosition) // Todo: This shouldn't be setting the gameobject's position even when the body hasn't changed
-            gameObject->transform.SetPosition({ body->GetPosition().x, body->GetPosition().y, 0 });
-        else if (gameObject->transform.GetPosition().x != body->GetTransform().p.x || gameObject->transform.GetPosition().y != body->GetTransform().p.y)
-        {
-            body->SetAwake(true);
-            body->SetTransform({ gameObject->transform.GetPosition().x, gameObject->transform.GetPosition().y }, body->GetAngle());
-        }
+    oldBodyType = bodyType;
+#endif
+}
 
-        if (gameObject->transform.GetRotation() == lastGameObjectRotation) // Todo: This shouldn't be setting the gameobject's rotation even when the body hasn't changed
-            gameObject->transform.SetRotationEuler({ 0, body->GetAngle() * RAD2DEG, 0 });
-        else if (DEG2RAD * gameObject->transform.GetRotation().y != body->GetTransform().q.GetAngle())
+#if !defined(EDITOR)
+void Rigidbody2D::SyncMovedTransforms()
+{
+    for (GameObject* gameObject : GameObject::movedPhysicsObjects)
+    {
+        gameObject->physicsMoved = false;
+        for (Component* component : gameObject->GetComponents())
         {
-            body->SetAwake(true);
-            body->SetTransform(body->GetPosition(), DEG2RAD * gameObject->transform.GetRotationEuler().z);
+            if (Collider2D* collider = dynamic_cast<Collider2D*>(component))
+                collider->SyncScale();
         }
+        if (Rigidbody2D* rigidbody = gameObject->GetComponent<Rigidbody2D>())
+            rigidbody->SyncTransform();
     }
-    else if (bodyType == Kinematic)
-    {
-        // Todo: Change this to if-else and make one checking if they were both changed
-        if (gameObject->transform.GetPosition() != lastGameObjectPosition) // Todo: This shouldn't be setting the gameobject's position even when the body hasn't changed
-            body->SetTransform({ gameObject->transform.GetPosition().x, gameObject->transform.GetPosition().y }, body->GetAngle());
-
-        //if (gameObject->transform.GetRotation() != lastGameObjectRotation || DEG2RAD * gameObject->transform.GetRotation().y != body->GetTransform().q.GetAngle())
-        if (gameObject->transform.GetRotation() != lastGameObjectRotation)
-            body->SetTransform(body->GetPosition(), DEG2RAD * gameObject->transform.GetRotation().y);
-
-        //if (gameObject->transform.GetPosition() == lastGameObjectPosition) // Todo: This shouldn't be setting the gameobject's position even when the body hasn't changed
-        //    gameObject->transform.SetPosition({ body->GetPosition().x, body->GetPosition().y, 0 });
-        //else if (gameObject->transform.GetPosition().x != body->GetTransform().p.x || gameObject->transform.GetPosition().y != body->GetTransform().p.y)
-        //    body->SetTransform({ gameObject->transform.GetPosition().x, gameObject->transform.GetPosition().y }, body->GetAngle());
-
-        //if (gameObject->transform.GetRotation() == lastGameObjectRotation) // Todo: This shouldn't be setting the gameobject's rotation even when the body hasn't changed
-        //    gameObject->transform.SetRotationEuler({ 0, body->GetAngle() * RAD2DEG, 0 });
-        //else if (DEG2RAD * gameObject->transform.GetRotation().y != body->GetTransform().q.GetAngle())
-        //    body->SetTransform(body->GetPosition(), DEG2RAD * gameObject->transform.GetRotationEuler().z);
-    }
-    else if (bodyType == Static)
+    GameObject::movedPhysicsObjects.clear();
+}
+
+void Rigidbody2D::SyncAwakeBodies()
+{
+    // Sleeping bodies haven't moved, so they're skipped without touching their game object.
+    // A body that fell asleep during the step moved before it did, so it's synced once more.
+    for (b2Body* body = world->GetBodyList(); body; body = body->GetNext())
     {
-        if (gameObject->transform.GetPosition() != lastGameObjectPosition)
-            body->SetTransform({ gameObject->transform.GetPosition().x, gameObject->transform.GetPosition().y }, body->GetAngle());
-            //gameObject->transform.SetPosition(lastGameObjectPosition);
-        if (gameObject->transform.GetRotation() != lastGameObjectRotation)
-            body->SetTransform(body->GetPosition(), DEG2RAD * gameObject->transform.GetRotation().y);
-            //gameObject->transform.SetRotation(lastGameObjectRotation);
+        if (body->GetType() != b2_dynamicBody || body->GetUserData().pointer == 0)
+            continue;
+
+        Rigidbody2D* rigidbody = reinterpret_cast<Rigidbody2D*>(body->GetUserData().pointer);
+        bool awake = body->IsAwake();
+        if (!awake && !rigidbody->wasAwake)
+            continue;
+
+        rigidbody->wasAwake = awake;
+        Vector3 position = rigidbody->gameObject->transform.GetPosition();
+        rigidbody->gameObject->transform.SetPhysicsTransform({ body->GetPosition().x, body->GetPosition().y, position.z }, EulerToQuaternion(0, 0, body->GetAngle()));
     }
+}
 
-    lastGameObjectPosition = gameObject->transform.GetPosition();
-    lastGameObjectRotation = gameObject->transform.GetRotation();
+void Rigidbody2D::SyncTransform()
+{
+    if (!body)
+        return;
 
-    oldBodyType = bodyType;
-#endif
+    // The body's angle is the game object's Z rotation, the same one sprites are drawn with
+    Vector3 position = gameObject->transform.GetPosition();
+    body->SetTransform({ position.x, position.y }, DEG2RAD * gameObject->transform.GetRotationEuler().z);
+    if (bodyType == Dynamic)
+        body->SetAwake(true);
 }
+#endif
 
 void Rigidbody2D::Destroy()
 {
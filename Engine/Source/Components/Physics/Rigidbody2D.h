@@ -47,6 +47,15 @@ public:
     // Hide in API
     std::deque<Collider2D*> colliders;
 
+#if !defined(EDITOR)
+    // Hide in API
+    // Moves the bodies of game objects whose transform was set since the last step. Called before each physics step.
+    static void SyncMovedTransforms();
+    // Hide in API
+    // Moves the game objects of the dynamic bodies that are awake or fell asleep during the step. Called after each physics step.
+    static void SyncAwakeBodies();
+#endif
+
     // Hide in API
 #if !defined(EDITOR)
     b2Body* body = nullptr;
@@ -58,8 +67,9 @@ private:
     float linearDamping = 0.0f;
     float angularDamping = 0.0f;
 
-    Vector3 lastGameObjectPosition;
-    Quaternion lastGameObjectRotation;
     BodyType oldBodyType;
+    bool wasAwake = true; // Whether the body was awake when SyncAwakeBodies() last ran
+
+    void SyncTransform();
 #endif
 };
@@ -1,5 +1,6 @@
 #include "Rigidbody3D.h"
 #include <cstdint>
+#include <algorithm>
 #if !defined(EDITOR)
 // Todo: Remove unnecessary includes.
 #include "Game.h"
@@ -12,8 +13,15 @@
 #include "ThirdParty/Jolt/Physics/Body/BodyCreationSettings.h"
 #include "ThirdParty/Jolt/Physics/Body/BodyActivationListener.h"
 
+JPH::PhysicsSystem* Rigidbody3D::physicsSystem = nullptr;
 JPH::BodyInterface* Rigidbody3D::bodyInterface = nullptr;
 const JPH::BodyLockInterface* Rigidbody3D::bodyLockInterface = nullptr;
+bool Rigidbody3D::batchingBodies = false;
+std::vector<Rigidbody3D*> Rigidbody3D::bodyRigidbodies;
+std::vector<JPH::BodyID> Rigidbody3D::pendingBodies[2];
+Rigidbody3D::ActivationListener Rigidbody3D::activationListener;
+std::mutex Rigidbody3D::deactivatedBodiesMutex;
+std::vector<JPH::BodyID> Rigidbody3D::deactivatedBodies;
 #endif
 
 std::unordered_map<uint32_t, Collider3D*> Rigidbody3D::colliderMap;
@@ -67,6 +75,12 @@ Rigidbody3D::Rigidbody3D(GameObject* obj, int id) : Component(obj, id) {
                     "continuousDetection",
                     false,
                     "Continuous Detection"
+                ],
+                [
+                    "string",
+                    "collisionLayer",
+                    "Default",
+                    "Collision Layer"
                 ]
             ]
         ]
@@ -78,25 +92,26 @@ Rigidbody3D::Rigidbody3D(GameObject* obj, int id) : Component(obj, id) {
 void Rigidbody3D::Awake()
 {
 #if !defined(EDITOR)
-    lastGOPosition = gameObject->transform.GetPosition();
-    lastGORotation = gameObject->transform.GetRotation();
     oldBodyType = bodyType;
-    JPH::ObjectLayer layer;
+
+    layer = CollisionLayers::GetLayer(collisionLayer);
+    if (layer == -1)
+    {
+        ConsoleLogger::WarningLog("The Rigidbody3D on " + gameObject->GetName() + " uses the collision layer \"" + collisionLayer + "\", which doesn't exist. It will use Default instead.");
+        layer = 0;
+    }
 
     JPH::EMotionType eMotionType;
 
     switch (bodyType) {
         case Dynamic:
             eMotionType = JPH::EMotionType::Dynamic;
-            layer = Layers::MOVING;
             break;
         case Kinematic:
             eMotionType = JPH::EMotionType::Kinematic;
-            layer = Layers::MOVING;
             break;
         default:
             eMotionType = JPH::EMotionType::Static;
-            layer = Layers::NON_MOVING;
             break;
     }
 
@@ -106,14 +121,19 @@ void Rigidbody3D::Awake()
     JPH::EmptyShapeSettings emptyShape;
     compoundSettings.AddShape({ 0,0,0 }, { 0,0,0,1 }, emptyShape.Create().Get());
     compoundShape = static_cast<JPH::MutableCompoundShape*>(compoundSettings.Create().Get().GetPtr());
-    JPH::BodyCreationSettings bodySettings(compoundShape, { goPosition.x, goPosition.y, goPosition.z }, { goRotation.x, goRotation.y, goRotation.z, goRotation.w }, eMotionType, layer); // Last parameter is the layer
+    JPH::BodyCreationSettings bodySettings(compoundShape, { goPosition.x, goPosition.y, goPosition.z }, { goRotation.x, goRotation.y, goRotation.z, goRotation.w }, eMotionType, GetObjectLayer()); // Last parameter is the layer
     bodySettings.mGravityFactor = gravityScale;
     bodySettings.mFriction = friction;
     bodySettings.mMotionQuality = (continuousDetection ? JPH::EMotionQuality::LinearCast : JPH::EMotionQuality::Discrete);
     //bodySettings.mLinearDamping = linearDamping;
     //bodySettings.mLinearVelocity = angularDamping;
     body = bodyInterface->CreateBody(bodySettings);
-    bodyInterface->AddBody(body->GetID(), JPH::EActivation::Activate);
+    AddBody(body, JPH::EActivation::Activate);
+
+    if (bodyRigidbodies.size() <= body->GetID().GetIndex())
+        bodyRigidbodies.resize(body->GetID().GetIndex() + 1, nullptr);
+    bodyRigidbodies[body->GetID().GetIndex()] = this;
+    gameObject->hasPhysicsBody = true;
 
     // Commenting this code since it doesn't work and the hacky fix is in the FixedUpdate()
     //bodyInterface->SetPosition(body->GetID(), { goPosition.x, goPosition.y, goPosition.z }, JPH::EActivation::DontActivate);
@@ -122,10 +142,6 @@ void Rigidbody3D::Awake()
     //JPH::Vec3 physicsPosition = Rigidbody3D::bodyInterface->GetPosition(body->GetID());
     //printf("RigidBody Position: (%f, %f, %f)\n", physicsPosition.GetX(), physicsPosition.GetY(), physicsPosition.GetZ());
     //printf("GameObject Position: (%f, %f, %f)\n", goPosition.x, goPosition.y, goPosition.z);
-
-
-    lastPhysicsPosition = body->GetPosition();
-    lastPhysicsRotation = body->GetRotation();
 #endif
 }
 
@@ -146,13 +162,14 @@ void Rigidbody3D::Enable()
 {
 #if !defined(EDITOR)
     //bodyInterface->AddBody(body->GetID(), JPH::EActivation::Activate);
-    bodyInterface->ActivateBody(body->GetID()); // Todo: When the component is first created, this will activate it despite it already being activated from Awake()
+    if (body->IsInBroadPhase()) // Batched bodies are activated when they're added
+        bodyInterface->ActivateBody(body->GetID()); // Todo: When the component is first created, this will activate it despite it already being activated from Awake()
 #endif
 
     for (Component* component : gameObject->GetComponents())
     {
         Collider3D* collider = dynamic_cast<Collider3D*>(component);
-        if (collider && !collider->IsTrigger())
+        if (collider && !collider->IsTrigger() && collider->GetShape() != Collider3D::Terrain) // Terrain colliders are always static
         {
 #if !defined(EDITOR)
             collider->SetRigidbody(this);
@@ -166,7 +183,8 @@ void Rigidbody3D::Disable()
 {
 #if !defined(EDITOR)
     //bodyInterface->RemoveBody(body->GetID());
-    bodyInterface->DeactivateBody(body->GetID());
+    if (body->IsInBroadPhase())
+        bodyInterface->DeactivateBody(body->GetID());
 #endif
 
     for (Collider3D* collider : colliders)
@@ -177,91 +195,156 @@ void Rigidbody3D::Disable()
 void Rigidbody3D::FixedUpdate()
 {
 #if !defined(EDITOR)
+    // Transforms are synced for every body at once by SyncMovedTransforms() and SyncActiveBodies()
     // Todo: Check if the game object or component is enabled/disabled, if it is then body->SetActive()
     if (bodyType != oldBodyType)
         SetBodyType(bodyType);
 
-    // Use switch-case for body type logic
-    switch (bodyType)
-    {
-    case Dynamic:
-    {
-        // Update position if the game object has moved
-        Vector3 position = gameObject->transform.GetPosition();
-        if (lastGOPosition != position)
-        {
-            // Update physics body position (with offset if needed)
-            Rigidbody3D::bodyInterface->SetPosition(body->GetID(), { position.x, position.y, position.z }, JPH::EActivation::DontActivate);
-            lastGOPosition = position;
-        }
+    oldBodyType = bodyType;
+#endif
+}
 
-        // Update rotation if the game object has rotated
-        Quaternion rotation = gameObject->transform.GetRotation();
-        if (lastGORotation != rotation)
-        {
-            // Update physics body rotation (correct method: SetRotation)
-            Rigidbody3D::bodyInterface->SetRotation(body->GetID(), { rotation.x, rotation.y, rotation.z, rotation.w }, JPH::EActivation::DontActivate);
-            lastGORotation = rotation;
-        }
+void Rigidbody3D::Destroy()
+{
+#if !defined(EDITOR)
+    const JPH::BodyID bodyID = body->GetID();
+    bodyRigidbodies[bodyID.GetIndex()] = nullptr;
+    RemoveBody(body);
+    bodyInterface->DestroyBody(bodyID);
+#endif
+}
 
-        // Update the game object's position if the physics body moved
-        JPH::Vec3 physicsPosition = Rigidbody3D::bodyInterface->GetPosition(body->GetID());
-        if (lastPhysicsPosition != physicsPosition)
-        {
-            gameObject->transform.SetPosition({ physicsPosition.GetX(), physicsPosition.GetY(), physicsPosition.GetZ() });
-            lastPhysicsPosition = physicsPosition;
-        }
+#if !defined(EDITOR)
+void Rigidbody3D::BeginBodyBatch()
+{
+    batchingBodies = true;
+}
 
-        // Update the game object's rotation if the physics body rotated
-        JPH::Quat physicsRotation = Rigidbody3D::bodyInterface->GetRotation(body->GetID());
-        if (lastPhysicsRotation != physicsRotation)
-        {
-            gameObject->transform.SetRotation({ physicsRotation.GetX(), physicsRotation.GetY(), physicsRotation.GetZ(), physicsRotation.GetW() });
-            lastPhysicsRotation = physicsRotation;
-        }
-        break;
-    }
+void Rigidbody3D::EndBodyBatch()
+{
+    batchingBodies = false;
 
-    case Kinematic:
-    case Static:
+    bool added = false;
+    for (int activation = 0; activation < 2; activation++)
     {
-        // Update body if the game object has moved or rotated
-        if (gameObject->transform.GetPosition() != lastGOPosition)
-        {
-            bodyInterface->SetPosition(body->GetID(), { gameObject->transform.GetPosition().x, gameObject->transform.GetPosition().y, gameObject->transform.GetPosition().z }, JPH::EActivation::DontActivate);
-        }
+        std::vector<JPH::BodyID>& bodies = pendingBodies[activation];
+        if (bodies.empty())
+            continue;
+
+        JPH::BodyInterface::AddState state = bodyInterface->AddBodiesPrepare(bodies.data(), static_cast<int>(bodies.size()));
+        bodyInterface->AddBodiesFinalize(bodies.data(), static_cast<int>(bodies.size()), state, static_cast<JPH::EActivation>(activation));
+        bodies.clear();
+        added = true;
+    }
+
+    // Bodies inserted in bulk leave the broad phase's trees unbalanced until they're rebuilt
+    if (added && physicsSystem)
+        physicsSystem->OptimizeBroadPhase();
+}
 
-        if (gameObject->transform.GetRotation() != lastGORotation)
+void Rigidbody3D::SyncMovedTransforms()
+{
+    for (GameObject* gameObject : GameObject::movedPhysicsObjects)
+    {
+        gameObject->physicsMoved = false;
+        for (Component* component : gameObject->GetComponents())
         {
-            Quaternion rotation = gameObject->transform.GetRotation();
-            bodyInterface->SetRotation(body->GetID(), { rotation.x, rotation.y, rotation.z, rotation.w }, JPH::EActivation::DontActivate);
+            if (Rigidbody3D* rigidbody = dynamic_cast<Rigidbody3D*>(component))
+                rigidbody->SyncTransform();
+            else if (Collider3D* collider = dynamic_cast<Collider3D*>(component))
+                collider->SyncTransform();
         }
-        break;
     }
+    GameObject::movedPhysicsObjects.clear();
+}
 
-    default:
-        break;
-    }
+void Rigidbody3D::ActivationListener::OnBodyDeactivated(const JPH::BodyID& inBodyID, JPH::uint64 inBodyUserData)
+{
+    std::lock_guard<std::mutex> lock(deactivatedBodiesMutex);
+    deactivatedBodies.push_back(inBodyID);
+}
 
-    // Update last states after all changes
-    lastGOPosition = gameObject->transform.GetPosition();
-    lastGORotation = gameObject->transform.GetRotation();
-    lastPhysicsPosition = body->GetPosition();
-    lastPhysicsRotation = body->GetRotation();
+void Rigidbody3D::SyncActiveBodies()
+{
+    // Called between steps, so nothing else is touching the bodies and the active list can be read without locking
+    JPH::BodyInterface& noLockInterface = physicsSystem->GetBodyInterfaceNoLock();
+    const JPH::BodyID* activeBodies = physicsSystem->GetActiveBodiesUnsafe(JPH::EBodyType::RigidBody);
+    uint32_t activeBodyCount = physicsSystem->GetNumActiveBodies(JPH::EBodyType::RigidBody);
+    for (uint32_t i = 0; i < activeBodyCount; i++)
+        SyncBody(noLockInterface, activeBodies[i]);
 
-    // Update the oldBodyType after the checks
-    oldBodyType = bodyType;
-#endif
+    // A body that fell asleep during the step moved before it did, and it won't be synced again until it wakes up
+    for (const JPH::BodyID& bodyID : deactivatedBodies)
+        SyncBody(noLockInterface, bodyID);
+    deactivatedBodies.clear();
 }
 
-void Rigidbody3D::Destroy()
+void Rigidbody3D::SyncBody(JPH::BodyInterface& noLockInterface, const JPH::BodyID& bodyID)
 {
-#if !defined(EDITOR)
-    bodyInterface->RemoveBody(body->GetID());
-    bodyInterface->DestroyBody(body->GetID());
-#endif
+    uint32_t index = bodyID.GetIndex();
+    if (index >= bodyRigidbodies.size())
+        return;
+
+    // Kinematic bodies are moved by their game object, not the other way around.
+    // Bodies deactivate when they're removed too, so the ID is compared in case the index was given to another body since.
+    Rigidbody3D* rigidbody = bodyRigidbodies[index];
+    if (!rigidbody || rigidbody->bodyType != Dynamic || rigidbody->body->GetID() != bodyID)
+        return;
+
+    JPH::RVec3 position;
+    JPH::Quat rotation;
+    noLockInterface.GetPositionAndRotation(bodyID, position, rotation);
+    rigidbody->gameObject->transform.SetPhysicsTransform({ position.GetX(), position.GetY(), position.GetZ() }, { rotation.GetX(), rotation.GetY(), rotation.GetZ(), rotation.GetW() });
 }
 
+const std::vector<Rigidbody3D*>& Rigidbody3D::GetBodyRigidbodies()
+{
+    return bodyRigidbodies;
+}
+
+void Rigidbody3D::SyncTransform()
+{
+    if (!body)
+        return;
+
+    Vector3 position = gameObject->transform.GetPosition();
+    Quaternion rotation = gameObject->transform.GetRotation();
+    bodyInterface->SetPositionAndRotation(body->GetID(), { position.x, position.y, position.z }, { rotation.x, rotation.y, rotation.z, rotation.w }, JPH::EActivation::DontActivate);
+}
+
+JPH::ObjectLayer Rigidbody3D::GetObjectLayer()
+{
+    return Layers::Get(layer, bodyType == Static ? Layers::NON_MOVING : Layers::MOVING);
+}
+
+void Rigidbody3D::AddBody(JPH::Body* body, JPH::EActivation activation)
+{
+    if (batchingBodies)
+        pendingBodies[static_cast<int>(activation)].push_back(body->GetID());
+    else
+        bodyInterface->AddBody(body->GetID(), activation);
+}
+
+void Rigidbody3D::RemoveBody(JPH::Body* body)
+{
+    if (body->IsInBroadPhase())
+    {
+        bodyInterface->RemoveBody(body->GetID());
+        return;
+    }
+
+    for (std::vector<JPH::BodyID>& bodies : pendingBodies)
+    {
+        auto it = std::find(bodies.begin(), bodies.end(), body->GetID());
+        if (it != bodies.end())
+        {
+            bodies.erase(it);
+            return;
+        }
+    }
+}
+#endif
+
 
 void Rigidbody3D::SetPosition(Vector3 position)
 {
@@ -337,20 +420,12 @@ void Rigidbody3D::SetBodyType(BodyType bodyType)
     this->bodyType = bodyType;
 
     if (bodyType == Dynamic)
-    {
         bodyInterface->SetMotionType(body->GetID(), JPH::EMotionType::Dynamic, JPH::EActivation::DontActivate);
-        bodyInterface->SetObjectLayer(body->GetID(), Layers::MOVING);
-    }
     else if (bodyType == Kinematic)
-    {
         bodyInterface->SetMotionType(body->GetID(), JPH::EMotionType::Kinematic, JPH::EActivation::DontActivate);
-        bodyInterface->SetObjectLayer(body->GetID(), Layers::MOVING);
-    }
     else
-    {
         bodyInterface->SetMotionType(body->GetID(), JPH::EMotionType::Static, JPH::EActivation::DontActivate);
-        bodyInterface->SetObjectLayer(body->GetID(), Layers::NON_MOVING);
-    }
+    bodyInterface->SetObjectLayer(body->GetID(), GetObjectLayer());
 #endif
 }
 
@@ -428,6 +503,44 @@ float Rigidbody3D::GetFriction()
 #endif
 }
 
+void Rigidbody3D::SetCollisionLayer(int layer)
+{
+#if !defined(EDITOR)
+    if (layer < 0 || layer >= CollisionLayers::GetLayerCount())
+    {
+        ConsoleLogger::WarningLog("Failed to set the collision layer of " + gameObject->GetName() + "'s Rigidbody3D. There's no layer " + std::to_string(layer) + ".");
+        return;
+    }
+
+    this->layer = layer;
+    collisionLayer = CollisionLayers::GetLayerName(layer);
+    if (body)
+        bodyInterface->SetObjectLayer(body->GetID(), GetObjectLayer());
+#endif
+}
+
+void Rigidbody3D::SetCollisionLayer(std::string name)
+{
+#if !defined(EDITOR)
+    int layer = CollisionLayers::GetLayer(name);
+    if (layer == -1)
+    {
+        ConsoleLogger::WarningLog("Failed to set the collision layer of " + gameObject->GetName() + "'s Rigidbody3D. There's no layer named \"" + name + "\".");
+        return;
+    }
+    SetCollisionLayer(layer);
+#endif
+}
+
+int Rigidbody3D::GetCollisionLayer()
+{
+#if !defined(EDITOR)
+    return layer;
+#else
+    return 0;
+#endif
+}
+
 void Rigidbody3D::SetLinearVelocity(Vector3 velocity)
 {
 #if !defined(EDITOR)
@@ -2,18 +2,29 @@
 
 #include "Components/Component.h"
 #include "Collider3D.h"
+#include "Systems/Physics/CollisionLayers.h"
 #include <deque>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 #include "ThirdParty/Jolt/Jolt.h"
 #include "ThirdParty/Jolt/Physics/Collision/Shape/MutableCompoundShape.h"
 #include "ThirdParty/Jolt/Physics/PhysicsSystem.h"
+#include "ThirdParty/Jolt/Physics/Body/BodyActivationListener.h"
 
 // Put in here so they can be accessed by Rigidbody3D.cpp and Game.cpp
+// An object layer holds how the body moves in its low 2 bits, and its collision layer from the project settings above them.
+// Broad phase layers only go by how the body moves, so there are 3 broad phase trees however many collision layers a project has.
 namespace Layers
 {
     static constexpr JPH::ObjectLayer NON_MOVING = 0;
     static constexpr JPH::ObjectLayer MOVING = 1;
-    static constexpr JPH::ObjectLayer NUM_LAYERS = 2;
+    static constexpr JPH::ObjectLayer SENSOR = 2; // Triggers with their own static body
+    static constexpr JPH::ObjectLayer NUM_LAYERS = CollisionLayers::maxLayers << 2;
+
+    inline JPH::ObjectLayer Get(int collisionLayer, JPH::ObjectLayer motion) { return static_cast<JPH::ObjectLayer>((collisionLayer << 2) | motion); }
+    inline JPH::ObjectLayer GetMotion(JPH::ObjectLayer layer) { return layer & 3; }
+    inline int GetCollisionLayer(JPH::ObjectLayer layer) { return layer >> 2; }
 };
 
 class Rigidbody3D : public Component {
@@ -45,6 +56,10 @@ public:
     Vector3 GetLinearVelocity();
     void SetAngularVelocity(Vector3 velocity);
     Vector3 GetAngularVelocity();
+    // Colliders on this game object collide as this layer, since they're all part of the rigidbody's body
+    void SetCollisionLayer(int layer);
+    void SetCollisionLayer(std::string name);
+    int GetCollisionLayer();
 
     BodyType bodyType = Dynamic;
 
@@ -70,8 +85,41 @@ public:
     //void RemoveShape(int id); // Should this be moved to Collider??
 
     JPH::Body* body = nullptr;
+    static JPH::PhysicsSystem* physicsSystem;
     static JPH::BodyInterface* bodyInterface;
     static const JPH::BodyLockInterface* bodyLockInterface;
+
+    // Hide in API
+    // Records the bodies that fall asleep during a step. They're no longer active once the step ends, so SyncActiveBodies() syncs them one last time.
+    class ActivationListener : public JPH::BodyActivationListener
+    {
+    public:
+        void OnBodyActivated(const JPH::BodyID& inBodyID, JPH::uint64 inBodyUserData) override {}
+        void OnBodyDeactivated(const JPH::BodyID& inBodyID, JPH::uint64 inBodyUserData) override;
+    };
+    static ActivationListener activationListener;
+
+    // Hide in API
+    // Bodies added between these are only inserted into the broad phase by EndBodyBatch(), all at once, which is much faster than one at a time.
+    // The broad phase is optimized afterwards. Used while a scene loads.
+    static void BeginBodyBatch();
+    // Hide in API
+    static void EndBodyBatch();
+    // Hide in API
+    static void AddBody(JPH::Body* body, JPH::EActivation activation);
+    // Hide in API
+    // Also takes a body out of the batch if it hasn't been added yet. Does nothing for bodies that aren't added.
+    static void RemoveBody(JPH::Body* body);
+
+    // Hide in API
+    // Moves the bodies of game objects whose transform was set since the last step. Called before each physics step.
+    static void SyncMovedTransforms();
+    // Hide in API
+    // Moves the game objects of the dynamic bodies that are awake or fell asleep during the step. Called after each physics step, so sleeping bodies cost nothing.
+    static void SyncActiveBodies();
+    // Hide in API
+    // Indexed by the body ID's index. Indices without a Rigidbody3D are nullptr.
+    static const std::vector<Rigidbody3D*>& GetBodyRigidbodies();
     //JPH::MutableCompoundShapeSettings compoundSettings;
     JPH::Ref<JPH::MutableCompoundShape> compoundShape;
     //std::vector<std::pair<int, JPH::ShapeSettings>> shapes; // id, shape
@@ -83,12 +131,22 @@ private:
     float friction = 0.2f;
     float linearDamping = 0.0f;
     float angularDamping = 0.0f;
+    std::string collisionLayer = "Default"; // The layer's name, so scenes keep working when layers are reordered
+    int layer = 0;
     bool firstUpdate = true;
 
-    Vector3 lastGOPosition;
-    Quaternion lastGORotation;
-    JPH::Vec3 lastPhysicsPosition;
-    JPH::Quat lastPhysicsRotation;
-
     BodyType oldBodyType;
+
+#if !defined(EDITOR)
+    void SyncTransform();
+    JPH::ObjectLayer GetObjectLayer();
+
+    static bool batchingBodies;
+    static std::vector<Rigidbody3D*> bodyRigidbodies; // Indexed by the body ID's index, so active bodies can be matched to their Rigidbody3D
+    static std::vector<JPH::BodyID> pendingBodies[2]; // Indexed by JPH::EActivation
+    static std::mutex deactivatedBodiesMutex; // Bodies can fall asleep on any of the job system's threads
+    static std::vector<JPH::BodyID> deactivatedBodies;
+
+    static void SyncBody(JPH::BodyInterface& noLockInterface, const JPH::BodyID& bodyID);
+#endif
 };
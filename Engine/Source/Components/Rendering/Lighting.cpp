@@ -2,6 +2,8 @@
 #include "Core/CryonicCore.h"
 #include "Raylib/RaylibLightWrapper.h"
 #include "Core/GameObject.h"
+#include "Systems/Rendering/RenderCulling.h"
+#include "Systems/Rendering/RenderQueue.h"
 #if defined(EDITOR)
 #include "Core/Editor.h"
 #include "Utilities/IconManager.h"
@@ -224,6 +226,7 @@ void Lighting::RenderLight(int index)
 	RaylibWrapper::BeginTextureMode(shadowManager.shadowMapTexture);
 	RaylibWrapper::ClearBackground({ 255, 255, 255, 255 });
 	RaylibWrapper::BeginMode3D(shadowManager.camera);
+	RenderCulling::BeginPass();
 
 	RaylibWrapper::Matrix lightView = RaylibWrapper::rlGetMatrixModelview();
 	RaylibWrapper::Matrix lightProj = RaylibWrapper::rlGetMatrixProjection();
@@ -234,15 +237,13 @@ void Lighting::RenderLight(int index)
 		if (!obj->IsActive())
 			continue;
 
-		// Optional: Frustum culling for performance
-		// if (!IsInLightFrustum(obj)) continue;
-
 		for (Component* component : obj->GetComponents())
 		{
 			if (component->IsActive())
 				component->Render(true);
 		}
 	}
+	RenderQueue::Flush();
 
 	RaylibWrapper::EndMode3D();
 	RaylibWrapper::EndTextureMode();
@@ -1,5 +1,7 @@
 #include "MeshRenderer.h"
 #include "Core/GameObject.h"
+#include "Systems/Rendering/RenderCulling.h"
+#include "Systems/Rendering/RenderQueue.h"
 #if defined (EDITOR)
 #include "Core/ProjectManager.h"
 #else
@@ -44,6 +46,10 @@ void MeshRenderer::SetModel(ModelType model, std::filesystem::path path, ShaderM
         this->modelSet = raylibModel.Create(model, path, shader, std::filesystem::path(exeParent) / "Resources" / "Assets");
 #endif
 
+    // The bounds depend on the model, so the proxy is re-added on the next render
+    RenderCulling::RemoveProxy(cullingProxy);
+    cullingProxy = -1;
+
     // This may cause issues when I fix start freeing/deallocating models since their material may already be freed from this. I'm not sure if Raylib creates a new material for each new primitive mesh.
     if (model != ModelType::Custom)
         raylibModel.SetMaterials({ &Material::defaultMaterial });
@@ -103,15 +109,8 @@ Material* MeshRenderer::GetMaterial()
     return material;
 }
 
-void MeshRenderer::Render(bool renderShadows)
+void MeshRenderer::ApplyMaterial()
 {
-    if (!modelSet || (renderShadows && !castShadows))
-        return;
-
-    Vector3 position = gameObject->transform.GetPosition();
-    Quaternion rotation = gameObject->transform.GetRotation();
-    Vector3 scale = gameObject->transform.GetScale();
-
     // If this MeshRenderer is using a different material than the model's embeded/default materials, then change the material on the model. Currently only embedded materials are supported, not default (set in the model data file).
     // We are not resetting the material back to embedded/default after since it's possible that the next MeshRenderer using this model may also not use the default materials, which therefore causes unnecessary overhead.
 
@@ -129,8 +128,43 @@ void MeshRenderer::Render(bool renderShadows)
         else
             raylibModel.SetMaterials({ material->GetRaylibMaterial()});
     }
+}
+
+void MeshRenderer::Render(bool renderShadows)
+{
+    if (!modelSet || (renderShadows && !castShadows))
+        return;
+
+    Vector3 position = gameObject->transform.GetPosition();
+    Quaternion rotation = gameObject->transform.GetRotation();
+    Vector3 scale = gameObject->transform.GetScale();
+
+    // Update the world bounds if the transform changed since they were last calculated
+    if (cullingProxy == -1)
+    {
+        worldBounds = RenderCulling::GetWorldBounds(raylibModel.GetBounds(), position, rotation, scale);
+        cullingProxy = RenderCulling::AddProxy(worldBounds);
+        boundsPosition = position;
+        boundsRotation = rotation;
+        boundsScale = scale;
+    }
+    else if (position != boundsPosition || rotation != boundsRotation || scale != boundsScale)
+    {
+        worldBounds = RenderCulling::GetWorldBounds(raylibModel.GetBounds(), position, rotation, scale);
+        RenderCulling::UpdateProxy(cullingProxy, worldBounds);
+        boundsPosition = position;
+        boundsRotation = rotation;
+        boundsScale = scale;
+    }
 
-    raylibModel.DrawModelWrapper(position.x, position.y, position.z, scale.x, scale.y, scale.z, rotation.x, rotation.y, rotation.z, rotation.w, 255, 255, 255, 255);
+    if (!RenderCulling::IsVisible(cullingProxy))
+        return;
+
+    if (raylibModel.GetLODCount() > 1)
+        raylibModel.SelectLOD(RenderCulling::GetScreenSize(worldBounds));
+
+    // Drawn by the render queue, sorted and batched with other MeshRenderers using the same model, LOD and material
+    RenderQueue::Submit(this, position, rotation, scale);
 }
 
 // TODO: IN AN UPDATE FUNCTION (make sure editor runs it too), CHEDCK IF MATERIAL updated FLAG HAS BEEN CHECKED, IF IT HAS, THEN UPDATE THE MATERIAL. Although then when would it flip back?
@@ -162,6 +196,9 @@ void MeshRenderer::EditorUpdate()
 
 void MeshRenderer::Destroy()
 {
+    RenderCulling::RemoveProxy(cullingProxy);
+    cullingProxy = -1;
+
     // Todo: Currently Destroy() does work in the editor, but it shouldn't. Will need to move this.
     if (modelSet)
         raylibModel.DeleteInstance();
@@ -3,6 +3,7 @@
 #include "Components/Component.h"
 #include "Raylib/RaylibModelWrapper.h"
 #include "Resources/Material.h"
+#include "Systems/Rendering/CullingTree.h"
 
 class MeshRenderer : public Component
 {
@@ -58,6 +59,8 @@ public:
 	void SetModelPath(std::filesystem::path path);
 	void SetMaterial(Material* mat);
 	Material* GetMaterial();
+	// Sets this MeshRenderer's material on the model, which is shared with other MeshRenderers using the same model
+	void ApplyMaterial();
 
 private:
 	bool setShader = false;
@@ -68,4 +71,10 @@ private:
 	bool defaultMaterial = false;
 
 	bool castShadows;
+
+	int cullingProxy = -1;
+	CullingBounds worldBounds; // Kept for picking the model's LOD
+	Vector3 boundsPosition;
+	Quaternion boundsRotation;
+	Vector3 boundsScale;
 };
\ No newline at end of file
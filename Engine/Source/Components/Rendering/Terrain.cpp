@@ -1,7 +1,130 @@
 #include "Terrain.h"
 #include "Core/GameObject.h"
+#include "Systems/Rendering/RenderCulling.h"
+#include "Resources/TerrainData.h"
 #include <algorithm>
 #include <random>
+#include <future>
+#include <thread>
+#include <unordered_map>
+
+static const float meshChunkSize = 32.0f; // World size of the chunks painted meshes are grouped into for culling
+static const int lodChunkCells = 32;
+static const float lodMaxScreenError = 2.0f; // In pixels
+static_assert(sizeof(MeshInstance) == 9 * sizeof(float), "Mesh instances are read and written as 9 floats by the terrain data file");
+static const int lodChunkLifetime = 600; // Render passes a chunk's mesh is kept for after it was last drawn
+static const int autoMeshTileCells = 32; // Placement cells per side of the tiles auto meshes are generated in parallel
+
+// Moves a row-major grid to a new size, keeping the samples that overlap and filling the rest with zeros
+static void ResizeGrid(std::vector<float>& grid, int oldWidth, int oldDepth, int width, int depth)
+{
+	size_t size = static_cast<size_t>(width) * depth;
+	if (grid.size() != static_cast<size_t>(oldWidth) * oldDepth)
+	{
+		grid.assign(size, 0.0f);
+		return;
+	}
+
+	if (oldWidth == width && oldDepth == depth)
+		return;
+
+	std::vector<float> resized(size, 0.0f);
+	int copyWidth = std::min(oldWidth, width);
+	for (int z = 0; z < std::min(oldDepth, depth); z++)
+		std::copy_n(grid.begin() + static_cast<size_t>(z) * oldWidth, copyWidth, resized.begin() + static_cast<size_t>(z) * width);
+	grid.swap(resized);
+}
+
+// Grids are saved as an array of rows
+static nlohmann::json GridToJson(const std::vector<float>& grid, int width, int depth)
+{
+	nlohmann::json rows = nlohmann::json::array();
+	if (grid.size() != static_cast<size_t>(width) * depth)
+		return rows;
+
+	for (int z = 0; z < depth; z++)
+		rows.push_back(std::vector<float>(grid.begin() + static_cast<size_t>(z) * width, grid.begin() + static_cast<size_t>(z + 1) * width));
+	return rows;
+}
+
+static std::vector<float> GridFromJson(const nlohmann::json& rows, int width, int depth)
+{
+	std::vector<float> grid(static_cast<size_t>(width) * depth, 0.0f);
+	int z = 0;
+	for (const auto& row : rows)
+	{
+		if (z >= depth)
+			break;
+
+		std::vector<float> values = row.get<std::vector<float>>();
+		std::copy_n(values.begin(), std::min(static_cast<int>(values.size()), width), grid.begin() + static_cast<size_t>(z) * width);
+		z++;
+	}
+	return grid;
+}
+
+static InstanceSpatialHash& GetInstanceHash(TerrainMesh& terrainMesh)
+{
+	if (terrainMesh.instanceHashDirty)
+	{
+		terrainMesh.instanceHash.Clear();
+		for (int i = 0; i < static_cast<int>(terrainMesh.instances.size()); i++)
+			terrainMesh.instanceHash.Insert(i, terrainMesh.instances[i].position.x, terrainMesh.instances[i].position.z);
+		terrainMesh.instanceHashDirty = false;
+	}
+	return terrainMesh.instanceHash;
+}
+
+static Vector3 GetRotationFromNormal(const Vector3& normal)
+{
+	// Calculate rotation from up vector to normal
+	Vector3 up = { 0.0f, 1.0f, 0.0f };
+	Vector3 axis = {
+		up.y * normal.z - up.z * normal.y,
+		up.z * normal.x - up.x * normal.z,
+		up.x * normal.y - up.y * normal.x
+	};
+
+	float axisLength = sqrtf(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+	if (axisLength <= 0.001f)
+		return { 0.0f, 0.0f, 0.0f };
+
+	float angle = acosf(up.x * normal.x + up.y * normal.y + up.z * normal.z);
+	return { axis.x / axisLength * angle, axis.y / axisLength * angle, axis.z / axisLength * angle };
+}
+
+static int SelectVariantIndex(const AutoMeshRule& rule, std::mt19937& generator)
+{
+	float totalWeight = 0.0f;
+	for (const MeshVariant& variant : rule.meshVariants)
+		totalWeight += variant.weight;
+
+	if (totalWeight <= 0.0f)
+		return 0;
+
+	float randomValue = std::uniform_real_distribution<float>(0.0f, totalWeight)(generator);
+	float cumulativeWeight = 0.0f;
+	for (int i = 0; i < static_cast<int>(rule.meshVariants.size()); i++)
+	{
+		cumulativeWeight += rule.meshVariants[i].weight;
+		if (randomValue <= cumulativeWeight)
+			return i;
+	}
+
+	return static_cast<int>(rule.meshVariants.size()) - 1;
+}
+
+static uint32_t GetTileSeed(uint32_t seed, int tileX, int tileZ)
+{
+	// Mixed so neighbouring tiles don't start with similar sequences
+	uint32_t hash = seed * 0x9E3779B9u ^ static_cast<uint32_t>(tileX) * 0x85EBCA6Bu ^ static_cast<uint32_t>(tileZ) * 0xC2B2AE35u;
+	hash ^= hash >> 16;
+	hash *= 0x7FEB352Du;
+	hash ^= hash >> 15;
+	hash *= 0x846CA68Bu;
+	hash ^= hash >> 16;
+	return hash;
+}
 
 void Terrain::Awake()
 {
@@ -18,39 +141,50 @@ void Terrain::Awake()
 
 void Terrain::GenerateTerrain()
 {
-	heightData.resize(terrainDepth, std::vector<float>(terrainWidth, 0.0f));
+	ResizeTerrainData();
 
 	// Generate flat mesh
-	raylibModel.CreateFromHeightData(heightData, terrainWidth, terrainDepth, terrainHeight, terrainMaterial->GetRaylibMaterial());
+	raylibModel.CreateForTerrainChunks(terrainMaterial->GetRaylibMaterial());
 	modelGenerated = true;
+	RebuildLOD();
 }
 
 void Terrain::GenerateFromHeightmap()
 {
-	// Load image data
-	RaylibWrapper::Image img = RaylibWrapper::LoadImage(heightmapSprite->GetPath().c_str());
-	RaylibWrapper::ImageFormat(&img, RaylibWrapper::PIXELFORMAT_UNCOMPRESSED_R8G8B8);
+	ResizeTerrainData();
 
-	if (img.width != terrainWidth || img.height != terrainDepth)
-		RaylibWrapper::ImageResize(&img, terrainWidth, terrainDepth);
+	// 16-bit PNG and RAW heightmaps keep their full precision, anything else is loaded by raylib as 8-bit
+	std::vector<float> heights;
+	if (TerrainDataFile::ImportHeightmap16(heightmapSprite->GetPath(), terrainWidth, terrainDepth, heights))
+	{
+		for (size_t i = 0; i < heights.size(); i++)
+			heightData[i] = heights[i] * terrainHeight * heightScale;
+	}
+	else
+	{
+		RaylibWrapper::Image img = RaylibWrapper::LoadImage(heightmapSprite->GetPath().c_str());
+		RaylibWrapper::ImageFormat(&img, RaylibWrapper::PIXELFORMAT_UNCOMPRESSED_R8G8B8);
 
-	heightData.resize(terrainDepth, std::vector<float>(terrainWidth));
+		if (img.width != terrainWidth || img.height != terrainDepth)
+			RaylibWrapper::ImageResize(&img, terrainWidth, terrainDepth);
 
-	RaylibWrapper::Color* pixels = RaylibWrapper::LoadImageColors(img);
-	for (int z = 0; z < terrainDepth; z++)
-	{
-		for (int x = 0; x < terrainWidth; x++)
+		RaylibWrapper::Color* pixels = RaylibWrapper::LoadImageColors(img);
+		for (int z = 0; z < terrainDepth; z++)
 		{
-			int index = z * terrainWidth + x;
-			float gray = (pixels[index].r + pixels[index].g + pixels[index].b) / 3.0f / 255.0f;
-			heightData[z][x] = gray * terrainHeight * heightScale;
+			for (int x = 0; x < terrainWidth; x++)
+			{
+				int index = z * terrainWidth + x;
+				float gray = (pixels[index].r + pixels[index].g + pixels[index].b) / 3.0f / 255.0f;
+				heightData[index] = gray * terrainHeight * heightScale;
+			}
 		}
+		UnloadImageColors(pixels);
+		UnloadImage(img);
 	}
-	UnloadImageColors(pixels);
-	UnloadImage(img);
 
-	raylibModel.CreateFromHeightData(heightData, terrainWidth, terrainDepth, terrainHeight, terrainMaterial->GetRaylibMaterial());
+	raylibModel.CreateForTerrainChunks(terrainMaterial->GetRaylibMaterial());
 	modelGenerated = true;
+	RebuildLOD();
 }
 
 void Terrain::Render(bool renderShadows)
@@ -111,10 +245,7 @@ void Terrain::Render(bool renderShadows)
 		RaylibWrapper::rlActiveTextureSlot(0);
 	}
 
-	raylibModel.DrawModelWrapper(centeredPos.x, centeredPos.y, centeredPos.z,
-		scale.x, scale.y, scale.z,
-		rot.x, rot.y, rot.z, rot.w,
-		255, 255, 255, 255);
+	RenderLODChunks(centeredPos, rot);
 
 	// Render Meshs (painted meshes)
 	RenderTerrainMeshs(renderShadows);
@@ -124,18 +255,8 @@ void Terrain::Update()
 {
 	if (needsRebuild)
 	{
-		if (lastRebuild >= 0.05f)
-		{
-			RebuildMesh(); // Todo: Should this call GenerateFromHeightmap() if a heightmap is being used?
-
-			UpdateSplatmapTexture();
-			needsSplatmapUpdate = false;
-
-			needsRebuild = false;
-			lastRebuild = 0.0f;
-		}
-		else
-			lastRebuild += RaylibWrapper::GetFrameTime();
+		UpdateDirtyHeights();
+		needsRebuild = false;
 	}
 
 	if (needsSplatmapUpdate)
@@ -143,6 +264,8 @@ void Terrain::Update()
 		UpdateSplatmapTexture();
 		needsSplatmapUpdate = false;
 	}
+	else
+		UpdateDirtySplatmap();
 }
 
 #if defined(EDITOR)
@@ -155,6 +278,8 @@ void Terrain::EditorUpdate()
 	int oldDepth = terrainDepth;
 	float oldHeight = terrainHeight;
 	float oldScale = heightScale;
+	bool oldEnableLOD = enableLOD;
+	int oldLODLevels = lodLevels;
 
 	// Update values from exposedVariables
 	terrainWidth = exposedVariables[1][0][2];
@@ -165,6 +290,10 @@ void Terrain::EditorUpdate()
 	lodLevels = exposedVariables[1][6][2];
 	lodDistance = exposedVariables[1][7][2];
 	castShadows = exposedVariables[1][8][2];
+	useImpostors = exposedVariables[1][9][2];
+	impostorDistance = exposedVariables[1][10][2];
+	impostorFadeDistance = exposedVariables[1][11][2];
+	compressData = exposedVariables[1][12][2];
 
 	if (setupEditor)
 	{
@@ -205,21 +334,230 @@ void Terrain::EditorUpdate()
 		else
 			RebuildMesh();
 	}
+	else if (modelGenerated && (enableLOD != oldEnableLOD || lodLevels != oldLODLevels))
+		RebuildLOD();
 }
 #endif
 
 void Terrain::RebuildMesh()
 {
-	// Resize the heightData if needed
-	if ((int)heightData.size() != terrainDepth || (int)heightData[0].size() != terrainWidth)
-		heightData.assign(terrainDepth, std::vector<float>(terrainWidth, 0.0f));
+	ResizeTerrainData();
+
+	if (!modelGenerated)
+	{
+		raylibModel.CreateForTerrainChunks(terrainMaterial->GetRaylibMaterial());
+		modelGenerated = true;
+	}
+
+	RebuildLOD();
+}
+
+void Terrain::RebuildLOD()
+{
+	ClearLODChunks();
+
+	// A full build covers any pending changes
+	dirtyMaxX = dirtyMinX - 1;
+	needsRebuild = false;
+	collisionNeedsRebuild = true;
+
+	if (heightData.size() != static_cast<size_t>(terrainWidth) * terrainDepth)
+	{
+		lod.Clear();
+		raycaster.Clear();
+		return;
+	}
+
+	lod.Build(heightData.data(), terrainWidth, terrainDepth, lodChunkCells, enableLOD ? std::max(lodLevels, 1) : 1);
+	raycaster.Build(heightData.data(), terrainWidth, terrainDepth);
+
+	for (int stitchEdges = 0; stitchEdges < 16; stitchEdges++)
+		TerrainLOD::BuildIndices(lod.GetChunkCells(), stitchEdges, lodIndices[stitchEdges]);
+}
+
+void Terrain::ResizeTerrainData()
+{
+	bool resized = dataWidth != terrainWidth || dataDepth != terrainDepth;
+
+	ResizeGrid(heightData, dataWidth, dataDepth, terrainWidth, terrainDepth);
+	for (TerrainLayer& layer : terrainLayers)
+		ResizeGrid(layer.splatmap, dataWidth, dataDepth, terrainWidth, terrainDepth);
+	dataWidth = terrainWidth;
+	dataDepth = terrainDepth;
+
+	// The splatmap texture has to be recreated at the new size
+	if (resized && splatmapGenerated)
+	{
+		RaylibWrapper::UnloadTexture(splatmapTexture);
+		splatmapGenerated = false;
+		needsSplatmapUpdate = true;
+	}
+}
+
+void Terrain::MarkHeightsDirty(int minX, int minZ, int maxX, int maxZ)
+{
+	if (dirtyMaxX < dirtyMinX)
+	{
+		dirtyMinX = minX;
+		dirtyMinZ = minZ;
+		dirtyMaxX = maxX;
+		dirtyMaxZ = maxZ;
+	}
+	else
+	{
+		dirtyMinX = std::min(dirtyMinX, minX);
+		dirtyMinZ = std::min(dirtyMinZ, minZ);
+		dirtyMaxX = std::max(dirtyMaxX, maxX);
+		dirtyMaxZ = std::max(dirtyMaxZ, maxZ);
+	}
+
+	// Raycasts are updated right away so brushes pick against the heights they just changed
+	raycaster.UpdateRegion(minX, minZ, maxX, maxZ);
+	MarkCollisionDirty(minX, minZ, maxX, maxZ);
+	needsRebuild = true;
+}
+
+void Terrain::MarkCollisionDirty(int minX, int minZ, int maxX, int maxZ)
+{
+	if (collisionDirtyMaxX < collisionDirtyMinX)
+	{
+		collisionDirtyMinX = minX;
+		collisionDirtyMinZ = minZ;
+		collisionDirtyMaxX = maxX;
+		collisionDirtyMaxZ = maxZ;
+	}
+	else
+	{
+		collisionDirtyMinX = std::min(collisionDirtyMinX, minX);
+		collisionDirtyMinZ = std::min(collisionDirtyMinZ, minZ);
+		collisionDirtyMaxX = std::max(collisionDirtyMaxX, maxX);
+		collisionDirtyMaxZ = std::max(collisionDirtyMaxZ, maxZ);
+	}
+}
+
+bool Terrain::TakeCollisionChanges(int& minX, int& minZ, int& maxX, int& maxZ, bool& fullRebuild)
+{
+	fullRebuild = collisionNeedsRebuild;
+	minX = std::max(collisionDirtyMinX, 0);
+	minZ = std::max(collisionDirtyMinZ, 0);
+	maxX = std::min(collisionDirtyMaxX, terrainWidth - 1);
+	maxZ = std::min(collisionDirtyMaxZ, terrainDepth - 1);
+	bool changed = fullRebuild || (minX <= maxX && minZ <= maxZ);
+
+	collisionNeedsRebuild = false;
+	collisionDirtyMaxX = collisionDirtyMinX - 1;
+	return changed;
+}
+
+void Terrain::UpdateDirtyHeights()
+{
+	if (dirtyMaxX < dirtyMinX || lod.GetNodeCount() == 0)
+		return;
+
+	lod.UpdateRegion(heightData.data(), dirtyMinX, dirtyMinZ, dirtyMaxX, dirtyMaxZ);
+
+	// Normals read the samples next to a vertex, so vertices one sample outside the rect change too
+	int minX = dirtyMinX - 1;
+	int minZ = dirtyMinZ - 1;
+	int maxX = dirtyMaxX + 1;
+	int maxZ = dirtyMaxZ + 1;
+	dirtyMaxX = dirtyMinX - 1;
+
+	int chunkCells = lod.GetChunkCells();
+	std::vector<float> positions, normals, texcoords;
+	for (auto& pair : lodChunks)
+	{
+		if (!pair.second.mesh.IsLoaded())
+			continue;
+
+		const TerrainLODNode& node = lod.GetNode(pair.first);
+		int stride = 1 << node.level;
+		int size = chunkCells * stride;
+		if (maxX < node.x || minX > node.x + size || maxZ < node.z || minZ > node.z + size)
+			continue;
+
+		// Only the rows of vertices inside the rect are uploaded. Rows past the terrain's edge repeat its last row.
+		int firstRow = std::max(0, (minZ - node.z + stride - 1) / stride);
+		int lastRow = maxZ >= terrainDepth - 1 ? chunkCells : std::min(chunkCells, (maxZ - node.z) / stride);
+		if (lastRow < firstRow)
+			continue;
+
+		lod.BuildVertices(pair.first, heightData.data(), positions, normals, texcoords);
+		pair.second.mesh.UpdateVertices(positions, normals, firstRow * (chunkCells + 1), (lastRow - firstRow + 1) * (chunkCells + 1));
+	}
+}
+
+void Terrain::ClearLODChunks()
+{
+	for (auto& pair : lodChunks)
+		pair.second.mesh.Unload();
+	lodChunks.clear();
+}
+
+void Terrain::RenderLODChunks(const Vector3& position, const Quaternion& rotation)
+{
+	lodPass++;
+
+	// Camera position in the terrain's space
+	RaylibWrapper::Matrix inverseView = RaylibWrapper::MatrixInvert(RaylibWrapper::rlGetMatrixModelview());
+	Vector3 viewOffset = { inverseView.m12 - position.x, inverseView.m13 - position.y, inverseView.m14 - position.z };
+	Vector3 localView = RotateVector3ByQuaternion(viewOffset, { -rotation.x, -rotation.y, -rotation.z, rotation.w });
+	float viewPosition[3] = { localView.x, localView.y, localView.z };
+
+	// Pixels covered by one unit, one unit away. m5 is 1 / tan(fovy / 2) for perspective projections.
+	float pixelsPerUnit = RaylibWrapper::GetScreenHeight() * 0.5f * RaylibWrapper::rlGetMatrixProjection().m5;
+
+	lod.Select(viewPosition, pixelsPerUnit, lodMaxScreenError, enableLOD ? lodDistance : 0.0f, lodSelection);
+
+	const float noOffset[3] = { 0.0f, 0.0f, 0.0f };
+	for (const TerrainLODSelection& selection : lodSelection)
+	{
+		CullingBounds localBounds = lod.GetBounds(selection.node, noOffset);
+		RaylibWrapper::BoundingBox box = { { localBounds.min[0], localBounds.min[1], localBounds.min[2] }, { localBounds.max[0], localBounds.max[1], localBounds.max[2] } };
+		if (!RenderCulling::IsVisible(RenderCulling::GetWorldBounds(box, position, rotation, { 1.0f, 1.0f, 1.0f })))
+			continue;
+
+		LODChunk& chunk = lodChunks[selection.node];
+		if (!chunk.mesh.IsLoaded())
+		{
+			std::vector<float> positions, normals, texcoords;
+			lod.BuildVertices(selection.node, heightData.data(), positions, normals, texcoords);
+			chunk.mesh.Upload(positions, normals, texcoords, lodIndices[0]); // No stitching has the most indices
+			chunk.stitchEdges = 0;
+		}
 
+		if (chunk.stitchEdges != selection.stitchEdges)
+		{
+			chunk.mesh.UpdateIndices(lodIndices[selection.stitchEdges]);
+			chunk.stitchEdges = selection.stitchEdges;
+		}
 
-	raylibModel.CreateFromHeightData(heightData, terrainWidth, terrainDepth, terrainHeight, terrainMaterial->GetRaylibMaterial());
+		chunk.lastUsedPass = lodPass;
+		raylibModel.DrawChunkMesh(chunk.mesh, position.x, position.y, position.z, rotation.x, rotation.y, rotation.z, rotation.w);
+	}
+
+	// Free the chunks that haven't been drawn in a while
+	if (lodPass % 60 == 0)
+	{
+		for (auto it = lodChunks.begin(); it != lodChunks.end();)
+		{
+			if (lodPass - it->second.lastUsedPass > lodChunkLifetime)
+			{
+				it->second.mesh.Unload();
+				it = lodChunks.erase(it);
+			}
+			else
+				++it;
+		}
+	}
 }
 
 void Terrain::Destroy()
 {
+	ClearLODChunks();
+	lod.Clear();
+	raycaster.Clear();
+
 	if (modelGenerated)
 		raylibModel.DeleteInstance();
 
@@ -238,6 +576,8 @@ void Terrain::Destroy()
 	// Clean up meshs
 	for (TerrainMesh& mesh : terrainMeshs)
 	{
+		mesh.impostor.Unload();
+
 		if (mesh.cachedModel)
 		{
 			// Check if this is the last reference to this model
@@ -308,39 +648,75 @@ void Terrain::Destroy()
 	autoGeneratedMeshIndices.clear();
 }
 
-bool Terrain::RaycastToTerrain(const RaylibWrapper::Ray& ray, Vector3& hitPos)
+HeightfieldRay Terrain::ToLocalRay(const RaylibWrapper::Ray& ray, float maxDistance) const
 {
-	float maxDistance = 1000.0f;
-	float step = 0.5f; // Acciracuy of the raycast. Smaller = more accurate.
-	for (float t = 0; t < maxDistance; t += step)
-	{
-		RaylibWrapper::Vector3 point = RaylibWrapper::Vector3Add(ray.position, RaylibWrapper::Vector3Scale(ray.direction, t));
+	// Same transform the chunks are drawn with in Render(), relative to the first sample
+	Vector3 position = gameObject->transform.GetPosition();
+	Quaternion rotation = gameObject->transform.GetRotation();
+	Quaternion inverseRotation = { -rotation.x, -rotation.y, -rotation.z, rotation.w };
+	Vector3 offset = {
+		ray.position.x - (position.x - terrainWidth * 0.5f),
+		ray.position.y - position.y,
+		ray.position.z - (position.z - terrainDepth * 0.5f)
+	};
+	Vector3 origin = RotateVector3ByQuaternion(offset, inverseRotation);
+	Vector3 direction = RotateVector3ByQuaternion({ ray.direction.x, ray.direction.y, ray.direction.z }, inverseRotation);
+
+	HeightfieldRay localRay;
+	localRay.origin[0] = origin.x;
+	localRay.origin[1] = origin.y;
+	localRay.origin[2] = origin.z;
+	localRay.direction[0] = direction.x;
+	localRay.direction[1] = direction.y;
+	localRay.direction[2] = direction.z;
+	localRay.maxDistance = maxDistance;
+	return localRay;
+}
 
-		// Convert world position to local terrain coordinates. This actually isnt needed
-		//RaylibWrapper::Vector3 local = WorldToLocal(point);
-		RaylibWrapper::Vector3 local = point;
+TerrainRaycastHit Terrain::ToWorldHit(const HeightfieldHit& hit) const
+{
+	TerrainRaycastHit worldHit;
+	if (!hit.hit)
+		return worldHit;
+
+	Vector3 position = gameObject->transform.GetPosition();
+	Quaternion rotation = gameObject->transform.GetRotation();
+	Vector3 hitPosition = RotateVector3ByQuaternion({ hit.position[0], hit.position[1], hit.position[2] }, rotation);
+
+	worldHit.hit = true;
+	worldHit.position = {
+		hitPosition.x + position.x - terrainWidth * 0.5f,
+		hitPosition.y + position.y,
+		hitPosition.z + position.z - terrainDepth * 0.5f
+	};
+	worldHit.normal = RotateVector3ByQuaternion({ hit.normal[0], hit.normal[1], hit.normal[2] }, rotation);
+	worldHit.distance = hit.distance;
+	return worldHit;
+}
 
-		// Center it since the terrain is rendered from the center
-		local.x = point.x - (gameObject->transform.GetPosition().x - terrainWidth / 2.0f);
-		local.z = point.z - (gameObject->transform.GetPosition().z - terrainDepth / 2.0f);
+bool Terrain::RaycastToTerrain(const RaylibWrapper::Ray& ray, Vector3& hitPos, float maxDistance) const
+{
+	HeightfieldHit hit;
+	if (!raycaster.Raycast(ToLocalRay(ray, maxDistance), hit))
+		return false;
 
-		// Check bounds
-		if (local.x < 0 || local.x >= terrainWidth || local.z < 0 || local.z >= terrainDepth)
-			continue;
+	hitPos = ToWorldHit(hit).position;
+	return true;
+}
 
-		float terrainY = heightData[(int)local.z][(int)local.x];
-		//if (point.y <= terrainY)
-		//{
-		//	hitPos = { point.x, point.y, point.z };
-		//	return true;
-		//}
-		float prevY = heightData[(int)local.z][(int)local.x];
-		if (point.y <= prevY) {
-			hitPos = { point.x, prevY, point.z };
-			return true;
-		}
-	}
-	return false;
+void Terrain::RaycastToTerrain(const std::vector<RaylibWrapper::Ray>& rays, std::vector<TerrainRaycastHit>& hits, float maxDistance) const
+{
+	std::vector<HeightfieldRay> localRays;
+	localRays.reserve(rays.size());
+	for (const RaylibWrapper::Ray& ray : rays)
+		localRays.push_back(ToLocalRay(ray, maxDistance));
+
+	std::vector<HeightfieldHit> localHits(rays.size());
+	raycaster.RaycastBatch(localRays.data(), localHits.data(), static_cast<int>(localRays.size()));
+
+	hits.resize(rays.size());
+	for (size_t i = 0; i < localHits.size(); i++)
+		hits[i] = ToWorldHit(localHits[i]);
 }
 
 int Terrain::WorldToHeightmapX(float worldX) const
@@ -364,7 +740,8 @@ int Terrain::WorldToHeightmapZ(float worldZ) const
 void Terrain::SetHeight(int x, int z, float height)
 {
 	if (x < 0 || z < 0 || x >= terrainWidth || z >= terrainDepth) return;
-	heightData[z][x] = height;
+	heightData[z * terrainWidth + x] = height;
+	MarkHeightsDirty(x, z, x, z);
 }
 
 float Terrain::GetHeight(int x, int z) const
@@ -376,7 +753,7 @@ float Terrain::GetHeight(int x, int z) const
 	if (z < 0) z = 0;
 	else if (z >= terrainDepth) z = terrainDepth - 1;
 
-	return heightData[z][x];
+	return heightData[z * terrainWidth + x];
 }
 
 float Terrain::GetHeightAtWorldPosition(float worldX, float worldZ) const
@@ -430,28 +807,45 @@ Vector3 Terrain::GetNormalAtWorldPosition(float worldX, float worldZ) const
 
 // ============= Sculpting =============
 
+bool Terrain::GetBrushRect(float centerX, float centerZ, float radius, int& minX, int& minZ, int& maxX, int& maxZ) const
+{
+	if (radius <= 0.0f || heightData.size() != static_cast<size_t>(terrainWidth) * terrainDepth)
+		return false;
+
+	minX = std::max(0, (int)std::floor(centerX - radius));
+	minZ = std::max(0, (int)std::floor(centerZ - radius));
+	maxX = std::min(terrainWidth - 1, (int)std::ceil(centerX + radius));
+	maxZ = std::min(terrainDepth - 1, (int)std::ceil(centerZ + radius));
+	return minX <= maxX && minZ <= maxZ;
+}
+
 void Terrain::RaiseTerrain(float worldX, float worldZ, float radius, float strength, float deltaTime)
 {
 	float centeredX = WorldToHeightmapX(worldX);
 	float centeredZ = WorldToHeightmapZ(worldZ);
 
-	for (int z = 0; z < terrainDepth; z++)
+	int minX, minZ, maxX, maxZ;
+	if (!GetBrushRect(centeredX, centeredZ, radius, minX, minZ, maxX, maxZ))
+		return;
+
+	float amount = strength * deltaTime;
+	for (int z = minZ; z <= maxZ; z++)
 	{
-		for (int x = 0; x < terrainWidth; x++)
+		float dz = z - centeredZ;
+		float* row = heightData.data() + static_cast<size_t>(z) * terrainWidth;
+
+		// Selects instead of branching so the compiler can vectorize the row
+		for (int x = minX; x <= maxX; x++)
 		{
 			float dx = x - centeredX;
-			float dz = z - centeredZ;
 			float dist = sqrtf(dx * dx + dz * dz);
-			if (dist < radius)
-			{
-				float falloff = 0.5f * (cosf(dist / radius * 3.14159f) + 1.0f);
-				heightData[z][x] = std::min(heightData[z][x] + strength * falloff * deltaTime, terrainHeight);
-			}
+			float falloff = 0.5f * (cosf(dist / radius * 3.14159f) + 1.0f);
+			float raised = std::min(row[x] + amount * falloff, terrainHeight);
+			row[x] = dist < radius ? raised : row[x];
 		}
 	}
 
-	needsRebuild = true;
-	//RebuildMesh(); // Let Update() handle the rebuild
+	MarkHeightsDirty(minX, minZ, maxX, maxZ); // Update() pushes the changes to the mesh
 }
 
 void Terrain::LowerTerrain(float worldX, float worldZ, float radius, float strength, float deltaTime)
@@ -464,30 +858,43 @@ void Terrain::SmoothTerrain(float worldX, float worldZ, float radius, float stre
 	float centeredX = WorldToHeightmapX(worldX);
 	float centeredZ = WorldToHeightmapZ(worldZ);
 
-	std::vector<std::vector<float>> newHeights = heightData;
-	for (int z = 1; z < terrainDepth - 1; z++)
+	int minX, minZ, maxX, maxZ;
+	if (!GetBrushRect(centeredX, centeredZ, radius, minX, minZ, maxX, maxZ))
+		return;
+
+	// The outer samples are missing neighbors, so they aren't smoothed
+	minX = std::max(minX, 1);
+	minZ = std::max(minZ, 1);
+	maxX = std::min(maxX, terrainWidth - 2);
+	maxZ = std::min(maxZ, terrainDepth - 2);
+	if (minX > maxX || minZ > maxZ)
+		return;
+
+	// Averages read the heights from before this stroke, so copy the rect and a border of neighbors
+	int scratchWidth = maxX - minX + 3;
+	int scratchDepth = maxZ - minZ + 3;
+	brushScratch.resize(static_cast<size_t>(scratchWidth) * scratchDepth);
+	for (int z = 0; z < scratchDepth; z++)
+		std::copy_n(heightData.data() + static_cast<size_t>(minZ - 1 + z) * terrainWidth + minX - 1, scratchWidth, brushScratch.data() + static_cast<size_t>(z) * scratchWidth);
+
+	float amount = strength * deltaTime;
+	for (int z = minZ; z <= maxZ; z++)
 	{
-		for (int x = 1; x < terrainWidth - 1; x++)
+		float dz = z - centeredZ;
+		float* row = heightData.data() + static_cast<size_t>(z) * terrainWidth + minX;
+		const float* center = brushScratch.data() + static_cast<size_t>(z - minZ + 1) * scratchWidth + 1;
+
+		for (int i = 0; i <= maxX - minX; i++)
 		{
-			float dx = x - centeredX;
-			float dz = z - centeredZ;
+			float dx = minX + i - centeredX;
 			float dist = sqrtf(dx * dx + dz * dz);
-			if (dist < radius)
-			{
-				float avg = (
-					GetHeight(x - 1, z) +
-					GetHeight(x + 1, z) +
-					GetHeight(x, z - 1) +
-					GetHeight(x, z + 1) +
-					GetHeight(x, z)) / 5.0f;
-				newHeights[z][x] = heightData[z][x] + (avg - heightData[z][x]) * strength * deltaTime;
-			}
+			float avg = (center[i - 1] + center[i + 1] + center[i - scratchWidth] + center[i + scratchWidth] + center[i]) / 5.0f;
+			float smoothed = center[i] + (avg - center[i]) * amount;
+			row[i] = dist < radius ? smoothed : row[i];
 		}
 	}
-	heightData = newHeights;
 
-	needsRebuild = true;
-	//RebuildMesh(); // Let Update() handle the rebuild
+	MarkHeightsDirty(minX, minZ, maxX, maxZ);
 }
 
 void Terrain::FlattenTerrain(float worldX, float worldZ, float radius, float strength, float targetHeight, float deltaTime)
@@ -498,20 +905,26 @@ void Terrain::FlattenTerrain(float worldX, float worldZ, float radius, float str
 	if (targetHeight > terrainHeight)
 		targetHeight = terrainHeight;
 
-	for (int z = 0; z < terrainDepth; z++)
+	int minX, minZ, maxX, maxZ;
+	if (!GetBrushRect(centeredX, centeredZ, radius, minX, minZ, maxX, maxZ))
+		return;
+
+	float amount = strength * deltaTime;
+	for (int z = minZ; z <= maxZ; z++)
 	{
-		for (int x = 0; x < terrainWidth; x++)
+		float dz = z - centeredZ;
+		float* row = heightData.data() + static_cast<size_t>(z) * terrainWidth;
+
+		for (int x = minX; x <= maxX; x++)
 		{
 			float dx = x - centeredX;
-			float dz = z - centeredZ;
 			float dist = sqrtf(dx * dx + dz * dz);
-			if (dist < radius)
-				heightData[z][x] += (targetHeight - heightData[z][x]) * strength * deltaTime;
+			float flattened = row[x] + (targetHeight - row[x]) * amount;
+			row[x] = dist < radius ? flattened : row[x];
 		}
 	}
 
-	needsRebuild = true;
-	//RebuildMesh(); // Let Update() handle the rebuild
+	MarkHeightsDirty(minX, minZ, maxX, maxZ);
 }
 
 // ============= Texture Painting =============
@@ -521,25 +934,16 @@ void Terrain::InitializeSplatmaps()
 	// Initialize splatmaps for all layers
 	for (auto& layer : terrainLayers)
 	{
-		if (layer.splatmap.empty())
-		{
-			layer.splatmap.resize(terrainDepth, std::vector<float>(terrainWidth, 0.0f));
-		}
+		if (layer.splatmap.size() != heightData.size())
+			layer.splatmap.assign(heightData.size(), 0.0f);
 	}
 
 	// If we have at least one layer, set it to full strength by default
-	if (!terrainLayers.empty() && terrainLayers[0].splatmap.size() > 0)
-	{
-		for (int z = 0; z < terrainDepth; z++)
-		{
-			for (int x = 0; x < terrainWidth; x++)
-			{
-				terrainLayers[0].splatmap[z][x] = 1.0f;
-			}
-		}
-	}
+	if (!terrainLayers.empty())
+		std::fill(terrainLayers[0].splatmap.begin(), terrainLayers[0].splatmap.end(), 1.0f);
 
 	needsSplatmapUpdate = true;
+	collisionNeedsRebuild = true;
 }
 
 void Terrain::LoadTerrainShader()
@@ -611,19 +1015,23 @@ void Terrain::NormalizeSplatmaps(int x, int z)
 	// Ensure all weights at this position sum to 1.0
 	if (terrainLayers.empty()) return;
 
+	if (x < 0 || z < 0 || x >= terrainWidth)
+		return;
+
+	size_t index = static_cast<size_t>(z) * terrainWidth + x;
 	float totalWeight = 0.0f;
 	for (auto& layer : terrainLayers)
 	{
-		if (z < (int)layer.splatmap.size() && x < (int)layer.splatmap[z].size())
-			totalWeight += layer.splatmap[z][x];
+		if (index < layer.splatmap.size())
+			totalWeight += layer.splatmap[index];
 	}
 
 	if (totalWeight > 0.0f)
 	{
 		for (auto& layer : terrainLayers)
 		{
-			if (z < (int)layer.splatmap.size() && x < (int)layer.splatmap[z].size())
-				layer.splatmap[z][x] /= totalWeight;
+			if (index < layer.splatmap.size())
+				layer.splatmap[index] /= totalWeight;
 		}
 	}
 }
@@ -637,11 +1045,22 @@ void Terrain::PaintTexture(float worldX, float worldZ, float radius, float stren
 	float centeredX = WorldToHeightmapX(worldX);
 	float centeredZ = WorldToHeightmapZ(worldZ);
 
+	int minX, minZ, maxX, maxZ;
+	if (!GetBrushRect(centeredX, centeredZ, radius, minX, minZ, maxX, maxZ))
+		return;
+
+	for (const TerrainLayer& layer : terrainLayers)
+	{
+		if (layer.splatmap.size() != heightData.size())
+			return;
+	}
+
 	// Paint in a circular brush pattern
-	for (int z = 0; z < terrainDepth; z++)
+	for (int z = minZ; z <= maxZ; z++)
 	{
-		for (int x = 0; x < terrainWidth; x++)
+		for (int x = minX; x <= maxX; x++)
 		{
+			size_t index = static_cast<size_t>(z) * terrainWidth + x;
 			float dx = (float)(x - centeredX);
 			float dz = (float)(z - centeredZ);
 			float dist = sqrtf(dx * dx + dz * dz);
@@ -653,17 +1072,17 @@ void Terrain::PaintTexture(float worldX, float worldZ, float radius, float stren
 				float paintStrength = strength * falloff * deltaTime;
 
 				// Increase weight of the target layer
-				terrainLayers[layerIndex].splatmap[z][x] = std::min(1.0f,
-					terrainLayers[layerIndex].splatmap[z][x] + paintStrength);
+				terrainLayers[layerIndex].splatmap[index] = std::min(1.0f,
+					terrainLayers[layerIndex].splatmap[index] + paintStrength);
 
 				// Decrease weight of other layers proportionally
-				float remainingWeight = 1.0f - terrainLayers[layerIndex].splatmap[z][x];
+				float remainingWeight = 1.0f - terrainLayers[layerIndex].splatmap[index];
 				float otherLayersTotal = 0.0f;
 
 				for (int i = 0; i < GetLayerCount(); i++)
 				{
 					if (i != layerIndex)
-						otherLayersTotal += terrainLayers[i].splatmap[z][x];
+						otherLayersTotal += terrainLayers[i].splatmap[index];
 				}
 
 				if (otherLayersTotal > 0.0f)
@@ -672,8 +1091,8 @@ void Terrain::PaintTexture(float worldX, float worldZ, float radius, float stren
 					{
 						if (i != layerIndex)
 						{
-							float ratio = terrainLayers[i].splatmap[z][x] / otherLayersTotal;
-							terrainLayers[i].splatmap[z][x] = remainingWeight * ratio;
+							float ratio = terrainLayers[i].splatmap[index] / otherLayersTotal;
+							terrainLayers[i].splatmap[index] = remainingWeight * ratio;
 						}
 					}
 				}
@@ -684,7 +1103,7 @@ void Terrain::PaintTexture(float worldX, float worldZ, float radius, float stren
 		}
 	}
 
-	needsSplatmapUpdate = true;
+	MarkSplatmapDirty(minX, minZ, maxX, maxZ);
 }
 
 void Terrain::UpdateSplatmapTexture()
@@ -692,58 +1111,31 @@ void Terrain::UpdateSplatmapTexture()
 	if (terrainLayers.empty())
 		return;
 
-	// Create or update splatmap texture
 	// For up to 4 layers, we can pack them into RGBA channels
-	int layerCount = std::min(4, GetLayerCount());
-
-	if (!splatmapGenerated)
+	int layerCount = std::min(TerrainSplatmap::maxLayers, GetLayerCount());
+	const float* layers[TerrainSplatmap::maxLayers] = {};
+	for (int i = 0; i < layerCount; i++)
 	{
-		// Create new texture
-		RaylibWrapper::Image splatImage = RaylibWrapper::GenImageColor(terrainWidth, terrainDepth, { 255, 0, 0, 0 });
-
-		RaylibWrapper::Color* pixels = RaylibWrapper::LoadImageColors(splatImage);
-
-		for (int z = 0; z < terrainDepth; z++)
-		{
-			for (int x = 0; x < terrainWidth; x++)
-			{
-				int index = z * terrainWidth + x;
+		if (terrainLayers[i].splatmap.size() != static_cast<size_t>(terrainWidth) * terrainDepth)
+			return;
+		layers[i] = terrainLayers[i].splatmap.data();
+	}
 
-				pixels[index].r = (layerCount > 0) ? (unsigned char)(terrainLayers[0].splatmap[z][x] * 255) : 255;
-				pixels[index].g = (layerCount > 1) ? (unsigned char)(terrainLayers[1].splatmap[z][x] * 255) : 0;
-				pixels[index].b = (layerCount > 2) ? (unsigned char)(terrainLayers[2].splatmap[z][x] * 255) : 0;
-				pixels[index].a = (layerCount > 3) ? (unsigned char)(terrainLayers[3].splatmap[z][x] * 255) : 0;
-			}
-		}
+	// Packed and uploaded in full here, painting only updates the rect it changed
+	splatmapPixels.resize(static_cast<size_t>(terrainWidth) * terrainDepth * 4);
+	TerrainSplatmap::Pack(layers, layerCount, terrainWidth, 0, 0, terrainWidth - 1, terrainDepth - 1, splatmapPixels.data());
+	splatDirtyMaxX = -1;
+	splatDirtyMaxZ = -1;
 
-		RaylibWrapper::UnloadImageColors(pixels);
+	if (!splatmapGenerated)
+	{
+		// The image only borrows the pixels, so it isn't unloaded
+		RaylibWrapper::Image splatImage = { splatmapPixels.data(), terrainWidth, terrainDepth, 1, RaylibWrapper::PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
 		splatmapTexture = RaylibWrapper::LoadTextureFromImage(splatImage);
-		RaylibWrapper::UnloadImage(splatImage);
 		splatmapGenerated = true;
 	}
 	else
-	{
-		// Update existing texture
-		RaylibWrapper::Image splatImage = RaylibWrapper::GenImageColor(terrainWidth, terrainDepth, { 255, 0, 0, 0 });
-		RaylibWrapper::Color* pixels = RaylibWrapper::LoadImageColors(splatImage);
-
-		for (int z = 0; z < terrainDepth; z++)
-		{
-			for (int x = 0; x < terrainWidth; x++)
-			{
-				int index = z * terrainWidth + x;
-
-				pixels[index].r = (layerCount > 0) ? (unsigned char)(terrainLayers[0].splatmap[z][x] * 255) : 255;
-				pixels[index].g = (layerCount > 1) ? (unsigned char)(terrainLayers[1].splatmap[z][x] * 255) : 0;
-				pixels[index].b = (layerCount > 2) ? (unsigned char)(terrainLayers[2].splatmap[z][x] * 255) : 0;
-				pixels[index].a = (layerCount > 3) ? (unsigned char)(terrainLayers[3].splatmap[z][x] * 255) : 0;
-			}
-		}
-
-		RaylibWrapper::UpdateTexture(splatmapTexture, pixels);
-		RaylibWrapper::UnloadImageColors(pixels);
-		RaylibWrapper::UnloadImage(splatImage);
-	}
+		RaylibWrapper::UpdateTexture(splatmapTexture, splatmapPixels.data());
 
 	// Apply the terrain shader to the model
 	if (modelGenerated)
@@ -781,11 +1173,68 @@ void Terrain::UpdateSplatmapTexture()
 	}
 }
 
+void Terrain::MarkSplatmapDirty(int minX, int minZ, int maxX, int maxZ)
+{
+	MarkCollisionDirty(minX, minZ, maxX, maxZ); // The collider's materials follow the dominant layer
+
+	if (splatDirtyMaxX < splatDirtyMinX)
+	{
+		splatDirtyMinX = minX;
+		splatDirtyMinZ = minZ;
+		splatDirtyMaxX = maxX;
+		splatDirtyMaxZ = maxZ;
+	}
+	else
+	{
+		splatDirtyMinX = std::min(splatDirtyMinX, minX);
+		splatDirtyMinZ = std::min(splatDirtyMinZ, minZ);
+		splatDirtyMaxX = std::max(splatDirtyMaxX, maxX);
+		splatDirtyMaxZ = std::max(splatDirtyMaxZ, maxZ);
+	}
+}
+
+void Terrain::UpdateDirtySplatmap()
+{
+	if (splatDirtyMaxX < splatDirtyMinX)
+		return;
+
+	int minX = std::max(splatDirtyMinX, 0);
+	int minZ = std::max(splatDirtyMinZ, 0);
+	int maxX = std::min(splatDirtyMaxX, terrainWidth - 1);
+	int maxZ = std::min(splatDirtyMaxZ, terrainDepth - 1);
+	splatDirtyMaxX = -1;
+	splatDirtyMaxZ = -1;
+
+	// Without a texture at this size there's nothing to update in place
+	if (!splatmapGenerated || splatmapPixels.size() != static_cast<size_t>(terrainWidth) * terrainDepth * 4)
+	{
+		UpdateSplatmapTexture();
+		return;
+	}
+
+	if (minX > maxX || minZ > maxZ)
+		return;
+
+	int layerCount = std::min(TerrainSplatmap::maxLayers, GetLayerCount());
+	const float* layers[TerrainSplatmap::maxLayers] = {};
+	for (int i = 0; i < layerCount; i++)
+	{
+		if (terrainLayers[i].splatmap.size() != static_cast<size_t>(terrainWidth) * terrainDepth)
+			return;
+		layers[i] = terrainLayers[i].splatmap.data();
+	}
+
+	TerrainSplatmap::Pack(layers, layerCount, terrainWidth, minX, minZ, maxX, maxZ, splatmapPixels.data());
+	TerrainSplatmap::CopyRect(splatmapPixels.data(), terrainWidth, minX, minZ, maxX, maxZ, splatmapUploadScratch);
+	RaylibWrapper::UpdateTextureRec(splatmapTexture, { static_cast<float>(minX), static_cast<float>(minZ), static_cast<float>(maxX - minX + 1), static_cast<float>(maxZ - minZ + 1) },
+		splatmapUploadScratch.data());
+}
+
 void Terrain::AddTerrainLayer(const std::string& materialPath, const std::string& name) {
 	TerrainLayer newLayer;
 	newLayer.material = Material::GetMaterial(materialPath);
 	newLayer.name = name;
-	newLayer.splatmap.resize(terrainDepth, std::vector<float>(terrainWidth, 0.0f));
+	newLayer.splatmap.assign(heightData.size(), 0.0f);
 	terrainLayers.push_back(newLayer);
 
 	// Renormalize splatmap weights so no pixel becomes all-zero
@@ -794,12 +1243,13 @@ void Terrain::AddTerrainLayer(const std::string& materialPath, const std::string
 			NormalizeSplatmaps(x, z);
 			// If after normalization total is still 0 (all layers were zero), make first layer full
 			float total = 0.0f;
-			for (auto& layer : terrainLayers) total += layer.splatmap[z][x];
-			if (total <= 0.0f && !terrainLayers.empty()) terrainLayers[0].splatmap[z][x] = 1.0f;
+			for (auto& layer : terrainLayers) total += layer.splatmap[z * terrainWidth + x];
+			if (total <= 0.0f && !terrainLayers.empty()) terrainLayers[0].splatmap[z * terrainWidth + x] = 1.0f;
 		}
 	}
 
 	needsSplatmapUpdate = true;
+	collisionNeedsRebuild = true;
 }
 
 
@@ -818,6 +1268,7 @@ void Terrain::RemoveTerrainLayer(int layerIndex)
 	}
 
 	needsSplatmapUpdate = true;
+	collisionNeedsRebuild = true;
 }
 
 TerrainLayer* Terrain::GetLayer(int index)
@@ -834,18 +1285,22 @@ const TerrainLayer* Terrain::GetLayer(int index) const
 
 nlohmann::json Terrain::SerializeHeightData()
 {
-	return heightData;
+	return GridToJson(heightData, dataWidth, dataDepth);
 }
 
 void Terrain::LoadHeightData(const nlohmann::json& data)
 {
-	heightData.clear();
-
+	// The widest row sets the width, ResizeTerrainData() fits it to the terrain's size later
+	raycaster.Clear(); // It points at the old heights
+	dataDepth = static_cast<int>(data.size());
+	dataWidth = 0;
 	for (const auto& row : data)
-		heightData.push_back(row.get<std::vector<float>>());
+		dataWidth = std::max(dataWidth, static_cast<int>(row.size()));
+
+	heightData = GridFromJson(data, dataWidth, dataDepth);
 }
 
-nlohmann::json Terrain::SerializeLayerData()
+nlohmann::json Terrain::SerializeLayerData(bool includeSplatmaps)
 {
 	nlohmann::json layersJson;
 
@@ -861,7 +1316,8 @@ nlohmann::json Terrain::SerializeLayerData()
 			layerJson["materialPath"] = "nullptr";
 
 		// Store splatmap data
-		layerJson["splatmap"] = terrainLayers[i].splatmap;
+		if (includeSplatmaps)
+			layerJson["splatmap"] = GridToJson(terrainLayers[i].splatmap, dataWidth, dataDepth);
 
 		layersJson.push_back(layerJson);
 	}
@@ -893,17 +1349,11 @@ void Terrain::LoadLayerData(const nlohmann::json& data)
 				layer.material = Material::GetMaterial(matPath);
 		}
 
+		// Splatmaps share the height data's layout
 		if (layerJson.contains("splatmap") && layerJson["splatmap"].is_array())
-		{
-			layer.splatmap.clear();
-			for (auto& row : layerJson["splatmap"])
-				layer.splatmap.push_back(row.get<std::vector<float>>());
-		}
+			layer.splatmap = GridFromJson(layerJson["splatmap"], dataWidth, dataDepth);
 		else
-		{
-			// Initialize empty splatmap if not provided
-			layer.splatmap.resize(terrainDepth, std::vector<float>(terrainWidth, 0.0f));
-		}
+			layer.splatmap.assign(heightData.size(), 0.0f); // Initialize empty splatmap if not provided
 
 		terrainLayers.push_back(layer);
 	}
@@ -936,6 +1386,8 @@ void Terrain::PaintMeshes(float worldX, float worldZ, float radius, float densit
 	float centeredX = WorldToHeightmapX(worldX);
 	float centeredZ = WorldToHeightmapZ(worldZ);
 
+	InstanceSpatialHash& instanceHash = GetInstanceHash(terrainMesh);
+
 	for (int i = 0; i < meshesToPlace; i++)
 	{
 		// Random position within brush radius
@@ -953,23 +1405,8 @@ void Terrain::PaintMeshes(float worldX, float worldZ, float radius, float densit
 			continue;
 
 		// Check if too close to existing instances (density control)
-		bool tooClose = false;
 		float minDistance = 2.0f / density; // Closer spacing for higher density
-
-		for (const MeshInstance& existing : terrainMesh.instances)
-		{
-			float dx = existing.position.x - (worldX + offsetX);
-			float dz = existing.position.z - (worldZ + offsetZ);
-			float distToExisting = sqrtf(dx * dx + dz * dz);
-
-			if (distToExisting < minDistance)
-			{
-				tooClose = true;
-				break;
-			}
-		}
-
-		if (tooClose)
+		if (instanceHash.AnyWithin(worldX + offsetX, worldZ + offsetZ, minDistance))
 			continue;
 
 		// Create new mesh instance
@@ -988,30 +1425,7 @@ void Terrain::PaintMeshes(float worldX, float worldZ, float radius, float densit
 		if (alignToNormal)
 		{
 			// Align to terrain normal
-			Vector3 normal = GetNormalAtWorldPosition(placeX, placeZ);
-
-			// Calculate rotation from up vector to normal
-			Vector3 up = { 0.0f, 1.0f, 0.0f };
-			Vector3 axis = {
-				up.y * normal.z - up.z * normal.y,
-				up.z * normal.x - up.x * normal.z,
-				up.x * normal.y - up.y * normal.x
-			};
-
-			float axisLength = sqrtf(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
-			if (axisLength > 0.001f)
-			{
-				axis.x /= axisLength;
-				axis.y /= axisLength;
-				axis.z /= axisLength;
-
-				float angle = acosf(up.x * normal.x + up.y * normal.y + up.z * normal.z);
-				instance.rotation.x = axis.x * angle;
-				instance.rotation.y = axis.y * angle;
-				instance.rotation.z = axis.z * angle;
-			}
-			else
-				instance.rotation = { 0.0f, 0.0f, 0.0f };
+			instance.rotation = GetRotationFromNormal(GetNormalAtWorldPosition(placeX, placeZ));
 
 			// Add random Y rotation
 			instance.rotation.y += dist(gen) * 2.0f * 3.14159f * rotationRandomness;
@@ -1025,7 +1439,9 @@ void Terrain::PaintMeshes(float worldX, float worldZ, float radius, float densit
 		}
 
 		// Add instance
+		instanceHash.Insert(static_cast<int>(terrainMesh.instances.size()), instance.position.x, instance.position.z);
 		terrainMesh.instances.push_back(instance);
+		terrainMesh.chunksDirty = true;
 	}
 }
 
@@ -1037,16 +1453,26 @@ void Terrain::EraseMeshes(float worldX, float worldZ, float radius, int terrainM
 	TerrainMesh& terrainMesh = terrainMeshs[terrainMeshIndex];
 
 	// Remove instances within radius
-	terrainMesh.instances.erase(
-		std::remove_if(terrainMesh.instances.begin(), terrainMesh.instances.end(),
-			[worldX, worldZ, radius](const MeshInstance& instance) {
-				float dx = instance.position.x - worldX;
-				float dz = instance.position.z - worldZ;
-				float dist = sqrtf(dx * dx + dz * dz);
-				return dist < radius;
-			}),
-		terrainMesh.instances.end()
-	);
+	InstanceSpatialHash& instanceHash = GetInstanceHash(terrainMesh);
+	std::vector<int> erased;
+	instanceHash.QueryRadius(worldX, worldZ, radius, erased);
+	if (erased.empty())
+		return;
+
+	// Swapped with the last instance, highest first so the ones still to be erased aren't the ones moved
+	std::sort(erased.begin(), erased.end(), std::greater<int>());
+	for (int index : erased)
+	{
+		int last = static_cast<int>(terrainMesh.instances.size()) - 1;
+		instanceHash.Remove(index, terrainMesh.instances[index].position.x, terrainMesh.instances[index].position.z);
+		if (index != last)
+		{
+			terrainMesh.instances[index] = terrainMesh.instances[last];
+			instanceHash.Renumber(last, index, terrainMesh.instances[index].position.x, terrainMesh.instances[index].position.z);
+		}
+		terrainMesh.instances.pop_back();
+	}
+	terrainMesh.chunksDirty = true;
 }
 
 void Terrain::AddTerrainMesh(const std::string& modelPath, const std::string& materialPath, const std::string& name)
@@ -1078,6 +1504,7 @@ void Terrain::RemoveTerrainMesh(int layerIndex)
 
 	// Clean up cached model if it's the only layer using it
 	TerrainMesh& layer = terrainMeshs[layerIndex];
+	layer.impostor.Unload();
 	if (layer.cachedModel)
 	{
 		bool isUsedByOthers = false;
@@ -1166,35 +1593,165 @@ void Terrain::LoadTerrainMeshModels()
 
 void Terrain::RenderTerrainMeshs(bool renderShadows)
 {
+	// Camera position of the current pass
+	RaylibWrapper::Matrix inverseView = RaylibWrapper::MatrixInvert(RaylibWrapper::rlGetMatrixModelview());
+	float viewPosition[3] = { inverseView.m12, inverseView.m13, inverseView.m14 };
+
+	static std::vector<RaylibWrapper::Matrix> nearTransforms;
+	static std::vector<ImpostorQuad> impostorQuads;
+
 	for (TerrainMesh& layer : terrainMeshs)
 	{
 		if (!layer.cachedModel || layer.instances.empty())
 			continue;
 
-		// Render all instances of this Mesh
-		for (const MeshInstance& instance : layer.instances)
+		if (layer.chunksDirty)
+			RebuildTerrainMeshChunks(layer);
+
+		// Set material if needed
+		if (layer.cachedMaterial && !layer.cachedModel->CompareMaterials({ layer.cachedMaterial->GetID() }))
+			layer.cachedModel->SetMaterials({ layer.cachedMaterial->GetRaylibMaterial() });
+		else if (!layer.cachedMaterial && layer.cachedModel->GetMaterialID(0) != 1)
+			layer.cachedModel->SetEmbeddedMaterials();
+
+		bool impostors = useImpostors && BakeTerrainMeshImpostor(layer);
+		float fadeDistance = std::max(impostorFadeDistance, 0.0f);
+		impostorQuads.clear();
+
+		// Draw each visible chunk of this Mesh instanced
+		for (const TerrainMesh::Chunk& chunk : layer.chunks)
 		{
-			// Convert euler angles to quaternion for rendering
-			Quaternion quat = EulerToQuaternion(instance.rotation.x * DEG2RAD, instance.rotation.y * DEG2RAD, instance.rotation.z * DEG2RAD);
+			if (!RenderCulling::IsVisible(chunk.bounds))
+				continue;
 
-			// Set material if needed
-			if (layer.cachedMaterial && !layer.cachedModel->CompareMaterials({ layer.cachedMaterial->GetID() }))
-				layer.cachedModel->SetMaterials({ layer.cachedMaterial->GetRaylibMaterial() });
-			else if (!layer.cachedMaterial && layer.cachedModel->GetMaterialID(0) != 1)
-				layer.cachedModel->SetEmbeddedMaterials();
-
-			// Draw the instance
-			layer.cachedModel->DrawModelWrapper(
-				instance.position.x, instance.position.y, instance.position.z,
-				instance.scale.x, instance.scale.y, instance.scale.z,
-				quat.x, quat.y, quat.z, quat.w,
-				255, 255, 255, 255
-			);
+			float nearestSquared = 0.0f;
+			float farthestSquared = 0.0f;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float nearest = std::max({ chunk.bounds.min[axis] - viewPosition[axis], 0.0f, viewPosition[axis] - chunk.bounds.max[axis] });
+				float farthest = std::max(std::abs(viewPosition[axis] - chunk.bounds.min[axis]), std::abs(viewPosition[axis] - chunk.bounds.max[axis]));
+				nearestSquared += nearest * nearest;
+				farthestSquared += farthest * farthest;
+			}
+
+			if (!impostors || farthestSquared < impostorDistance * impostorDistance)
+			{
+				layer.cachedModel->DrawModelInstanced(chunk.transforms.data(), static_cast<int>(chunk.transforms.size()));
+				continue;
+			}
+
+			// Instances fade in as impostors past impostorDistance, and the models stop being drawn once they've faded in
+			bool allImpostors = nearestSquared > (impostorDistance + fadeDistance) * (impostorDistance + fadeDistance);
+			nearTransforms.clear();
+			for (size_t i = 0; i < chunk.instances.size(); i++)
+			{
+				const ModelInstance& instance = chunk.instances[i];
+				float offset[3] = { instance.posX - viewPosition[0], instance.posY - viewPosition[1], instance.posZ - viewPosition[2] };
+				float distance = std::sqrt(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]);
+
+				if (!allImpostors && distance < impostorDistance + fadeDistance)
+					nearTransforms.push_back(chunk.transforms[i]);
+
+				if (distance <= impostorDistance)
+					continue;
+
+				float fade = fadeDistance > 0.0f ? std::min((distance - impostorDistance) / fadeDistance, 1.0f) : 1.0f;
+				Quaternion rotation = { instance.rotationX, instance.rotationY, instance.rotationZ, instance.rotationW };
+				Vector3 center = RotateVector3ByQuaternion({ layer.impostorAtlas.center[0] * instance.sizeX, layer.impostorAtlas.center[1] * instance.sizeY,
+					layer.impostorAtlas.center[2] * instance.sizeZ }, rotation);
+
+				ImpostorQuad quad;
+				quad.posX = instance.posX + center.x;
+				quad.posY = instance.posY + center.y;
+				quad.posZ = instance.posZ + center.z;
+
+				// Faces the camera around the up axis
+				float directionX = viewPosition[0] - quad.posX;
+				float directionZ = viewPosition[2] - quad.posZ;
+				float length = std::sqrt(directionX * directionX + directionZ * directionZ);
+				if (length < 0.0001f)
+					continue;
+				directionX /= length;
+				directionZ /= length;
+				quad.rightX = directionZ;
+				quad.rightZ = -directionX;
+
+				// The frame is picked from the direction to the camera in the model's space
+				Quaternion inverseRotation = { -rotation.x, -rotation.y, -rotation.z, rotation.w };
+				Vector3 localDirection = RotateVector3ByQuaternion({ directionX, 0.0f, directionZ }, inverseRotation);
+				quad.frame = ImpostorBaker::GetFrame(layer.impostorAtlas, localDirection.x, localDirection.z);
+
+				quad.halfWidth = layer.impostorAtlas.quadSize * 0.5f * std::max(std::abs(instance.sizeX), std::abs(instance.sizeZ));
+				quad.halfHeight = layer.impostorAtlas.quadSize * 0.5f * std::abs(instance.sizeY);
+				quad.fade = static_cast<unsigned char>(fade * 255.0f);
+				impostorQuads.push_back(quad);
+			}
+
+			if (!nearTransforms.empty())
+				layer.cachedModel->DrawModelInstanced(nearTransforms.data(), static_cast<int>(nearTransforms.size()));
+		}
+
+		if (!impostorQuads.empty())
+			layer.impostor.Draw(impostorQuads.data(), static_cast<int>(impostorQuads.size()));
+	}
+}
+
+bool Terrain::BakeTerrainMeshImpostor(TerrainMesh& terrainMesh)
+{
+	if (terrainMesh.impostorBaked)
+		return terrainMesh.impostor.IsLoaded();
+
+	terrainMesh.impostorBaked = true;
+	if (!terrainMesh.cachedModel)
+		return false;
+
+	if (!ImpostorBaker::Bake(terrainMesh.cachedModel->GetImpostorSources(), terrainMesh.impostorAtlas))
+		return false;
+
+	bool loaded = terrainMesh.impostor.Load(terrainMesh.impostorAtlas);
+	terrainMesh.impostorAtlas.pixels.clear();
+	terrainMesh.impostorAtlas.pixels.shrink_to_fit();
+	return loaded;
+}
+
+void Terrain::RebuildTerrainMeshChunks(TerrainMesh& terrainMesh)
+{
+	terrainMesh.chunks.clear();
+	terrainMesh.chunksDirty = false;
+
+	if (!terrainMesh.cachedModel)
+		return;
+
+	RaylibWrapper::BoundingBox modelBounds = terrainMesh.cachedModel->GetBounds();
+
+	// Chunks are keyed by their cell in the world, so instances stay in the same chunk wherever the terrain is
+	std::unordered_map<uint64_t, int> chunkIndices;
+	for (const MeshInstance& instance : terrainMesh.instances)
+	{
+		int chunkX = static_cast<int>(std::floor(instance.position.x / meshChunkSize));
+		int chunkZ = static_cast<int>(std::floor(instance.position.z / meshChunkSize));
+		uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(chunkX)) << 32) | static_cast<uint32_t>(chunkZ);
+
+		Quaternion rotation = EulerToQuaternion(instance.rotation.x * DEG2RAD, instance.rotation.y * DEG2RAD, instance.rotation.z * DEG2RAD);
+		CullingBounds bounds = RenderCulling::GetWorldBounds(modelBounds, instance.position, rotation, instance.scale);
+
+		auto it = chunkIndices.find(key);
+		if (it == chunkIndices.end())
+		{
+			it = chunkIndices.emplace(key, static_cast<int>(terrainMesh.chunks.size())).first;
+			terrainMesh.chunks.emplace_back();
+			terrainMesh.chunks.back().bounds = bounds;
 		}
+
+		TerrainMesh::Chunk& chunk = terrainMesh.chunks[it->second];
+		chunk.bounds = CullingBounds::Combine(chunk.bounds, bounds);
+		chunk.instances.push_back({ instance.position.x, instance.position.y, instance.position.z,
+			instance.scale.x, instance.scale.y, instance.scale.z, rotation.x, rotation.y, rotation.z, rotation.w });
+		chunk.transforms.push_back(RaylibModel::GetInstanceTransform(chunk.instances.back()));
 	}
 }
 
-nlohmann::json Terrain::SerializeMeshData()
+nlohmann::json Terrain::SerializeMeshData(bool includeInstances)
 {
 	nlohmann::json terrainMeshsJson;
 
@@ -1206,16 +1763,19 @@ nlohmann::json Terrain::SerializeMeshData()
 		layerJson["materialPath"] = terrainMesh.materialPath;
 		layerJson["modelType"] = static_cast<int>(terrainMesh.modelType);
 
-		nlohmann::json instancesJson;
-		for (const MeshInstance& instance : terrainMesh.instances)
+		if (includeInstances)
 		{
-			nlohmann::json instanceJson;
-			instanceJson["position"] = { instance.position.x, instance.position.y, instance.position.z };
-			instanceJson["rotation"] = { instance.rotation.x, instance.rotation.y, instance.rotation.z };
-			instanceJson["scale"] = { instance.scale.x, instance.scale.y, instance.scale.z };
-			instancesJson.push_back(instanceJson);
+			nlohmann::json instancesJson;
+			for (const MeshInstance& instance : terrainMesh.instances)
+			{
+				nlohmann::json instanceJson;
+				instanceJson["position"] = { instance.position.x, instance.position.y, instance.position.z };
+				instanceJson["rotation"] = { instance.rotation.x, instance.rotation.y, instance.rotation.z };
+				instanceJson["scale"] = { instance.scale.x, instance.scale.y, instance.scale.z };
+				instancesJson.push_back(instanceJson);
+			}
+			layerJson["instances"] = instancesJson;
 		}
-		layerJson["instances"] = instancesJson;
 
 		terrainMeshsJson.push_back(layerJson);
 	}
@@ -1295,6 +1855,7 @@ void Terrain::AddAutoMeshRule(const std::string& name, int targetLayerIndex)
 	rule.name = name;
 	rule.targetLayerIndex = targetLayerIndex;
 	rule.maxHeight = terrainHeight; // Set to current terrain max height
+	rule.seed = std::random_device()();
 
 	autoMeshRules.push_back(rule);
 }
@@ -1418,6 +1979,8 @@ void Terrain::ClearAutoGeneratedMeshes()
 				if (mesh && mesh->modelPath == variant.modelPath)
 				{
 					mesh->instances.clear();
+					mesh->chunksDirty = true;
+					mesh->instanceHashDirty = true;
 				}
 			}
 		}
@@ -1538,9 +2101,10 @@ bool Terrain::CheckPlacementConstraints(const AutoMeshRule& rule, int x, int z,
 	if (rule.targetLayerIndex >= 0 && rule.targetLayerIndex < GetLayerCount())
 	{
 		const TerrainLayer* layer = GetLayer(rule.targetLayerIndex);
-		if (layer && z < (int)layer->splatmap.size() && x < (int)layer->splatmap[z].size())
+		size_t index = static_cast<size_t>(z) * terrainWidth + x;
+		if (layer && x >= 0 && z >= 0 && x < terrainWidth && index < layer->splatmap.size())
 		{
-			float weight = layer->splatmap[z][x];
+			float weight = layer->splatmap[index];
 			if (weight < rule.textureWeightThreshold)
 				return false;
 		}
@@ -1556,138 +2120,166 @@ void Terrain::GenerateAutoMeshesForRule(AutoMeshRule& rule)
 	if (rule.meshVariants.empty() || rule.cachedVariants.empty())
 		return;
 
-	static std::random_device rd;
-	static std::mt19937 gen(rd());
-	std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-
 	// Calculate cell size based on density
 	float cellSize = 1.0f / sqrtf(rule.density);
 	int cellsX = (int)(terrainWidth / cellSize);
 	int cellsZ = (int)(terrainDepth / cellSize);
+	if (cellsX <= 0 || cellsZ <= 0)
+		return;
 
-	// Track which terrain mesh indices we're adding to
-	std::vector<int> usedMeshIndices;
+	// The cells are split into tiles that are generated in parallel. Each tile seeds its own generator from the rule's seed,
+	// so the placement is the same no matter how many threads there are or which order the tiles finish in.
+	int tilesX = (cellsX + autoMeshTileCells - 1) / autoMeshTileCells;
+	int tilesZ = (cellsZ + autoMeshTileCells - 1) / autoMeshTileCells;
+	int tileCount = tilesX * tilesZ;
 
-	// For each cell, attempt to place a mesh
-	for (int cz = 0; cz < cellsZ; cz++)
+	struct PlacedInstance
 	{
-		for (int cx = 0; cx < cellsX; cx++)
+		int variantIndex;
+		MeshInstance instance;
+	};
+	std::vector<std::vector<PlacedInstance>> tiles(tileCount);
+	Vector3 terrainPos = gameObject->transform.GetPosition();
+
+	auto generateTile = [&](int tile)
+	{
+		int tileX = tile % tilesX;
+		int tileZ = tile / tilesX;
+		std::mt19937 gen(GetTileSeed(rule.seed, tileX, tileZ));
+		std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+		int lastCellX = std::min((tileX + 1) * autoMeshTileCells, cellsX);
+		int lastCellZ = std::min((tileZ + 1) * autoMeshTileCells, cellsZ);
+		for (int cz = tileZ * autoMeshTileCells; cz < lastCellZ; cz++)
 		{
-			// Calculate cell center
-			float baseCenterX = cx * cellSize + cellSize * 0.5f;
-			float baseCenterZ = cz * cellSize + cellSize * 0.5f;
+			for (int cx = tileX * autoMeshTileCells; cx < lastCellX; cx++)
+			{
+				// Calculate cell center
+				float baseCenterX = cx * cellSize + cellSize * 0.5f;
+				float baseCenterZ = cz * cellSize + cellSize * 0.5f;
 
-			// Add random offset
-			float offsetX = (dist(gen) - 0.5f) * cellSize * rule.randomOffset;
-			float offsetZ = (dist(gen) - 0.5f) * cellSize * rule.randomOffset;
+				// Add random offset
+				float offsetX = (dist(gen) - 0.5f) * cellSize * rule.randomOffset;
+				float offsetZ = (dist(gen) - 0.5f) * cellSize * rule.randomOffset;
 
-			float centerX = baseCenterX + offsetX;
-			float centerZ = baseCenterZ + offsetZ;
+				float centerX = baseCenterX + offsetX;
+				float centerZ = baseCenterZ + offsetZ;
 
-			// Check bounds
-			if (centerX < 0 || centerX >= terrainWidth || centerZ < 0 || centerZ >= terrainDepth)
-				continue;
+				// Check bounds
+				if (centerX < 0 || centerX >= terrainWidth || centerZ < 0 || centerZ >= terrainDepth)
+					continue;
 
-			int x = (int)centerX;
-			int z = (int)centerZ;
+				int x = (int)centerX;
+				int z = (int)centerZ;
 
-			// Get terrain info at this position
-			float height = GetHeight(x, z);
-			Vector3 normal = GetNormalAtWorldPosition((float)x, (float)z);
+				// Get terrain info at this position
+				float height = GetHeight(x, z);
+				Vector3 normal = GetNormalAtWorldPosition((float)x, (float)z);
 
-			// Check placement constraints
-			if (!CheckPlacementConstraints(rule, x, z, height, normal))
-				continue;
+				// Check placement constraints
+				if (!CheckPlacementConstraints(rule, x, z, height, normal))
+					continue;
 
-			// Select a variant
-			MeshVariant* selectedVariant = SelectWeightedVariant(rule);
-			if (!selectedVariant)
-				continue;
+				PlacedInstance placed;
+				placed.variantIndex = SelectVariantIndex(rule, gen);
 
-			// Find or create the terrain mesh for this variant
-			int terrainMeshIndex = -1;
-			for (int i = 0; i < GetTerrainMeshCount(); i++)
-			{
-				TerrainMesh* mesh = GetTerrainMesh(i);
-				if (mesh && mesh->modelPath == selectedVariant->modelPath)
+				// World position
+				MeshInstance& instance = placed.instance;
+				instance.position = {
+					terrainPos.x + centerX - (terrainWidth * 0.5f),
+					terrainPos.y + height,
+					terrainPos.z + centerZ - (terrainDepth * 0.5f)
+				};
+
+				// Scale with variation
+				float baseScale = 1.0f;
+				float scaleRandom = 1.0f + (dist(gen) - 0.5f) * 2.0f * rule.scaleVariation;
+				instance.scale = { baseScale * scaleRandom, baseScale * scaleRandom, baseScale * scaleRandom };
+
+				// Rotation
+				if (rule.alignToNormal)
 				{
-					terrainMeshIndex = i;
-					break;
+					// Align to terrain normal, plus a random Y rotation
+					instance.rotation = GetRotationFromNormal(normal);
+					instance.rotation.y += dist(gen) * 2.0f * 3.14159f * rule.rotationRandomness;
+				}
+				else
+				{
+					// Random rotation around Y axis
+					instance.rotation.x = 0.0f;
+					instance.rotation.y = dist(gen) * 2.0f * 3.14159f;
+					instance.rotation.z = 0.0f;
 				}
-			}
 
-			// If terrain mesh doesn't exist, create it
-			if (terrainMeshIndex == -1)
-			{
-				AddTerrainMesh(selectedVariant->modelPath, selectedVariant->materialPath,
-					std::filesystem::path(selectedVariant->modelPath).stem().string());
-				terrainMeshIndex = GetTerrainMeshCount() - 1;
+				tiles[tile].push_back(placed);
 			}
+		}
+	};
 
-			TerrainMesh* terrainMesh = GetTerrainMesh(terrainMeshIndex);
-			if (!terrainMesh)
-				continue;
-
-			// Create mesh instance
-			MeshInstance instance;
+	// The calling thread takes a share of the tiles instead of waiting idle
+	int threadCount = std::min(std::max(1, static_cast<int>(std::thread::hardware_concurrency())), tileCount);
+	std::vector<std::future<void>> workers;
+	for (int thread = 1; thread < threadCount; thread++)
+	{
+		workers.push_back(std::async(std::launch::async, [&, thread]()
+		{
+			for (int tile = thread; tile < tileCount; tile += threadCount)
+				generateTile(tile);
+		}));
+	}
+	for (int tile = 0; tile < tileCount; tile += threadCount)
+		generateTile(tile);
+	for (std::future<void>& worker : workers)
+		worker.get();
 
-			// World position
-			Vector3 terrainPos = gameObject->transform.GetPosition();
-			instance.position = {
-				terrainPos.x + centerX - (terrainWidth * 0.5f),
-				terrainPos.y + height,
-				terrainPos.z + centerZ - (terrainDepth * 0.5f)
-			};
+	// Terrain meshes can't be added from the worker threads, so the instances are handed to them here in tile order
+	std::vector<size_t> variantCounts(rule.meshVariants.size(), 0);
+	for (const std::vector<PlacedInstance>& tile : tiles)
+		for (const PlacedInstance& placed : tile)
+			variantCounts[placed.variantIndex]++;
 
-			// Scale with variation
-			float baseScale = 1.0f;
-			float scaleRandom = 1.0f + (dist(gen) - 0.5f) * 2.0f * rule.scaleVariation;
-			instance.scale = { baseScale * scaleRandom, baseScale * scaleRandom, baseScale * scaleRandom };
+	// Track which terrain mesh indices we're adding to
+	std::vector<int> usedMeshIndices;
+	std::vector<int> variantMeshIndices(rule.meshVariants.size(), -1);
+	for (size_t variant = 0; variant < rule.meshVariants.size(); variant++)
+	{
+		if (variantCounts[variant] == 0)
+			continue;
 
-			// Rotation
-			if (rule.alignToNormal)
+		// Find or create the terrain mesh for this variant
+		const MeshVariant& meshVariant = rule.meshVariants[variant];
+		int terrainMeshIndex = -1;
+		for (int i = 0; i < GetTerrainMeshCount(); i++)
+		{
+			if (terrainMeshs[i].modelPath == meshVariant.modelPath)
 			{
-				// Align to terrain normal
-				Vector3 up = { 0.0f, 1.0f, 0.0f };
-				Vector3 axis = {
-					up.y * normal.z - up.z * normal.y,
-					up.z * normal.x - up.x * normal.z,
-					up.x * normal.y - up.y * normal.x
-				};
+				terrainMeshIndex = i;
+				break;
+			}
+		}
 
-				float axisLength = sqrtf(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
-				if (axisLength > 0.001f)
-				{
-					axis.x /= axisLength;
-					axis.y /= axisLength;
-					axis.z /= axisLength;
-
-					float angle = acosf(up.x * normal.x + up.y * normal.y + up.z * normal.z);
-					instance.rotation.x = axis.x * angle;
-					instance.rotation.y = axis.y * angle;
-					instance.rotation.z = axis.z * angle;
-				}
-				else
-					instance.rotation = { 0.0f, 0.0f, 0.0f };
+		if (terrainMeshIndex == -1)
+		{
+			AddTerrainMesh(meshVariant.modelPath, meshVariant.materialPath, std::filesystem::path(meshVariant.modelPath).stem().string());
+			terrainMeshIndex = GetTerrainMeshCount() - 1;
+		}
 
-				// Add random Y rotation
-				instance.rotation.y += dist(gen) * 2.0f * 3.14159f * rule.rotationRandomness;
-			}
-			else
-			{
-				// Random rotation around Y axis
-				instance.rotation.x = 0.0f;
-				instance.rotation.y = dist(gen) * 2.0f * 3.14159f;
-				instance.rotation.z = 0.0f;
-			}
+		variantMeshIndices[variant] = terrainMeshIndex;
+		if (std::find(usedMeshIndices.begin(), usedMeshIndices.end(), terrainMeshIndex) == usedMeshIndices.end())
+			usedMeshIndices.push_back(terrainMeshIndex);
 
-			// Add instance to terrain mesh
-			terrainMesh->instances.push_back(instance);
+		std::vector<MeshInstance>& instances = terrainMeshs[terrainMeshIndex].instances;
+		instances.reserve(instances.size() + variantCounts[variant]);
+	}
 
-			// Track this for the rule
-			if (std::find(usedMeshIndices.begin(), usedMeshIndices.end(), terrainMeshIndex) == usedMeshIndices.end())
-				usedMeshIndices.push_back(terrainMeshIndex);
-		}
+	for (const std::vector<PlacedInstance>& tile : tiles)
+		for (const PlacedInstance& placed : tile)
+			terrainMeshs[variantMeshIndices[placed.variantIndex]].instances.push_back(placed.instance);
+
+	for (int terrainMeshIndex : usedMeshIndices)
+	{
+		terrainMeshs[terrainMeshIndex].chunksDirty = true;
+		terrainMeshs[terrainMeshIndex].instanceHashDirty = true;
 	}
 
 	// Store which meshes were generated by this rule
@@ -1705,31 +2297,129 @@ void Terrain::GenerateAutoMeshesForRule(AutoMeshRule& rule)
 		autoGeneratedMeshIndices[ruleIndex] = usedMeshIndices;
 }
 
-nlohmann::json Terrain::SerializeTerrainData()
+std::filesystem::path Terrain::GetTerrainDataPath(const std::filesystem::path& scenePath, uint64_t version) const
+{
+	// Hidden next to the scene, like the scene's journal
+	return scenePath.parent_path() / ("." + scenePath.filename().string() + "." + std::to_string(id) + "." + std::to_string(version) + ".terrain");
+}
+
+void Terrain::RemoveStaleTerrainDataFiles(const std::filesystem::path& scenePath) const
+{
+	if (dataFileName.empty())
+		return;
+
+	// Matches every version, and the unversioned name data files had before
+	std::string prefix = "." + scenePath.filename().string() + "." + std::to_string(id) + ".";
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(scenePath.parent_path(), error))
+	{
+		std::string fileName = entry.path().filename().string();
+		if (fileName != dataFileName && fileName.compare(0, prefix.size(), prefix) == 0 && entry.path().extension() == ".terrain")
+		{
+			std::error_code removeError;
+			std::filesystem::remove(entry.path(), removeError);
+		}
+	}
+}
+
+bool Terrain::SaveTerrainDataFile(const std::filesystem::path& path) const
+{
+	if (heightData.empty())
+		return false;
+
+	TerrainDataContents contents;
+	contents.width = dataWidth;
+	contents.depth = dataDepth;
+	contents.heights = heightData.data();
+	for (const TerrainLayer& layer : terrainLayers)
+	{
+		if (layer.splatmap.size() != heightData.size())
+			return false;
+		contents.splatmaps.push_back(layer.splatmap.data());
+	}
+	for (const TerrainMesh& terrainMesh : terrainMeshs)
+		contents.meshInstances.push_back({ reinterpret_cast<const float*>(terrainMesh.instances.data()), static_cast<int>(terrainMesh.instances.size()) });
+
+	return TerrainDataFile::Save(path, contents, compressData);
+}
+
+nlohmann::json Terrain::SerializeTerrainData(const std::filesystem::path& scenePath)
 {
 	nlohmann::json dataJson;
-	dataJson["heightData"] = SerializeHeightData();
-	dataJson["layers"] = SerializeLayerData();
-	dataJson["terrainMeshes"] = SerializeMeshData();
+
+	if (!scenePath.empty())
+	{
+		// Written under a new name, so the file the saved scene references stays intact until the save that references this one is committed
+		std::filesystem::path dataPath = GetTerrainDataPath(scenePath, dataFileVersion + 1);
+		if (SaveTerrainDataFile(dataPath))
+		{
+			dataFileVersion++;
+			dataFileName = dataPath.filename().string();
+			dataJson["dataFile"] = dataFileName;
+			dataJson["dataFileVersion"] = dataFileVersion;
+			dataJson["layers"] = SerializeLayerData(false);
+			dataJson["terrainMeshes"] = SerializeMeshData(false);
+		}
+		else
+			ConsoleLogger::WarningLog(gameObject->GetName() + "'s Terrain failed to save its data to \"" + dataPath.string() + "\", so it will be saved in the scene instead.");
+	}
+
+	if (!dataJson.contains("dataFile"))
+	{
+		dataJson["heightData"] = SerializeHeightData();
+		dataJson["layers"] = SerializeLayerData();
+		dataJson["terrainMeshes"] = SerializeMeshData();
+	}
 	dataJson["autoMeshRules"] = SerializeAutoMeshRules();
 
 	return dataJson;
 }
 
-void Terrain::LoadTerrainData(const nlohmann::json& data)
+void Terrain::LoadTerrainData(const nlohmann::json& data, const std::filesystem::path& scenePath)
 {
-	if (data.contains("heightData"))
+	TerrainDataFile dataFile;
+	bool fromFile = false;
+	if (data.contains("dataFile"))
+	{
+		std::filesystem::path dataPath = scenePath.parent_path() / data["dataFile"].get<std::string>();
+		if (!scenePath.empty() && dataFile.Open(dataPath))
+		{
+			raycaster.Clear(); // It points at the old heights
+			dataWidth = dataFile.GetWidth();
+			dataDepth = dataFile.GetDepth();
+			heightData.resize(static_cast<size_t>(dataWidth) * dataDepth);
+			dataFile.ReadHeights(heightData.data());
+			fromFile = true;
+			dataFileName = data["dataFile"].get<std::string>();
+			dataFileVersion = std::max(dataFileVersion, data.value("dataFileVersion", static_cast<uint64_t>(0)));
+		}
+		else
+			ConsoleLogger::ErrorLog(gameObject->GetName() + "'s Terrain failed to load its data from \"" + dataPath.string() + "\".");
+	}
+	else if (data.contains("heightData"))
 		LoadHeightData(data["heightData"]);
 	else
 		ConsoleLogger::ErrorLog(gameObject->GetName() + "'s Terrain failed to load height data.");
 
 	if (data.contains("layers"))
+	{
 		LoadLayerData(data["layers"]);
+		for (int i = 0; fromFile && i < std::min(static_cast<int>(terrainLayers.size()), dataFile.GetLayerCount()); i++)
+			dataFile.ReadSplatmap(i, terrainLayers[i].splatmap.data());
+	}
 	else
 		ConsoleLogger::ErrorLog(gameObject->GetName() + "'s Terrain failed to load texture layers.");
 
 	if (data.contains("terrainMeshes"))
+	{
 		LoadMeshData(data["terrainMeshes"]);
+		for (int i = 0; fromFile && i < std::min(static_cast<int>(terrainMeshs.size()), dataFile.GetMeshCount()); i++)
+		{
+			terrainMeshs[i].instances.resize(dataFile.GetInstanceCount(i));
+			dataFile.ReadInstances(i, reinterpret_cast<float*>(terrainMeshs[i].instances.data()));
+			terrainMeshs[i].chunksDirty = true;
+		}
+	}
 	else
 		ConsoleLogger::ErrorLog(gameObject->GetName() + "'s Terrain failed to load meshes.");
 
@@ -1737,6 +2427,12 @@ void Terrain::LoadTerrainData(const nlohmann::json& data)
 		LoadAutoMeshRules(data["autoMeshRules"]);
 	else
 		ConsoleLogger::ErrorLog(gameObject->GetName() + "'s Terrain failed to load auto mesh rules.");
+
+#if defined(EDITOR)
+	// The loaded file is the committed one, so any other version was either replaced or written by a save that never committed
+	if (fromFile)
+		RemoveStaleTerrainDataFiles(scenePath);
+#endif
 }
 
 nlohmann::json Terrain::SerializeAutoMeshRules()
@@ -1758,6 +2454,7 @@ nlohmann::json Terrain::SerializeAutoMeshRules()
 		ruleJson["rotationRandomness"] = rule.rotationRandomness;
 		ruleJson["alignToNormal"] = rule.alignToNormal;
 		ruleJson["randomOffset"] = rule.randomOffset;
+		ruleJson["seed"] = rule.seed;
 
 		nlohmann::json variantsJson;
 		for (const MeshVariant& variant : rule.meshVariants)
@@ -1827,6 +2524,9 @@ void Terrain::LoadAutoMeshRules(const nlohmann::json& data)
 		if (ruleJson.contains("randomOffset"))
 			rule.randomOffset = ruleJson["randomOffset"].get<float>();
 
+		if (ruleJson.contains("seed"))
+			rule.seed = ruleJson["seed"].get<unsigned int>();
+
 		if (ruleJson.contains("variants") && ruleJson["variants"].is_array())
 		{
 			for (const nlohmann::json& variantJson : ruleJson["variants"])
@@ -1,11 +1,19 @@
 #pragma once
 #include "Components/Component.h"
 #include "Raylib/RaylibModelWrapper.h"
+#include "Raylib/RaylibImpostorWrapper.h"
 #include "Resources/Material.h"
 #include "Resources/Sprite.h"
 #include "Core/GameObject.h"
+#include "Systems/Rendering/CullingTree.h"
+#include "Systems/Rendering/TerrainLOD.h"
+#include "Systems/Rendering/HeightfieldRaycaster.h"
+#include "Systems/Rendering/InstanceSpatialHash.h"
+#include "Systems/Rendering/TerrainSplatmap.h"
 #include <vector>
 #include <string>
+#include <filesystem>
+#include <unordered_map>
 #include <cmath>
 #include "ThirdParty/Misc/json.hpp"
 
@@ -13,7 +21,7 @@ struct TerrainLayer
 {
 	Material* material = nullptr;
 	std::string name = "Layer";
-	std::vector<std::vector<float>> splatmap; // Per-vertex weight (0-1)
+	std::vector<float> splatmap; // Per-vertex weight (0-1), row-major in the same layout as the height data
 };
 
 struct MeshInstance
@@ -23,17 +31,44 @@ struct MeshInstance
 	Vector3 scale;
 };
 
+struct TerrainRaycastHit
+{
+	bool hit = false;
+	Vector3 position = { 0, 0, 0 };
+	Vector3 normal = { 0, 1, 0 };
+	float distance = 0.0f;
+};
+
 struct TerrainMesh
 {
 	std::string name = "Mesh";
 	std::string modelPath;
 	std::string materialPath;
 	ModelType modelType = ModelType::Custom;
-	std::vector<MeshInstance> instances;
+	std::vector<MeshInstance> instances; // Set chunksDirty and instanceHashDirty after changing these
+
+	// The instances' positions for painting and erasing. Rebuilt the next time it's needed once it's dirty.
+	InstanceSpatialHash instanceHash;
+	bool instanceHashDirty = true;
 
 	// Cached rendering data
 	RaylibModel* cachedModel = nullptr;
 	Material* cachedMaterial = nullptr;
+
+	// The instances grouped into square chunks of the terrain, with their transforms baked for instanced drawing
+	struct Chunk
+	{
+		CullingBounds bounds;
+		std::vector<RaylibWrapper::Matrix> transforms;
+		std::vector<ModelInstance> instances; // Same order as transforms, used to place impostors
+	};
+	std::vector<Chunk> chunks;
+	bool chunksDirty = true;
+
+	// Billboard drawn instead of the model for far instances. Baked the first time it's needed.
+	RaylibImpostor impostor;
+	ImpostorAtlas impostorAtlas; // The pixels are freed once uploaded
+	bool impostorBaked = false;
 };
 
 struct MeshVariant
@@ -57,6 +92,7 @@ struct AutoMeshRule
 	float rotationRandomness = 1.0f;
 	bool alignToNormal = true;
 	float randomOffset = 1.0f;
+	unsigned int seed = 0; // The same seed places the same meshes
 
 	std::vector<MeshVariant> meshVariants;
 
@@ -87,11 +123,15 @@ public:
                 ["int","terrainDepth",256,"Terrain Depth"],
                 ["float","terrainHeight",50.0,"Max Height"],
                 ["float","heightScale",1.0,"Height Scale"],
-                ["Sprite","heightmapSprite","nullptr","Heightmap Texture",{"Extensions":[".png",".jpg",".jpeg"]}],
+                ["Sprite","heightmapSprite","nullptr","Heightmap Texture",{"Extensions":[".png",".jpg",".jpeg",".raw",".r16"]}],
                 ["bool","enableLOD",true,"Enable LOD"],
                 ["int","lodLevels",4,"LOD Levels"],
                 ["float","lodDistance",100.0,"LOD Distance"],
-                ["bool","castShadows",true,"Cast Shadows"]
+                ["bool","castShadows",true,"Cast Shadows"],
+                ["bool","useImpostors",true,"Use Mesh Impostors"],
+                ["float","impostorDistance",150.0,"Impostor Distance"],
+                ["float","impostorFadeDistance",20.0,"Impostor Fade Distance"],
+                ["bool","compressData",false,"Compress Terrain Data"]
             ]
         ]
         )";
@@ -110,7 +150,10 @@ public:
 #endif
 	void Destroy() override;
 
-	bool RaycastToTerrain(const RaylibWrapper::Ray& ray, Vector3& hitPos);
+	// Rays are in world space and hit the terrain's full resolution triangles
+	bool RaycastToTerrain(const RaylibWrapper::Ray& ray, Vector3& hitPos, float maxDistance = 1000.0f) const;
+	// Splits the rays across threads, for picking or snapping many objects to the ground at once
+	void RaycastToTerrain(const std::vector<RaylibWrapper::Ray>& rays, std::vector<TerrainRaycastHit>& hits, float maxDistance = 1000.0f) const;
 	int WorldToHeightmapX(float worldX) const;
 	int WorldToHeightmapZ(float worldZ) const;
 
@@ -124,6 +167,14 @@ public:
 	int GetLODLevels() const { return lodLevels; }
 	float GetLODDistance() const { return lodDistance; }
 	bool IsCastingShadows() const { return castShadows; }
+	bool IsUsingImpostors() const { return useImpostors; }
+	float GetImpostorDistance() const { return impostorDistance; }
+	float GetImpostorFadeDistance() const { return impostorFadeDistance; }
+	const std::vector<float>& GetHeightData() const { return heightData; } // Row-major, GetWidth() * GetDepth() once the terrain is generated
+
+	// Samples whose heights or splat weights changed since the last call, inclusive, so the terrain's collider can update just that region.
+	// fullRebuild is set instead when the terrain was regenerated or its layers changed. Returns false if nothing changed.
+	bool TakeCollisionChanges(int& minX, int& minZ, int& maxX, int& maxZ, bool& fullRebuild);
 
 	// Height manipulation
 	void SetHeight(int x, int z, float height);
@@ -171,13 +222,16 @@ public:
 	void GenerateAutoMeshesForRule(AutoMeshRule& rule);
 
 	// Serialization
-	nlohmann::json SerializeTerrainData();
-	void LoadTerrainData(const nlohmann::json& data);
+	// With a scene path the heights, splatmaps and mesh instances are saved to a binary file next to the scene instead of the JSON
+	nlohmann::json SerializeTerrainData(const std::filesystem::path& scenePath = {});
+	void LoadTerrainData(const nlohmann::json& data, const std::filesystem::path& scenePath = {});
+	// Deletes the terrain's older data files. Only call it once the scene referencing the current one is saved.
+	void RemoveStaleTerrainDataFiles(const std::filesystem::path& scenePath) const;
 	nlohmann::json SerializeHeightData();
 	void LoadHeightData(const nlohmann::json& data);
-	nlohmann::json SerializeLayerData();
+	nlohmann::json SerializeLayerData(bool includeSplatmaps = true);
 	void LoadLayerData(const nlohmann::json& data);
-	nlohmann::json SerializeMeshData();
+	nlohmann::json SerializeMeshData(bool includeInstances = true);
 	void LoadMeshData(const nlohmann::json& datas);
 	nlohmann::json SerializeAutoMeshRules();
 	void LoadAutoMeshRules(const nlohmann::json& data);
@@ -188,13 +242,29 @@ private:
 	void GenerateFromHeightmap();
 	void RebuildMesh();
 	void UpdateSplatmapTexture();
+	void MarkSplatmapDirty(int minX, int minZ, int maxX, int maxZ);
+	void UpdateDirtySplatmap();
 	void InitializeSplatmaps();
 	void NormalizeSplatmaps(int x, int z);
+	void ResizeTerrainData();
+	bool GetBrushRect(float centerX, float centerZ, float radius, int& minX, int& minZ, int& maxX, int& maxZ) const;
+	void MarkHeightsDirty(int minX, int minZ, int maxX, int maxZ);
+	void MarkCollisionDirty(int minX, int minZ, int maxX, int maxZ);
+	std::filesystem::path GetTerrainDataPath(const std::filesystem::path& scenePath, uint64_t version) const;
+	bool SaveTerrainDataFile(const std::filesystem::path& path) const;
+	void UpdateDirtyHeights();
+	HeightfieldRay ToLocalRay(const RaylibWrapper::Ray& ray, float maxDistance) const;
+	TerrainRaycastHit ToWorldHit(const HeightfieldHit& hit) const;
 	void LoadTerrainShader();
 	void UpdateShaderTextures();
 	void InitializeMaterial();
 	void LoadTerrainMeshModels();
 	void RenderTerrainMeshs(bool renderShadows);
+	void RebuildTerrainMeshChunks(TerrainMesh& terrainMesh);
+	bool BakeTerrainMeshImpostor(TerrainMesh& terrainMesh);
+	void RebuildLOD();
+	void ClearLODChunks();
+	void RenderLODChunks(const Vector3& position, const Quaternion& rotation);
 
 private:
 	bool setupEditor = true;
@@ -212,6 +282,12 @@ private:
 	int lodLevels = 4;
 	float lodDistance = 100.0f;
 	bool castShadows = true;
+	bool useImpostors = true;
+	float impostorDistance = 150.0f; // Mesh instances further than this from the camera are drawn as impostors
+	float impostorFadeDistance = 20.0f; // Instances are drawn as both while they fade across this distance
+	bool compressData = false; // DEFLATE the terrain data file. Smaller, but it has to be decompressed instead of read from a mapping.
+	uint64_t dataFileVersion = 0; // Each save writes a new data file, so the file a scene or journal record references is never overwritten
+	std::string dataFileName; // The data file the terrain was last loaded from or saved to
 
 	int splatmapLoc = -1;
 	int texture1Loc = -1;
@@ -220,19 +296,49 @@ private:
 	int textureScaleLoc = -1;
 	std::pair<unsigned int, int*> terrainShader;
 
-	bool needsRebuild = false;
-	float lastRebuild = 0.0f;
-	bool needsSplatmapUpdate = false;
+	bool needsRebuild = false; // The dirty samples need to be pushed to the LOD chunks
+	int dirtyMinX = 0; // Samples changed since the last update, inclusive
+	int dirtyMinZ = 0;
+	int dirtyMaxX = -1;
+	int dirtyMaxZ = -1;
+	bool needsSplatmapUpdate = false; // The whole splatmap texture is packed and uploaded again, and the layers' textures are reassigned
+	int splatDirtyMinX = 0; // Splatmap samples painted since the last update, inclusive
+	int splatDirtyMinZ = 0;
+	int splatDirtyMaxX = -1;
+	int splatDirtyMaxZ = -1;
+	bool collisionNeedsRebuild = true; // Taken by the terrain's Collider3D, which rebuilds its height field
+	int collisionDirtyMinX = 0; // Samples sculpted or painted since the collider last updated, inclusive
+	int collisionDirtyMinZ = 0;
+	int collisionDirtyMaxX = -1;
+	int collisionDirtyMaxZ = -1;
 
-	std::vector<std::vector<float>> heightData;
+	std::vector<float> heightData; // Row-major, dataWidth * dataDepth
+	int dataWidth = 0; // Layout of heightData and the splatmaps. Loaded data keeps its own size until ResizeTerrainData() matches it to the terrain's.
+	int dataDepth = 0;
+	std::vector<float> brushScratch; // Heights under the smooth brush before it's applied
+	HeightfieldRaycaster raycaster; // Reads heightData directly, and is kept up to date as it's sculpted
 	std::vector<TerrainLayer> terrainLayers;
 	std::vector<TerrainMesh> terrainMeshs;
 	std::vector<AutoMeshRule> autoMeshRules;
 	std::map<int, std::vector<int>> autoGeneratedMeshIndices;
 
-	RaylibModel raylibModel;
+	RaylibModel raylibModel; // Holds the terrain's material, the geometry is drawn in LOD chunks
 	bool modelGenerated = false;
 
+	struct LODChunk
+	{
+		RaylibChunkMesh mesh;
+		int stitchEdges = 0;
+		int lastUsedPass = 0;
+	};
+	TerrainLOD lod;
+	std::unordered_map<int, LODChunk> lodChunks; // Chunks that have been drawn recently, by node
+	std::vector<unsigned short> lodIndices[16]; // Chunk indices for each combination of stitched edges
+	std::vector<TerrainLODSelection> lodSelection;
+	int lodPass = 0;
+
 	RaylibWrapper::Texture2D splatmapTexture = { 0 };
+	std::vector<unsigned char> splatmapPixels; // The splatmap texture's RGBA8 texels, packed from the layers' weights
+	std::vector<unsigned char> splatmapUploadScratch; // The painted rect of splatmapPixels, tightly packed for the upload
 	bool splatmapGenerated = false;
 };
\ No newline at end of file
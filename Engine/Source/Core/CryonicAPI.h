@@ -16,6 +16,10 @@
 // Physics
 #include "Components/Physics/Collider2D.h"
 #include "Components/Physics/Rigidbody2D.h"
+#include "Systems/Physics/CollisionLayers.h"
+#include "Systems/Physics/PhysicsSnapshot.h"
+#include "Systems/Physics/PhysicsQueries.h"
+#include "Systems/Physics/PhysicsMemory.h"
 #if defined(IS3D)
 #include "Components/Physics/Collider3D.h"
 #include "Components/Physics/Rigidbody3D.h"
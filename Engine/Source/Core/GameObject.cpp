@@ -7,6 +7,9 @@
 
 std::vector<GameObject*> GameObject::markedForDeletion;
 bool GameObject::markForDeletion = false;
+#if !defined(EDITOR)
+std::vector<GameObject*> GameObject::movedPhysicsObjects;
+#endif
 
 GameObject::GameObject(int id)
 {
@@ -36,6 +39,7 @@ bool GameObject::IsComponentValid(Component* component)
 void GameObject::SetComponentGameObject(Component* component)
 {
     component->gameObject = this;
+    dirty = true;
 }
 
 //Model GameObject::GetModel() const
@@ -79,6 +83,7 @@ void GameObject::SetActive(bool active)
     if (active == this->active)
         return;
     this->active = active;
+    dirty = true;
 
 #if !defined(EDITOR)
     if (IsGlobalActive())
@@ -118,6 +123,7 @@ void GameObject::SetGlobalActive(bool globalActive)
     if (globalActive == this->globalActive)
         return;
     this->globalActive = globalActive;
+    dirty = true;
 
 #if !defined(EDITOR)
     for (Component* component : components)
@@ -181,6 +187,7 @@ std::string GameObject::GetName() const
 void GameObject::SetName(std::string name)
 {
     this->name = name;
+    dirty = true;
 }
 
 
@@ -246,6 +253,8 @@ bool GameObject::RemoveComponent()
             component->Destroy();
             delete component;
             components.erase(it);
+            UpdateCollisionEvents();
+            dirty = true;
             return true;
         }
     }
@@ -269,11 +278,25 @@ bool GameObject::RemoveComponent(Component* component)
         component->Destroy();
         delete* it;
         components.erase(it);
+        UpdateCollisionEvents();
+        dirty = true;
         return true;
     }
     return false;
 }
 
+void GameObject::UpdateCollisionEvents()
+{
+    collisionEvents = 0;
+    for (Component* component : components)
+        collisionEvents |= component->collisionEvents;
+}
+
+bool GameObject::HasComponent(Component* component)
+{
+    return std::find(components.begin(), components.end(), component) != components.end();
+}
+
 void GameObject::Destroy()
 {
     SceneManager::GetActiveScene()->RemoveGameObject(this); // Todo: This assumes the game object is in the active scene.
@@ -311,7 +334,10 @@ bool GameObject::operator!=(const GameObject& other) const
 
 GameObject::~GameObject()
 {
-
+#if !defined(EDITOR)
+    if (physicsMoved)
+        movedPhysicsObjects.erase(std::remove(movedPhysicsObjects.begin(), movedPhysicsObjects.end(), this), movedPhysicsObjects.end());
+#endif
 }
 
 bool GameObject::IsChild(GameObject& gameObject, GameObject* parent)
@@ -344,6 +370,7 @@ void GameObject::SetParent(GameObject* gameObject)
         gameObject->SetParent(parentGameObject);
 
     parentGameObject = gameObject;
+    dirty = true;
     if (parentGameObject != nullptr) // If its nullptr, then the game object will become a root game object.
     {
         parentGameObject->childGameObjects.push_back(this);
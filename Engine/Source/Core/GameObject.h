@@ -8,9 +8,15 @@
 #include <filesystem>
 #include <memory>
 #include <algorithm>
+#include <cstdint>
 
 class Component;
 
+// Hide in API
+// Which OnCollision functions a component type overrides. Defined in Component.h
+template <typename T>
+uint8_t GetCollisionEvents();
+
 class GameObject
 {
 public:
@@ -81,6 +87,8 @@ public:
             return nullptr;
         }
         SetComponentGameObject(static_cast<Component*>(newComponent)); // Todo: This may cause a crash if its not a component
+        newComponent->collisionEvents = GetCollisionEvents<T>();
+        collisionEvents |= newComponent->collisionEvents;
         //Component* componentPtr = static_cast<Component*>(newComponent);
         //if (componentPtr)
         //    componentPtr->gameObject = this;
@@ -114,6 +122,8 @@ public:
     T& AddComponentInternal(int id = -1) {
         T* newComponent = new T(this, id);
         SetComponentGameObject(static_cast<Component*>(newComponent)); // Todo: This may cause a crash if its not a component
+        newComponent->collisionEvents = GetCollisionEvents<T>();
+        collisionEvents |= newComponent->collisionEvents;
         components.push_back(newComponent);
         return *newComponent;
     }
@@ -123,6 +133,8 @@ public:
     T& AddComponent(int id) {
         T* newComponent = new T(this, id);
         SetComponentGameObject(static_cast<Component*>(newComponent)); // Todo: This may cause a crash if its not a component
+        newComponent->collisionEvents = GetCollisionEvents<T>();
+        collisionEvents |= newComponent->collisionEvents;
         components.push_back(newComponent);
         return *newComponent;
     }
@@ -138,6 +150,11 @@ public:
     bool RemoveComponent();
 
     bool RemoveComponent(Component* component);
+    // Hide in API
+    void UpdateCollisionEvents();
+    // Hide in API
+    // Whether the component is still attached. For callers that hold a component while calling code that can remove it.
+    bool HasComponent(Component* component);
 
     void Destroy();
     void Destroy(Component* component);
@@ -170,6 +187,11 @@ public:
                 child->transform.SetPosition(child->transform.GetLocalPosition() + position);
 
             _position = position;
+#ifdef EDITOR
+            gameObject->dirty = true;
+#else
+            MarkPhysicsMoved();
+#endif
         }
         void SetPosition(Vector2 position) { SetPosition({position.x, position.y, _position.z}); }
         void SetPosition(float x, float y, float z) { SetPosition({ x, y, z }); }
@@ -194,6 +216,9 @@ public:
         {
 #ifdef EDITOR
             eulerRotation = QuaternionToEuler(rotation) * RAD2DEG;
+            gameObject->dirty = true;
+#else
+            MarkPhysicsMoved();
 #endif
             _rotation = rotation;
         }
@@ -207,6 +232,9 @@ public:
 #ifdef EDITOR
             eulerRotation = rotation;
             NormalizeEuler(eulerRotation); // Todo: Should this run when not in the editor too?
+            gameObject->dirty = true;
+#else
+            MarkPhysicsMoved();
 #endif
             for (GameObject* child : gameObject->childGameObjects)
                 child->transform.SetRotationEuler(child->transform.GetLocalRotationEuler() + rotation);
@@ -292,6 +320,9 @@ public:
 #ifdef EDITOR
             eulerRotation += euler;
             NormalizeEuler(eulerRotation);
+            gameObject->dirty = true;
+#else
+            MarkPhysicsMoved();
 #endif
             for (GameObject* child : gameObject->childGameObjects)
                 child->transform.Rotate(euler);
@@ -323,6 +354,11 @@ public:
                 child->transform.SetScale(child->transform.GetLocalScale() * scale);
 
             _scale = scale;
+#ifdef EDITOR
+            gameObject->dirty = true;
+#else
+            MarkPhysicsMoved();
+#endif
         }
         void SetScale(Vector2 scale) { SetScale({ scale.x, scale.y, _scale.z }); }
         void SetScale(float x, float y, float z) { SetScale({ x, y, z }); }
@@ -361,9 +397,33 @@ public:
             return !(*this == other);
         }
 
+#if !defined(EDITOR)
+        // Hide in API
+        // Used by the physics sync to move the game object to its body without queueing the body to be moved back. Children are still queued.
+        void SetPhysicsTransform(Vector3 position, Quaternion rotation)
+        {
+            bool moved = gameObject->physicsMoved;
+            gameObject->physicsMoved = true;
+            SetPosition(position);
+            SetRotation(rotation);
+            gameObject->physicsMoved = moved;
+        }
+#endif
+
         GameObject* gameObject;
 
     private:
+#if !defined(EDITOR)
+        void MarkPhysicsMoved()
+        {
+            if (!gameObject->hasPhysicsBody || gameObject->physicsMoved)
+                return;
+
+            gameObject->physicsMoved = true;
+            movedPhysicsObjects.push_back(gameObject);
+        }
+#endif
+
         Vector3 _position = { 0,0,0 };
         Quaternion _rotation = Quaternion::Identity();
         Vector3 eulerRotation = { 0,0,0 }; // Used only in the editor
@@ -375,6 +435,18 @@ public:
     static std::vector<GameObject*> markedForDeletion;
     // Hide in API
     static bool markForDeletion;
+    // Hide in API
+    bool dirty = false; // Set when the object or its components change in the editor. Only dirty objects are written by incremental scene saves.
+#if !defined(EDITOR)
+    // Hide in API
+    static std::vector<GameObject*> movedPhysicsObjects; // Game objects with a physics body that were moved since the last physics step
+    // Hide in API
+    bool hasPhysicsBody = false;
+    // Hide in API
+    bool physicsMoved = false;
+#endif
+    // Hide in API
+    uint8_t collisionEvents = 0; // Every collision event the components handle, so collisions skip game objects that don't handle them
 
 private:
     //Model model;
@@ -0,0 +1,74 @@
+#include "RaylibImpostorWrapper.h"
+#include "ThirdParty/Raylib/include/raylib.h"
+#include "ThirdParty/Raylib/include/rlgl.h"
+#include "Systems/Rendering/ShaderManager.h"
+
+bool RaylibImpostor::Load(const ImpostorAtlas& atlas)
+{
+    Unload();
+
+    if (atlas.pixels.empty() || atlas.width <= 0 || atlas.height <= 0)
+        return false;
+
+    Image image = { const_cast<uint8_t*>(atlas.pixels.data()), atlas.width, atlas.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    Texture2D texture = LoadTextureFromImage(image);
+    if (texture.id == 0)
+        return false;
+
+    GenTextureMipmaps(&texture);
+    SetTextureFilter(texture, TEXTURE_FILTER_TRILINEAR);
+
+    textureId = texture.id;
+    columns = atlas.columns;
+    rows = atlas.rows;
+    return true;
+}
+
+void RaylibImpostor::Unload()
+{
+    if (textureId != 0)
+        rlUnloadTexture(textureId);
+    textureId = 0;
+}
+
+void RaylibImpostor::Draw(const ImpostorQuad* quads, int count)
+{
+    if (textureId == 0 || count <= 0)
+        return;
+
+    std::pair<unsigned int, int*> shader = ShaderManager::GetShader(ShaderManager::Impostor);
+    if (shader.first != 0)
+        BeginShaderMode({ shader.first, shader.second });
+
+    float frameWidth = 1.0f / columns;
+    float frameHeight = 1.0f / rows;
+
+    rlSetTexture(textureId);
+    rlBegin(RL_QUADS);
+    rlNormal3f(0.0f, 1.0f, 0.0f);
+    for (int i = 0; i < count; i++)
+    {
+        const ImpostorQuad& quad = quads[i];
+        float u = (quad.frame % columns) * frameWidth;
+        float v = (quad.frame / columns) * frameHeight;
+        float rightX = quad.rightX * quad.halfWidth;
+        float rightZ = quad.rightZ * quad.halfWidth;
+
+        rlColor4ub(255, 255, 255, quad.fade);
+
+        // Counter clockwise when seen from the camera
+        rlTexCoord2f(u, v);
+        rlVertex3f(quad.posX - rightX, quad.posY + quad.halfHeight, quad.posZ - rightZ);
+        rlTexCoord2f(u, v + frameHeight);
+        rlVertex3f(quad.posX - rightX, quad.posY - quad.halfHeight, quad.posZ - rightZ);
+        rlTexCoord2f(u + frameWidth, v + frameHeight);
+        rlVertex3f(quad.posX + rightX, quad.posY - quad.halfHeight, quad.posZ + rightZ);
+        rlTexCoord2f(u + frameWidth, v);
+        rlVertex3f(quad.posX + rightX, quad.posY + quad.halfHeight, quad.posZ + rightZ);
+    }
+    rlEnd();
+    rlSetTexture(0);
+
+    if (shader.first != 0)
+        EndShaderMode();
+}
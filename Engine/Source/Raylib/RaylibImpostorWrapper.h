@@ -0,0 +1,27 @@
+#pragma once
+#include "Systems/Rendering/ImpostorBaker.h"
+
+// A quad facing the camera around the up axis, drawn with one frame of an impostor atlas
+struct ImpostorQuad
+{
+	float posX, posY, posZ; // Center
+	float rightX, rightZ; // Normalized horizontal direction of the quad's right edge
+	float halfWidth, halfHeight;
+	int frame;
+	unsigned char fade; // 255 is fully visible, lower values are dithered out
+};
+
+class RaylibImpostor
+{
+public:
+	bool Load(const ImpostorAtlas& atlas);
+	void Unload();
+	bool IsLoaded() const { return textureId != 0; }
+	// Draws every quad in one batch with the impostor shader
+	void Draw(const ImpostorQuad* quads, int count);
+
+private:
+	unsigned int textureId = 0;
+	int columns = 1;
+	int rows = 1;
+};
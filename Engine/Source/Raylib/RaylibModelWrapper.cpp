@@ -4,13 +4,35 @@
 #include "ThirdParty/Raylib/include/raymath.h"
 #include "RaylibShaderWrapper.h"
 #include <unordered_map>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <cfloat>
+#include <string>
 #include "Utilities/ConsoleLogger.h"
+#include "Resources/CookedMesh.h"
+#include "Systems/Rendering/MeshOptimizer.h"
+
+// The simplified meshes of a model loaded from a CookedMeshFile. Each one shares its full detail mesh's vertex buffer, with its own index buffer.
+struct CookedModelLODs
+{
+    std::filesystem::path cookedPath; // For GetImpostorSources(), since the meshes don't keep their normals and texcoords on the CPU
+    int lodCount = 1;
+    float screenSizes[cookedMeshMaxLods] = {};
+    std::vector<Mesh> meshes[cookedMeshMaxLods - 1]; // Every mesh of the model for each LOD after the first. Meshes without that LOD repeat their last one.
+    std::vector<Mesh> ownedMeshes; // The meshes above without the repeats, for unloading
+};
 
 static std::unordered_map<std::filesystem::path, std::pair<Model, int>> models;
 static std::unordered_map<ModelType, std::pair<Model, int>> primitiveModels;
 static std::unordered_map<std::filesystem::path, std::vector<Material>> embeddedMaterials;
+static std::unordered_map<const Model*, BoundingBox> modelBounds;
+static std::unordered_map<const Model*, CookedModelLODs> cookedModels;
+static bool LoadCookedModel(const std::filesystem::path& cookedPath, Model& model, CookedModelLODs& lods);
 std::pair<unsigned int, int*> RaylibModel::shadowShader;
 std::pair<unsigned int, int*> RaylibModel::materialPreviewShadowShader;
+static int shadowShaderInstancingLoc = -1;
+static int shadowShaderInstanceTransformLoc = -1;
 //std::unordered_map<Model, std::vector<RaylibWrapper::Material>> RaylibModel::rWrapperMaterials;
 
 bool RaylibModel::Create(ModelType type, std::filesystem::path path, ShaderManager::Shaders shader, std::filesystem::path projectPath, std::vector<float> data)
@@ -29,11 +51,29 @@ bool RaylibModel::Create(ModelType type, std::filesystem::path path, ShaderManag
         {
             model = &(it->second);
             model->second++;
+            if (auto cookedIt = cookedModels.find(&model->first); cookedIt != cookedModels.end())
+                cookedLODs = &cookedIt->second;
         }
         else
         {
-            models[path] = std::make_pair(LoadModel((projectPath/ path).string().c_str()), 1);
             model = &models[path];
+            model->second = 1;
+
+            // The cooked model is used while the source is unchanged. Copying a build's assets changes their write time, so the game only checks the size.
+            std::filesystem::path cookedPath = GetCookedPath(path, projectPath);
+#if defined(EDITOR)
+            bool checkTime = true;
+#else
+            bool checkTime = false;
+#endif
+            CookedModelLODs& lods = cookedModels[&model->first];
+            if (CookedMeshFile::IsUpToDate(cookedPath, projectPath / path, checkTime) && LoadCookedModel(cookedPath, model->first, lods))
+                cookedLODs = &lods;
+            else
+            {
+                cookedModels.erase(&model->first);
+                model->first = LoadModel((projectPath/ path).string().c_str());
+            }
         }
         break;
     case ModelType::Cube:
@@ -119,6 +159,10 @@ bool RaylibModel::Create(ModelType type, std::filesystem::path path, ShaderManag
 
     modelShader = shader;
 
+    // Cache the bounds so renderers using this model can be culled without going through its vertices again
+    if (!skyboxModel && modelBounds.find(&model->first) == modelBounds.end())
+        modelBounds[&model->first] = GetModelBoundingBox(model->first);
+
     if (path == "MaterialPreview" && projectPath == "MaterialPreview")
     {
         for (size_t i = 0; i < model->first.materialCount; ++i)
@@ -294,6 +338,26 @@ bool RaylibModel::CreateFromHeightData(const std::vector<std::vector<float>>& he
 
     terrainModel = true;
 
+	SetupTerrainMaterials(material);
+
+	return true;
+}
+
+bool RaylibModel::CreateForTerrainChunks(RaylibWrapper::Material* material)
+{
+	DeleteInstance();
+
+	// A single quad so the model is valid, it's never drawn
+	model = new std::pair<Model, int>(LoadModelFromMesh(GenMeshPlane(1.0f, 1.0f, 1, 1)), 1);
+	terrainModel = true;
+
+	SetupTerrainMaterials(material);
+
+	return true;
+}
+
+void RaylibModel::SetupTerrainMaterials(RaylibWrapper::Material* material)
+{
 	// Set shader
 	modelShader = ShaderManager::Terrain;
 
@@ -312,8 +376,83 @@ bool RaylibModel::CreateFromHeightData(const std::vector<std::vector<float>>& he
 
 	// Set embeded materials
 	SetEmbeddedMaterials();
+}
 
-	return true;
+void RaylibModel::DrawChunkMesh(const RaylibChunkMesh& mesh, float posX, float posY, float posZ, float rotationX, float rotationY, float rotationZ, float rotationW)
+{
+    if (model == nullptr || model->first.materialCount < 1 || !mesh.mesh)
+        return;
+
+    Matrix transform = MatrixMultiply(QuaternionToMatrix({ rotationX, rotationY, rotationZ, rotationW }), MatrixTranslate(posX, posY, posZ));
+    DrawMesh(*mesh.mesh, model->first.materials[0], MatrixMultiply(model->first.transform, transform));
+}
+
+bool RaylibChunkMesh::Upload(const std::vector<float>& positions, const std::vector<float>& normals, const std::vector<float>& texcoords, const std::vector<unsigned short>& indices)
+{
+    Unload();
+
+    int vertexCount = static_cast<int>(positions.size() / 3);
+    if (vertexCount == 0 || indices.empty() || normals.size() < positions.size() || texcoords.size() < static_cast<size_t>(vertexCount) * 2)
+        return false;
+
+    mesh = new Mesh();
+    *mesh = { 0 };
+    mesh->vertexCount = vertexCount;
+    mesh->triangleCount = static_cast<int>(indices.size() / 3);
+
+    // Raylib frees these when the mesh is unloaded
+    mesh->vertices = (float*)MemAlloc(static_cast<unsigned int>(positions.size() * sizeof(float)));
+    mesh->normals = (float*)MemAlloc(static_cast<unsigned int>(vertexCount * 3 * sizeof(float)));
+    mesh->texcoords = (float*)MemAlloc(static_cast<unsigned int>(vertexCount * 2 * sizeof(float)));
+    mesh->indices = (unsigned short*)MemAlloc(static_cast<unsigned int>(indices.size() * sizeof(unsigned short)));
+    memcpy(mesh->vertices, positions.data(), positions.size() * sizeof(float));
+    memcpy(mesh->normals, normals.data(), vertexCount * 3 * sizeof(float));
+    memcpy(mesh->texcoords, texcoords.data(), vertexCount * 2 * sizeof(float));
+    memcpy(mesh->indices, indices.data(), indices.size() * sizeof(unsigned short));
+
+    UploadMesh(mesh, true);
+    indexCapacity = static_cast<int>(indices.size());
+    return true;
+}
+
+void RaylibChunkMesh::UpdateIndices(const std::vector<unsigned short>& indices)
+{
+    if (!mesh || indices.empty())
+        return;
+
+    int count = std::min(static_cast<int>(indices.size()), indexCapacity);
+    memcpy(mesh->indices, indices.data(), count * sizeof(unsigned short));
+    rlUpdateVertexBufferElements(mesh->vboId[RL_DEFAULT_SHADER_ATTRIB_LOCATION_INDICES], mesh->indices, count * sizeof(unsigned short), 0);
+    mesh->triangleCount = count / 3;
+}
+
+void RaylibChunkMesh::UpdateVertices(const std::vector<float>& positions, const std::vector<float>& normals, int firstVertex, int vertexCount)
+{
+    if (!mesh || positions.size() < static_cast<size_t>(mesh->vertexCount) * 3 || normals.size() < static_cast<size_t>(mesh->vertexCount) * 3)
+        return;
+
+    firstVertex = std::max(firstVertex, 0);
+    vertexCount = std::min(vertexCount, mesh->vertexCount - firstVertex);
+    if (vertexCount <= 0)
+        return;
+
+    size_t offset = static_cast<size_t>(firstVertex) * 3;
+    int size = vertexCount * 3 * sizeof(float);
+    memcpy(mesh->vertices + offset, positions.data() + offset, size);
+    memcpy(mesh->normals + offset, normals.data() + offset, size);
+    rlUpdateVertexBuffer(mesh->vboId[RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION], mesh->vertices + offset, size, static_cast<int>(offset * sizeof(float)));
+    rlUpdateVertexBuffer(mesh->vboId[RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL], mesh->normals + offset, size, static_cast<int>(offset * sizeof(float)));
+}
+
+void RaylibChunkMesh::Unload()
+{
+    if (!mesh)
+        return;
+
+    UnloadMesh(*mesh);
+    delete mesh;
+    mesh = nullptr;
+    indexCapacity = 0;
 }
 
 void RaylibModel::Unload()
@@ -321,7 +460,18 @@ void RaylibModel::Unload()
     if (model == nullptr)
         return;
 
+    if (auto it = cookedModels.find(&model->first); it != cookedModels.end())
+    {
+        // Unloaded first, since they use the full detail meshes' vertex buffers
+        for (Mesh& mesh : it->second.ownedMeshes)
+            UnloadMesh(mesh);
+        cookedModels.erase(it);
+    }
+    cookedLODs = nullptr;
+    lod = 0;
+
     UnloadModel(model->first);
+    modelBounds.erase(&model->first);
     if (primitiveModel)
     {
         auto it = primitiveModels.begin();
@@ -414,8 +564,11 @@ void RaylibModel::DrawModelWrapper(float posX, float posY, float posZ, float siz
     //if (renderShadow)
     //    BeginShaderMode({ shadowShader.first, shadowShader.second });
 
-    // Draw model
+    // Draw model, with the selected LOD's meshes swapped in
+    Mesh* meshes = model->first.meshes;
+    model->first.meshes = GetLODMeshes();
     DrawModel(model->first, Vector3Zero(), 1, { colorR, colorG, colorB, colorA });
+    model->first.meshes = meshes;
 
     //if (renderShadow)
     //    EndShaderMode();
@@ -425,9 +578,103 @@ void RaylibModel::DrawModelWrapper(float posX, float posY, float posZ, float siz
     rlPopMatrix();
 }
 
+void RaylibModel::DrawModelInstanced(const ModelInstance* instances, int count, bool setInstancingUniform)
+{
+    if (count <= 0)
+        return;
+
+    std::vector<RaylibWrapper::Matrix> transforms;
+    transforms.reserve(count);
+    for (int i = 0; i < count; i++)
+        transforms.push_back(GetInstanceTransform(instances[i]));
+
+    DrawModelInstanced(transforms.data(), count, setInstancingUniform);
+}
+
+void RaylibModel::DrawModelInstanced(const RaylibWrapper::Matrix* transforms, int count, bool setInstancingUniform)
+{
+    if (model == nullptr || model->first.meshCount < 1)
+    {
+        ConsoleLogger::ErrorLog("Error drawing model");
+        return;
+    }
+
+    if (count <= 0)
+        return;
+
+    static_assert(sizeof(RaylibWrapper::Matrix) == sizeof(Matrix), "RaylibWrapper::Matrix must match raylib's Matrix");
+    const Matrix* instanceTransforms = reinterpret_cast<const Matrix*>(transforms);
+
+    // The model's own transform is usually identity, so the transforms are only copied when it isn't
+    static std::vector<Matrix> modelTransforms;
+    Matrix identity = MatrixIdentity();
+    if (std::memcmp(&model->first.transform, &identity, sizeof(Matrix)) != 0)
+    {
+        modelTransforms.resize(count);
+        for (int i = 0; i < count; i++)
+            modelTransforms[i] = MatrixMultiply(model->first.transform, instanceTransforms[i]);
+        instanceTransforms = modelTransforms.data();
+    }
+
+    Mesh* meshes = GetLODMeshes();
+    for (int i = 0; i < model->first.meshCount; i++)
+    {
+        Material& material = model->first.materials[model->first.meshMaterial[i]];
+
+        if (material.shader.id != shadowShader.first || shadowShaderInstancingLoc == -1 || shadowShaderInstanceTransformLoc == -1)
+        {
+            for (int j = 0; j < count; j++)
+                DrawMesh(meshes[i], material, instanceTransforms[j]);
+            continue;
+        }
+
+        // Raylib sends the instance transforms to the attribute at the model matrix location, so it's swapped for the draw
+        int modelLoc = material.shader.locs[SHADER_LOC_MATRIX_MODEL];
+        material.shader.locs[SHADER_LOC_MATRIX_MODEL] = shadowShaderInstanceTransformLoc;
+
+        int useInstancing = 1;
+        if (setInstancingUniform)
+            ::SetShaderValue(material.shader, shadowShaderInstancingLoc, &useInstancing, SHADER_UNIFORM_INT);
+        DrawMeshInstanced(meshes[i], material, instanceTransforms, count);
+        useInstancing = 0;
+        if (setInstancingUniform)
+            ::SetShaderValue(material.shader, shadowShaderInstancingLoc, &useInstancing, SHADER_UNIFORM_INT);
+
+        material.shader.locs[SHADER_LOC_MATRIX_MODEL] = modelLoc;
+    }
+}
+
+bool RaylibModel::GetInstancingUniform(unsigned int& shaderId, int*& shaderLocs, int& location)
+{
+    if (shadowShaderInstancingLoc == -1 || shadowShaderInstanceTransformLoc == -1)
+        return false;
+
+    shaderId = shadowShader.first;
+    shaderLocs = shadowShader.second;
+    location = shadowShaderInstancingLoc;
+    return true;
+}
+
+RaylibWrapper::Matrix RaylibModel::GetInstanceTransform(const ModelInstance& instance)
+{
+    // Same transform as DrawModelWrapper()
+    Matrix transform = MatrixTranslate(instance.posX, instance.posY, instance.posZ);
+    transform = MatrixMultiply(QuaternionToMatrix({ instance.rotationX, instance.rotationY, instance.rotationZ, instance.rotationW }), transform);
+    transform = MatrixMultiply(MatrixScale(instance.sizeX, instance.sizeY, instance.sizeZ), transform);
+
+    RaylibWrapper::Matrix result;
+    std::memcpy(&result, &transform, sizeof(result));
+    return result;
+}
+
 void RaylibModel::SetShadowShader(unsigned int id, int* locs)
 {
     shadowShader = { id, locs };
+
+    // The shader switches to the instance transform attribute when useInstancing is set
+    Shader shader = { id, locs };
+    shadowShaderInstanceTransformLoc = GetShaderLocationAttrib(shader, "instanceTransform");
+    shadowShaderInstancingLoc = ::GetShaderLocation(shader, "useInstancing");
 }
 
 void RaylibModel::SetMaterialPreviewShader(unsigned int id, int* locs)
@@ -489,6 +736,614 @@ int RaylibModel::GetTriangleCount(int meshIndex)
     return model->first.meshes[meshIndex].triangleCount;
 }
 
+RaylibWrapper::BoundingBox RaylibModel::GetBounds()
+{
+    if (!model)
+        return {};
+
+    auto it = modelBounds.find(&model->first);
+    if (it == modelBounds.end())
+        it = modelBounds.emplace(&model->first, GetModelBoundingBox(model->first)).first;
+
+    return { { it->second.min.x, it->second.min.y, it->second.min.z }, { it->second.max.x, it->second.max.y, it->second.max.z } };
+}
+
+const void* RaylibModel::GetModelHandle() const
+{
+    return model;
+}
+
+std::vector<ImpostorSource> RaylibModel::GetImpostorSources()
+{
+    std::vector<ImpostorSource> sources;
+    if (!model)
+        return sources;
+
+    CookedMeshFile cookedFile;
+    if (cookedLODs && !cookedFile.Open(cookedLODs->cookedPath))
+        ConsoleLogger::WarningLog("The cooked model \"" + cookedLODs->cookedPath.string() + "\" couldn't be read, so its impostor won't have normals or texcoords.");
+
+    for (int i = 0; i < model->first.meshCount; i++)
+    {
+        const Mesh& mesh = model->first.meshes[i];
+        if (!mesh.vertices || mesh.vertexCount <= 0)
+            continue;
+
+        ImpostorSource source;
+        source.positions.resize(static_cast<size_t>(mesh.vertexCount) * 3);
+        for (int v = 0; v < mesh.vertexCount; v++)
+        {
+            Vector3 position = Vector3Transform({ mesh.vertices[v * 3], mesh.vertices[v * 3 + 1], mesh.vertices[v * 3 + 2] }, model->first.transform);
+            source.positions[v * 3] = position.x;
+            source.positions[v * 3 + 1] = position.y;
+            source.positions[v * 3 + 2] = position.z;
+        }
+        if (mesh.normals)
+            source.normals.assign(mesh.normals, mesh.normals + mesh.vertexCount * 3);
+        else if (cookedFile.IsOpen() && i < cookedFile.GetMeshCount() && cookedFile.GetMesh(i).vertexCount == mesh.vertexCount && (cookedFile.GetMesh(i).format & CookedVertexNormals))
+        {
+            source.normals.resize(static_cast<size_t>(mesh.vertexCount) * 3);
+            cookedFile.ReadNormals(i, source.normals.data());
+        }
+        if (mesh.texcoords)
+            source.texcoords.assign(mesh.texcoords, mesh.texcoords + mesh.vertexCount * 2);
+        else if (cookedFile.IsOpen() && i < cookedFile.GetMeshCount() && cookedFile.GetMesh(i).vertexCount == mesh.vertexCount && (cookedFile.GetMesh(i).format & CookedVertexTexcoords))
+        {
+            source.texcoords.resize(static_cast<size_t>(mesh.vertexCount) * 2);
+            cookedFile.ReadTexcoords(i, source.texcoords.data());
+        }
+        if (mesh.indices)
+            source.indices.assign(mesh.indices, mesh.indices + mesh.triangleCount * 3);
+
+        const Material& material = model->first.materials[model->first.meshMaterial[i]];
+        const MaterialMap& albedo = material.maps[MATERIAL_MAP_ALBEDO];
+        source.color[0] = albedo.color.r;
+        source.color[1] = albedo.color.g;
+        source.color[2] = albedo.color.b;
+        source.color[3] = albedo.color.a;
+
+        if (albedo.texture.id != 0 && albedo.texture.id != rlGetTextureIdDefault())
+        {
+            Image image = LoadImageFromTexture(albedo.texture);
+            if (image.data)
+            {
+                ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+                source.textureWidth = image.width;
+                source.textureHeight = image.height;
+                const unsigned char* pixels = static_cast<const unsigned char*>(image.data);
+                source.texture.assign(pixels, pixels + static_cast<size_t>(image.width) * image.height * 4);
+            }
+            UnloadImage(image);
+        }
+
+        sources.push_back(std::move(source));
+    }
+
+    return sources;
+}
+
+bool RaylibModel::GetCollisionGeometry(std::vector<float>& positions, std::vector<unsigned int>& indices)
+{
+    positions.clear();
+    indices.clear();
+    if (!model)
+        return false;
+
+    for (int i = 0; i < model->first.meshCount; i++)
+    {
+        const Mesh& mesh = model->first.meshes[i];
+        if (!mesh.vertices || mesh.vertexCount <= 0)
+            continue;
+
+        unsigned int firstVertex = static_cast<unsigned int>(positions.size() / 3);
+        for (int v = 0; v < mesh.vertexCount; v++)
+        {
+            Vector3 position = Vector3Transform({ mesh.vertices[v * 3], mesh.vertices[v * 3 + 1], mesh.vertices[v * 3 + 2] }, model->first.transform);
+            positions.push_back(position.x);
+            positions.push_back(position.y);
+            positions.push_back(position.z);
+        }
+
+        if (mesh.indices)
+        {
+            for (int index = 0; index < mesh.triangleCount * 3; index++)
+                indices.push_back(firstVertex + mesh.indices[index]);
+        }
+        else
+        {
+            for (int v = 0; v < mesh.vertexCount / 3 * 3; v++)
+                indices.push_back(firstVertex + v);
+        }
+    }
+
+    return !positions.empty();
+}
+
+static const int meshVertexBufferCount = 9; // Raylib's MAX_MESH_VERTEX_BUFFERS. UnloadMesh() frees this many from vboId.
+static const int glShort = 0x1402; // GL_SHORT and GL_UNSIGNED_SHORT, which rlgl doesn't define
+static const int glUnsignedShort = 0x1403;
+static const int lodResolutions[cookedMeshMaxLods - 1] = { 64, 32, 16 }; // Grid cells along the model's longest side for each LOD after the first
+static const float lodMinimumReduction = 0.75f; // A LOD is only kept if it has at most this much of the previous LOD's triangles
+
+// Sets up a VAO reading the cooked vertices from vertexBuffer, with an index buffer for the mesh's indices.
+// Returns false if VAOs aren't supported, since the attributes would have to be bound on every draw.
+// The web build's rlgl 4.5 takes the attribute's offset as a pointer, like glVertexAttribPointer(), while rlgl 5.0 takes it as an int
+static void SetCookedVertexAttribute(unsigned int index, int componentCount, int type, bool normalized, int stride, int offset)
+{
+#if defined(WEB)
+    rlSetVertexAttribute(index, componentCount, type, normalized, stride, (const void*)(uintptr_t)offset);
+#else
+    rlSetVertexAttribute(index, componentCount, type, normalized, stride, offset);
+#endif
+}
+
+static bool LoadCookedVertexArray(Mesh& mesh, unsigned int vertexBuffer, const CookedMeshView& view)
+{
+    mesh.vaoId = rlLoadVertexArray();
+    if (mesh.vaoId == 0)
+        return false;
+
+    const CookedVertexLayout& layout = view.layout;
+    rlEnableVertexArray(mesh.vaoId);
+    rlEnableVertexBuffer(vertexBuffer);
+
+    SetCookedVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 3, RL_FLOAT, false, layout.stride, 0);
+    rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+
+    // Missing attributes get the same defaults UploadMesh() gives them
+    if (layout.texcoordOffset >= 0)
+    {
+        bool unorm = (view.format & CookedVertexTexcoordsUnorm) != 0;
+        SetCookedVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD, 2, unorm ? glUnsignedShort : RL_FLOAT, unorm, layout.stride, layout.texcoordOffset);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD);
+    }
+    else
+    {
+        float value[2] = { 0.0f, 0.0f };
+        rlSetVertexAttributeDefault(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD, value, SHADER_ATTRIB_VEC2, 2);
+        rlDisableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD);
+    }
+
+    if (layout.normalOffset >= 0)
+    {
+        SetCookedVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL, 3, glShort, true, layout.stride, layout.normalOffset);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL);
+    }
+    else
+    {
+        float value[3] = { 1.0f, 1.0f, 1.0f };
+        rlSetVertexAttributeDefault(RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL, value, SHADER_ATTRIB_VEC3, 3);
+        rlDisableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL);
+    }
+
+    if (layout.colorOffset >= 0)
+    {
+        SetCookedVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, 4, RL_UNSIGNED_BYTE, true, layout.stride, layout.colorOffset);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR);
+    }
+    else
+    {
+        float value[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        rlSetVertexAttributeDefault(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, value, SHADER_ATTRIB_VEC4, 4);
+        rlDisableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR);
+    }
+
+    if (layout.tangentOffset >= 0)
+    {
+        SetCookedVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TANGENT, 4, glShort, true, layout.stride, layout.tangentOffset);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TANGENT);
+    }
+    else
+    {
+        float value[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        rlSetVertexAttributeDefault(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TANGENT, value, SHADER_ATTRIB_VEC4, 4);
+        rlDisableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TANGENT);
+    }
+
+    float texcoord2[2] = { 0.0f, 0.0f };
+    rlSetVertexAttributeDefault(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD2, texcoord2, SHADER_ATTRIB_VEC2, 2);
+    rlDisableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD2);
+
+    mesh.vboId[RL_DEFAULT_SHADER_ATTRIB_LOCATION_INDICES] = rlLoadVertexBufferElement(mesh.indices, mesh.triangleCount * 3 * sizeof(unsigned short), false);
+    rlDisableVertexArray();
+    return true;
+}
+
+static bool LoadCookedModel(const std::filesystem::path& cookedPath, Model& model, CookedModelLODs& lods)
+{
+    // Closed once everything is uploaded, so the editor can cook the model again while it's loaded
+    CookedMeshFile file;
+    if (!file.Open(cookedPath))
+        return false;
+    lods.cookedPath = cookedPath;
+
+    // Raylib frees everything allocated here when the model is unloaded
+    model = {};
+    static_assert(sizeof(Matrix) == 16 * sizeof(float), "Matrix must be 16 floats");
+    memcpy(&model.transform, file.GetTransform(), sizeof(Matrix));
+    model.meshCount = file.GetMeshCount();
+    model.meshes = (Mesh*)MemAlloc(static_cast<unsigned int>(model.meshCount * sizeof(Mesh)));
+    model.meshMaterial = (int*)MemAlloc(static_cast<unsigned int>(model.meshCount * sizeof(int)));
+
+    std::vector<Texture2D> textures(file.GetTextureCount(), Texture2D{ 0 });
+    for (int i = 0; i < file.GetTextureCount(); i++)
+    {
+        size_t size = 0;
+        const uint8_t* data = file.GetTexture(i, size);
+        Image image = LoadImageFromMemory(".png", data, static_cast<int>(size));
+        if (image.data)
+            textures[i] = LoadTextureFromImage(image);
+        UnloadImage(image);
+    }
+
+    model.materialCount = std::max(file.GetMaterialCount(), 1);
+    model.materials = (Material*)MemAlloc(static_cast<unsigned int>(model.materialCount * sizeof(Material)));
+    for (int i = 0; i < model.materialCount; i++)
+    {
+        model.materials[i] = LoadMaterialDefault();
+        if (i >= file.GetMaterialCount())
+            continue;
+
+        CookedMaterial cooked = file.GetMaterial(i);
+        for (int map = 0; map < cookedMaterialMaps; map++)
+        {
+            MaterialMap& materialMap = model.materials[i].maps[map];
+            materialMap.color = { cooked.colors[map][0], cooked.colors[map][1], cooked.colors[map][2], cooked.colors[map][3] };
+            materialMap.value = cooked.values[map];
+            if (cooked.textures[map] >= 0 && cooked.textures[map] < static_cast<int>(textures.size()) && textures[cooked.textures[map]].id != 0)
+                materialMap.texture = textures[cooked.textures[map]];
+        }
+        memcpy(model.materials[i].params, cooked.params, sizeof(cooked.params));
+    }
+
+    bool vertexArrays = true;
+    for (int i = 0; i < model.meshCount; i++)
+    {
+        const CookedMeshView& view = file.GetMesh(i);
+        Mesh& mesh = model.meshes[i];
+        mesh.vertexCount = view.vertexCount;
+        mesh.triangleCount = view.indexCounts[0] / 3;
+        model.meshMaterial[i] = std::clamp(view.material, 0, model.materialCount - 1);
+
+        // The positions and indices stay on the CPU for bounds, collision shapes and indexed drawing
+        mesh.vertices = (float*)MemAlloc(static_cast<unsigned int>(view.vertexCount * 3 * sizeof(float)));
+        file.ReadPositions(i, mesh.vertices);
+        mesh.indices = (unsigned short*)MemAlloc(static_cast<unsigned int>(view.indexCounts[0] * sizeof(unsigned short)));
+        memcpy(mesh.indices, view.indices[0], view.indexCounts[0] * sizeof(unsigned short));
+
+        // The interleaved vertices are copied to the GPU as they are in the file
+        mesh.vboId = (unsigned int*)MemAlloc(meshVertexBufferCount * sizeof(unsigned int));
+        mesh.vboId[0] = rlLoadVertexBuffer(view.vertices, view.vertexCount * view.layout.stride, false);
+        if (LoadCookedVertexArray(mesh, mesh.vboId[0], view))
+            continue;
+
+        // Without VAOs raylib binds each attribute from its own buffer, so the mesh is unpacked and uploaded the usual way
+        vertexArrays = false;
+        rlUnloadVertexBuffer(mesh.vboId[0]);
+        MemFree(mesh.vboId);
+        mesh.vboId = nullptr;
+        if (view.format & CookedVertexNormals)
+        {
+            mesh.normals = (float*)MemAlloc(static_cast<unsigned int>(view.vertexCount * 3 * sizeof(float)));
+            file.ReadNormals(i, mesh.normals);
+        }
+        mesh.texcoords = (float*)MemAlloc(static_cast<unsigned int>(view.vertexCount * 2 * sizeof(float)));
+        file.ReadTexcoords(i, mesh.texcoords);
+        if (view.format & CookedVertexTangents)
+        {
+            mesh.tangents = (float*)MemAlloc(static_cast<unsigned int>(view.vertexCount * 4 * sizeof(float)));
+            file.ReadTangents(i, mesh.tangents);
+        }
+        if (view.format & CookedVertexColors)
+        {
+            mesh.colors = (unsigned char*)MemAlloc(static_cast<unsigned int>(view.vertexCount * 4));
+            for (int v = 0; v < view.vertexCount; v++)
+                memcpy(mesh.colors + v * 4, view.vertices + static_cast<size_t>(v) * view.layout.stride + view.layout.colorOffset, 4);
+        }
+        UploadMesh(&mesh, false);
+    }
+
+    const float* boundsMin = file.GetBoundsMin();
+    const float* boundsMax = file.GetBoundsMax();
+    modelBounds[&model] = { { boundsMin[0], boundsMin[1], boundsMin[2] }, { boundsMax[0], boundsMax[1], boundsMax[2] } };
+
+    // The LODs need their own VAO for their index buffer
+    lods.lodCount = vertexArrays ? file.GetLODCount() : 1;
+    for (int lod = 1; lod < lods.lodCount; lod++)
+    {
+        lods.screenSizes[lod] = file.GetLODScreenSize(lod);
+        lods.meshes[lod - 1].resize(model.meshCount);
+        for (int i = 0; i < model.meshCount; i++)
+        {
+            const CookedMeshView& view = file.GetMesh(i);
+            if (lod >= view.lodCount)
+            {
+                lods.meshes[lod - 1][i] = lod > 1 ? lods.meshes[lod - 2][i] : model.meshes[i];
+                continue;
+            }
+
+            Mesh mesh = { 0 };
+            mesh.vertexCount = view.vertexCount;
+            mesh.triangleCount = view.indexCounts[lod] / 3;
+            mesh.indices = (unsigned short*)MemAlloc(static_cast<unsigned int>(view.indexCounts[lod] * sizeof(unsigned short)));
+            memcpy(mesh.indices, view.indices[lod], view.indexCounts[lod] * sizeof(unsigned short));
+            mesh.vboId = (unsigned int*)MemAlloc(meshVertexBufferCount * sizeof(unsigned int));
+            LoadCookedVertexArray(mesh, model.meshes[i].vboId[0], view);
+
+            lods.meshes[lod - 1][i] = mesh;
+            lods.ownedMeshes.push_back(mesh);
+        }
+    }
+
+    return true;
+}
+
+std::filesystem::path RaylibModel::GetCookedPath(const std::filesystem::path& path, const std::filesystem::path& projectPath)
+{
+    // Cache/Meshes next to the Assets folder, so the editor cooks into the project's cache and builds read it from Resources/Cache/Meshes
+    std::filesystem::path cookedPath = projectPath.parent_path() / "Cache" / "Meshes" / path;
+    cookedPath += ".mesh";
+    return cookedPath;
+}
+
+bool RaylibModel::CookModel(const std::filesystem::path& sourcePath, const std::filesystem::path& cookedPath)
+{
+    Model loaded = LoadModel(sourcePath.string().c_str());
+
+    // Textures aren't freed by UnloadModel(), and the cooked file has its own copies
+    auto unloadLoaded = [&loaded]() {
+        std::vector<unsigned int> textureIds;
+        for (int i = 0; i < loaded.materialCount; i++)
+            for (int map = 0; map < cookedMaterialMaps; map++)
+            {
+                unsigned int id = loaded.materials[i].maps[map].texture.id;
+                if (id != 0 && id != rlGetTextureIdDefault() && std::find(textureIds.begin(), textureIds.end(), id) == textureIds.end())
+                    textureIds.push_back(id);
+            }
+        for (unsigned int id : textureIds)
+            rlUnloadTexture(id);
+        UnloadModel(loaded);
+    };
+
+    if (loaded.meshCount < 1 || loaded.boneCount > 0)
+    {
+        unloadLoaded();
+        return false;
+    }
+
+    CookedModelContents contents;
+    std::error_code error;
+    contents.sourceSize = std::filesystem::file_size(sourcePath, error);
+    contents.sourceTime = CookedMeshFile::GetSourceTime(sourcePath);
+    memcpy(contents.transform, &loaded.transform, sizeof(contents.transform));
+
+    BoundingBox bounds = GetModelBoundingBox(loaded);
+    contents.boundsMin[0] = bounds.min.x;
+    contents.boundsMin[1] = bounds.min.y;
+    contents.boundsMin[2] = bounds.min.z;
+    contents.boundsMax[0] = bounds.max.x;
+    contents.boundsMax[1] = bounds.max.y;
+    contents.boundsMax[2] = bounds.max.z;
+
+    // The LOD grid is over every mesh in mesh space, so the meshes' cells line up and the seams between them collapse the same way
+    float gridMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float gridMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    for (int i = 0; i < loaded.meshCount; i++)
+    {
+        const Mesh& mesh = loaded.meshes[i];
+        if (!mesh.vertices || mesh.vertexCount <= 0 || mesh.animVertices)
+        {
+            unloadLoaded();
+            return false;
+        }
+
+        // Unindexed meshes have a vertex per triangle corner, so identical vertices are welded first
+        std::vector<unsigned int> uniqueVertices; // The source vertex of each welded vertex
+        std::vector<unsigned int> indices;
+        if (mesh.indices)
+        {
+            indices.assign(mesh.indices, mesh.indices + mesh.triangleCount * 3);
+            uniqueVertices.resize(mesh.vertexCount);
+            for (int v = 0; v < mesh.vertexCount; v++)
+                uniqueVertices[v] = v;
+        }
+        else
+        {
+            std::unordered_map<std::string, unsigned int> welded;
+            indices.reserve(mesh.vertexCount / 3 * 3);
+            for (int v = 0; v < mesh.vertexCount / 3 * 3; v++)
+            {
+                std::string key(reinterpret_cast<const char*>(mesh.vertices + v * 3), 3 * sizeof(float));
+                if (mesh.normals)
+                    key.append(reinterpret_cast<const char*>(mesh.normals + v * 3), 3 * sizeof(float));
+                if (mesh.texcoords)
+                    key.append(reinterpret_cast<const char*>(mesh.texcoords + v * 2), 2 * sizeof(float));
+                if (mesh.colors)
+                    key.append(reinterpret_cast<const char*>(mesh.colors + v * 4), 4);
+                if (mesh.tangents)
+                    key.append(reinterpret_cast<const char*>(mesh.tangents + v * 4), 4 * sizeof(float));
+
+                auto [it, added] = welded.emplace(std::move(key), static_cast<unsigned int>(uniqueVertices.size()));
+                if (added)
+                    uniqueVertices.push_back(v);
+                indices.push_back(it->second);
+            }
+        }
+
+        if (uniqueVertices.size() > 65536 || indices.empty())
+        {
+            ConsoleLogger::WarningLog("\"" + sourcePath.filename().string() + "\" wasn't cooked since one of its meshes has more than 65536 vertices or no triangles. It will load from the source file.");
+            unloadLoaded();
+            return false;
+        }
+
+        std::vector<float> uniquePositions(uniqueVertices.size() * 3);
+        for (size_t v = 0; v < uniqueVertices.size(); v++)
+            memcpy(&uniquePositions[v * 3], mesh.vertices + uniqueVertices[v] * 3, 3 * sizeof(float));
+
+        MeshOptimizer::OptimizeVertexCache(indices, uniqueVertices.size());
+        MeshOptimizer::OptimizeOverdraw(indices, uniquePositions.data(), uniqueVertices.size());
+        std::vector<int> remap;
+        size_t vertexCount = MeshOptimizer::OptimizeVertexFetch(indices, uniqueVertices.size(), remap);
+
+        CookedMeshSource cooked;
+        cooked.material = loaded.meshMaterial ? loaded.meshMaterial[i] : 0;
+        cooked.positions.resize(vertexCount * 3);
+        if (mesh.normals)
+            cooked.normals.resize(vertexCount * 3);
+        if (mesh.texcoords)
+            cooked.texcoords.resize(vertexCount * 2);
+        if (mesh.colors)
+            cooked.colors.resize(vertexCount * 4);
+        if (mesh.tangents)
+            cooked.tangents.resize(vertexCount * 4);
+
+        for (size_t v = 0; v < uniqueVertices.size(); v++)
+        {
+            if (remap[v] < 0)
+                continue;
+
+            size_t target = static_cast<size_t>(remap[v]);
+            unsigned int source = uniqueVertices[v];
+            memcpy(&cooked.positions[target * 3], mesh.vertices + source * 3, 3 * sizeof(float));
+            if (mesh.normals)
+                memcpy(&cooked.normals[target * 3], mesh.normals + source * 3, 3 * sizeof(float));
+            if (mesh.texcoords)
+                memcpy(&cooked.texcoords[target * 2], mesh.texcoords + source * 2, 2 * sizeof(float));
+            if (mesh.colors)
+                memcpy(&cooked.colors[target * 4], mesh.colors + source * 4, 4);
+            if (mesh.tangents)
+                memcpy(&cooked.tangents[target * 4], mesh.tangents + source * 4, 4 * sizeof(float));
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                gridMin[axis] = std::min(gridMin[axis], cooked.positions[target * 3 + axis]);
+                gridMax[axis] = std::max(gridMax[axis], cooked.positions[target * 3 + axis]);
+            }
+        }
+
+        cooked.lods.emplace_back(indices.begin(), indices.end());
+        contents.meshes.push_back(std::move(cooked));
+    }
+
+    // Each LOD is kept only if the whole model lost enough triangles, otherwise the next coarser grid is tried in its place
+    float longestSide = std::max({ gridMax[0] - gridMin[0], gridMax[1] - gridMin[1], gridMax[2] - gridMin[2] });
+    size_t previousTriangles = 0;
+    for (const CookedMeshSource& mesh : contents.meshes)
+        previousTriangles += mesh.lods[0].size() / 3;
+
+    int lodCount = 1;
+    for (int resolution : lodResolutions)
+    {
+        if (longestSide <= 0.0f)
+            break;
+
+        std::vector<std::vector<unsigned int>> simplified(contents.meshes.size());
+        size_t triangles = 0;
+        for (size_t i = 0; i < contents.meshes.size(); i++)
+        {
+            const CookedMeshSource& mesh = contents.meshes[i];
+            std::vector<unsigned int> indices(mesh.lods[0].begin(), mesh.lods[0].end());
+            MeshOptimizer::SimplifyClustered(indices, mesh.positions.data(), mesh.normals.empty() ? nullptr : mesh.normals.data(), mesh.positions.size() / 3,
+                gridMin, longestSide / resolution, simplified[i]);
+            triangles += simplified[i].size() / 3;
+        }
+
+        if (triangles == 0 || triangles > previousTriangles * lodMinimumReduction)
+            continue;
+
+        // A cell is about 4 pixels tall at 1080p once the LOD is used
+        contents.lodScreenSizes[lodCount] = resolution / 256.0f;
+        for (size_t i = 0; i < contents.meshes.size(); i++)
+        {
+            CookedMeshSource& mesh = contents.meshes[i];
+            if (simplified[i].empty() || mesh.lods.size() < static_cast<size_t>(lodCount))
+                continue; // Meshes that collapsed completely keep drawing their last LOD
+
+            MeshOptimizer::OptimizeVertexCache(simplified[i], mesh.positions.size() / 3);
+            mesh.lods.emplace_back(simplified[i].begin(), simplified[i].end());
+        }
+        previousTriangles = triangles;
+        lodCount++;
+    }
+
+    // Every map's texture is saved once, even if several maps or materials share it
+    std::unordered_map<unsigned int, int> textureIndices;
+    for (int i = 0; i < loaded.materialCount; i++)
+    {
+        const Material& material = loaded.materials[i];
+        CookedMaterial cooked = {};
+        memcpy(cooked.params, material.params, sizeof(cooked.params));
+        for (int map = 0; map < cookedMaterialMaps; map++)
+        {
+            const MaterialMap& materialMap = material.maps[map];
+            cooked.colors[map][0] = materialMap.color.r;
+            cooked.colors[map][1] = materialMap.color.g;
+            cooked.colors[map][2] = materialMap.color.b;
+            cooked.colors[map][3] = materialMap.color.a;
+            cooked.values[map] = materialMap.value;
+            cooked.textures[map] = -1;
+
+            unsigned int id = materialMap.texture.id;
+            if (id == 0 || id == rlGetTextureIdDefault())
+                continue;
+
+            if (auto it = textureIndices.find(id); it != textureIndices.end())
+            {
+                cooked.textures[map] = it->second;
+                continue;
+            }
+
+            int pngSize = 0;
+            unsigned char* png = nullptr;
+            Image image = LoadImageFromTexture(materialMap.texture);
+            if (image.data)
+                png = ExportImageToMemory(image, ".png", &pngSize);
+            UnloadImage(image);
+
+            int index = -1;
+            if (png && pngSize > 0)
+            {
+                index = static_cast<int>(contents.textures.size());
+                contents.textures.emplace_back(png, png + pngSize);
+            }
+            if (png)
+                MemFree(png);
+            textureIndices[id] = index;
+            cooked.textures[map] = index;
+        }
+        contents.materials.push_back(cooked);
+    }
+
+    unloadLoaded();
+    return CookedMeshFile::Save(cookedPath, contents);
+}
+
+void RaylibModel::SelectLOD(float screenSize)
+{
+    lod = 0;
+    if (!cookedLODs)
+        return;
+
+    // The screen sizes get smaller with each LOD
+    while (lod + 1 < cookedLODs->lodCount && screenSize < cookedLODs->screenSizes[lod + 1])
+        lod++;
+}
+
+int RaylibModel::GetLODCount() const
+{
+    return cookedLODs ? cookedLODs->lodCount : 1;
+}
+
+Mesh* RaylibModel::GetLODMeshes()
+{
+    if (lod <= 0 || !cookedLODs || lod >= cookedLODs->lodCount)
+        return model->first.meshes;
+
+    return cookedLODs->meshes[lod - 1].data();
+}
+
 std::vector<int> RaylibModel::GetMaterialIDs()
 {
     std::vector<int> ids;
@@ -1,9 +1,13 @@
 #pragma once
 #include "Systems/Rendering/ShaderManager.h"
 #include <filesystem>
+#include <vector>
 #include "Raylib/RaylibWrapper.h"
+#include "Systems/Rendering/ImpostorBaker.h"
 
 class Model;
+struct Mesh;
+struct CookedModelLODs;
 
 enum class ModelType
 {
@@ -16,6 +20,32 @@ enum class ModelType
 	Skybox
 };
 
+// Transform of a single instance for RaylibModel::DrawModelInstanced()
+struct ModelInstance
+{
+	float posX, posY, posZ;
+	float sizeX, sizeY, sizeZ;
+	float rotationX, rotationY, rotationZ, rotationW;
+};
+
+// A mesh owned outside of a model and drawn with a model's material, used for the Terrain's LOD chunks
+class RaylibChunkMesh
+{
+public:
+	// The index buffer is sized for these indices, later updates can't have more
+	bool Upload(const std::vector<float>& positions, const std::vector<float>& normals, const std::vector<float>& texcoords, const std::vector<unsigned short>& indices);
+	void UpdateIndices(const std::vector<unsigned short>& indices);
+	// Uploads the positions and normals of vertexCount vertices starting at firstVertex. The vectors hold every vertex of the mesh.
+	void UpdateVertices(const std::vector<float>& positions, const std::vector<float>& normals, int firstVertex, int vertexCount);
+	void Unload();
+	bool IsLoaded() const { return mesh != nullptr; }
+
+private:
+	friend class RaylibModel;
+	Mesh* mesh = nullptr;
+	int indexCapacity = 0;
+};
+
 class RaylibModel
 {
 public:
@@ -26,8 +56,21 @@ public:
 		int depth,
 		float maxHeight,
 		RaylibWrapper::Material* material);
+	// Creates a terrain model without its own geometry, to hold the terrain's material for DrawChunkMesh()
+	bool CreateForTerrainChunks(RaylibWrapper::Material* material);
 	void Unload();
 	void DeleteInstance();
+	// Draws every instance with one instanced draw per mesh. Falls back to a draw per instance if the model's shader doesn't support instancing.
+	// setInstancingUniform is false when the caller sets the shader's instancing uniform itself, like a command buffer that recorded it.
+	void DrawModelInstanced(const ModelInstance* instances, int count, bool setInstancingUniform = true);
+	// Same as above with the instance transforms already built with GetInstanceTransform()
+	void DrawModelInstanced(const RaylibWrapper::Matrix* transforms, int count, bool setInstancingUniform = true);
+	// The uniform that switches the shadow shader to instance transforms. Returns false if the shader doesn't support instancing.
+	static bool GetInstancingUniform(unsigned int& shaderId, int*& shaderLocs, int& location);
+	// The transform DrawModelWrapper() builds for an instance, not including the model's own transform
+	static RaylibWrapper::Matrix GetInstanceTransform(const ModelInstance& instance);
+	// Draws the mesh with this model's first material
+	void DrawChunkMesh(const RaylibChunkMesh& mesh, float posX, float posY, float posZ, float rotationX, float rotationY, float rotationZ, float rotationW);
 	void DrawModelWrapper(float posX, float posY, float posZ, float sizeX, float sizeY, float sizeZ, float rotationX, float rotationY, float rotationZ, float rotationW, unsigned char colorR, unsigned char colorG, unsigned char colorB, unsigned char colorA, bool loadIdentity = false, bool ortho = false, bool ndc = false);
 	void SetMaterialMap(int materialIndex, int mapIndex, RaylibWrapper::Texture2D texture, RaylibWrapper::Color color, float intesity);
 	void SetMaterials(std::vector<RaylibWrapper::Material*> mats);
@@ -48,13 +91,38 @@ public:
 	bool IsPrimitive();
 	int GetMeshCount();
 	int GetTriangleCount(int meshIndex);
+	// Local space bounds, computed once per loaded model
+	RaylibWrapper::BoundingBox GetBounds();
+	// Identifies the loaded model, which is shared between every RaylibModel created from the same path or primitive
+	const void* GetModelHandle() const;
+	// Copies the meshes and their albedo into sources for ImpostorBaker. Textures are read back from the GPU.
+	std::vector<ImpostorSource> GetImpostorSources();
+	// Every mesh's triangles merged into one list in model space, for building collision shapes. Positions are xyz per vertex.
+	bool GetCollisionGeometry(std::vector<float>& positions, std::vector<unsigned int>& indices);
+
+	// Cooks a model asset into a CookedMeshFile, which Create() loads instead of the source file while the source is unchanged.
+	// Must be called on the thread with the GL context, since the model's textures are read back from the GPU.
+	// Returns false for models that can't be cooked, like animated ones or meshes with more than 65536 vertices, which keep loading from the source file.
+	static bool CookModel(const std::filesystem::path& sourcePath, const std::filesystem::path& cookedPath);
+	// Where Create() looks for a model's cooked file, with the same path and projectPath passed to Create()
+	static std::filesystem::path GetCookedPath(const std::filesystem::path& path, const std::filesystem::path& projectPath);
+	// Picks the LOD to draw from how much of the screen's height the model covers. Models that weren't cooked only have their full detail LOD.
+	void SelectLOD(float screenSize);
+	int GetLOD() const { return lod; }
+	int GetLODCount() const;
 
 private:
+	void SetupTerrainMaterials(RaylibWrapper::Material* material);
+	// The meshes of the selected LOD, in the same order as the model's meshes
+	Mesh* GetLODMeshes();
+
 	std::pair<Model, int>* model = nullptr;
 	bool primitiveModel = false;
 	bool terrainModel = false;
 	bool skyboxModel = false;
 	std::filesystem::path path;
+	CookedModelLODs* cookedLODs = nullptr; // Shared by every RaylibModel using the same cooked model
+	int lod = 0;
 	// This was removed because it added overhead for something that has an easier solution. It will only need to be re-added if GetMaterial() is needed
 	//static std::unordered_map<Model, std::vector<RaylibWrapper::Material>> rWrapperMaterials; // Model can not be used as a key. A pointer could be used though.
 	ShaderManager::Shaders modelShader;
@@ -1142,6 +1142,19 @@ namespace RaylibWrapper {
         ::UnloadDroppedFiles({ files.capacity, files.count, files.paths });
     }
 
+    // Compression functions
+    unsigned char* CompressData(const unsigned char* data, int dataSize, int* compDataSize) {
+        return ::CompressData(data, dataSize, compDataSize);
+    }
+
+    unsigned char* DecompressData(const unsigned char* compData, int compDataSize, int* dataSize) {
+        return ::DecompressData(compData, compDataSize, dataSize);
+    }
+
+    void MemFree(void* ptr) {
+        ::MemFree(ptr);
+    }
+
 
 
     void DrawGrid(int slices, float spacing) {
@@ -927,6 +927,11 @@ namespace RaylibWrapper
     FilePathList LoadDroppedFiles(void);
     void UnloadDroppedFiles(FilePathList files);
 
+    // Compression functions
+    unsigned char* CompressData(const unsigned char* data, int dataSize, int* compDataSize);
+    unsigned char* DecompressData(const unsigned char* compData, int compDataSize, int* dataSize);
+    void MemFree(void* ptr);
+
 
     void DrawGrid(int slices, float spacing);
 
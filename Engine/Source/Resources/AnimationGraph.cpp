@@ -1,4 +1,5 @@
 #include "AnimationGraph.h"
+#include "Utilities/JsonStreamReader.h"
 
 std::unordered_map<std::string, std::weak_ptr<AnimationGraph>> AnimationGraphCache::cache;
 
@@ -11,27 +12,24 @@ AnimationGraph::AnimationGraph(std::string path)
 			c = '/';
 	}
 
-	std::ifstream file;
+	std::filesystem::path graphPath;
 #ifndef EDITOR
 	if (exeParent.empty())
-		file.open("Resources/Assets/" + filePath);
+		graphPath = "Resources/Assets/" + filePath;
 	else
-		file.open(std::filesystem::path(exeParent) / "Resources" / "Assets" / filePath);
+		graphPath = std::filesystem::path(exeParent) / "Resources" / "Assets" / filePath;
 #else
-	file.open(filePath);
+	graphPath = filePath;
 #endif
 
-	if (!file.is_open())
+	JsonStreamReader reader;
+	if (!reader.ParseFile(graphPath))
 	{
-		ConsoleLogger::ErrorLog("Animation Graph failed to load. Path: " + filePath);
+		ConsoleLogger::ErrorLog("Animation Graph failed to load. Path: " + filePath + ". " + reader.GetError());
 		return;
 	}
 
-	nlohmann::json jsonData;
-	file >> jsonData;
-	file.close();
-
-	LoadFromJson(jsonData);
+	LoadFromJson(reader.GetRemainder());
 }
 
 AnimationGraph::~AnimationGraph()
@@ -448,18 +446,14 @@ AnimationGraph::Transition* AnimationGraph::CheckTransitions(AnimationState* cur
 
 void AnimationGraph::ReloadFromFile()
 {
-	std::ifstream file(filePath);
-	if (!file.is_open())
+	JsonStreamReader reader;
+	if (!reader.ParseFile(filePath))
 	{
-		ConsoleLogger::ErrorLog("Failed to reload Animation Graph: " + filePath);
+		ConsoleLogger::ErrorLog("Failed to reload Animation Graph: " + filePath + ". " + reader.GetError());
 		return;
 	}
 
-	nlohmann::json jsonData;
-	file >> jsonData;
-	file.close();
-
-	LoadFromJson(jsonData);
+	LoadFromJson(reader.GetRemainder());
 }
 
 // AnimationGraphCache implementation
@@ -0,0 +1,436 @@
+#include "CookedMesh.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+static const char cookedMeshMagic[4] = { 'C', 'M', 'S', 'H' };
+static const uint32_t cookedMeshVersion = 1; // Changing this cooks every model again
+static const size_t headerSize = 144;
+static const size_t meshEntrySize = 48;
+static const size_t textureEntrySize = 16;
+
+struct CookedMeshHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t sourceSize;
+	int64_t sourceTime;
+	uint32_t meshCount;
+	uint32_t materialCount;
+	uint32_t textureCount;
+	uint32_t lodCount;
+	float lodScreenSizes[cookedMeshMaxLods];
+	float boundsMin[3];
+	float boundsMax[3];
+	float transform[16];
+};
+static_assert(sizeof(CookedMeshHeader) == headerSize, "The cooked mesh header must match the file layout");
+
+struct CookedMeshEntry
+{
+	uint32_t vertexCount;
+	uint32_t format;
+	uint32_t vertexStride;
+	int32_t material;
+	uint32_t indexCounts[cookedMeshMaxLods]; // 0 for LODs the mesh doesn't have
+	uint64_t vertexOffset;
+	uint64_t indexOffset; // The LODs' indices follow each other
+};
+static_assert(sizeof(CookedMeshEntry) == meshEntrySize, "The cooked mesh entry must match the file layout");
+
+struct CookedTextureEntry
+{
+	uint64_t offset;
+	uint64_t size;
+};
+static_assert(sizeof(CookedTextureEntry) == textureEntrySize, "The cooked texture entry must match the file layout");
+
+static size_t AlignTo4(size_t size)
+{
+	return (size + 3) & ~static_cast<size_t>(3);
+}
+
+static int16_t FloatToSnorm16(float value)
+{
+	return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+static float Snorm16ToFloat(int16_t value)
+{
+	return std::max(value / 32767.0f, -1.0f);
+}
+
+CookedVertexLayout CookedVertexLayout::FromFormat(uint32_t format)
+{
+	CookedVertexLayout layout;
+	if (format & CookedVertexNormals)
+	{
+		layout.normalOffset = layout.stride;
+		layout.stride += 4 * sizeof(int16_t); // Padded to 4 values to keep the vertex 4 byte aligned
+	}
+	if (format & CookedVertexTexcoords)
+	{
+		layout.texcoordOffset = layout.stride;
+		layout.stride += (format & CookedVertexTexcoordsUnorm) ? 2 * sizeof(uint16_t) : 2 * sizeof(float);
+	}
+	if (format & CookedVertexColors)
+	{
+		layout.colorOffset = layout.stride;
+		layout.stride += 4;
+	}
+	if (format & CookedVertexTangents)
+	{
+		layout.tangentOffset = layout.stride;
+		layout.stride += 4 * sizeof(int16_t);
+	}
+	return layout;
+}
+
+int64_t CookedMeshFile::GetSourceTime(const std::filesystem::path& sourcePath)
+{
+	std::error_code error;
+	std::filesystem::file_time_type time = std::filesystem::last_write_time(sourcePath, error);
+	return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+bool CookedMeshFile::Save(const std::filesystem::path& path, const CookedModelContents& contents)
+{
+	if (contents.meshes.empty())
+		return false;
+
+	CookedMeshHeader header = {};
+	memcpy(header.magic, cookedMeshMagic, sizeof(header.magic));
+	header.version = cookedMeshVersion;
+	header.sourceSize = contents.sourceSize;
+	header.sourceTime = contents.sourceTime;
+	header.meshCount = static_cast<uint32_t>(contents.meshes.size());
+	header.materialCount = static_cast<uint32_t>(contents.materials.size());
+	header.textureCount = static_cast<uint32_t>(contents.textures.size());
+	memcpy(header.lodScreenSizes, contents.lodScreenSizes, sizeof(header.lodScreenSizes));
+	memcpy(header.boundsMin, contents.boundsMin, sizeof(header.boundsMin));
+	memcpy(header.boundsMax, contents.boundsMax, sizeof(header.boundsMax));
+	memcpy(header.transform, contents.transform, sizeof(header.transform));
+
+	size_t offset = headerSize + contents.meshes.size() * meshEntrySize + contents.materials.size() * sizeof(CookedMaterial) + contents.textures.size() * textureEntrySize;
+
+	std::vector<CookedMeshEntry> entries(contents.meshes.size());
+	for (size_t i = 0; i < contents.meshes.size(); i++)
+	{
+		const CookedMeshSource& mesh = contents.meshes[i];
+		size_t vertexCount = mesh.positions.size() / 3;
+		if (vertexCount == 0 || vertexCount > 65536 || mesh.lods.empty() || mesh.lods.size() > cookedMeshMaxLods)
+			return false;
+
+		CookedMeshEntry& entry = entries[i];
+		entry.vertexCount = static_cast<uint32_t>(vertexCount);
+		entry.material = mesh.material;
+		if (mesh.normals.size() >= vertexCount * 3)
+			entry.format |= CookedVertexNormals;
+		if (mesh.texcoords.size() >= vertexCount * 2)
+		{
+			entry.format |= CookedVertexTexcoords;
+			if (std::all_of(mesh.texcoords.begin(), mesh.texcoords.begin() + vertexCount * 2, [](float value) { return value >= 0.0f && value <= 1.0f; }))
+				entry.format |= CookedVertexTexcoordsUnorm;
+		}
+		if (mesh.colors.size() >= vertexCount * 4)
+			entry.format |= CookedVertexColors;
+		if (mesh.tangents.size() >= vertexCount * 4)
+			entry.format |= CookedVertexTangents;
+		entry.vertexStride = static_cast<uint32_t>(CookedVertexLayout::FromFormat(entry.format).stride);
+
+		entry.vertexOffset = offset;
+		offset += vertexCount * entry.vertexStride;
+		entry.indexOffset = offset;
+		for (size_t lod = 0; lod < mesh.lods.size(); lod++)
+		{
+			entry.indexCounts[lod] = static_cast<uint32_t>(mesh.lods[lod].size());
+			offset += mesh.lods[lod].size() * sizeof(uint16_t);
+		}
+		offset = AlignTo4(offset);
+		header.lodCount = std::max(header.lodCount, static_cast<uint32_t>(mesh.lods.size()));
+	}
+
+	std::vector<CookedTextureEntry> textureEntries(contents.textures.size());
+	for (size_t i = 0; i < contents.textures.size(); i++)
+	{
+		textureEntries[i].offset = offset;
+		textureEntries[i].size = contents.textures[i].size();
+		offset = AlignTo4(offset + contents.textures[i].size());
+	}
+
+	std::vector<uint8_t> data(offset, 0);
+	memcpy(data.data(), &header, sizeof(header));
+	size_t tableOffset = headerSize;
+	memcpy(data.data() + tableOffset, entries.data(), entries.size() * meshEntrySize);
+	tableOffset += entries.size() * meshEntrySize;
+	if (!contents.materials.empty())
+		memcpy(data.data() + tableOffset, contents.materials.data(), contents.materials.size() * sizeof(CookedMaterial));
+	tableOffset += contents.materials.size() * sizeof(CookedMaterial);
+	if (!textureEntries.empty())
+		memcpy(data.data() + tableOffset, textureEntries.data(), textureEntries.size() * textureEntrySize);
+
+	for (size_t i = 0; i < contents.meshes.size(); i++)
+	{
+		const CookedMeshSource& mesh = contents.meshes[i];
+		const CookedMeshEntry& entry = entries[i];
+		CookedVertexLayout layout = CookedVertexLayout::FromFormat(entry.format);
+
+		uint8_t* vertex = data.data() + entry.vertexOffset;
+		for (uint32_t v = 0; v < entry.vertexCount; v++, vertex += entry.vertexStride)
+		{
+			memcpy(vertex, &mesh.positions[v * 3], 3 * sizeof(float));
+			if (layout.normalOffset >= 0)
+			{
+				int16_t normal[4] = { FloatToSnorm16(mesh.normals[v * 3]), FloatToSnorm16(mesh.normals[v * 3 + 1]), FloatToSnorm16(mesh.normals[v * 3 + 2]), 0 };
+				memcpy(vertex + layout.normalOffset, normal, sizeof(normal));
+			}
+			if (layout.texcoordOffset >= 0)
+			{
+				if (entry.format & CookedVertexTexcoordsUnorm)
+				{
+					uint16_t texcoord[2] = { static_cast<uint16_t>(std::lround(mesh.texcoords[v * 2] * 65535.0f)), static_cast<uint16_t>(std::lround(mesh.texcoords[v * 2 + 1] * 65535.0f)) };
+					memcpy(vertex + layout.texcoordOffset, texcoord, sizeof(texcoord));
+				}
+				else
+					memcpy(vertex + layout.texcoordOffset, &mesh.texcoords[v * 2], 2 * sizeof(float));
+			}
+			if (layout.colorOffset >= 0)
+				memcpy(vertex + layout.colorOffset, &mesh.colors[v * 4], 4);
+			if (layout.tangentOffset >= 0)
+			{
+				int16_t tangent[4];
+				for (int axis = 0; axis < 4; axis++)
+					tangent[axis] = FloatToSnorm16(mesh.tangents[v * 4 + axis]);
+				memcpy(vertex + layout.tangentOffset, tangent, sizeof(tangent));
+			}
+		}
+
+		uint8_t* indices = data.data() + entry.indexOffset;
+		for (const std::vector<unsigned short>& lod : mesh.lods)
+		{
+			if (!lod.empty())
+				memcpy(indices, lod.data(), lod.size() * sizeof(uint16_t));
+			indices += lod.size() * sizeof(uint16_t);
+		}
+	}
+
+	for (size_t i = 0; i < contents.textures.size(); i++)
+		if (!contents.textures[i].empty())
+			memcpy(data.data() + textureEntries[i].offset, contents.textures[i].data(), contents.textures[i].size());
+
+	std::error_code error;
+	std::filesystem::create_directories(path.parent_path(), error);
+
+	// Written to a temporary file first so a failed write doesn't replace the last good one
+	std::filesystem::path tempPath = path;
+	tempPath += ".tmp";
+	std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+	stream.write(reinterpret_cast<const char*>(data.data()), data.size());
+	stream.close();
+
+	if (stream.fail())
+	{
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+
+	std::filesystem::rename(tempPath, path, error);
+	return !error;
+}
+
+bool CookedMeshFile::IsUpToDate(const std::filesystem::path& path, const std::filesystem::path& sourcePath, bool checkTime)
+{
+	std::ifstream stream(path, std::ios::binary);
+	CookedMeshHeader header;
+	if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+		return false;
+
+	if (memcmp(header.magic, cookedMeshMagic, sizeof(header.magic)) != 0 || header.version != cookedMeshVersion)
+		return false;
+
+	std::error_code error;
+	uintmax_t sourceSize = std::filesystem::file_size(sourcePath, error);
+	if (error || sourceSize != header.sourceSize)
+		return false;
+
+	return !checkTime || header.sourceTime == GetSourceTime(sourcePath);
+}
+
+bool CookedMeshFile::Open(const std::filesystem::path& path)
+{
+	Close();
+
+	if (!file.Open(path) || file.GetSize() < headerSize)
+	{
+		Close();
+		return false;
+	}
+
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(file.GetData());
+	size_t size = file.GetSize();
+
+	CookedMeshHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, cookedMeshMagic, sizeof(header.magic)) != 0 || header.version != cookedMeshVersion || header.meshCount == 0
+		|| header.lodCount == 0 || header.lodCount > cookedMeshMaxLods)
+	{
+		Close();
+		return false;
+	}
+
+	materialsOffset = headerSize + static_cast<size_t>(header.meshCount) * meshEntrySize;
+	texturesOffset = materialsOffset + static_cast<size_t>(header.materialCount) * sizeof(CookedMaterial);
+	if (size < texturesOffset + static_cast<size_t>(header.textureCount) * textureEntrySize)
+	{
+		Close();
+		return false;
+	}
+
+	meshes.resize(header.meshCount);
+	for (uint32_t i = 0; i < header.meshCount; i++)
+	{
+		CookedMeshEntry entry;
+		memcpy(&entry, data + headerSize + i * meshEntrySize, sizeof(entry));
+
+		CookedMeshView& mesh = meshes[i];
+		mesh.vertexCount = static_cast<int>(entry.vertexCount);
+		mesh.format = entry.format;
+		mesh.layout = CookedVertexLayout::FromFormat(entry.format);
+		mesh.material = entry.material;
+
+		size_t indexCount = 0;
+		for (int lod = 0; lod < cookedMeshMaxLods && entry.indexCounts[lod] > 0; lod++)
+		{
+			mesh.indices[lod] = reinterpret_cast<const uint16_t*>(data + entry.indexOffset + indexCount * sizeof(uint16_t));
+			mesh.indexCounts[lod] = static_cast<int>(entry.indexCounts[lod]);
+			mesh.lodCount = lod + 1;
+			indexCount += entry.indexCounts[lod];
+		}
+
+		if (entry.vertexCount == 0 || entry.vertexStride != static_cast<uint32_t>(mesh.layout.stride) || mesh.lodCount == 0
+			|| entry.vertexOffset + static_cast<uint64_t>(entry.vertexCount) * entry.vertexStride > size || entry.indexOffset + indexCount * sizeof(uint16_t) > size)
+		{
+			Close();
+			return false;
+		}
+		mesh.vertices = data + entry.vertexOffset;
+
+		// The indices go straight into an index buffer, so one past the vertices would read outside the vertex buffer on the GPU
+		const uint16_t* indices = mesh.indices[0];
+		for (size_t index = 0; index < indexCount; index++)
+		{
+			if (indices[index] >= entry.vertexCount)
+			{
+				Close();
+				return false;
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < header.textureCount; i++)
+	{
+		CookedTextureEntry entry;
+		memcpy(&entry, data + texturesOffset + i * textureEntrySize, sizeof(entry));
+		if (entry.offset + entry.size > size)
+		{
+			Close();
+			return false;
+		}
+	}
+
+	materialCount = header.materialCount;
+	textureCount = header.textureCount;
+	lodCount = header.lodCount;
+	memcpy(lodScreenSizes, header.lodScreenSizes, sizeof(lodScreenSizes));
+	memcpy(boundsMin, header.boundsMin, sizeof(boundsMin));
+	memcpy(boundsMax, header.boundsMax, sizeof(boundsMax));
+	memcpy(transform, header.transform, sizeof(transform));
+	return true;
+}
+
+void CookedMeshFile::Close()
+{
+	file.Close();
+	meshes.clear();
+	materialCount = 0;
+	textureCount = 0;
+	lodCount = 0;
+}
+
+CookedMaterial CookedMeshFile::GetMaterial(int index) const
+{
+	CookedMaterial material;
+	memcpy(&material, file.GetData() + materialsOffset + index * sizeof(CookedMaterial), sizeof(material));
+	return material;
+}
+
+const uint8_t* CookedMeshFile::GetTexture(int index, size_t& size) const
+{
+	size = 0;
+	if (index < 0 || index >= static_cast<int>(textureCount))
+		return nullptr;
+
+	CookedTextureEntry entry;
+	memcpy(&entry, file.GetData() + texturesOffset + index * textureEntrySize, sizeof(entry));
+	size = static_cast<size_t>(entry.size);
+	return reinterpret_cast<const uint8_t*>(file.GetData()) + entry.offset;
+}
+
+void CookedMeshFile::ReadPositions(int mesh, float* positions) const
+{
+	const CookedMeshView& view = meshes[mesh];
+	for (int v = 0; v < view.vertexCount; v++)
+		memcpy(positions + v * 3, view.vertices + static_cast<size_t>(v) * view.layout.stride, 3 * sizeof(float));
+}
+
+void CookedMeshFile::ReadNormals(int mesh, float* normals) const
+{
+	const CookedMeshView& view = meshes[mesh];
+	if (view.layout.normalOffset < 0)
+		return;
+
+	for (int v = 0; v < view.vertexCount; v++)
+	{
+		int16_t normal[3];
+		memcpy(normal, view.vertices + static_cast<size_t>(v) * view.layout.stride + view.layout.normalOffset, sizeof(normal));
+		for (int axis = 0; axis < 3; axis++)
+			normals[v * 3 + axis] = Snorm16ToFloat(normal[axis]);
+	}
+}
+
+void CookedMeshFile::ReadTexcoords(int mesh, float* texcoords) const
+{
+	const CookedMeshView& view = meshes[mesh];
+	if (view.layout.texcoordOffset < 0)
+		return;
+
+	for (int v = 0; v < view.vertexCount; v++)
+	{
+		const uint8_t* read = view.vertices + static_cast<size_t>(v) * view.layout.stride + view.layout.texcoordOffset;
+		if (view.format & CookedVertexTexcoordsUnorm)
+		{
+			uint16_t texcoord[2];
+			memcpy(texcoord, read, sizeof(texcoord));
+			texcoords[v * 2] = texcoord[0] / 65535.0f;
+			texcoords[v * 2 + 1] = texcoord[1] / 65535.0f;
+		}
+		else
+			memcpy(texcoords + v * 2, read, 2 * sizeof(float));
+	}
+}
+
+void CookedMeshFile::ReadTangents(int mesh, float* tangents) const
+{
+	const CookedMeshView& view = meshes[mesh];
+	if (view.layout.tangentOffset < 0)
+		return;
+
+	for (int v = 0; v < view.vertexCount; v++)
+	{
+		int16_t tangent[4];
+		memcpy(tangent, view.vertices + static_cast<size_t>(v) * view.layout.stride + view.layout.tangentOffset, sizeof(tangent));
+		for (int axis = 0; axis < 4; axis++)
+			tangents[v * 4 + axis] = Snorm16ToFloat(tangent[axis]);
+	}
+}
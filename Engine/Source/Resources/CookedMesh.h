@@ -0,0 +1,128 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+#include <cstdint>
+#include "Utilities/MappedFile.h"
+
+static const int cookedMeshMaxLods = 4;
+static const int cookedMaterialMaps = 12; // Raylib's MAX_MATERIAL_MAPS
+
+// What a cooked vertex holds besides its position
+enum CookedVertexFormat : uint32_t
+{
+	CookedVertexNormals = 1,
+	CookedVertexTexcoords = 2,
+	CookedVertexTexcoordsUnorm = 4, // Texcoords are 16 bits from 0 to 1 instead of floats, set when every texcoord of the mesh is in that range
+	CookedVertexColors = 8,
+	CookedVertexTangents = 16
+};
+
+// Byte offsets of each attribute in an interleaved vertex, -1 if the format doesn't have it.
+// Positions are 3 floats, normals and tangents are 4 signed 16 bit normalized values, and colors are 4 bytes.
+struct CookedVertexLayout
+{
+	int stride = 12;
+	int normalOffset = -1;
+	int texcoordOffset = -1;
+	int colorOffset = -1;
+	int tangentOffset = -1;
+
+	static CookedVertexLayout FromFormat(uint32_t format);
+};
+
+// One mesh of a model to cook, with the vertices and indices already optimized. Attributes the mesh doesn't have are left empty.
+struct CookedMeshSource
+{
+	std::vector<float> positions; // xyz
+	std::vector<float> normals; // xyz
+	std::vector<float> texcoords; // uv
+	std::vector<unsigned char> colors; // rgba
+	std::vector<float> tangents; // xyzw
+	std::vector<std::vector<unsigned short>> lods; // Triangle lists into the same vertices, full detail first
+	int material = 0;
+};
+
+struct CookedMaterial
+{
+	unsigned char colors[cookedMaterialMaps][4];
+	float values[cookedMaterialMaps];
+	float params[4];
+	int32_t textures[cookedMaterialMaps]; // Index of the map's texture in the file, -1 if it has none
+};
+static_assert(sizeof(CookedMaterial) == 160, "The cooked material must match the file layout");
+
+// What a cooked mesh file is written from
+struct CookedModelContents
+{
+	uint64_t sourceSize = 0;
+	int64_t sourceTime = 0;
+	float boundsMin[3] = { 0, 0, 0 };
+	float boundsMax[3] = { 0, 0, 0 };
+	float transform[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	float lodScreenSizes[cookedMeshMaxLods] = { 0, 0, 0, 0 }; // Each LOD after the first is used once the model covers less of the screen's height than this
+	std::vector<CookedMeshSource> meshes;
+	std::vector<CookedMaterial> materials;
+	std::vector<std::vector<unsigned char>> textures; // PNG files
+};
+
+// A cooked mesh's data in the file. Pointers are into the file's memory mapping, so they're only valid while it's open.
+struct CookedMeshView
+{
+	int vertexCount = 0;
+	uint32_t format = 0;
+	CookedVertexLayout layout;
+	int material = 0;
+	const uint8_t* vertices = nullptr;
+	int lodCount = 0;
+	const uint16_t* indices[cookedMeshMaxLods] = {};
+	int indexCounts[cookedMeshMaxLods] = {};
+};
+
+// Binary model the editor cooks from a model asset, so the game loads its meshes by copying them straight into GPU buffers instead of parsing the source file.
+// Vertices are interleaved with quantized normals, tangents and texcoords, indices are 16 bits and already ordered for the vertex cache,
+// and each mesh has up to cookedMeshMaxLods simplified index lists sharing its vertices. Materials are stored with their textures as PNG files.
+class CookedMeshFile
+{
+public:
+	static bool Save(const std::filesystem::path& path, const CookedModelContents& contents);
+	// Only reads the header. The source's write time is ignored when checkTime is false, since copying a build's assets changes it.
+	static bool IsUpToDate(const std::filesystem::path& path, const std::filesystem::path& sourcePath, bool checkTime);
+	static int64_t GetSourceTime(const std::filesystem::path& sourcePath);
+
+	bool Open(const std::filesystem::path& path);
+	void Close();
+	bool IsOpen() const { return file.IsOpen(); }
+
+	int GetMeshCount() const { return static_cast<int>(meshes.size()); }
+	int GetMaterialCount() const { return static_cast<int>(materialCount); }
+	int GetTextureCount() const { return static_cast<int>(textureCount); }
+	int GetLODCount() const { return static_cast<int>(lodCount); }
+	float GetLODScreenSize(int lod) const { return lodScreenSizes[lod]; }
+	const float* GetBoundsMin() const { return boundsMin; }
+	const float* GetBoundsMax() const { return boundsMax; }
+	const float* GetTransform() const { return transform; }
+
+	const CookedMeshView& GetMesh(int index) const { return meshes[index]; }
+	CookedMaterial GetMaterial(int index) const;
+	const uint8_t* GetTexture(int index, size_t& size) const;
+
+	// Unpacks a mesh's attributes into floats, for code that needs them on the CPU. The buffers must hold 3, 2 or 4 floats per vertex.
+	void ReadPositions(int mesh, float* positions) const;
+	void ReadNormals(int mesh, float* normals) const;
+	void ReadTexcoords(int mesh, float* texcoords) const;
+	void ReadTangents(int mesh, float* tangents) const;
+
+private:
+	MappedFile file;
+	std::vector<CookedMeshView> meshes;
+	uint32_t materialCount = 0;
+	uint32_t textureCount = 0;
+	uint32_t lodCount = 0;
+	float lodScreenSizes[cookedMeshMaxLods] = {};
+	float boundsMin[3] = {};
+	float boundsMax[3] = {};
+	float transform[16] = {};
+	size_t materialsOffset = 0;
+	size_t texturesOffset = 0;
+};
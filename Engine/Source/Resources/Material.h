@@ -6,6 +6,7 @@
 #include "Raylib/RaylibWrapper.h"
 #include "Utilities/ConsoleLogger.h"
 #include "ThirdParty/Misc/json.hpp"
+#include "Utilities/JsonStreamReader.h"
 #ifndef EDITOR
 #include "Game.h"
 #endif
@@ -147,24 +148,23 @@ public:
 
     void LoadData()
     {
-        std::ifstream file;
+        std::filesystem::path materialPath;
 #ifdef EDITOR
-        file.open(ProjectManager::projectData.path.string() + "/Assets/" + path);
+        materialPath = ProjectManager::projectData.path.string() + "/Assets/" + path;
 #else
         if (exeParent.empty())
-            file.open("Resources/Assets/" + path);
+            materialPath = "Resources/Assets/" + path;
         else
-            file.open(std::filesystem::path(exeParent) / "Resources" / "Assets" / path);
+            materialPath = std::filesystem::path(exeParent) / "Resources" / "Assets" / path;
 #endif
-        if (!file.is_open())
+        // Parsed straight from a memory mapping of the file
+        JsonStreamReader reader;
+        if (!reader.ParseFile(materialPath))
         {
-            ConsoleLogger::ErrorLog("Material failed to load. Path: " + path);
+            ConsoleLogger::ErrorLog("Material failed to load. Path: " + path + ". " + reader.GetError());
             return;
         }
-
-        nlohmann::json jsonData;
-        file >> jsonData;
-        file.close();
+        nlohmann::json& jsonData = reader.GetRemainder();
 
         // Parse material properties from JSON
         try {
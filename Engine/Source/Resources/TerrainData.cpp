@@ -0,0 +1,511 @@
+#include "TerrainData.h"
+#include "Raylib/RaylibWrapper.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_STATIC // Raylib has its own copy
+#define STBI_ONLY_PNG
+#include "ThirdParty/Misc/stb_image.h"
+
+static const char terrainDataMagic[4] = { 'C', 'T', 'R', 'D' };
+static const uint32_t terrainDataVersion = 2; // Version 1 stored the angles as a fraction of 360 instead of a full turn in radians
+static const uint32_t terrainDataCompressed = 1;
+static const size_t headerSize = 48;
+static const size_t instanceSize = 24; // Position as floats, rotation as 16 bit angles, scale as half floats
+static const size_t compressionBlockSize = 8 * 1024 * 1024; // Raylib can only decompress up to 64MB at once
+static const uint64_t maxCompressionRatio = 1032; // The most DEFLATE can compress data by
+
+struct TerrainDataHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t flags;
+	int32_t width;
+	int32_t depth;
+	float minHeight;
+	float maxHeight;
+	uint32_t layerCount;
+	uint32_t meshCount;
+	uint32_t reserved;
+	uint64_t bodySize; // Before compression
+};
+static_assert(sizeof(TerrainDataHeader) == headerSize, "The terrain data header must match the file layout");
+
+static uint16_t FloatToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t floatExponent = (bits >> 23) & 0xff;
+	uint32_t mantissa = bits & 0x7fffff;
+
+	if (floatExponent == 0xff)
+		return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0)); // Infinity or NaN
+
+	int exponent = static_cast<int>(floatExponent) - 127 + 15;
+	if (exponent >= 31)
+		return static_cast<uint16_t>(sign | 0x7bff); // Clamped to the largest half
+
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+			return static_cast<uint16_t>(sign);
+
+		// Subnormal
+		mantissa |= 0x800000;
+		int shift = 14 - exponent;
+		uint32_t half = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1)
+			half++;
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	// Rounding can carry into the exponent, which is still correct
+	uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+	if (mantissa & 0x1000)
+		half++;
+	return static_cast<uint16_t>(half);
+}
+
+static float HalfToFloat(uint16_t half)
+{
+	uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+	uint32_t exponent = (half >> 10) & 0x1f;
+	uint32_t mantissa = half & 0x3ff;
+
+	uint32_t bits;
+	if (exponent == 0)
+	{
+		if (mantissa == 0)
+			bits = sign;
+		else
+		{
+			// Subnormal, normalized for the float's larger exponent range
+			exponent = 127 - 15 + 1;
+			while (!(mantissa & 0x400))
+			{
+				mantissa <<= 1;
+				exponent--;
+			}
+			bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+		}
+	}
+	else if (exponent == 31)
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	else
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static const float fullTurn = 6.28318530718f;
+
+static uint16_t AngleToShort(float radians)
+{
+	float wrapped = std::fmod(radians, fullTurn);
+	if (wrapped < 0.0f)
+		wrapped += fullTurn;
+	return static_cast<uint16_t>(static_cast<uint32_t>(std::lround(wrapped / fullTurn * 65536.0f)) & 0xffff);
+}
+
+static float ShortToAngle(uint16_t value, uint32_t version)
+{
+	if (version >= 2)
+		return value * (fullTurn / 65536.0f);
+
+	// Version 1 wrapped the radians at 360, so negative angles were stored as 360 minus the angle
+	float angle = value * (360.0f / 65536.0f);
+	return angle > 180.0f ? angle - 360.0f : angle;
+}
+
+bool TerrainDataFile::Save(const std::filesystem::path& path, const TerrainDataContents& contents, bool compress)
+{
+	if (!contents.heights || contents.width <= 0 || contents.depth <= 0)
+		return false;
+
+	size_t sampleCount = static_cast<size_t>(contents.width) * contents.depth;
+	size_t instanceCount = 0;
+	for (const TerrainDataInstances& instances : contents.meshInstances)
+		instanceCount += instances.count;
+
+	TerrainDataHeader header = {};
+	memcpy(header.magic, terrainDataMagic, sizeof(header.magic));
+	header.version = terrainDataVersion;
+	header.width = contents.width;
+	header.depth = contents.depth;
+	header.layerCount = static_cast<uint32_t>(contents.splatmaps.size());
+	header.meshCount = static_cast<uint32_t>(contents.meshInstances.size());
+	header.bodySize = contents.meshInstances.size() * sizeof(uint32_t) + sampleCount * sizeof(uint16_t) + sampleCount * contents.splatmaps.size() + instanceCount * instanceSize;
+
+	auto bounds = std::minmax_element(contents.heights, contents.heights + sampleCount);
+	header.minHeight = *bounds.first;
+	header.maxHeight = *bounds.second;
+
+	std::vector<uint8_t> body(header.bodySize);
+	uint8_t* write = body.data();
+
+	for (const TerrainDataInstances& instances : contents.meshInstances)
+	{
+		uint32_t count = static_cast<uint32_t>(instances.count);
+		memcpy(write, &count, sizeof(count));
+		write += sizeof(count);
+	}
+
+	float range = header.maxHeight - header.minHeight;
+	float scale = range > 0.0f ? 65535.0f / range : 0.0f;
+	for (size_t i = 0; i < sampleCount; i++)
+	{
+		uint16_t quantized = static_cast<uint16_t>(std::min(std::lround((contents.heights[i] - header.minHeight) * scale), 65535L));
+		memcpy(write, &quantized, sizeof(quantized));
+		write += sizeof(quantized);
+	}
+
+	// Layers are interleaved so a sample's weights are next to each other
+	for (size_t i = 0; i < sampleCount; i++)
+		for (const float* splatmap : contents.splatmaps)
+			*write++ = static_cast<uint8_t>(std::lround(std::clamp(splatmap[i], 0.0f, 1.0f) * 255.0f));
+
+	for (const TerrainDataInstances& instances : contents.meshInstances)
+	{
+		for (int i = 0; i < instances.count; i++)
+		{
+			const float* instance = instances.data + static_cast<size_t>(i) * 9;
+			uint16_t rotation[3] = { AngleToShort(instance[3]), AngleToShort(instance[4]), AngleToShort(instance[5]) };
+			uint16_t instanceScale[3] = { FloatToHalf(instance[6]), FloatToHalf(instance[7]), FloatToHalf(instance[8]) };
+			memcpy(write, instance, 3 * sizeof(float));
+			memcpy(write + 12, rotation, sizeof(rotation));
+			memcpy(write + 18, instanceScale, sizeof(instanceScale));
+			write += instanceSize;
+		}
+	}
+
+	// Compressed in blocks, each of which decompresses to compressionBlockSize bytes except the last
+	std::vector<uint32_t> blockSizes;
+	std::vector<uint8_t> compressed;
+	if (compress && !body.empty())
+	{
+		for (size_t offset = 0; offset < body.size(); offset += compressionBlockSize)
+		{
+			int blockSize = static_cast<int>(std::min(compressionBlockSize, body.size() - offset));
+			int compressedSize = 0;
+			unsigned char* block = RaylibWrapper::CompressData(body.data() + offset, blockSize, &compressedSize);
+			if (!block)
+			{
+				blockSizes.clear();
+				break;
+			}
+			compressed.insert(compressed.end(), block, block + compressedSize);
+			blockSizes.push_back(static_cast<uint32_t>(compressedSize));
+			RaylibWrapper::MemFree(block);
+		}
+
+		// Not worth it if it didn't shrink
+		if (blockSizes.empty() || compressed.size() + blockSizes.size() * sizeof(uint32_t) >= body.size())
+			blockSizes.clear();
+		else
+			header.flags |= terrainDataCompressed;
+	}
+
+	// Written to a temporary file first so a failed write doesn't replace the last good one
+	std::filesystem::path tempPath = path;
+	tempPath += ".tmp";
+	std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	if (header.flags & terrainDataCompressed)
+	{
+		uint32_t blockCount = static_cast<uint32_t>(blockSizes.size());
+		stream.write(reinterpret_cast<const char*>(&blockCount), sizeof(blockCount));
+		stream.write(reinterpret_cast<const char*>(blockSizes.data()), blockSizes.size() * sizeof(uint32_t));
+		stream.write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+	}
+	else
+		stream.write(reinterpret_cast<const char*>(body.data()), body.size());
+	stream.close();
+
+	std::error_code error;
+	if (stream.fail())
+	{
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+
+	std::filesystem::rename(tempPath, path, error);
+	return !error;
+}
+
+bool TerrainDataFile::Open(const std::filesystem::path& path)
+{
+	Close();
+
+	if (!file.Open(path) || file.GetSize() < headerSize)
+	{
+		Close();
+		return false;
+	}
+
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(file.GetData());
+	size_t size = file.GetSize();
+
+	TerrainDataHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, terrainDataMagic, sizeof(header.magic)) != 0 || header.version < 1 || header.version > terrainDataVersion || header.width <= 0 || header.depth <= 0)
+	{
+		Close();
+		return false;
+	}
+
+	if (header.flags & terrainDataCompressed)
+	{
+		size_t offset = headerSize;
+		uint32_t blockCount = 0;
+		if (size < offset + sizeof(blockCount))
+		{
+			Close();
+			return false;
+		}
+		memcpy(&blockCount, data + offset, sizeof(blockCount));
+		offset += sizeof(blockCount);
+
+		// The sizes are checked against the file before anything is allocated for them, so a damaged header can't ask for more memory than the file could hold
+		uint64_t expectedBlockCount = (header.bodySize + compressionBlockSize - 1) / compressionBlockSize;
+		if (blockCount != expectedBlockCount || blockCount > (size - offset) / sizeof(uint32_t))
+		{
+			Close();
+			return false;
+		}
+		size_t blockSizesSize = blockCount * sizeof(uint32_t);
+		if (header.bodySize > static_cast<uint64_t>(size - offset - blockSizesSize) * maxCompressionRatio)
+		{
+			Close();
+			return false;
+		}
+
+		std::vector<uint32_t> blockSizes(blockCount);
+		memcpy(blockSizes.data(), data + offset, blockSizesSize);
+		offset += blockSizesSize;
+
+		decompressed.resize(static_cast<size_t>(header.bodySize));
+		size_t written = 0;
+		for (uint32_t blockSize : blockSizes)
+		{
+			size_t expected = std::min(compressionBlockSize, decompressed.size() - written);
+			int blockLength = 0;
+			unsigned char* block = offset + blockSize <= size ? RaylibWrapper::DecompressData(data + offset, static_cast<int>(blockSize), &blockLength) : nullptr;
+			if (!block || static_cast<size_t>(blockLength) != expected)
+			{
+				if (block)
+					RaylibWrapper::MemFree(block);
+				Close();
+				return false;
+			}
+			memcpy(decompressed.data() + written, block, expected);
+			RaylibWrapper::MemFree(block);
+			written += expected;
+			offset += blockSize;
+		}
+
+		if (written != decompressed.size())
+		{
+			Close();
+			return false;
+		}
+
+		// Everything is in memory now, so the mapping isn't needed
+		file.Close();
+		body = decompressed.data();
+	}
+	else
+	{
+		if (header.bodySize > size - headerSize)
+		{
+			Close();
+			return false;
+		}
+		body = data + headerSize;
+	}
+	bodySize = header.bodySize;
+	version = header.version;
+
+	width = header.width;
+	depth = header.depth;
+	layerCount = static_cast<int>(header.layerCount);
+	minHeight = header.minHeight;
+	maxHeight = header.maxHeight;
+
+	size_t sampleCount = static_cast<size_t>(width) * depth;
+	size_t countsSize = header.meshCount * sizeof(uint32_t);
+	if (bodySize < countsSize)
+	{
+		Close();
+		return false;
+	}
+	instanceCounts.resize(header.meshCount);
+	memcpy(instanceCounts.data(), body, countsSize);
+
+	size_t instanceCount = 0;
+	for (uint32_t count : instanceCounts)
+		instanceCount += count;
+
+	heightsOffset = countsSize;
+	splatmapsOffset = heightsOffset + sampleCount * sizeof(uint16_t);
+	instancesOffset = splatmapsOffset + sampleCount * layerCount;
+	if (instancesOffset + instanceCount * instanceSize != bodySize)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void TerrainDataFile::Close()
+{
+	file.Close();
+	decompressed.clear();
+	decompressed.shrink_to_fit();
+	body = nullptr;
+	bodySize = 0;
+	version = 0;
+	width = 0;
+	depth = 0;
+	layerCount = 0;
+	instanceCounts.clear();
+}
+
+void TerrainDataFile::ReadHeights(float* heights) const
+{
+	if (!body)
+		return;
+
+	size_t sampleCount = static_cast<size_t>(width) * depth;
+	const uint8_t* read = body + heightsOffset;
+	float scale = (maxHeight - minHeight) / 65535.0f;
+	for (size_t i = 0; i < sampleCount; i++)
+	{
+		uint16_t quantized;
+		memcpy(&quantized, read + i * sizeof(uint16_t), sizeof(quantized));
+		heights[i] = minHeight + quantized * scale;
+	}
+}
+
+void TerrainDataFile::ReadSplatmap(int layer, float* weights) const
+{
+	if (!body || layer < 0 || layer >= layerCount)
+		return;
+
+	size_t sampleCount = static_cast<size_t>(width) * depth;
+	const uint8_t* read = body + splatmapsOffset + layer;
+	for (size_t i = 0; i < sampleCount; i++)
+		weights[i] = read[i * layerCount] / 255.0f;
+}
+
+void TerrainDataFile::ReadInstances(int mesh, float* instances) const
+{
+	if (!body || mesh < 0 || mesh >= GetMeshCount())
+		return;
+
+	size_t first = 0;
+	for (int i = 0; i < mesh; i++)
+		first += instanceCounts[i];
+
+	const uint8_t* read = body + instancesOffset + first * instanceSize;
+	for (uint32_t i = 0; i < instanceCounts[mesh]; i++, read += instanceSize, instances += 9)
+	{
+		uint16_t rotation[3];
+		uint16_t scale[3];
+		memcpy(instances, read, 3 * sizeof(float));
+		memcpy(rotation, read + 12, sizeof(rotation));
+		memcpy(scale, read + 18, sizeof(scale));
+		for (int axis = 0; axis < 3; axis++)
+		{
+			instances[3 + axis] = ShortToAngle(rotation[axis], version);
+			instances[6 + axis] = HalfToFloat(scale[axis]);
+		}
+	}
+}
+
+bool TerrainDataFile::ImportHeightmap16(const std::filesystem::path& path, int width, int depth, std::vector<float>& heights)
+{
+	if (width <= 0 || depth <= 0)
+		return false;
+
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	bool raw = extension == ".raw" || extension == ".r16";
+	if (!raw && extension != ".png")
+		return false;
+
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream.is_open())
+		return false;
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+	int sourceWidth = 0;
+	int sourceDepth = 0;
+	std::vector<uint16_t> samples;
+	if (raw)
+	{
+		size_t count = data.size() / sizeof(uint16_t);
+		if (data.size() % sizeof(uint16_t) != 0 || count == 0)
+			return false;
+
+		if (count == static_cast<size_t>(width) * depth)
+		{
+			sourceWidth = width;
+			sourceDepth = depth;
+		}
+		else
+		{
+			int side = static_cast<int>(std::lround(std::sqrt(static_cast<double>(count))));
+			if (static_cast<size_t>(side) * side != count)
+				return false;
+			sourceWidth = side;
+			sourceDepth = side;
+		}
+
+		samples.resize(count);
+		for (size_t i = 0; i < count; i++)
+			samples[i] = static_cast<uint16_t>(data[i * 2] | (data[i * 2 + 1] << 8));
+	}
+	else
+	{
+		if (data.empty() || !stbi_is_16_bit_from_memory(data.data(), static_cast<int>(data.size())))
+			return false;
+
+		int channels = 0;
+		stbi_us* pixels = stbi_load_16_from_memory(data.data(), static_cast<int>(data.size()), &sourceWidth, &sourceDepth, &channels, 1);
+		if (!pixels)
+			return false;
+		samples.assign(pixels, pixels + static_cast<size_t>(sourceWidth) * sourceDepth);
+		stbi_image_free(pixels);
+	}
+
+	// Bilinear, so the extra precision isn't lost to stair steps when the sizes don't match
+	heights.resize(static_cast<size_t>(width) * depth);
+	float scaleX = width > 1 ? static_cast<float>(sourceWidth - 1) / (width - 1) : 0.0f;
+	float scaleZ = depth > 1 ? static_cast<float>(sourceDepth - 1) / (depth - 1) : 0.0f;
+	for (int z = 0; z < depth; z++)
+	{
+		float sourceZ = z * scaleZ;
+		int z0 = std::min(static_cast<int>(sourceZ), sourceDepth - 1);
+		int z1 = std::min(z0 + 1, sourceDepth - 1);
+		float fractionZ = sourceZ - z0;
+		for (int x = 0; x < width; x++)
+		{
+			float sourceX = x * scaleX;
+			int x0 = std::min(static_cast<int>(sourceX), sourceWidth - 1);
+			int x1 = std::min(x0 + 1, sourceWidth - 1);
+			float fractionX = sourceX - x0;
+
+			float top = samples[static_cast<size_t>(z0) * sourceWidth + x0] * (1.0f - fractionX) + samples[static_cast<size_t>(z0) * sourceWidth + x1] * fractionX;
+			float bottom = samples[static_cast<size_t>(z1) * sourceWidth + x0] * (1.0f - fractionX) + samples[static_cast<size_t>(z1) * sourceWidth + x1] * fractionX;
+			heights[static_cast<size_t>(z) * width + x] = (top * (1.0f - fractionZ) + bottom * fractionZ) / 65535.0f;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+#include <cstdint>
+#include "Utilities/MappedFile.h"
+
+// Instances of one terrain mesh, 9 floats each: position, rotation in radians, then scale
+struct TerrainDataInstances
+{
+	const float* data = nullptr;
+	int count = 0;
+};
+
+// What a terrain data file is written from. Grids are row-major, width * depth.
+struct TerrainDataContents
+{
+	int width = 0;
+	int depth = 0;
+	const float* heights = nullptr;
+	std::vector<const float*> splatmaps; // Weights from 0 to 1
+	std::vector<TerrainDataInstances> meshInstances;
+};
+
+// Binary terrain asset saved next to the scene, so the scene doesn't hold the terrain as JSON arrays.
+// Heights are quantized to 16 bits between their lowest and highest value, splat weights are packed into a byte per layer per sample,
+// and mesh instances store their rotation as 16 bit angles and their scale as half floats.
+// The body can be DEFLATE compressed. Uncompressed files are read straight from a memory mapping.
+class TerrainDataFile
+{
+public:
+	static bool Save(const std::filesystem::path& path, const TerrainDataContents& contents, bool compress);
+
+	bool Open(const std::filesystem::path& path);
+	void Close();
+
+	int GetWidth() const { return width; }
+	int GetDepth() const { return depth; }
+	int GetLayerCount() const { return layerCount; }
+	int GetMeshCount() const { return static_cast<int>(instanceCounts.size()); }
+	int GetInstanceCount(int mesh) const { return static_cast<int>(instanceCounts[mesh]); }
+
+	// The buffers must hold width * depth values, or 9 floats per instance
+	void ReadHeights(float* heights) const;
+	void ReadSplatmap(int layer, float* weights) const;
+	void ReadInstances(int mesh, float* instances) const;
+
+	// Reads a 16-bit PNG, or a RAW file of little-endian 16-bit samples, resampled to the size with heights from 0 to 1.
+	// RAW files must be square or already the terrain's size. Returns false for anything else, so 8-bit images can be loaded as usual.
+	static bool ImportHeightmap16(const std::filesystem::path& path, int width, int depth, std::vector<float>& heights);
+
+private:
+	MappedFile file;
+	std::vector<uint8_t> decompressed;
+	const uint8_t* body = nullptr;
+	size_t bodySize = 0;
+	uint32_t version = 0;
+
+	int width = 0;
+	int depth = 0;
+	int layerCount = 0;
+	float minHeight = 0.0f;
+	float maxHeight = 0.0f;
+	std::vector<uint32_t> instanceCounts;
+	size_t heightsOffset = 0;
+	size_t splatmapsOffset = 0;
+	size_t instancesOffset = 0;
+};
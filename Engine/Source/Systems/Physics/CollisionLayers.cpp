@@ -0,0 +1,57 @@
+#include "CollisionLayers.h"
+#include <algorithm>
+
+std::vector<std::string> CollisionLayers::names = { "Default" };
+uint32_t CollisionLayers::masks[maxLayers] = {
+    0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+    0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+    0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+    0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF
+};
+
+void CollisionLayers::SetLayers(const std::vector<std::string>& layerNames, const std::vector<uint32_t>& layerMasks)
+{
+    names.assign(layerNames.begin(), layerNames.begin() + std::min<size_t>(layerNames.size(), maxLayers));
+    if (names.empty())
+        names.push_back("Default");
+
+    for (int layer = 0; layer < maxLayers; layer++)
+        masks[layer] = layer < static_cast<int>(layerMasks.size()) ? layerMasks[layer] : 0xFFFFFFFF;
+
+    // An unchecked box on either side of the matrix turns the pair off
+    for (int a = 0; a < maxLayers; a++)
+        for (int b = a + 1; b < maxLayers; b++)
+            SetCollides(a, b, Collides(a, b) && Collides(b, a));
+}
+
+int CollisionLayers::GetLayer(const std::string& name)
+{
+    auto it = std::find(names.begin(), names.end(), name);
+    return it != names.end() ? static_cast<int>(it - names.begin()) : -1;
+}
+
+std::string CollisionLayers::GetLayerName(int layer)
+{
+    if (layer < 0 || layer >= static_cast<int>(names.size()))
+        return "";
+    return names[layer];
+}
+
+int CollisionLayers::GetLayerCount()
+{
+    return static_cast<int>(names.size());
+}
+
+void CollisionLayers::SetCollides(int layerA, int layerB, bool collides)
+{
+    if (collides)
+    {
+        masks[layerA] |= 1u << layerB;
+        masks[layerB] |= 1u << layerA;
+    }
+    else
+    {
+        masks[layerA] &= ~(1u << layerB);
+        masks[layerB] &= ~(1u << layerA);
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// The project's collision layers. Every layer has a mask with bit n set if it collides with layer n, and the matrix is kept symmetric.
+// Layer 0 is "Default". 3D physics can use all 32 layers, 2D physics only the first 16 since they're Box2D's filter category bits.
+class CollisionLayers
+{
+public:
+    static const int maxLayers = 32;
+    static const int maxLayers2D = 16;
+
+    // Called by Game.cpp with the layers from the project settings before any scene is loaded. Missing masks collide with everything.
+    static void SetLayers(const std::vector<std::string>& layerNames, const std::vector<uint32_t>& layerMasks);
+
+    // Returns -1 if there's no layer with the name
+    static int GetLayer(const std::string& name);
+    static std::string GetLayerName(int layer);
+    static int GetLayerCount();
+
+    static bool Collides(int layerA, int layerB) { return (masks[layerA] >> layerB) & 1; }
+    static uint32_t GetMask(int layer) { return masks[layer]; }
+    // Sets both layers' bits, so the matrix stays symmetric
+    static void SetCollides(int layerA, int layerB, bool collides);
+
+private:
+    static std::vector<std::string> names;
+    static uint32_t masks[maxLayers];
+};
@@ -1,11 +1,27 @@
 #include "CollisionListener2D.h"
 #include "Components/Physics/Collider2D.h"
 #include "Utilities/ConsoleLogger.h"
-#include <deque>
-#include <algorithm>
-#include <list>
 
-std::list<b2Contact*> continuedContact;
+static const uint8_t collisionEvents2D = Component::CollisionEnter2D | Component::CollisionExit2D | Component::CollisionStay2D;
+
+void CollisionListener2D::SendCollision(Collider2D* collider, Collider2D* other, uint8_t event)
+{
+    if ((collider->gameObject->collisionEvents & event) == 0)
+        return;
+
+    for (Component* component : collider->gameObject->GetComponents())
+    {
+        if ((component->collisionEvents & event) == 0)
+            continue;
+
+        if (event == Component::CollisionEnter2D)
+            component->OnCollisionEnter2D(other);
+        else if (event == Component::CollisionStay2D)
+            component->OnCollisionStay2D(other);
+        else
+            component->OnCollisionExit2D(other);
+    }
+}
 
 void CollisionListener2D::BeginContact(b2Contact* contact)
 {
@@ -14,47 +30,59 @@ void CollisionListener2D::BeginContact(b2Contact* contact)
 
     if (colliderA && colliderB)
     {
-        for (Component* component : colliderA->gameObject->GetComponents())
-            component->OnCollisionEnter2D(colliderB);
-        for (Component* component : colliderB->gameObject->GetComponents())
-            component->OnCollisionEnter2D(colliderA);
+        // Contacts between game objects that don't handle collisions aren't tracked at all
+        if (((colliderA->gameObject->collisionEvents | colliderB->gameObject->collisionEvents) & collisionEvents2D) == 0)
+            return;
+
+        SendCollision(colliderA, colliderB, Component::CollisionEnter2D);
+        SendCollision(colliderB, colliderA, Component::CollisionEnter2D);
     }
 
-    continuedContact.push_back(contact);
+    continuedContacts.insert({ contact->GetFixtureA(), contact->GetFixtureB() });
 }
 
 void CollisionListener2D::EndContact(b2Contact* contact)
 {
+    // Only contacts that were tracked get Exit
+    if (continuedContacts.erase({ contact->GetFixtureA(), contact->GetFixtureB() }) == 0)
+        return;
+
     Collider2D* colliderA = reinterpret_cast<Collider2D*>(contact->GetFixtureA()->GetUserData().pointer);
     Collider2D* colliderB = reinterpret_cast<Collider2D*>(contact->GetFixtureB()->GetUserData().pointer);
 
     // Checking if they're null separately since they should still callback even if the other collider is now null. Components are responsible for ensuring they're valid
     if (colliderA)
-        for (Component* component : colliderA->gameObject->GetComponents())
-            component->OnCollisionExit2D(colliderB);
+        SendCollision(colliderA, colliderB, Component::CollisionExit2D);
 
     if (colliderB)
-        for (Component* component : colliderB->gameObject->GetComponents())
-            component->OnCollisionExit2D(colliderA);
-
-    auto it = std::find(continuedContact.begin(), continuedContact.end(), contact);
-    if (it != continuedContact.end())
-        continuedContact.erase(it);
+        SendCollision(colliderB, colliderA, Component::CollisionExit2D);
 }
 
 void CollisionListener2D::ContinueContact()
 {
-    for (b2Contact* contact : continuedContact)
+    // Iterates a copy of the fixtures instead of the colliders, since a callback can destroy a collider and end its contacts through EndContact()
+    stayingContacts.assign(continuedContacts.begin(), continuedContacts.end());
+    for (const FixturePair& pair : stayingContacts)
     {
-        Collider2D* colliderA = reinterpret_cast<Collider2D*>(contact->GetFixtureA()->GetUserData().pointer);
-        Collider2D* colliderB = reinterpret_cast<Collider2D*>(contact->GetFixtureB()->GetUserData().pointer);
-
-        if (colliderA && colliderB)
-        {
-            for (Component* component : colliderA->gameObject->GetComponents())
-                component->OnCollisionStay2D(colliderB);
-            for (Component* component : colliderB->gameObject->GetComponents())
-                component->OnCollisionStay2D(colliderA);
-        }                           
+        if (SendStay(pair, false))
+            SendStay(pair, true);
     }
 }
+
+bool CollisionListener2D::SendStay(const FixturePair& pair, bool reversed)
+{
+    // The fixtures are only read while their contact is still tracked, since a destroyed collider's fixture is freed with it
+    if (continuedContacts.find(pair) == continuedContacts.end())
+        return false;
+
+    Collider2D* colliderA = reinterpret_cast<Collider2D*>(pair.fixtureA->GetUserData().pointer);
+    Collider2D* colliderB = reinterpret_cast<Collider2D*>(pair.fixtureB->GetUserData().pointer);
+    if (!colliderA || !colliderB)
+        return false;
+
+    if (reversed)
+        SendCollision(colliderB, colliderA, Component::CollisionStay2D);
+    else
+        SendCollision(colliderA, colliderB, Component::CollisionStay2D);
+    return true;
+}
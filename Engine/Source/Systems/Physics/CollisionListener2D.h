@@ -1,10 +1,41 @@
 #pragma once
 
 #include "ThirdParty/box2d/include/box2d.h"
+#include <cstdint>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+class Collider2D;
 
 class CollisionListener2D : public b2ContactListener {
 public:
 	void BeginContact(b2Contact* contact) override;
 	void EndContact(b2Contact* contact) override;
 	void ContinueContact();
-};
\ No newline at end of file
+
+private:
+	struct FixturePair
+	{
+		b2Fixture* fixtureA;
+		b2Fixture* fixtureB;
+
+		bool operator==(const FixturePair& other) const { return fixtureA == other.fixtureA && fixtureB == other.fixtureB; }
+	};
+
+	struct FixturePairHasher
+	{
+		size_t operator()(const FixturePair& pair) const
+		{
+			size_t hash = std::hash<b2Fixture*>()(pair.fixtureA);
+			return hash ^ (std::hash<b2Fixture*>()(pair.fixtureB) + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+		}
+	};
+
+	static void SendCollision(Collider2D* collider, Collider2D* other, uint8_t event);
+	// Sends Stay for a contact copied by ContinueContact(). Returns false if the contact ended or lost a collider since it was copied.
+	bool SendStay(const FixturePair& pair, bool reversed);
+
+	std::unordered_set<FixturePair, FixturePairHasher> continuedContacts;
+	std::vector<FixturePair> stayingContacts; // Reused by ContinueContact() so a callback ending a contact can't invalidate the set while it's iterated
+};
@@ -1,76 +1,304 @@
 #include "CollisionListener3D.h"
 #include "Components/Physics/Collider3D.h"
-#include "Components/Physics/Rigidbody3D.h"
+#include <algorithm>
+#include <cstring>
+#include <tuple>
 
-// BodyID hashing doesn't seem to work
-//std::unordered_map<std::pair<JPH::BodyID, JPH::BodyID>, std::pair<Collider3D*, Collider3D*>> contactMap;
+std::mutex CollisionListener3D::eventBuffersMutex;
+std::vector<std::unique_ptr<std::vector<CollisionListener3D::ContactEvent>>> CollisionListener3D::eventBuffers;
+std::vector<CollisionListener3D::ContactEvent> CollisionListener3D::events;
+std::unordered_map<JPH::SubShapeIDPair, CollisionListener3D::ColliderPair> CollisionListener3D::activeContacts;
+std::map<CollisionListener3D::ColliderPair, CollisionListener3D::PairState> CollisionListener3D::activePairs;
+std::vector<CollisionListener3D::PendingCall> CollisionListener3D::pendingCalls;
+
+static const uint8_t collisionEvents3D = Component::CollisionEnter3D | Component::CollisionExit3D | Component::CollisionStay3D;
+
+bool CollisionListener3D::ColliderPair::operator<(const ColliderPair& other) const
+{
+    if (idA != other.idA)
+        return idA < other.idA;
+    if (idB != other.idB)
+        return idB < other.idB;
+    // Only reached if two colliders share an ID
+    return std::less<Collider3D*>()(colliderA, other.colliderA) || (colliderA == other.colliderA && std::less<Collider3D*>()(colliderB, other.colliderB));
+}
+
+std::vector<CollisionListener3D::ContactEvent>& CollisionListener3D::GetThreadEvents()
+{
+    // Each thread only takes the lock the first time it reports a contact
+    thread_local std::vector<ContactEvent>* threadEvents = nullptr;
+    if (!threadEvents)
+    {
+        std::lock_guard<std::mutex> lock(eventBuffersMutex);
+        eventBuffers.push_back(std::make_unique<std::vector<ContactEvent>>());
+        threadEvents = eventBuffers.back().get();
+    }
+    return *threadEvents;
+}
 
 void CollisionListener3D::OnContactAdded(const JPH::Body& inBody1, const JPH::Body& inBody2, const JPH::ContactManifold& inManifold, JPH::ContactSettings& ioSettings)
 {
-    Collider3D* colliderA;
-    Collider3D* colliderB;
+    Collider3D* colliderA = Collider3D::FromBody(inBody1, inManifold.mSubShapeID1);
+    Collider3D* colliderB = Collider3D::FromBody(inBody2, inManifold.mSubShapeID2);
+    if (!colliderA || !colliderB)
+        return;
+
+    // Nothing is recorded unless a component on either game object handles 3D collisions
+    if (((colliderA->gameObject->collisionEvents | colliderB->gameObject->collisionEvents) & collisionEvents3D) == 0)
+        return;
+
+    GetThreadEvents().push_back({ JPH::SubShapeIDPair(inBody1.GetID(), inManifold.mSubShapeID1, inBody2.GetID(), inManifold.mSubShapeID2), colliderA, colliderB, true });
+}
+
+void CollisionListener3D::OnContactRemoved(const JPH::SubShapeIDPair& inSubShapePair)
+{
+    GetThreadEvents().push_back({ inSubShapePair, nullptr, nullptr, false });
+}
+
+void CollisionListener3D::DispatchContacts()
+{
+    for (std::unique_ptr<std::vector<ContactEvent>>& buffer : eventBuffers)
+    {
+        events.insert(events.end(), buffer->begin(), buffer->end());
+        buffer->clear();
+    }
+
+    // Which thread reported a contact changes from run to run, so the events are sorted to always be handled in the same order. Removals go first.
+    std::sort(events.begin(), events.end(), [](const ContactEvent& a, const ContactEvent& b) {
+        auto key = [](const ContactEvent& event) {
+            return std::make_tuple(event.added,
+                event.subShapes.GetBody1ID().GetIndexAndSequenceNumber(), event.subShapes.GetSubShapeID1().GetValue(),
+                event.subShapes.GetBody2ID().GetIndexAndSequenceNumber(), event.subShapes.GetSubShapeID2().GetValue());
+        };
+        return key(a) < key(b);
+    });
+
+    for (const ContactEvent& event : events)
+    {
+        if (!event.added)
+        {
+            auto contact = activeContacts.find(event.subShapes);
+            if (contact == activeContacts.end())
+                continue;
 
-    if (inBody1.GetUserData() != 0)
-        colliderA = reinterpret_cast<Collider3D*>(inBody1.GetUserData());
-    else
-        colliderA = Rigidbody3D::colliderMap[inBody1.GetShape()->GetSubShapeUserData(inManifold.mSubShapeID1)];
+            auto pair = activePairs.find(contact->second);
+            activeContacts.erase(contact);
+            if (pair == activePairs.end() || --pair->second.contactCount > 0)
+                continue;
 
-    if (inBody2.GetUserData() != 0)
-        colliderB = reinterpret_cast<Collider3D*>(inBody2.GetUserData());
-    else
-        colliderB = Rigidbody3D::colliderMap[inBody2.GetShape()->GetSubShapeUserData(inManifold.mSubShapeID2)];
+            pendingCalls.push_back({ pair->first.colliderA, pair->first.colliderB, Component::CollisionExit3D });
+            pendingCalls.push_back({ pair->first.colliderB, pair->first.colliderA, Component::CollisionExit3D });
+            activePairs.erase(pair);
+            continue;
+        }
 
-    //contactMap[std::make_pair(inBody1.GetID(), inBody2.GetID())] = std::make_pair(colliderA, colliderB);
+        // Lower ID first, so a pair is the same whichever body Jolt reported first
+        ColliderPair pair = { event.colliderA->id, event.colliderB->id, event.colliderA, event.colliderB };
+        if (pair.idB < pair.idA)
+            pair = { pair.idB, pair.idA, pair.colliderB, pair.colliderA };
 
-    if (colliderA && colliderB)
+        if (!activeContacts.emplace(event.subShapes, pair).second)
+            continue;
+
+        PairState& state = activePairs[pair];
+        if (++state.contactCount == 1)
+        {
+            state.entered = true;
+            pendingCalls.push_back({ pair.colliderA, pair.colliderB, Component::CollisionEnter3D });
+            pendingCalls.push_back({ pair.colliderB, pair.colliderA, Component::CollisionEnter3D });
+        }
+    }
+    events.clear();
+
+    // Pairs that started touching this step only get Enter
+    for (auto& [pair, state] : activePairs)
     {
-        for (Component* component : colliderA->gameObject->GetComponents())
-            component->OnCollisionEnter3D(colliderB);
-        for (Component* component : colliderB->gameObject->GetComponents())
-            component->OnCollisionEnter3D(colliderA);
+        if (state.entered)
+        {
+            state.entered = false;
+            continue;
+        }
+
+        pendingCalls.push_back({ pair.colliderA, pair.colliderB, Component::CollisionStay3D });
+        pendingCalls.push_back({ pair.colliderB, pair.colliderA, Component::CollisionStay3D });
     }
+
+    Dispatch(pendingCalls);
+    pendingCalls.clear();
 }
 
-void CollisionListener3D::OnContactPersisted(const JPH::Body& inBody1, const JPH::Body& inBody2, const JPH::ContactManifold& inManifold, JPH::ContactSettings& ioSettings)
+void CollisionListener3D::Dispatch(std::vector<PendingCall>& calls)
 {
-    Collider3D* colliderA;
-    Collider3D* colliderB;
+    // Indexed since a callback can destroy a collider, which clears its calls through RemoveCollider()
+    for (size_t i = 0; i < calls.size(); i++)
+    {
+        if (!calls[i].collider || !calls[i].other || (calls[i].collider->gameObject->collisionEvents & calls[i].event) == 0)
+            continue;
+
+        for (Component* component : calls[i].collider->gameObject->GetComponents())
+        {
+            // The previous component's callback can destroy either collider or remove this component, so the call is checked again each time
+            const PendingCall& call = calls[i];
+            if (!call.collider || !call.other)
+                break;
 
-    if (inBody1.GetUserData() != 0)
-        colliderA = reinterpret_cast<Collider3D*>(inBody1.GetUserData());
-    else
-        colliderA = Rigidbody3D::colliderMap[inBody1.GetShape()->GetSubShapeUserData(inManifold.mSubShapeID1)];
+            if (!call.collider->gameObject->HasComponent(component) || (component->collisionEvents & call.event) == 0)
+                continue;
 
-    if (inBody2.GetUserData() != 0)
-        colliderB = reinterpret_cast<Collider3D*>(inBody2.GetUserData());
-    else
-        colliderB = Rigidbody3D::colliderMap[inBody2.GetShape()->GetSubShapeUserData(inManifold.mSubShapeID2)];
+            if (call.event == Component::CollisionEnter3D)
+                component->OnCollisionEnter3D(call.other);
+            else if (call.event == Component::CollisionStay3D)
+                component->OnCollisionStay3D(call.other);
+            else
+                component->OnCollisionExit3D(call.other);
+        }
+    }
+}
+
+void CollisionListener3D::RemoveCollider(Collider3D* collider)
+{
+    for (auto it = activeContacts.begin(); it != activeContacts.end();)
+    {
+        if (it->second.colliderA == collider || it->second.colliderB == collider)
+            it = activeContacts.erase(it);
+        else
+            ++it;
+    }
 
-    if (colliderA && colliderB)
+    for (auto it = activePairs.begin(); it != activePairs.end();)
     {
-        for (Component* component : colliderA->gameObject->GetComponents())
-            component->OnCollisionExit3D(colliderB);
-        for (Component* component : colliderB->gameObject->GetComponents())
-            component->OnCollisionExit3D(colliderA);
+        if (it->first.colliderA == collider || it->first.colliderB == collider)
+            it = activePairs.erase(it);
+        else
+            ++it;
     }
+
+    for (PendingCall& call : pendingCalls)
+        if (call.collider == collider || call.other == collider)
+            call.collider = nullptr;
+
+    for (std::unique_ptr<std::vector<ContactEvent>>& buffer : eventBuffers)
+        buffer->erase(std::remove_if(buffer->begin(), buffer->end(), [collider](const ContactEvent& event) {
+            return event.colliderA == collider || event.colliderB == collider;
+        }), buffer->end());
 }
 
-void CollisionListener3D::OnContactRemoved(const JPH::SubShapeIDPair& inSubShapePair)
+template <typename T>
+static void WriteField(std::vector<uint8_t>& buffer, T value)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static bool ReadField(const uint8_t*& data, const uint8_t* end, T& value)
+{
+    if (static_cast<size_t>(end - data) < sizeof(T))
+        return false;
+    std::memcpy(&value, data, sizeof(T));
+    data += sizeof(T);
+    return true;
+}
+
+void CollisionListener3D::WriteColliderPair(std::vector<uint8_t>& buffer, const ColliderPair& pair)
 {
-    //if (auto it = contactMap.find(std::make_pair(inSubShapePair.GetBody1ID(), inSubShapePair.GetBody2ID())); it != contactMap.end())
-    //{
-    //    Collider3D* colliderA = it->second.first;
-    //    Collider3D* colliderB = it->second.second;
-
-    //    // Checking if they're null separately since they should still callback even if the other collider is now null. Components are responsible for ensuring they're valid
-    //    if (colliderA)
-    //        for (Component* component : colliderA->gameObject->GetComponents())
-    //            component->OnCollisionStay3D(colliderB);
-
-    //    if (colliderB)
-    //        for (Component* component : colliderB->gameObject->GetComponents())
-    //            component->OnCollisionStay3D(colliderA);
-
-    //    contactMap.erase(it);
-    //}
-}
\ No newline at end of file
+    WriteField(buffer, static_cast<int32_t>(pair.idA));
+    WriteField(buffer, static_cast<int32_t>(pair.idB));
+    WriteField(buffer, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pair.colliderA)));
+    WriteField(buffer, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pair.colliderB)));
+}
+
+bool CollisionListener3D::ReadColliderPair(const uint8_t*& data, const uint8_t* end, ColliderPair& pair)
+{
+    int32_t idA;
+    int32_t idB;
+    uint64_t colliderA;
+    uint64_t colliderB;
+    if (!ReadField(data, end, idA) || !ReadField(data, end, idB) || !ReadField(data, end, colliderA) || !ReadField(data, end, colliderB))
+        return false;
+
+    pair = { idA, idB, reinterpret_cast<Collider3D*>(static_cast<uintptr_t>(colliderA)), reinterpret_cast<Collider3D*>(static_cast<uintptr_t>(colliderB)) };
+    return true;
+}
+
+void CollisionListener3D::SaveState(std::vector<uint8_t>& buffer)
+{
+    // Written field by field in sorted order, so the same contacts always give the same bytes whatever the map's insertion history and padding
+    std::vector<const std::pair<const JPH::SubShapeIDPair, ColliderPair>*> contacts;
+    contacts.reserve(activeContacts.size());
+    for (const auto& contact : activeContacts)
+        contacts.push_back(&contact);
+    std::sort(contacts.begin(), contacts.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+    WriteField(buffer, static_cast<uint32_t>(contacts.size()));
+    for (const auto* contact : contacts)
+    {
+        WriteField(buffer, contact->first.GetBody1ID().GetIndexAndSequenceNumber());
+        WriteField(buffer, contact->first.GetSubShapeID1().GetValue());
+        WriteField(buffer, contact->first.GetBody2ID().GetIndexAndSequenceNumber());
+        WriteField(buffer, contact->first.GetSubShapeID2().GetValue());
+        WriteColliderPair(buffer, contact->second);
+    }
+
+    // Already ordered by the map
+    WriteField(buffer, static_cast<uint32_t>(activePairs.size()));
+    for (const auto& [pair, state] : activePairs)
+    {
+        WriteColliderPair(buffer, pair);
+        WriteField(buffer, static_cast<int32_t>(state.contactCount));
+        WriteField(buffer, static_cast<uint8_t>(state.entered));
+    }
+}
+
+bool CollisionListener3D::RestoreState(const uint8_t* data, size_t size)
+{
+    const uint8_t* end = data + size;
+    static const size_t contactSize = sizeof(uint32_t) * 4 + colliderPairSize;
+
+    // Read into new maps first, so a damaged buffer leaves the current contacts alone
+    decltype(activeContacts) contacts;
+    decltype(activePairs) pairs;
+
+    uint32_t contactCount;
+    if (!ReadField(data, end, contactCount) || static_cast<size_t>(end - data) / contactSize < contactCount)
+        return false;
+    contacts.reserve(contactCount);
+    for (uint32_t i = 0; i < contactCount; i++)
+    {
+        uint32_t body1;
+        uint32_t body2;
+        JPH::SubShapeID::Type subShape1;
+        JPH::SubShapeID::Type subShape2;
+        ColliderPair pair;
+        if (!ReadField(data, end, body1) || !ReadField(data, end, subShape1) || !ReadField(data, end, body2) || !ReadField(data, end, subShape2) || !ReadColliderPair(data, end, pair))
+            return false;
+
+        JPH::SubShapeID subShapeID1;
+        JPH::SubShapeID subShapeID2;
+        subShapeID1.SetValue(subShape1);
+        subShapeID2.SetValue(subShape2);
+        contacts.emplace(JPH::SubShapeIDPair(JPH::BodyID(body1), subShapeID1, JPH::BodyID(body2), subShapeID2), pair);
+    }
+
+    uint32_t pairCount;
+    if (!ReadField(data, end, pairCount))
+        return false;
+    for (uint32_t i = 0; i < pairCount; i++)
+    {
+        ColliderPair pair;
+        int32_t pairContactCount;
+        uint8_t entered;
+        if (!ReadColliderPair(data, end, pair) || !ReadField(data, end, pairContactCount) || !ReadField(data, end, entered))
+            return false;
+        pairs.emplace_hint(pairs.end(), pair, PairState{ pairContactCount, entered != 0 });
+    }
+    if (data != end)
+        return false;
+
+    activeContacts = std::move(contacts);
+    activePairs = std::move(pairs);
+    pendingCalls.clear();
+    for (std::unique_ptr<std::vector<ContactEvent>>& buffer : eventBuffers)
+        buffer->clear();
+    return true;
+}
@@ -12,13 +12,80 @@
 #include "Jolt/Physics/Collision/Shape/SphereShape.h"
 #include "Jolt/Physics/Body/BodyCreationSettings.h"
 #include "Jolt/Physics/Body/BodyActivationListener.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class Collider3D;
 
 // Removed to fix "Color" conflictions
 //using namespace JPH;
 
+// Jolt reports contacts from its worker threads, so they're only recorded during the step, each thread into its own buffer.
+// DispatchContacts() runs on the main thread after the step and turns them into OnCollisionEnter3D, OnCollisionStay3D, and OnCollisionExit3D calls.
+// A pair of colliders touching with several sub shapes, like a mesh's triangles, gets a single Enter and Exit.
 class CollisionListener3D : public JPH::ContactListener {
 public:
 	virtual void OnContactAdded(const JPH::Body& inBody1, const JPH::Body& inBody2, const JPH::ContactManifold& inManifold, JPH::ContactSettings& ioSettings) override;
-	virtual void OnContactPersisted(const JPH::Body& inBody1, const JPH::Body& inBody2, const JPH::ContactManifold& inManifold, JPH::ContactSettings& ioSettings) override;
 	virtual void OnContactRemoved(const JPH::SubShapeIDPair& inSubShapePair) override;
-};
\ No newline at end of file
+
+	void DispatchContacts();
+
+	// Forgets the collider's contacts without calling Exit, so no events reference it after it's destroyed
+	static void RemoveCollider(Collider3D* collider);
+
+	// Used by PhysicsSnapshot, so contacts restored into Jolt keep their Enter, Stay, and Exit state.
+	// The colliders are saved as pointers, so the state can only be restored while they still exist. Contacts are saved sorted by their bodies and sub shapes.
+	static void SaveState(std::vector<uint8_t>& buffer);
+	// Returns false, without changing anything, if the buffer isn't a complete state
+	static bool RestoreState(const uint8_t* data, size_t size);
+
+private:
+	struct ContactEvent
+	{
+		JPH::SubShapeIDPair subShapes;
+		Collider3D* colliderA; // Both null for removed contacts, since the bodies may not exist anymore
+		Collider3D* colliderB;
+		bool added;
+	};
+
+	struct ColliderPair
+	{
+		int idA;
+		int idB;
+		Collider3D* colliderA;
+		Collider3D* colliderB;
+
+		bool operator<(const ColliderPair& other) const;
+	};
+
+	struct PairState
+	{
+		int contactCount = 0; // Sub shape contacts between the pair
+		bool entered = false; // Set on the step the pair started touching, which gets Enter instead of Stay
+	};
+
+	struct PendingCall
+	{
+		Collider3D* collider;
+		Collider3D* other;
+		uint8_t event;
+	};
+
+	static const size_t colliderPairSize = sizeof(int32_t) * 2 + sizeof(uint64_t) * 2; // How many bytes a saved ColliderPair takes
+
+	static std::vector<ContactEvent>& GetThreadEvents();
+	static void WriteColliderPair(std::vector<uint8_t>& buffer, const ColliderPair& pair);
+	static bool ReadColliderPair(const uint8_t*& data, const uint8_t* end, ColliderPair& pair);
+	static void Dispatch(std::vector<PendingCall>& calls);
+
+	static std::mutex eventBuffersMutex;
+	static std::vector<std::unique_ptr<std::vector<ContactEvent>>> eventBuffers;
+	static std::vector<ContactEvent> events;
+
+	static std::unordered_map<JPH::SubShapeIDPair, ColliderPair> activeContacts;
+	static std::map<ColliderPair, PairState> activePairs; // Ordered so Stay is called in the same order every run
+	static std::vector<PendingCall> pendingCalls;
+};
@@ -0,0 +1,134 @@
+#include "PhysicsMemory.h"
+#if defined(IS3D) && !defined(EDITOR)
+#include "Utilities/ConsoleLogger.h"
+#include <algorithm>
+#include <limits>
+#include <string>
+#endif
+
+#if defined(IS3D) && !defined(EDITOR)
+static PhysicsMemoryStats stats;
+static bool warnedTempOverflow = false;
+static bool warnedBodies = false;
+static bool warnedBodyPairs = false;
+static bool warnedContacts = false;
+
+// Jolt's TempAllocatorImplWithMallocFallback, but keeping track of how much of the arena is used and how much overflowed.
+// Jolt only uses the temp allocator from one job at a time, so the counters don't need to be atomic.
+class PhysicsTempArena final : public JPH::TempAllocator
+{
+public:
+    explicit PhysicsTempArena(size_t size) : arena(static_cast<JPH::uint>(size)) {}
+
+    void* Allocate(JPH::uint inSize) override
+    {
+        if (arena.CanAllocate(inSize))
+        {
+            void* address = arena.Allocate(inSize);
+            stats.tempArenaPeak = std::max(stats.tempArenaPeak, static_cast<size_t>(arena.GetUsage()));
+            return address;
+        }
+
+        overflowBytes += inSize;
+        stats.tempOverflowPeak = std::max(stats.tempOverflowPeak, overflowBytes);
+        stats.tempOverflowCount++;
+        return fallback.Allocate(inSize);
+    }
+
+    void Free(void* inAddress, JPH::uint inSize) override
+    {
+        if (inAddress == nullptr || arena.OwnsMemory(inAddress))
+        {
+            arena.Free(inAddress, inSize);
+            return;
+        }
+
+        overflowBytes -= inSize;
+        fallback.Free(inAddress, inSize);
+    }
+
+private:
+    JPH::TempAllocatorImpl arena;
+    JPH::TempAllocatorMalloc fallback;
+    size_t overflowBytes = 0;
+};
+#endif
+
+PhysicsMemoryStats PhysicsMemory::GetStats()
+{
+#if defined(IS3D) && !defined(EDITOR)
+    return stats;
+#else
+    return PhysicsMemoryStats();
+#endif
+}
+
+void PhysicsMemory::ResetPeaks()
+{
+#if defined(IS3D) && !defined(EDITOR)
+    stats.tempArenaPeak = 0;
+    stats.tempOverflowPeak = 0;
+    stats.tempOverflowCount = 0;
+    stats.bodyPeak = stats.bodyCount;
+    stats.activeBodyPeak = 0;
+    stats.bodyPairOverflowSteps = 0;
+    stats.contactOverflowSteps = 0;
+#endif
+}
+
+#if defined(IS3D) && !defined(EDITOR)
+JPH::TempAllocator* PhysicsMemory::CreateTempAllocator(size_t size)
+{
+    // Jolt's arena size is 32 bits and it aligns allocations up, so the arena is capped at the largest aligned size that fits
+    const size_t maxSize = std::numeric_limits<JPH::uint>::max() & ~static_cast<size_t>(JPH_RVECTOR_ALIGNMENT - 1);
+    if (size > maxSize)
+    {
+        ConsoleLogger::WarningLog("3D physics temp memory can't be more than " + std::to_string(maxSize / (1024 * 1024)) + " MB, so it was reduced to that. Lower Temp Memory in the project's physics settings.");
+        size = maxSize;
+    }
+
+    stats.tempArenaSize = size;
+    return new PhysicsTempArena(size);
+}
+
+void PhysicsMemory::SetCapacities(int maxBodyPairs, int maxContactConstraints)
+{
+    stats.maxBodyPairs = maxBodyPairs;
+    stats.maxContactConstraints = maxContactConstraints;
+}
+
+void PhysicsMemory::RecordStep(const JPH::PhysicsSystem& physicsSystem, JPH::EPhysicsUpdateError errors)
+{
+    stats.bodyCount = static_cast<int>(physicsSystem.GetNumBodies());
+    stats.maxBodies = static_cast<int>(physicsSystem.GetMaxBodies());
+    stats.bodyPeak = std::max(stats.bodyPeak, stats.bodyCount);
+    stats.activeBodyPeak = std::max(stats.activeBodyPeak, static_cast<int>(physicsSystem.GetNumActiveBodies(JPH::EBodyType::RigidBody)));
+
+    if ((errors & JPH::EPhysicsUpdateError::BodyPairCacheFull) != JPH::EPhysicsUpdateError::None)
+        stats.bodyPairOverflowSteps++;
+    if ((errors & (JPH::EPhysicsUpdateError::ManifoldCacheFull | JPH::EPhysicsUpdateError::ContactConstraintsFull)) != JPH::EPhysicsUpdateError::None)
+        stats.contactOverflowSteps++;
+
+    // Only warned about once each, since an overflowing capacity usually overflows every step
+    if (stats.tempOverflowCount > 0 && !warnedTempOverflow)
+    {
+        warnedTempOverflow = true;
+        ConsoleLogger::WarningLog("3D physics ran out of its " + std::to_string(stats.tempArenaSize / (1024 * 1024)) + " MB of temp memory and allocated the rest. Increase Temp Memory in the project's physics settings.");
+    }
+    if (stats.bodyCount >= stats.maxBodies && !warnedBodies)
+    {
+        warnedBodies = true;
+        ConsoleLogger::WarningLog("3D physics reached its limit of " + std::to_string(stats.maxBodies) + " bodies, so no more can be created. Increase Max Bodies in the project's physics settings.");
+    }
+    if (stats.bodyPairOverflowSteps > 0 && !warnedBodyPairs)
+    {
+        warnedBodyPairs = true;
+        ConsoleLogger::WarningLog("3D physics had more than " + std::to_string(stats.maxBodyPairs) + " touching body pairs and ignored some contacts. Increase Max Body Pairs in the project's physics settings.");
+    }
+    if (stats.contactOverflowSteps > 0 && !warnedContacts)
+    {
+        warnedContacts = true;
+        ConsoleLogger::WarningLog("3D physics had more than " + std::to_string(stats.maxContactConstraints) + " contacts and ignored some. Increase Max Contacts in the project's physics settings.");
+    }
+}
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#if defined(IS3D) && !defined(EDITOR)
+#include "ThirdParty/Jolt/Jolt.h"
+#include "ThirdParty/Jolt/Core/TempAllocator.h"
+#include "ThirdParty/Jolt/Physics/PhysicsSystem.h"
+#endif
+
+struct PhysicsMemoryStats
+{
+    size_t tempArenaSize = 0; // Bytes preallocated for each step's temporary data
+    size_t tempArenaPeak = 0; // Most of the arena a step has used at once
+    size_t tempOverflowPeak = 0; // Most bytes that didn't fit in the arena at once, and were allocated with malloc instead
+    int tempOverflowCount = 0; // Allocations that didn't fit in the arena
+
+    int bodyCount = 0;
+    int bodyPeak = 0;
+    int maxBodies = 0;
+    int activeBodyPeak = 0;
+    int maxBodyPairs = 0;
+    int maxContactConstraints = 0;
+    int bodyPairOverflowSteps = 0; // Steps that dropped contacts because there were more than maxBodyPairs
+    int contactOverflowSteps = 0; // Steps that dropped contacts because there were more than maxContactConstraints
+};
+
+// How much of the 3D physics capacities from the project settings a game actually uses, for sizing them.
+// Every capacity overflow is also logged as a warning the first time it happens. 2D projects report zeros, since Box2D grows as needed.
+class PhysicsMemory
+{
+public:
+    static PhysicsMemoryStats GetStats();
+    // Starts the peaks and overflow counts over, like after loading a scene
+    static void ResetPeaks();
+
+#if defined(IS3D) && !defined(EDITOR)
+    // Hide in API
+    // Preallocates the arena Jolt uses for each step's temporary data, so steps don't allocate. Allocations that don't fit use malloc instead of crashing.
+    static JPH::TempAllocator* CreateTempAllocator(size_t size);
+    // Hide in API
+    // Jolt doesn't expose the pair and contact capacities it was initialized with, so Game.cpp passes them in
+    static void SetCapacities(int maxBodyPairs, int maxContactConstraints);
+    // Hide in API
+    // Called after every step with what PhysicsSystem::Update() returned
+    static void RecordStep(const JPH::PhysicsSystem& physicsSystem, JPH::EPhysicsUpdateError errors);
+#endif
+};
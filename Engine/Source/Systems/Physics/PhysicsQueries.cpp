@@ -0,0 +1,460 @@
+#include "PhysicsQueries.h"
+#if !defined(EDITOR)
+#include "Game.h"
+#include "Components/Physics/Collider2D.h"
+#include "QueryThreadPool.h"
+#include "ThirdParty/box2d/include/b2_distance.h"
+#if defined(IS3D)
+#include "Components/Physics/Rigidbody3D.h"
+#include "Components/Physics/Collider3D.h"
+#include "ThirdParty/Jolt/Physics/Collision/RayCast.h"
+#include "ThirdParty/Jolt/Physics/Collision/CastResult.h"
+#include "ThirdParty/Jolt/Physics/Collision/ShapeCast.h"
+#include "ThirdParty/Jolt/Physics/Collision/CollideShape.h"
+#include "ThirdParty/Jolt/Physics/Collision/CollisionCollectorImpl.h"
+#include "ThirdParty/Jolt/Physics/Collision/Shape/SphereShape.h"
+#include "ThirdParty/Jolt/Physics/Collision/Shape/BoxShape.h"
+#endif
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+#endif
+
+#if !defined(EDITOR)
+static const int minQueriesPerThread = 256; // Fewer than this isn't worth waking a worker for
+
+static QueryThreadPool queryThreadPool;
+
+// Splits the queries into one slice per thread and runs them on the query thread pool. Batches too small to be worth splitting run on the calling thread.
+template <typename QueryRange>
+static void RunBatch(int count, int threadCount, QueryRange queryRange)
+{
+    if (count <= 0)
+        return;
+
+    if (threadCount <= 0)
+        threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    threadCount = std::min(threadCount, (count + minQueriesPerThread - 1) / minQueriesPerThread);
+
+    if (threadCount <= 1)
+    {
+        queryRange(0, count);
+        return;
+    }
+
+    queryThreadPool.Run(count, threadCount, queryRange);
+}
+
+// Adds a result to a query's slice unless it's already there. Returns false once the slice is full.
+template <typename T>
+static bool AddUnique(T** results, int& resultCount, int maxResults, T* result)
+{
+    if (!result || std::find(results, results + resultCount, result) != results + resultCount)
+        return resultCount < maxResults;
+
+    results[resultCount++] = result;
+    return resultCount < maxResults;
+}
+
+#if defined(IS3D)
+class QueryLayerFilter final : public JPH::ObjectLayerFilter
+{
+public:
+    explicit QueryLayerFilter(uint32_t layerMask) : layerMask(layerMask) {}
+
+    bool ShouldCollide(JPH::ObjectLayer inLayer) const override
+    {
+        return ((layerMask >> Layers::GetCollisionLayer(inLayer)) & 1) != 0;
+    }
+
+private:
+    uint32_t layerMask;
+};
+
+class QueryBodyFilter final : public JPH::BodyFilter
+{
+public:
+    explicit QueryBodyFilter(bool hitTriggers) : hitTriggers(hitTriggers) {}
+
+    bool ShouldCollideLocked(const JPH::Body& inBody) const override
+    {
+        return hitTriggers || !inBody.IsSensor();
+    }
+
+private:
+    bool hitTriggers;
+};
+
+// Writes the colliders a shape overlaps straight into the query's slice of the results
+class OverlapCollector final : public JPH::CollideShapeCollector
+{
+public:
+    OverlapCollector(Collider3D** results, int maxResults) : results(results), maxResults(maxResults) {}
+
+    void AddHit(const JPH::CollideShapeResult& inResult) override
+    {
+        const JPH::Body* body = Rigidbody3D::physicsSystem->GetBodyLockInterfaceNoLock().TryGetBody(inResult.mBodyID2);
+        if (body && !AddUnique(results, resultCount, maxResults, Collider3D::FromBody(*body, inResult.mSubShapeID2)))
+            ForceEarlyOut();
+    }
+
+    int resultCount = 0;
+
+private:
+    Collider3D** results;
+    int maxResults;
+};
+
+// Returns false for zero length directions, which can't hit anything
+static bool Normalize(const Vector3& direction, JPH::Vec3& normalized)
+{
+    float length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+    if (length <= 0.0f)
+        return false;
+
+    normalized = JPH::Vec3(direction.x, direction.y, direction.z) / length;
+    return true;
+}
+
+static void Raycast(const RaycastQuery& query, RaycastHit& hit)
+{
+    hit = RaycastHit();
+    JPH::Vec3 direction;
+    if (query.maxDistance <= 0.0f || !Normalize(query.direction, direction))
+        return;
+
+    JPH::RRayCast ray(JPH::RVec3(query.origin.x, query.origin.y, query.origin.z), direction * query.maxDistance);
+    JPH::RayCastResult result;
+    QueryLayerFilter layerFilter(query.layerMask);
+    QueryBodyFilter bodyFilter(query.hitTriggers);
+    if (!Rigidbody3D::physicsSystem->GetNarrowPhaseQueryNoLock().CastRay(ray, result, {}, layerFilter, bodyFilter))
+        return;
+
+    const JPH::Body* body = Rigidbody3D::physicsSystem->GetBodyLockInterfaceNoLock().TryGetBody(result.mBodyID);
+    if (!body)
+        return;
+
+    JPH::RVec3 point = ray.GetPointOnRay(result.mFraction);
+    JPH::Vec3 normal = body->GetWorldSpaceSurfaceNormal(result.mSubShapeID2, point);
+    hit.hit = true;
+    hit.distance = result.mFraction * query.maxDistance;
+    hit.point = { static_cast<float>(point.GetX()), static_cast<float>(point.GetY()), static_cast<float>(point.GetZ()) };
+    hit.normal = { normal.GetX(), normal.GetY(), normal.GetZ() };
+    hit.collider = Collider3D::FromBody(*body, result.mSubShapeID2);
+}
+
+static void SphereCast(const SphereCastQuery& query, RaycastHit& hit)
+{
+    hit = RaycastHit();
+    JPH::Vec3 direction;
+    if (query.radius <= 0.0f || query.maxDistance <= 0.0f || !Normalize(query.direction, direction))
+        return;
+
+    // Lives on the stack, so it must never be reference counted down to zero
+    JPH::SphereShape sphere(query.radius);
+    sphere.SetEmbedded();
+
+    JPH::RVec3 origin(query.origin.x, query.origin.y, query.origin.z);
+    JPH::RShapeCast cast = JPH::RShapeCast::sFromWorldTransform(&sphere, JPH::Vec3::sReplicate(1.0f), JPH::RMat44::sTranslation(origin), direction * query.maxDistance);
+    JPH::ShapeCastSettings settings;
+    JPH::ClosestHitCollisionCollector<JPH::CastShapeCollector> collector;
+    QueryLayerFilter layerFilter(query.layerMask);
+    QueryBodyFilter bodyFilter(query.hitTriggers);
+    Rigidbody3D::physicsSystem->GetNarrowPhaseQueryNoLock().CastShape(cast, settings, origin, collector, {}, layerFilter, bodyFilter);
+    if (!collector.HadHit())
+        return;
+
+    const JPH::ShapeCastResult& result = collector.mHit;
+    const JPH::Body* body = Rigidbody3D::physicsSystem->GetBodyLockInterfaceNoLock().TryGetBody(result.mBodyID2);
+    if (!body)
+        return;
+
+    // Contact points are relative to the base offset, which is the origin here
+    JPH::RVec3 point = origin + result.mContactPointOn2;
+    JPH::Vec3 normal = -result.mPenetrationAxis.NormalizedOr(-direction);
+    hit.hit = true;
+    hit.distance = result.mFraction * query.maxDistance;
+    hit.point = { static_cast<float>(point.GetX()), static_cast<float>(point.GetY()), static_cast<float>(point.GetZ()) };
+    hit.normal = { normal.GetX(), normal.GetY(), normal.GetZ() };
+    hit.collider = Collider3D::FromBody(*body, result.mSubShapeID2);
+}
+
+static int OverlapBox(const OverlapBoxQuery& query, Collider3D** results, int maxResults)
+{
+    if (maxResults <= 0 || query.halfExtents.x <= 0.0f || query.halfExtents.y <= 0.0f || query.halfExtents.z <= 0.0f)
+        return 0;
+
+    // No convex radius so the box is exactly the size asked for, even for very thin boxes
+    JPH::BoxShape box(JPH::Vec3(query.halfExtents.x, query.halfExtents.y, query.halfExtents.z), 0.0f);
+    box.SetEmbedded();
+
+    JPH::RVec3 center(query.center.x, query.center.y, query.center.z);
+    JPH::Quat rotation = JPH::Quat(query.rotation.x, query.rotation.y, query.rotation.z, query.rotation.w).Normalized();
+    JPH::CollideShapeSettings settings;
+    OverlapCollector collector(results, maxResults);
+    QueryLayerFilter layerFilter(query.layerMask);
+    QueryBodyFilter bodyFilter(query.hitTriggers);
+    Rigidbody3D::physicsSystem->GetNarrowPhaseQueryNoLock().CollideShape(&box, JPH::Vec3::sReplicate(1.0f), JPH::RMat44::sRotationTranslation(rotation, center),
+        settings, center, collector, {}, layerFilter, bodyFilter);
+    return collector.resultCount;
+}
+#endif
+
+// Disabled fixtures have no category bits, so the mask check skips them too
+static bool Accepts(const b2Fixture* fixture, uint32_t layerMask, bool hitTriggers)
+{
+    return (fixture->GetFilterData().categoryBits & layerMask) != 0 && (hitTriggers || !fixture->IsSensor());
+}
+
+static Collider2D* GetCollider(const b2Fixture* fixture)
+{
+    return reinterpret_cast<Collider2D*>(fixture->GetUserData().pointer);
+}
+
+class RaycastCallback2D final : public b2RayCastCallback
+{
+public:
+    RaycastCallback2D(const RaycastQuery2D& query, RaycastHit2D& hit) : query(query), hit(hit) {}
+
+    float ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction) override
+    {
+        if (!Accepts(fixture, query.layerMask, query.hitTriggers))
+            return -1.0f; // Ignores this fixture and keeps going
+
+        hit.hit = true;
+        hit.distance = fraction * query.maxDistance;
+        hit.point = { point.x, point.y };
+        hit.normal = { normal.x, normal.y };
+        hit.collider = GetCollider(fixture);
+        return fraction; // Only looks for hits closer than this one from now on
+    }
+
+private:
+    const RaycastQuery2D& query;
+    RaycastHit2D& hit;
+};
+
+// Box2D has no world shape cast, so this finds the fixtures along the sweep and casts against each one
+class SphereCastCallback2D final : public b2QueryCallback
+{
+public:
+    SphereCastCallback2D(const SphereCastQuery2D& query, const b2Vec2& translation, RaycastHit2D& hit) : query(query), translation(translation), hit(hit)
+    {
+        circle.m_radius = query.radius;
+        origin.Set(b2Vec2(query.origin.x, query.origin.y), 0.0f);
+    }
+
+    bool ReportFixture(b2Fixture* fixture) override
+    {
+        if (!Accepts(fixture, query.layerMask, query.hitTriggers))
+            return true;
+
+        const b2Shape* shape = fixture->GetShape();
+        for (int32 child = 0; child < shape->GetChildCount(); child++)
+        {
+            b2ShapeCastInput input;
+            input.proxyA.Set(shape, child);
+            input.proxyB.Set(&circle, 0);
+            input.transformA = fixture->GetBody()->GetTransform();
+            input.transformB = origin;
+            input.translationB = translation;
+
+            b2ShapeCastOutput output;
+            if (!b2ShapeCast(&output, &input) || output.lambda >= closest)
+                continue;
+
+            closest = output.lambda;
+            hit.hit = true;
+            hit.distance = output.lambda * query.maxDistance;
+            hit.point = { output.point.x, output.point.y };
+            hit.normal = { output.normal.x, output.normal.y };
+            hit.collider = GetCollider(fixture);
+        }
+        return true;
+    }
+
+private:
+    const SphereCastQuery2D& query;
+    b2Vec2 translation;
+    RaycastHit2D& hit;
+    b2CircleShape circle;
+    b2Transform origin;
+    float closest = 1.0f;
+};
+
+class OverlapBoxCallback2D final : public b2QueryCallback
+{
+public:
+    OverlapBoxCallback2D(const OverlapBoxQuery2D& query, Collider2D** results, int maxResults) : query(query), results(results), maxResults(maxResults)
+    {
+        box.SetAsBox(query.halfExtents.x, query.halfExtents.y);
+        transform.Set(b2Vec2(query.center.x, query.center.y), query.angle * DEG2RAD);
+    }
+
+    void GetAABB(b2AABB& aabb) const
+    {
+        box.ComputeAABB(&aabb, transform, 0);
+    }
+
+    bool ReportFixture(b2Fixture* fixture) override
+    {
+        if (!Accepts(fixture, query.layerMask, query.hitTriggers))
+            return true;
+
+        const b2Shape* shape = fixture->GetShape();
+        for (int32 child = 0; child < shape->GetChildCount(); child++)
+            if (b2TestOverlap(shape, child, &box, 0, fixture->GetBody()->GetTransform(), transform))
+                return AddUnique(results, resultCount, maxResults, GetCollider(fixture));
+        return true;
+    }
+
+    int resultCount = 0;
+
+private:
+    const OverlapBoxQuery2D& query;
+    Collider2D** results;
+    int maxResults;
+    b2PolygonShape box;
+    b2Transform transform;
+};
+
+static bool Normalize(const Vector2& direction, b2Vec2& normalized)
+{
+    float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+    if (length <= 0.0f)
+        return false;
+
+    normalized.Set(direction.x / length, direction.y / length);
+    return true;
+}
+
+static void Raycast(const RaycastQuery2D& query, RaycastHit2D& hit)
+{
+    hit = RaycastHit2D();
+    b2Vec2 direction;
+    if (query.maxDistance <= 0.0f || !Normalize(query.direction, direction))
+        return;
+
+    b2Vec2 origin(query.origin.x, query.origin.y);
+    RaycastCallback2D callback(query, hit);
+    world->RayCast(&callback, origin, origin + query.maxDistance * direction);
+}
+
+static void SphereCast(const SphereCastQuery2D& query, RaycastHit2D& hit)
+{
+    hit = RaycastHit2D();
+    b2Vec2 direction;
+    if (query.radius <= 0.0f || query.maxDistance <= 0.0f || !Normalize(query.direction, direction))
+        return;
+
+    b2Vec2 origin(query.origin.x, query.origin.y);
+    b2Vec2 translation = query.maxDistance * direction;
+    b2Vec2 end = origin + translation;
+    b2Vec2 radius(query.radius, query.radius);
+    b2AABB sweep;
+    sweep.lowerBound = b2Min(origin, end) - radius;
+    sweep.upperBound = b2Max(origin, end) + radius;
+
+    SphereCastCallback2D callback(query, translation, hit);
+    world->QueryAABB(&callback, sweep);
+}
+
+static int OverlapBox(const OverlapBoxQuery2D& query, Collider2D** results, int maxResults)
+{
+    if (maxResults <= 0 || query.halfExtents.x <= 0.0f || query.halfExtents.y <= 0.0f)
+        return 0;
+
+    OverlapBoxCallback2D callback(query, results, maxResults);
+    b2AABB aabb;
+    callback.GetAABB(aabb);
+    world->QueryAABB(&callback, aabb);
+    return callback.resultCount;
+}
+#endif
+
+#if defined(IS3D)
+void PhysicsQueries::RaycastBatch(const RaycastQuery* queries, RaycastHit* hits, int count, int threadCount)
+{
+#if !defined(EDITOR)
+    if (!Rigidbody3D::physicsSystem)
+        return;
+
+    RunBatch(count, threadCount, [queries, hits](int first, int last)
+    {
+        for (int i = first; i < last; i++)
+            Raycast(queries[i], hits[i]);
+    });
+#endif
+}
+
+void PhysicsQueries::SphereCastBatch(const SphereCastQuery* queries, RaycastHit* hits, int count, int threadCount)
+{
+#if !defined(EDITOR)
+    if (!Rigidbody3D::physicsSystem)
+        return;
+
+    RunBatch(count, threadCount, [queries, hits](int first, int last)
+    {
+        for (int i = first; i < last; i++)
+            SphereCast(queries[i], hits[i]);
+    });
+#endif
+}
+
+void PhysicsQueries::OverlapBoxBatch(const OverlapBoxQuery* queries, Collider3D** results, int* resultCounts, int count, int maxResultsPerQuery, int threadCount)
+{
+#if !defined(EDITOR)
+    if (!Rigidbody3D::physicsSystem)
+        return;
+
+    RunBatch(count, threadCount, [queries, results, resultCounts, maxResultsPerQuery](int first, int last)
+    {
+        for (int i = first; i < last; i++)
+            resultCounts[i] = OverlapBox(queries[i], results + static_cast<size_t>(i) * maxResultsPerQuery, maxResultsPerQuery);
+    });
+#endif
+}
+#endif
+
+void PhysicsQueries::RaycastBatch(const RaycastQuery2D* queries, RaycastHit2D* hits, int count, int threadCount)
+{
+#if !defined(EDITOR)
+    if (!world)
+        return;
+
+    RunBatch(count, threadCount, [queries, hits](int first, int last)
+    {
+        for (int i = first; i < last; i++)
+            Raycast(queries[i], hits[i]);
+    });
+#endif
+}
+
+void PhysicsQueries::SphereCastBatch(const SphereCastQuery2D* queries, RaycastHit2D* hits, int count, int threadCount)
+{
+#if !defined(EDITOR)
+    if (!world)
+        return;
+
+    RunBatch(count, threadCount, [queries, hits](int first, int last)
+    {
+        for (int i = first; i < last; i++)
+            SphereCast(queries[i], hits[i]);
+    });
+#endif
+}
+
+void PhysicsQueries::OverlapBoxBatch(const OverlapBoxQuery2D* queries, Collider2D** results, int* resultCounts, int count, int maxResultsPerQuery, int threadCount)
+{
+#if !defined(EDITOR)
+    if (!world)
+        return;
+
+    RunBatch(count, threadCount, [queries, results, resultCounts, maxResultsPerQuery](int first, int last)
+    {
+        for (int i = first; i < last; i++)
+            resultCounts[i] = OverlapBox(queries[i], results + static_cast<size_t>(i) * maxResultsPerQuery, maxResultsPerQuery);
+    });
+#endif
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Core/GameObject.h"
+#include <cstdint>
+
+class Collider2D;
+class Collider3D;
+
+// Layer masks have bit n set to hit collision layer n from the project settings. Triggers are skipped unless hitTriggers is set.
+
+struct RaycastQuery
+{
+    Vector3 origin = { 0, 0, 0 };
+    Vector3 direction = { 0, -1, 0 }; // Doesn't need to be normalized
+    float maxDistance = 1000.0f;
+    uint32_t layerMask = 0xFFFFFFFF;
+    bool hitTriggers = false;
+};
+
+struct SphereCastQuery
+{
+    Vector3 origin = { 0, 0, 0 };
+    Vector3 direction = { 0, -1, 0 }; // Doesn't need to be normalized
+    float radius = 0.5f;
+    float maxDistance = 1000.0f;
+    uint32_t layerMask = 0xFFFFFFFF;
+    bool hitTriggers = false;
+};
+
+struct OverlapBoxQuery
+{
+    Vector3 center = { 0, 0, 0 };
+    Vector3 halfExtents = { 0.5f, 0.5f, 0.5f };
+    Quaternion rotation = { 0, 0, 0, 1 };
+    uint32_t layerMask = 0xFFFFFFFF;
+    bool hitTriggers = false;
+};
+
+struct RaycastHit
+{
+    bool hit = false;
+    float distance = 0.0f; // Along the normalized direction. 0 for sphere casts that start inside a collider.
+    Vector3 point = { 0, 0, 0 };
+    Vector3 normal = { 0, 1, 0 };
+    Collider3D* collider = nullptr;
+};
+
+// Only the first 16 collision layers exist in 2D, so only the low 16 bits of the masks are used
+struct RaycastQuery2D
+{
+    Vector2 origin = { 0, 0 };
+    Vector2 direction = { 0, -1 }; // Doesn't need to be normalized
+    float maxDistance = 1000.0f;
+    uint32_t layerMask = 0xFFFFFFFF;
+    bool hitTriggers = false;
+};
+
+struct SphereCastQuery2D
+{
+    Vector2 origin = { 0, 0 };
+    Vector2 direction = { 0, -1 }; // Doesn't need to be normalized
+    float radius = 0.5f;
+    float maxDistance = 1000.0f;
+    uint32_t layerMask = 0xFFFFFFFF;
+    bool hitTriggers = false;
+};
+
+struct OverlapBoxQuery2D
+{
+    Vector2 center = { 0, 0 };
+    Vector2 halfExtents = { 0.5f, 0.5f };
+    float angle = 0.0f; // Degrees
+    uint32_t layerMask = 0xFFFFFFFF;
+    bool hitTriggers = false;
+};
+
+struct RaycastHit2D
+{
+    bool hit = false;
+    float distance = 0.0f; // Along the normalized direction. Sphere casts miss colliders they start inside, since Box2D's shape cast doesn't report them.
+    Vector2 point = { 0, 0 };
+    Vector2 normal = { 0, 1 };
+    Collider2D* collider = nullptr;
+};
+
+// Physics queries for many agents at once, like line of sight and ground checks. Results go into the caller's arrays, one per query.
+// Batches are split across threads, and each query reads the physics world without taking locks, so they must run outside the physics step,
+// from the main thread, while no bodies are being added, removed, or moved.
+class PhysicsQueries
+{
+public:
+    // threadCount 0 uses every core. Small batches use fewer threads, since waking one isn't worth it for a few queries.
+#if defined(IS3D)
+    static void RaycastBatch(const RaycastQuery* queries, RaycastHit* hits, int count, int threadCount = 0);
+    static void SphereCastBatch(const SphereCastQuery* queries, RaycastHit* hits, int count, int threadCount = 0);
+    // Query i writes up to maxResultsPerQuery colliders starting at results[i * maxResultsPerQuery], and how many it wrote to resultCounts[i]
+    static void OverlapBoxBatch(const OverlapBoxQuery* queries, Collider3D** results, int* resultCounts, int count, int maxResultsPerQuery, int threadCount = 0);
+#endif
+
+    static void RaycastBatch(const RaycastQuery2D* queries, RaycastHit2D* hits, int count, int threadCount = 0);
+    static void SphereCastBatch(const SphereCastQuery2D* queries, RaycastHit2D* hits, int count, int threadCount = 0);
+    static void OverlapBoxBatch(const OverlapBoxQuery2D* queries, Collider2D** results, int* resultCounts, int count, int maxResultsPerQuery, int threadCount = 0);
+};
@@ -0,0 +1,487 @@
+#include "PhysicsSnapshot.h"
+#if !defined(EDITOR)
+#include "Game.h"
+#include "Core/GameObject.h"
+#include "Utilities/ConsoleLogger.h"
+#include "Components/Physics/Rigidbody2D.h"
+#if defined(IS3D)
+#include "Components/Physics/Rigidbody3D.h"
+#include "Systems/Physics/CollisionListener3D.h"
+#include "ThirdParty/Jolt/Physics/StateRecorder.h"
+#endif
+#include <algorithm>
+#include <cstring>
+#include <string>
+#endif
+
+#if !defined(EDITOR)
+static const uint32_t snapshotVersion = 2;
+static const size_t minDeltaGap = 8; // Differences closer than this share a run, since each run costs 8 bytes for its offset and length
+
+// Where a section starts in a state, not counting its size in front
+struct StateSection
+{
+    size_t offset;
+    uint32_t size;
+};
+
+// Reused so saving and restoring don't allocate once they've grown to the scene's size
+static std::vector<uint8_t> stateBuffer;
+static std::vector<uint8_t> baseBuffer;
+static std::vector<uint8_t> deltaBaseBuffer;
+static std::vector<StateSection> sections;
+static std::vector<StateSection> baseSections;
+#if defined(IS3D)
+static std::vector<uint8_t> rollbackBuffer;
+#endif
+static std::vector<GameObject*> rigidbodyObjects;
+
+template <typename T>
+static void Write(std::vector<uint8_t>& buffer, const T& value)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static bool Read(const uint8_t*& data, const uint8_t* end, T& value)
+{
+    if (static_cast<size_t>(end - data) < sizeof(T))
+        return false;
+    std::memcpy(&value, data, sizeof(T));
+    data += sizeof(T);
+    return true;
+}
+
+// The game objects whose transforms are synced from their bodies, in the same order every time while the bodies don't change
+static void CollectRigidbodyObjects()
+{
+    rigidbodyObjects.clear();
+#if defined(IS3D)
+    for (Rigidbody3D* rigidbody : Rigidbody3D::GetBodyRigidbodies())
+        if (rigidbody)
+            rigidbodyObjects.push_back(rigidbody->gameObject);
+#else
+    for (b2Body* body = world->GetBodyList(); body; body = body->GetNext())
+        if (body->GetUserData().pointer != 0)
+            rigidbodyObjects.push_back(reinterpret_cast<Rigidbody2D*>(body->GetUserData().pointer)->gameObject);
+#endif
+}
+
+#if defined(IS3D)
+// Lets Jolt save into and restore from a plain byte buffer, instead of StateRecorderImpl's stringstream
+class SnapshotRecorder final : public JPH::StateRecorder
+{
+public:
+    explicit SnapshotRecorder(std::vector<uint8_t>& output) : output(&output) {}
+    SnapshotRecorder(const uint8_t* data, size_t size) : input(data), inputSize(size) {}
+
+    void WriteBytes(const void* inData, size_t inNumBytes) override
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(inData);
+        output->insert(output->end(), bytes, bytes + inNumBytes);
+    }
+
+    void ReadBytes(void* outData, size_t inNumBytes) override
+    {
+        if (inputSize - readOffset < inNumBytes)
+        {
+            std::memset(outData, 0, inNumBytes);
+            failed = true;
+            return;
+        }
+        std::memcpy(outData, input + readOffset, inNumBytes);
+        readOffset += inNumBytes;
+    }
+
+    bool IsEOF() const override { return readOffset >= inputSize; }
+    bool IsFailed() const override { return failed; }
+
+private:
+    std::vector<uint8_t>* output = nullptr;
+    const uint8_t* input = nullptr;
+    size_t inputSize = 0;
+    size_t readOffset = 0;
+    bool failed = false;
+};
+
+#endif
+
+// The state is its version followed by sections, each with its size in front, so restoring can hand each part exactly its own bytes.
+// Deltas are taken per section, so a section changing size, like the contacts, doesn't stop the others from being diffed.
+template <typename SaveFunction>
+static void WriteSection(std::vector<uint8_t>& buffer, SaveFunction save)
+{
+    size_t sizeOffset = buffer.size();
+    Write(buffer, uint32_t(0));
+    save();
+    uint32_t size = static_cast<uint32_t>(buffer.size() - sizeOffset - sizeof(uint32_t));
+    std::memcpy(buffer.data() + sizeOffset, &size, sizeof(size));
+}
+
+static bool ReadSection(const uint8_t*& data, const uint8_t* end, const uint8_t*& section, uint32_t& size)
+{
+    if (!Read(data, end, size) || static_cast<size_t>(end - data) < size)
+        return false;
+    section = data;
+    data += size;
+    return true;
+}
+
+static bool FindSections(const std::vector<uint8_t>& buffer, std::vector<StateSection>& found)
+{
+    found.clear();
+    const uint8_t* data = buffer.data();
+    const uint8_t* end = data + buffer.size();
+    uint32_t version;
+    if (!Read(data, end, version) || version != snapshotVersion)
+        return false;
+
+    while (data != end)
+    {
+        const uint8_t* section;
+        uint32_t size;
+        if (!ReadSection(data, end, section, size))
+            return false;
+        found.push_back({ static_cast<size_t>(section - buffer.data()), size });
+    }
+    return true;
+}
+
+// Appends the runs of bytes that differ between two sections of the same size, each as its offset in the section, its length, and the bytes
+static void WriteRuns(std::vector<uint8_t>& output, const uint8_t* state, const uint8_t* base, size_t size)
+{
+    size_t i = 0;
+    while (i < size)
+    {
+        if (state[i] == base[i])
+        {
+            i++;
+            continue;
+        }
+
+        size_t start = i;
+        size_t last = i;
+        for (i++; i < size && i - last <= minDeltaGap; i++)
+            if (state[i] != base[i])
+                last = i;
+
+        Write(output, static_cast<uint32_t>(start));
+        Write(output, static_cast<uint32_t>(last - start + 1));
+        output.insert(output.end(), state + start, state + last + 1);
+        i = last + 1;
+    }
+}
+#endif
+
+void PhysicsSnapshot::Save()
+{
+#if !defined(EDITOR)
+    base = nullptr;
+    SaveState(data);
+#endif
+}
+
+void PhysicsSnapshot::SaveDelta(const PhysicsSnapshot& base)
+{
+#if !defined(EDITOR)
+    if (&base == this || base.IsEmpty())
+    {
+        Save();
+        return;
+    }
+
+    base.GetState(baseBuffer);
+    SaveState(stateBuffer);
+
+    // Every state has the same sections, so this only fails for a base saved by another version
+    if (!FindSections(stateBuffer, sections) || !FindSections(baseBuffer, baseSections) || sections.size() != baseSections.size())
+    {
+        this->base = nullptr;
+        data = stateBuffer;
+        return;
+    }
+
+    // Each section is its size, then its runs that differ from the base's section if they're the same size, or else all of its bytes
+    this->base = &base;
+    data.clear();
+    for (size_t i = 0; i < sections.size(); i++)
+    {
+        const uint8_t* section = stateBuffer.data() + sections[i].offset;
+        Write(data, sections[i].size);
+        if (sections[i].size != baseSections[i].size)
+        {
+            data.insert(data.end(), section, section + sections[i].size);
+            continue;
+        }
+
+        size_t runsSizeOffset = data.size();
+        Write(data, uint32_t(0));
+        WriteRuns(data, section, baseBuffer.data() + baseSections[i].offset, sections[i].size);
+        uint32_t runsSize = static_cast<uint32_t>(data.size() - runsSizeOffset - sizeof(uint32_t));
+        std::memcpy(data.data() + runsSizeOffset, &runsSize, sizeof(runsSize));
+    }
+#endif
+}
+
+bool PhysicsSnapshot::Restore() const
+{
+#if !defined(EDITOR)
+    if (data.empty())
+        return false;
+
+    if (!base)
+        return RestoreState(data);
+
+    GetState(stateBuffer);
+    return RestoreState(stateBuffer);
+#else
+    return false;
+#endif
+}
+
+void PhysicsSnapshot::GetState(std::vector<uint8_t>& buffer) const
+{
+#if !defined(EDITOR)
+    if (!base)
+    {
+        buffer = data;
+        return;
+    }
+
+    // The base's state is copied out, since a base that's a delta itself builds its state with the same buffer
+    base->GetState(buffer);
+    deltaBaseBuffer = buffer;
+    buffer.clear();
+    Write(buffer, snapshotVersion);
+    if (!FindSections(deltaBaseBuffer, baseSections)) // The base was saved again since
+        return;
+
+    const uint8_t* delta = data.data();
+    const uint8_t* end = delta + data.size();
+    for (const StateSection& baseSection : baseSections)
+    {
+        uint32_t size;
+        if (!Read(delta, end, size))
+            return;
+        Write(buffer, size);
+
+        if (size != baseSection.size)
+        {
+            if (static_cast<size_t>(end - delta) < size)
+                return;
+            buffer.insert(buffer.end(), delta, delta + size);
+            delta += size;
+            continue;
+        }
+
+        size_t sectionOffset = buffer.size();
+        buffer.insert(buffer.end(), deltaBaseBuffer.begin() + baseSection.offset, deltaBaseBuffer.begin() + baseSection.offset + size);
+
+        const uint8_t* runs;
+        uint32_t runsSize;
+        if (!ReadSection(delta, end, runs, runsSize))
+            return;
+        const uint8_t* runsEnd = runs + runsSize;
+        uint32_t offset;
+        uint32_t length;
+        while (Read(runs, runsEnd, offset) && Read(runs, runsEnd, length))
+        {
+            if (offset + static_cast<size_t>(length) > size || static_cast<size_t>(runsEnd - runs) < length)
+                return;
+            std::memcpy(buffer.data() + sectionOffset + offset, runs, length);
+            runs += length;
+        }
+    }
+#endif
+}
+
+void PhysicsSnapshot::SaveState(std::vector<uint8_t>& buffer)
+{
+#if !defined(EDITOR)
+    buffer.clear();
+
+#if defined(IS3D)
+    Rigidbody3D::SyncMovedTransforms();
+#else
+    Rigidbody2D::SyncMovedTransforms();
+#endif
+
+    Write(buffer, snapshotVersion);
+
+    CollectRigidbodyObjects();
+    WriteSection(buffer, [&buffer]() {
+        Write(buffer, static_cast<uint32_t>(rigidbodyObjects.size()));
+        for (GameObject* gameObject : rigidbodyObjects)
+        {
+            Vector3 position = gameObject->transform.GetPosition();
+            Quaternion rotation = gameObject->transform.GetRotation();
+            Write(buffer, position);
+            Write(buffer, rotation);
+        }
+    });
+
+#if defined(IS3D)
+    // The bodies and constraints keep the same size while no bodies are added or removed, so they're saved apart from the contacts, whose size changes every step
+    WriteSection(buffer, [&buffer]() {
+        SnapshotRecorder recorder(buffer);
+        Rigidbody3D::physicsSystem->SaveState(recorder, JPH::EStateRecorderState::Global | JPH::EStateRecorderState::Bodies | JPH::EStateRecorderState::Constraints);
+    });
+    WriteSection(buffer, [&buffer]() {
+        SnapshotRecorder recorder(buffer);
+        Rigidbody3D::physicsSystem->SaveState(recorder, JPH::EStateRecorderState::Contacts);
+    });
+    WriteSection(buffer, [&buffer]() { CollisionListener3D::SaveState(buffer); });
+#else
+    WriteSection(buffer, [&buffer]() {
+        Write(buffer, static_cast<uint32_t>(world->GetBodyCount()));
+        for (b2Body* body = world->GetBodyList(); body; body = body->GetNext())
+        {
+            Write(buffer, body->GetPosition());
+            Write(buffer, body->GetAngle());
+            Write(buffer, body->GetLinearVelocity());
+            Write(buffer, body->GetAngularVelocity());
+            Write(buffer, static_cast<uint8_t>(body->IsAwake()));
+        }
+    });
+#endif
+#endif
+}
+
+bool PhysicsSnapshot::RestoreState(const std::vector<uint8_t>& buffer)
+{
+#if !defined(EDITOR)
+    const uint8_t* data = buffer.data();
+    const uint8_t* end = data + buffer.size();
+
+    uint32_t version;
+    const uint8_t* transforms;
+    uint32_t transformsSize;
+    uint32_t transformCount;
+    CollectRigidbodyObjects();
+    if (!Read(data, end, version) || version != snapshotVersion || !ReadSection(data, end, transforms, transformsSize)
+        || !Read(transforms, transforms + transformsSize, transformCount) || transformCount != rigidbodyObjects.size())
+    {
+        ConsoleLogger::WarningLog("Failed to restore the physics snapshot. Rigidbodies were added or removed since it was saved.");
+        return false;
+    }
+
+    if (transformsSize - sizeof(uint32_t) != transformCount * (sizeof(Vector3) + sizeof(Quaternion)))
+        return false;
+    const uint8_t* transformsEnd = transforms + transformCount * (sizeof(Vector3) + sizeof(Quaternion));
+
+#if defined(IS3D)
+    const uint8_t* joltBodies;
+    const uint8_t* joltContacts;
+    const uint8_t* contacts;
+    uint32_t joltBodiesSize;
+    uint32_t joltContactsSize;
+    uint32_t contactsSize;
+    if (!ReadSection(data, end, joltBodies, joltBodiesSize) || !ReadSection(data, end, joltContacts, joltContactsSize) || !ReadSection(data, end, contacts, contactsSize))
+        return false;
+
+    // Jolt can fail after it already restored part of the state, so the current state is kept to go back to
+    rollbackBuffer.clear();
+    SnapshotRecorder rollbackRecorder(rollbackBuffer);
+    Rigidbody3D::physicsSystem->SaveState(rollbackRecorder);
+
+    // Each recording holds which parts of the state it saved, so they're restored one after the other
+    SnapshotRecorder bodiesRecorder(joltBodies, joltBodiesSize);
+    SnapshotRecorder contactsRecorder(joltContacts, joltContactsSize);
+    if (!Rigidbody3D::physicsSystem->RestoreState(bodiesRecorder) || bodiesRecorder.IsFailed()
+        || !Rigidbody3D::physicsSystem->RestoreState(contactsRecorder) || contactsRecorder.IsFailed()
+        || !CollisionListener3D::RestoreState(contacts, contactsSize))
+    {
+        SnapshotRecorder rollback(rollbackBuffer.data(), rollbackBuffer.size());
+        Rigidbody3D::physicsSystem->RestoreState(rollback);
+        ConsoleLogger::WarningLog("Failed to restore the physics snapshot. Bodies were added or removed since it was saved.");
+        return false;
+    }
+#else
+    // Every body's state is checked to be there before any body is changed
+    const uint8_t* bodies;
+    uint32_t bodiesSize;
+    uint32_t bodyCount;
+    size_t bodySize = sizeof(b2Vec2) * 2 + sizeof(float) * 2 + sizeof(uint8_t);
+    if (!ReadSection(data, end, bodies, bodiesSize) || !Read(bodies, bodies + bodiesSize, bodyCount) || bodyCount != static_cast<uint32_t>(world->GetBodyCount())
+        || bodiesSize - sizeof(uint32_t) != bodyCount * bodySize)
+    {
+        ConsoleLogger::WarningLog("Failed to restore the physics snapshot. Bodies were added or removed since it was saved.");
+        return false;
+    }
+
+    const uint8_t* bodiesEnd = bodies + bodyCount * bodySize;
+    for (b2Body* body = world->GetBodyList(); body; body = body->GetNext())
+    {
+        b2Vec2 position;
+        float angle;
+        b2Vec2 linearVelocity;
+        float angularVelocity;
+        uint8_t awake;
+        if (!Read(bodies, bodiesEnd, position) || !Read(bodies, bodiesEnd, angle) || !Read(bodies, bodiesEnd, linearVelocity) || !Read(bodies, bodiesEnd, angularVelocity) || !Read(bodies, bodiesEnd, awake))
+            return false;
+
+        body->SetTransform(position, angle);
+        body->SetLinearVelocity(linearVelocity);
+        body->SetAngularVelocity(angularVelocity);
+        body->SetAwake(awake != 0);
+    }
+#endif
+
+    for (GameObject* gameObject : rigidbodyObjects)
+    {
+        Vector3 position;
+        Quaternion rotation;
+        if (!Read(transforms, transformsEnd, position) || !Read(transforms, transformsEnd, rotation))
+            return false;
+        gameObject->transform.SetPhysicsTransform(position, rotation);
+    }
+
+    // The bodies are already where these game objects were moved to, including children moved with their parent above
+    for (GameObject* gameObject : GameObject::movedPhysicsObjects)
+        gameObject->physicsMoved = false;
+    GameObject::movedPhysicsObjects.clear();
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool PhysicsSnapshot::CheckDeterminism(int steps, const std::function<void()>& step)
+{
+#if !defined(EDITOR)
+    PhysicsSnapshot start;
+    start.Save();
+
+    std::vector<uint8_t> firstRun;
+    for (int i = 0; i < steps; i++)
+        step();
+    SaveState(firstRun);
+
+    if (!start.Restore())
+        return false;
+
+    std::vector<uint8_t> secondRun;
+    for (int i = 0; i < steps; i++)
+        step();
+    SaveState(secondRun);
+
+    if (firstRun.size() != secondRun.size())
+    {
+        ConsoleLogger::WarningLog("Physics isn't deterministic. The state after re-simulating " + std::to_string(steps) + " steps is a different size.");
+        return false;
+    }
+
+    auto difference = std::mismatch(firstRun.begin(), firstRun.end(), secondRun.begin());
+    if (difference.first != firstRun.end())
+    {
+        ConsoleLogger::WarningLog("Physics isn't deterministic. The state after re-simulating " + std::to_string(steps) + " steps first differs at byte " + std::to_string(difference.first - firstRun.begin()) + ".");
+        return false;
+    }
+
+    ConsoleLogger::InfoLog("Physics is deterministic. Re-simulating " + std::to_string(steps) + " steps from a snapshot gave bit-identical state.");
+    return true;
+#else
+    return false;
+#endif
+}
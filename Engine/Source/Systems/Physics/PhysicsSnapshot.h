@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+// A copy of the physics state in memory, for rolling back to it or simulating ahead and coming back.
+// 3D snapshots hold Jolt's state from PhysicsSystem::SaveState(), so stepping again after Restore() gives bit-identical results.
+// 2D snapshots hold each Box2D body's transform, velocities, and sleep state. Box2D doesn't expose its contacts, so they're rebuilt and 2D re-simulation can drift slightly.
+// Both also hold the transforms of the game objects with a rigidbody.
+// A snapshot can only be restored into the bodies it was saved from, so no bodies can be created or destroyed in between.
+class PhysicsSnapshot
+{
+public:
+    // Moves the bodies of game objects that were moved since the last step first, the same as the next step would
+    void Save();
+    // Only keeps the bytes that differ from the base, which is much smaller for snapshots a few steps apart. The state is diffed in sections,
+    // and a section that changed size since the base, like the contacts, is kept whole. The base must stay alive and unchanged while this snapshot is used.
+    void SaveDelta(const PhysicsSnapshot& base);
+    // Returns false, without changing anything, if the bodies changed since the snapshot was saved.
+    // 3D snapshots keep a copy of the current Jolt state while restoring, since Jolt can fail after part of the snapshot was applied.
+    bool Restore() const;
+    // Saves a snapshot, runs the steps, restores the snapshot and runs them again, then checks both runs ended in bit-identical state.
+    // The step function must do everything a fixed update does to the physics. 2D is expected to fail, since its contacts aren't snapshotted.
+    static bool CheckDeterminism(int steps, const std::function<void()>& step);
+
+    bool IsEmpty() const { return data.empty(); }
+    bool IsDelta() const { return base != nullptr; }
+    // Bytes the snapshot uses, not counting its base
+    size_t GetSize() const { return data.size(); }
+
+private:
+    static void SaveState(std::vector<uint8_t>& buffer);
+    static bool RestoreState(const std::vector<uint8_t>& buffer);
+    void GetState(std::vector<uint8_t>& buffer) const;
+
+    std::vector<uint8_t> data; // The state, or for deltas the runs of bytes that differ from the base
+    const PhysicsSnapshot* base = nullptr;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads kept alive between batches, so running a batch doesn't start threads or allocate anything. The calling thread works on the batch too.
+// Slices are taken from a shared counter, so a worker that finishes early takes the next one.
+class QueryThreadPool
+{
+public:
+    ~QueryThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        batchReady.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    template <typename QueryRange>
+    void Run(int count, int sliceCount, QueryRange& queryRange)
+    {
+        // A lambda without captures so the batch can be stored without a std::function
+        Run(count, sliceCount, [](void* range, int first, int last) { (*static_cast<QueryRange*>(range))(first, last); }, &queryRange);
+    }
+
+private:
+    void Run(int count, int sliceCount, void (*runRange)(void*, int, int), void* range)
+    {
+        std::lock_guard<std::mutex> batchLock(batchMutex); // One batch at a time
+
+        if (workers.empty())
+        {
+            int workerCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+            workers.reserve(workerCount);
+            for (int i = 0; i < workerCount; i++)
+                workers.emplace_back([this]() { WorkerLoop(); });
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->runRange = runRange;
+            this->range = range;
+            this->count = count;
+            this->sliceCount = sliceCount;
+            sliceSize = (count + sliceCount - 1) / sliceCount;
+            nextSlice = 0;
+            workersWanted = std::min(static_cast<int>(workers.size()), sliceCount - 1);
+            workersBusy = workersWanted;
+            batch++;
+        }
+        batchReady.notify_all();
+
+        RunSlices();
+
+        // The range lives on the caller's stack, so every worker that joined must be done with it
+        std::unique_lock<std::mutex> lock(mutex);
+        batchDone.wait(lock, [this]() { return workersBusy == 0; });
+    }
+
+    void WorkerLoop()
+    {
+        uint64_t joinedBatch = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            batchReady.wait(lock, [&]() { return stopping || (batch != joinedBatch && workersWanted > 0); });
+            if (stopping)
+                return;
+
+            joinedBatch = batch;
+            workersWanted--;
+            lock.unlock();
+            RunSlices();
+            lock.lock();
+            if (--workersBusy == 0)
+                batchDone.notify_one();
+        }
+    }
+
+    void RunSlices()
+    {
+        for (int slice = nextSlice++; slice < sliceCount; slice = nextSlice++)
+        {
+            int first = slice * sliceSize;
+            runRange(range, first, std::min(first + sliceSize, count));
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex batchMutex;
+    std::mutex mutex;
+    std::condition_variable batchReady;
+    std::condition_variable batchDone;
+    bool stopping = false;
+    uint64_t batch = 0;
+    int workersWanted = 0; // Workers that still need to join the current batch
+    int workersBusy = 0; // Workers that joined the current batch and haven't finished it
+
+    // The current batch
+    void (*runRange)(void*, int, int) = nullptr;
+    void* range = nullptr;
+    int count = 0;
+    int sliceCount = 0;
+    int sliceSize = 0;
+    std::atomic<int> nextSlice = 0;
+};
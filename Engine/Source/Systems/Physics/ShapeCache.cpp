@@ -0,0 +1,303 @@
+#include "ShapeCache.h"
+#if !defined(EDITOR)
+#include "Game.h"
+#include "Utilities/ConsoleLogger.h"
+#include "ThirdParty/Jolt/Core/HashCombine.h"
+#include "ThirdParty/Jolt/Core/StreamWrapper.h"
+#include "ThirdParty/Jolt/Physics/Collision/Shape/MeshShape.h"
+#include "ThirdParty/Jolt/Physics/Collision/Shape/ConvexHullShape.h"
+#include "ThirdParty/Jolt/Physics/Collision/Shape/BoxShape.h"
+#include "ThirdParty/Jolt/Physics/Collision/Shape/SphereShape.h"
+#include "ThirdParty/Jolt/Physics/Collision/Shape/CylinderShape.h"
+#include <fstream>
+#include <cstdio>
+#endif
+
+std::filesystem::path ShapeCache::cookedDirectory;
+
+#if !defined(EDITOR)
+std::unordered_map<ShapeCache::ShapeKey, JPH::RefConst<JPH::Shape>, ShapeCache::ShapeKeyHasher> ShapeCache::sharedShapes;
+std::unordered_map<const JPH::Shape*, ShapeCache::ShapeKey> ShapeCache::sharedShapeKeys;
+
+static const uint32_t cookedShapeVersion = 1; // Changing this cooks every shape again
+
+static uint64_t HashGeometry(const std::vector<float>& positions, const std::vector<unsigned int>& indices, bool convexHull)
+{
+    // Jolt's binary format isn't stable between versions, so its version is part of the key
+    uint32_t versions[3] = { cookedShapeVersion, JPH_VERSION_MAJOR, JPH_VERSION_MINOR };
+    uint64_t hash = JPH::HashBytes(versions, sizeof(versions));
+    hash = JPH::HashBytes(&convexHull, sizeof(convexHull), hash);
+    hash = JPH::HashBytes(positions.data(), static_cast<JPH::uint>(positions.size() * sizeof(float)), hash);
+    if (!convexHull)
+        hash = JPH::HashBytes(indices.data(), static_cast<JPH::uint>(indices.size() * sizeof(unsigned int)), hash);
+    return hash;
+}
+
+static JPH::RefConst<JPH::Shape> LoadCookedShape(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return nullptr;
+
+    JPH::StreamInWrapper stream(file);
+    JPH::Shape::IDToShapeMap shapeMap;
+    JPH::Shape::IDToMaterialMap materialMap;
+    JPH::Shape::ShapeResult result = JPH::Shape::sRestoreWithChildren(stream, shapeMap, materialMap);
+    if (result.HasError())
+        return nullptr;
+
+    return result.Get();
+}
+
+static bool SaveCookedShape(const std::filesystem::path& path, const JPH::Shape* shape)
+{
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    // Written to a temporary file first so a failed write doesn't leave a broken shape to be loaded
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    JPH::StreamOutWrapper stream(file);
+    JPH::Shape::ShapeToIDMap shapeMap;
+    JPH::Shape::MaterialToIDMap materialMap;
+    shape->SaveWithChildren(stream, shapeMap, materialMap);
+    file.close();
+
+    if (stream.IsFailed() || file.fail())
+    {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    std::filesystem::rename(tempPath, path, error);
+    return !error;
+}
+
+bool ShapeCache::ShapeKey::operator==(const ShapeKey& other) const
+{
+    return type == other.type && parameters[0] == other.parameters[0] && parameters[1] == other.parameters[1] && parameters[2] == other.parameters[2]
+        && geometryHash == other.geometryHash;
+}
+
+size_t ShapeCache::ShapeKeyHasher::operator()(const ShapeKey& key) const
+{
+    size_t hash = std::hash<uint64_t>()(key.geometryHash) ^ static_cast<size_t>(key.type);
+    for (float parameter : key.parameters)
+        hash = hash * 31 + std::hash<float>()(parameter);
+    return hash;
+}
+
+JPH::RefConst<JPH::Shape> ShapeCache::FindShared(const ShapeKey& key)
+{
+    auto it = sharedShapes.find(key);
+    return it != sharedShapes.end() ? it->second : nullptr;
+}
+
+void ShapeCache::AddShared(const ShapeKey& key, const JPH::RefConst<JPH::Shape>& shape)
+{
+    if (shape == nullptr)
+        return;
+
+    sharedShapes[key] = shape;
+    sharedShapeKeys[shape.GetPtr()] = key;
+}
+#endif
+
+JPH::RefConst<JPH::Shape> ShapeCache::GetBoxShape(float halfExtentX, float halfExtentY, float halfExtentZ)
+{
+#if !defined(EDITOR)
+    ShapeKey key = { ShapeType::Box, { halfExtentX, halfExtentY, halfExtentZ } };
+    JPH::RefConst<JPH::Shape> shape = FindShared(key);
+    if (shape != nullptr)
+        return shape;
+
+    JPH::ShapeSettings::ShapeResult result = JPH::BoxShapeSettings(JPH::Vec3(halfExtentX, halfExtentY, halfExtentZ)).Create();
+    if (result.HasError())
+        return nullptr;
+
+    AddShared(key, result.Get());
+    return result.Get();
+#else
+    return nullptr;
+#endif
+}
+
+JPH::RefConst<JPH::Shape> ShapeCache::GetSphereShape(float radius)
+{
+#if !defined(EDITOR)
+    ShapeKey key = { ShapeType::Sphere, { radius, 0, 0 } };
+    JPH::RefConst<JPH::Shape> shape = FindShared(key);
+    if (shape != nullptr)
+        return shape;
+
+    JPH::ShapeSettings::ShapeResult result = JPH::SphereShapeSettings(radius).Create();
+    if (result.HasError())
+        return nullptr;
+
+    AddShared(key, result.Get());
+    return result.Get();
+#else
+    return nullptr;
+#endif
+}
+
+JPH::RefConst<JPH::Shape> ShapeCache::GetCylinderShape(float halfHeight, float radius)
+{
+#if !defined(EDITOR)
+    ShapeKey key = { ShapeType::Cylinder, { halfHeight, radius, 0 } };
+    JPH::RefConst<JPH::Shape> shape = FindShared(key);
+    if (shape != nullptr)
+        return shape;
+
+    JPH::ShapeSettings::ShapeResult result = JPH::CylinderShapeSettings(halfHeight, radius).Create();
+    if (result.HasError())
+        return nullptr;
+
+    AddShared(key, result.Get());
+    return result.Get();
+#else
+    return nullptr;
+#endif
+}
+
+JPH::RefConst<JPH::Shape> ShapeCache::GetMeshShape(const std::vector<float>& positions, const std::vector<unsigned int>& indices, bool convexHull)
+{
+#if !defined(EDITOR)
+    size_t vertexCount = positions.size() / 3;
+    if (vertexCount < 3 || (!convexHull && indices.size() < 3))
+        return nullptr;
+
+    // Objects sharing a model and scale share the shape, so it's only read or cooked once
+    ShapeKey key = { convexHull ? ShapeType::ConvexHull : ShapeType::Mesh };
+    key.geometryHash = HashGeometry(positions, indices, convexHull);
+    JPH::RefConst<JPH::Shape> sharedShape = FindShared(key);
+    if (sharedShape != nullptr)
+        return sharedShape;
+
+    char fileName[32];
+    std::snprintf(fileName, sizeof(fileName), "%016llx.shape", static_cast<unsigned long long>(key.geometryHash));
+    std::filesystem::path path = GetCookedDirectory() / fileName;
+
+    if (std::filesystem::exists(path))
+    {
+        JPH::RefConst<JPH::Shape> shape = LoadCookedShape(path);
+        if (shape != nullptr)
+        {
+            AddShared(key, shape);
+            return shape;
+        }
+
+        ConsoleLogger::WarningLog("The cooked collision shape \"" + path.string() + "\" couldn't be read, so it's being cooked again.");
+    }
+
+    JPH::ShapeSettings::ShapeResult result;
+    if (convexHull)
+    {
+        JPH::Array<JPH::Vec3> points;
+        points.reserve(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++)
+            points.push_back(JPH::Vec3(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]));
+        result = JPH::ConvexHullShapeSettings(points).Create();
+    }
+    else
+    {
+        JPH::VertexList vertices;
+        vertices.reserve(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++)
+            vertices.push_back(JPH::Float3(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]));
+
+        JPH::IndexedTriangleList triangles;
+        triangles.reserve(indices.size() / 3);
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            if (indices[i] < vertexCount && indices[i + 1] < vertexCount && indices[i + 2] < vertexCount)
+                triangles.push_back(JPH::IndexedTriangle(indices[i], indices[i + 1], indices[i + 2], 0));
+        }
+        result = JPH::MeshShapeSettings(std::move(vertices), std::move(triangles)).Create();
+    }
+
+    if (result.HasError())
+    {
+        ConsoleLogger::ErrorLog("Failed to cook a collision shape. " + std::string(result.GetError().c_str()));
+        return nullptr;
+    }
+
+    if (!SaveCookedShape(path, result.Get()))
+        ConsoleLogger::WarningLog("Failed to save the cooked collision shape \"" + path.string() + "\". It will be cooked again next time.");
+
+    AddShared(key, result.Get());
+    return result.Get();
+#else
+    return nullptr;
+#endif
+}
+
+void ShapeCache::SetCookedDirectory(const std::filesystem::path& directory)
+{
+    cookedDirectory = directory;
+}
+
+std::filesystem::path ShapeCache::GetCookedDirectory()
+{
+    if (!cookedDirectory.empty())
+        return cookedDirectory;
+
+#if !defined(EDITOR)
+    if (!exeParent.empty())
+        return exeParent / "Resources" / "Cache" / "Shapes";
+#endif
+    return std::filesystem::path("Resources") / "Cache" / "Shapes";
+}
+
+void ShapeCache::Release(JPH::RefConst<JPH::Shape>& shape)
+{
+#if !defined(EDITOR)
+    if (shape == nullptr)
+        return;
+
+    const JPH::Shape* released = shape.GetPtr();
+    shape = nullptr;
+
+    auto keyIt = sharedShapeKeys.find(released);
+    if (keyIt == sharedShapeKeys.end())
+        return;
+
+    auto shapeIt = sharedShapes.find(keyIt->second);
+    if (shapeIt != sharedShapes.end() && shapeIt->second->GetRefCount() > 1)
+        return;
+
+    sharedShapeKeys.erase(keyIt);
+    if (shapeIt != sharedShapes.end())
+        sharedShapes.erase(shapeIt);
+#endif
+}
+
+void ShapeCache::ReleaseUnused()
+{
+#if !defined(EDITOR)
+    for (auto it = sharedShapes.begin(); it != sharedShapes.end();)
+    {
+        if (it->second->GetRefCount() > 1)
+        {
+            ++it;
+            continue;
+        }
+
+        sharedShapeKeys.erase(it->second.GetPtr());
+        it = sharedShapes.erase(it);
+    }
+#endif
+}
+
+int ShapeCache::GetSharedShapeCount()
+{
+#if !defined(EDITOR)
+    return static_cast<int>(sharedShapes.size());
+#else
+    return 0;
+#endif
+}
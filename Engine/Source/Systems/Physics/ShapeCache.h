@@ -0,0 +1,65 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "ThirdParty/Jolt/Jolt.h"
+#include "ThirdParty/Jolt/Physics/Collision/Shape/Shape.h"
+
+// Collision shapes shared between colliders. Every shape is kept under its parameters, so a thousand 1x1x1 boxes use one BoxShape.
+// The cache holds a reference to each shape, and Release() frees a shape once the cache is the only thing still using it.
+// Shapes cooked from mesh geometry are also saved with Jolt's binary serialization under a hash of their geometry,
+// so the next run reads them back instead of building the MeshShape or ConvexHullShape again.
+class ShapeCache
+{
+public:
+    // Returns nullptr if Jolt can't build the shape, for example a box thinner than its convex radius
+    static JPH::RefConst<JPH::Shape> GetBoxShape(float halfExtentX, float halfExtentY, float halfExtentZ);
+    static JPH::RefConst<JPH::Shape> GetSphereShape(float radius);
+    static JPH::RefConst<JPH::Shape> GetCylinderShape(float halfHeight, float radius);
+
+    // Positions are xyz per vertex and every 3 indices is a triangle. Convex hulls only use the positions. Returns nullptr if the shape can't be built.
+    static JPH::RefConst<JPH::Shape> GetMeshShape(const std::vector<float>& positions, const std::vector<unsigned int>& indices, bool convexHull);
+
+    // Where cooked shapes are saved. Defaults to Resources/Cache/Shapes next to the game.
+    static void SetCookedDirectory(const std::filesystem::path& directory);
+    static std::filesystem::path GetCookedDirectory();
+
+    // Drops the caller's reference, and the cache's too if nothing else uses the shape. Shapes that didn't come from the cache are just released.
+    static void Release(JPH::RefConst<JPH::Shape>& shape);
+    // Frees every shared shape only the cache still uses, such as ones that were part of a compound shape that's gone
+    static void ReleaseUnused();
+    static int GetSharedShapeCount();
+
+private:
+    enum class ShapeType
+    {
+        Box,
+        Sphere,
+        Cylinder,
+        Mesh,
+        ConvexHull
+    };
+
+    struct ShapeKey
+    {
+        ShapeType type;
+        float parameters[3] = { 0, 0, 0 };
+        uint64_t geometryHash = 0; // Mesh shapes are keyed by their geometry instead
+
+        bool operator==(const ShapeKey& other) const;
+    };
+
+    struct ShapeKeyHasher
+    {
+        size_t operator()(const ShapeKey& key) const;
+    };
+
+    static JPH::RefConst<JPH::Shape> FindShared(const ShapeKey& key);
+    static void AddShared(const ShapeKey& key, const JPH::RefConst<JPH::Shape>& shape);
+
+    static std::filesystem::path cookedDirectory;
+    static std::unordered_map<ShapeKey, JPH::RefConst<JPH::Shape>, ShapeKeyHasher> sharedShapes;
+    static std::unordered_map<const JPH::Shape*, ShapeKey> sharedShapeKeys; // So Release() can find a shape's entry
+};
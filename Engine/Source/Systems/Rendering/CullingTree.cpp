@@ -0,0 +1,337 @@
+#include "CullingTree.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+bool CullingBounds::Contains(const CullingBounds& other) const
+{
+    for (int i = 0; i < 3; i++)
+        if (other.min[i] < min[i] || other.max[i] > max[i])
+            return false;
+    return true;
+}
+
+float CullingBounds::GetPerimeter() const
+{
+    float x = max[0] - min[0];
+    float y = max[1] - min[1];
+    float z = max[2] - min[2];
+    return 2.0f * (x * y + y * z + z * x);
+}
+
+CullingBounds CullingBounds::Combine(const CullingBounds& a, const CullingBounds& b)
+{
+    CullingBounds bounds;
+    for (int i = 0; i < 3; i++)
+    {
+        bounds.min[i] = std::min(a.min[i], b.min[i]);
+        bounds.max[i] = std::max(a.max[i], b.max[i]);
+    }
+    return bounds;
+}
+
+CullingFrustum CullingFrustum::FromMatrix(const float matrix[16])
+{
+    // Rows of the matrix. The element at row r and column c is matrix[c * 4 + r].
+    float rows[4][4];
+    for (int r = 0; r < 4; r++)
+        for (int c = 0; c < 4; c++)
+            rows[r][c] = matrix[c * 4 + r];
+
+    CullingFrustum frustum;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            frustum.planes[i * 2][c] = rows[3][c] + rows[i][c]; // Left, bottom, near
+            frustum.planes[i * 2 + 1][c] = rows[3][c] - rows[i][c]; // Right, top, far
+        }
+    }
+
+    for (auto& plane : frustum.planes)
+    {
+        float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (length > 0.0f)
+            for (float& value : plane)
+                value /= length;
+    }
+
+    return frustum;
+}
+
+bool CullingFrustum::Intersects(const CullingBounds& bounds) const
+{
+    for (const auto& plane : planes)
+    {
+        // The corner furthest along the plane's normal
+        float distance = plane[0] * (plane[0] > 0 ? bounds.max[0] : bounds.min[0])
+            + plane[1] * (plane[1] > 0 ? bounds.max[1] : bounds.min[1])
+            + plane[2] * (plane[2] > 0 ? bounds.max[2] : bounds.min[2])
+            + plane[3];
+        if (distance < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool CullingFrustum::Contains(const CullingBounds& bounds) const
+{
+    for (const auto& plane : planes)
+    {
+        // The corner furthest behind the plane
+        float distance = plane[0] * (plane[0] > 0 ? bounds.min[0] : bounds.max[0])
+            + plane[1] * (plane[1] > 0 ? bounds.min[1] : bounds.max[1])
+            + plane[2] * (plane[2] > 0 ? bounds.min[2] : bounds.max[2])
+            + plane[3];
+        if (distance < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+int CullingTree::CreateProxy(const CullingBounds& bounds)
+{
+    int proxy = AllocateNode();
+
+    Node& node = nodes[proxy];
+    for (int i = 0; i < 3; i++)
+    {
+        node.bounds.min[i] = bounds.min[i] - margin;
+        node.bounds.max[i] = bounds.max[i] + margin;
+    }
+    node.height = 0;
+
+    InsertLeaf(proxy);
+    proxyCount++;
+    return proxy;
+}
+
+void CullingTree::DestroyProxy(int proxy)
+{
+    if (proxy < 0 || proxy >= static_cast<int>(nodes.size()) || !nodes[proxy].IsLeaf() || nodes[proxy].height != 0)
+        return;
+
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    proxyCount--;
+}
+
+bool CullingTree::MoveProxy(int proxy, const CullingBounds& bounds)
+{
+    if (nodes[proxy].bounds.Contains(bounds))
+        return false;
+
+    RemoveLeaf(proxy);
+
+    Node& node = nodes[proxy];
+    for (int i = 0; i < 3; i++)
+    {
+        node.bounds.min[i] = bounds.min[i] - margin;
+        node.bounds.max[i] = bounds.max[i] + margin;
+    }
+
+    InsertLeaf(proxy);
+    return true;
+}
+
+const CullingBounds& CullingTree::GetFatBounds(int proxy) const
+{
+    return nodes[proxy].bounds;
+}
+
+int CullingTree::GetProxyCount() const
+{
+    return proxyCount;
+}
+
+int CullingTree::GetHeight() const
+{
+    return root == -1 ? 0 : nodes[root].height;
+}
+
+void CullingTree::Clear()
+{
+    nodes.clear();
+    root = -1;
+    freeList = -1;
+    proxyCount = 0;
+}
+
+int CullingTree::AllocateNode()
+{
+    if (freeList == -1)
+    {
+        nodes.emplace_back();
+        return static_cast<int>(nodes.size()) - 1;
+    }
+
+    int node = freeList;
+    freeList = nodes[node].parent;
+    nodes[node] = Node();
+    return node;
+}
+
+void CullingTree::FreeNode(int node)
+{
+    nodes[node].parent = freeList;
+    nodes[node].child1 = -1;
+    nodes[node].child2 = -1;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+void CullingTree::InsertLeaf(int leaf)
+{
+    if (root == -1)
+    {
+        root = leaf;
+        nodes[root].parent = -1;
+        return;
+    }
+
+    // Find the best sibling by walking down the tree, picking the child that increases the surface area the least
+    CullingBounds leafBounds = nodes[leaf].bounds;
+    int index = root;
+    while (!nodes[index].IsLeaf())
+    {
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+
+        float area = nodes[index].bounds.GetPerimeter();
+        float combinedArea = CullingBounds::Combine(nodes[index].bounds, leafBounds).GetPerimeter();
+
+        // Cost of creating a new parent for this node and the new leaf
+        float cost = 2.0f * combinedArea;
+        // Minimum cost of pushing the leaf further down the tree
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto childCost = [&](int child) {
+            float newArea = CullingBounds::Combine(leafBounds, nodes[child].bounds).GetPerimeter();
+            if (nodes[child].IsLeaf())
+                return newArea + inheritanceCost;
+            return newArea - nodes[child].bounds.GetPerimeter() + inheritanceCost;
+        };
+        float cost1 = childCost(child1);
+        float cost2 = childCost(child2);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+
+        index = cost1 < cost2 ? child1 : child2;
+    }
+
+    int sibling = index;
+    int oldParent = nodes[sibling].parent;
+    int newParent = AllocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].bounds = CullingBounds::Combine(leafBounds, nodes[sibling].bounds);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent == -1)
+        root = newParent;
+    else if (nodes[oldParent].child1 == sibling)
+        nodes[oldParent].child1 = newParent;
+    else
+        nodes[oldParent].child2 = newParent;
+
+    RefitAncestors(nodes[leaf].parent);
+}
+
+void CullingTree::RemoveLeaf(int leaf)
+{
+    if (leaf == root)
+    {
+        root = -1;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent == -1)
+    {
+        root = sibling;
+        nodes[sibling].parent = -1;
+        FreeNode(parent);
+        return;
+    }
+
+    // Replace the parent with the sibling
+    if (nodes[grandParent].child1 == parent)
+        nodes[grandParent].child1 = sibling;
+    else
+        nodes[grandParent].child2 = sibling;
+    nodes[sibling].parent = grandParent;
+    FreeNode(parent);
+
+    RefitAncestors(grandParent);
+}
+
+void CullingTree::RefitAncestors(int node)
+{
+    while (node != -1)
+    {
+        node = Balance(node);
+
+        int child1 = nodes[node].child1;
+        int child2 = nodes[node].child2;
+        nodes[node].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[node].bounds = CullingBounds::Combine(nodes[child1].bounds, nodes[child2].bounds);
+
+        node = nodes[node].parent;
+    }
+}
+
+// Rotates the node's taller child up if the node is unbalanced. Returns the node now at its position.
+int CullingTree::Balance(int a)
+{
+    Node& nodeA = nodes[a];
+    if (nodeA.IsLeaf() || nodeA.height < 2)
+        return a;
+
+    int b = nodeA.child1;
+    int c = nodeA.child2;
+    int balance = nodes[c].height - nodes[b].height;
+    if (std::abs(balance) <= 1)
+        return a;
+
+    // Rotate the taller child up, moving its shorter child down to a
+    int up = balance > 1 ? c : b;
+    int other = up == c ? b : c;
+    int f = nodes[up].child1;
+    int g = nodes[up].child2;
+
+    // Swap a and up
+    nodes[up].child1 = a;
+    nodes[up].parent = nodes[a].parent;
+    nodes[a].parent = up;
+
+    if (nodes[up].parent == -1)
+        root = up;
+    else if (nodes[nodes[up].parent].child1 == a)
+        nodes[nodes[up].parent].child1 = up;
+    else
+        nodes[nodes[up].parent].child2 = up;
+
+    // The taller grandchild stays under up, the shorter one replaces up under a
+    int stay = nodes[f].height > nodes[g].height ? f : g;
+    int move = stay == f ? g : f;
+    nodes[up].child2 = stay;
+    if (up == c)
+        nodes[a].child2 = move;
+    else
+        nodes[a].child1 = move;
+    nodes[move].parent = a;
+
+    nodes[a].bounds = CullingBounds::Combine(nodes[other].bounds, nodes[move].bounds);
+    nodes[a].height = 1 + std::max(nodes[other].height, nodes[move].height);
+    nodes[up].bounds = CullingBounds::Combine(nodes[a].bounds, nodes[stay].bounds);
+    nodes[up].height = 1 + std::max(nodes[a].height, nodes[stay].height);
+
+    return up;
+}
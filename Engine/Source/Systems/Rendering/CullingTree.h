@@ -0,0 +1,126 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// Axis aligned bounds in world space
+struct CullingBounds
+{
+    float min[3] = { 0, 0, 0 };
+    float max[3] = { 0, 0, 0 };
+
+    bool Contains(const CullingBounds& other) const;
+    float GetPerimeter() const;
+    static CullingBounds Combine(const CullingBounds& a, const CullingBounds& b);
+};
+
+// Six planes, pointing inwards
+struct CullingFrustum
+{
+    float planes[6][4] = {};
+
+    // Extracts the planes from a view projection matrix. The matrix is column major (OpenGL/raylib layout) with a clip space depth of -w to w.
+    static CullingFrustum FromMatrix(const float matrix[16]);
+
+    bool Intersects(const CullingBounds& bounds) const;
+    bool Contains(const CullingBounds& bounds) const;
+};
+
+// Dynamic AABB tree used to cull renderables against a frustum. Leaves store enlarged (fat) bounds so small movements don't need the tree
+// to be updated. This has no dependency on raylib or the scene, so it can be used and tested on its own.
+class CullingTree
+{
+public:
+    // Returns the proxy ID. IDs are reused once destroyed.
+    int CreateProxy(const CullingBounds& bounds);
+    void DestroyProxy(int proxy);
+    // Returns true if the proxy had to be re-inserted
+    bool MoveProxy(int proxy, const CullingBounds& bounds);
+    const CullingBounds& GetFatBounds(int proxy) const;
+
+    // Calls the callback with every proxy whose fat bounds are inside or intersecting the frustum
+    template <typename Callback>
+    void Query(const CullingFrustum& frustum, Callback&& callback) const;
+
+    int GetProxyCount() const;
+    int GetHeight() const;
+    void Clear();
+
+    float margin = 0.1f; // How much the bounds are enlarged by in each direction
+
+private:
+    struct Node
+    {
+        CullingBounds bounds;
+        int parent = -1; // Next free node while in the free list
+        int child1 = -1;
+        int child2 = -1;
+        int height = 0; // 0 for leaves, -1 for free nodes
+
+        bool IsLeaf() const { return child1 == -1; }
+    };
+
+    int AllocateNode();
+    void FreeNode(int node);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    int Balance(int node);
+    void RefitAncestors(int node);
+    template <typename Callback>
+    void AddLeaves(int node, Callback& callback, std::vector<int>& stack) const;
+
+    std::vector<Node> nodes;
+    int root = -1;
+    int freeList = -1;
+    int proxyCount = 0;
+    mutable std::vector<int> queryStack;
+};
+
+template <typename Callback>
+void CullingTree::Query(const CullingFrustum& frustum, Callback&& callback) const
+{
+    if (root == -1)
+        return;
+
+    std::vector<int>& stack = queryStack;
+    stack.clear();
+    stack.push_back(root);
+    while (!stack.empty())
+    {
+        int nodeId = stack.back();
+        stack.pop_back();
+        const Node& node = nodes[nodeId];
+
+        if (!frustum.Intersects(node.bounds))
+            continue;
+
+        if (node.IsLeaf())
+            callback(nodeId);
+        else if (frustum.Contains(node.bounds)) // Everything below is visible, so the planes don't need to be tested again
+            AddLeaves(nodeId, callback, stack);
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+template <typename Callback>
+void CullingTree::AddLeaves(int node, Callback& callback, std::vector<int>& stack) const
+{
+    std::size_t base = stack.size();
+    stack.push_back(node);
+    while (stack.size() > base)
+    {
+        int nodeId = stack.back();
+        stack.pop_back();
+        if (nodes[nodeId].IsLeaf())
+            callback(nodeId);
+        else
+        {
+            stack.push_back(nodes[nodeId].child1);
+            stack.push_back(nodes[nodeId].child2);
+        }
+    }
+}
@@ -0,0 +1,325 @@
+#include "HeightfieldRaycaster.h"
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <thread>
+
+static const int minRaysPerThread = 256; // Fewer than this isn't worth starting a thread for
+static const float boundsPadding = 0.0001f; // Keeps rays grazing a cell's bounds from missing triangles on its edge
+
+static bool IntersectBounds(const float origin[3], const float direction[3], const float min[3], const float max[3], float maxDistance, float& nearDistance)
+{
+    float nearest = 0.0f;
+    float farthest = maxDistance;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (std::abs(direction[axis]) < 1e-12f)
+        {
+            if (origin[axis] < min[axis] || origin[axis] > max[axis])
+                return false;
+            continue;
+        }
+
+        float inverse = 1.0f / direction[axis];
+        float t0 = (min[axis] - origin[axis]) * inverse;
+        float t1 = (max[axis] - origin[axis]) * inverse;
+        if (t0 > t1)
+            std::swap(t0, t1);
+
+        nearest = std::max(nearest, t0);
+        farthest = std::min(farthest, t1);
+        if (nearest > farthest)
+            return false;
+    }
+
+    nearDistance = nearest;
+    return true;
+}
+
+static bool IntersectTriangle(const float origin[3], const float direction[3], const float a[3], const float b[3], const float c[3], float& distance, float normal[3])
+{
+    // Barycentric coordinates can be slightly outside the triangle so rays through a shared edge don't slip between both triangles
+    const float tolerance = 0.00001f;
+
+    float edge1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    float edge2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    float p[3] = {
+        direction[1] * edge2[2] - direction[2] * edge2[1],
+        direction[2] * edge2[0] - direction[0] * edge2[2],
+        direction[0] * edge2[1] - direction[1] * edge2[0]
+    };
+    float determinant = edge1[0] * p[0] + edge1[1] * p[1] + edge1[2] * p[2];
+    if (std::abs(determinant) < 1e-12f)
+        return false;
+
+    float inverse = 1.0f / determinant;
+    float s[3] = { origin[0] - a[0], origin[1] - a[1], origin[2] - a[2] };
+    float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse;
+    if (u < -tolerance || u > 1.0f + tolerance)
+        return false;
+
+    float q[3] = {
+        s[1] * edge1[2] - s[2] * edge1[1],
+        s[2] * edge1[0] - s[0] * edge1[2],
+        s[0] * edge1[1] - s[1] * edge1[0]
+    };
+    float v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * inverse;
+    if (v < -tolerance || u + v > 1.0f + tolerance)
+        return false;
+
+    distance = (edge2[0] * q[0] + edge2[1] * q[1] + edge2[2] * q[2]) * inverse;
+    if (distance < 0.0f)
+        return false;
+
+    // Both of a cell's triangles are wound so this points up
+    normal[0] = edge1[1] * edge2[2] - edge1[2] * edge2[1];
+    normal[1] = edge1[2] * edge2[0] - edge1[0] * edge2[2];
+    normal[2] = edge1[0] * edge2[1] - edge1[1] * edge2[0];
+    float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    for (int axis = 0; axis < 3; axis++)
+        normal[axis] /= length;
+    return true;
+}
+
+void HeightfieldRaycaster::Build(const float* heights, int width, int depth)
+{
+    Clear();
+
+    if (!heights || width < 2 || depth < 2)
+        return;
+
+    this->heights = heights;
+    this->width = width;
+    this->depth = depth;
+
+    Level level;
+    level.width = width - 1;
+    level.depth = depth - 1;
+    while (true)
+    {
+        level.minHeights.resize(static_cast<size_t>(level.width) * level.depth);
+        level.maxHeights.resize(static_cast<size_t>(level.width) * level.depth);
+        levels.push_back(level);
+        if (level.width == 1 && level.depth == 1)
+            break;
+
+        level.width = (level.width + 1) / 2;
+        level.depth = (level.depth + 1) / 2;
+    }
+
+    UpdateCells(0, 0, levels[0].width - 1, levels[0].depth - 1);
+}
+
+void HeightfieldRaycaster::UpdateRegion(int minX, int minZ, int maxX, int maxZ)
+{
+    if (levels.empty())
+        return;
+
+    // A sample is a corner of the cells before and after it
+    int minCellX = std::max(minX - 1, 0);
+    int minCellZ = std::max(minZ - 1, 0);
+    int maxCellX = std::min(maxX, levels[0].width - 1);
+    int maxCellZ = std::min(maxZ, levels[0].depth - 1);
+    if (minCellX > maxCellX || minCellZ > maxCellZ)
+        return;
+
+    UpdateCells(minCellX, minCellZ, maxCellX, maxCellZ);
+}
+
+void HeightfieldRaycaster::Clear()
+{
+    levels.clear();
+    heights = nullptr;
+    width = 0;
+    depth = 0;
+}
+
+void HeightfieldRaycaster::UpdateCells(int minCellX, int minCellZ, int maxCellX, int maxCellZ)
+{
+    Level& base = levels[0];
+    for (int z = minCellZ; z <= maxCellZ; z++)
+    {
+        const float* row = heights + static_cast<size_t>(z) * width;
+        const float* nextRow = row + width;
+        for (int x = minCellX; x <= maxCellX; x++)
+        {
+            size_t cell = static_cast<size_t>(z) * base.width + x;
+            base.minHeights[cell] = std::min({ row[x], row[x + 1], nextRow[x], nextRow[x + 1] });
+            base.maxHeights[cell] = std::max({ row[x], row[x + 1], nextRow[x], nextRow[x + 1] });
+        }
+    }
+
+    for (size_t i = 1; i < levels.size(); i++)
+    {
+        const Level& below = levels[i - 1];
+        Level& level = levels[i];
+        minCellX /= 2;
+        minCellZ /= 2;
+        maxCellX /= 2;
+        maxCellZ /= 2;
+
+        for (int z = minCellZ; z <= maxCellZ; z++)
+        {
+            for (int x = minCellX; x <= maxCellX; x++)
+            {
+                float minHeight = INFINITY;
+                float maxHeight = -INFINITY;
+                for (int childZ = z * 2; childZ < std::min(z * 2 + 2, below.depth); childZ++)
+                {
+                    for (int childX = x * 2; childX < std::min(x * 2 + 2, below.width); childX++)
+                    {
+                        size_t child = static_cast<size_t>(childZ) * below.width + childX;
+                        minHeight = std::min(minHeight, below.minHeights[child]);
+                        maxHeight = std::max(maxHeight, below.maxHeights[child]);
+                    }
+                }
+
+                size_t cell = static_cast<size_t>(z) * level.width + x;
+                level.minHeights[cell] = minHeight;
+                level.maxHeights[cell] = maxHeight;
+            }
+        }
+    }
+}
+
+bool HeightfieldRaycaster::IntersectCell(int cellX, int cellZ, const float origin[3], const float direction[3], float maxDistance, float& distance, float normal[3]) const
+{
+    const float* row = heights + static_cast<size_t>(cellZ) * width;
+    const float* nextRow = row + width;
+    float x0 = static_cast<float>(cellX);
+    float z0 = static_cast<float>(cellZ);
+    float topLeft[3] = { x0, row[cellX], z0 };
+    float topRight[3] = { x0 + 1.0f, row[cellX + 1], z0 };
+    float bottomLeft[3] = { x0, nextRow[cellX], z0 + 1.0f };
+    float bottomRight[3] = { x0 + 1.0f, nextRow[cellX + 1], z0 + 1.0f };
+
+    // Same triangles as TerrainLOD::BuildIndices()
+    bool found = false;
+    float triangleDistance;
+    float triangleNormal[3];
+    if (IntersectTriangle(origin, direction, topLeft, bottomLeft, topRight, triangleDistance, triangleNormal) && triangleDistance <= maxDistance)
+    {
+        maxDistance = triangleDistance;
+        distance = triangleDistance;
+        std::copy(triangleNormal, triangleNormal + 3, normal);
+        found = true;
+    }
+    if (IntersectTriangle(origin, direction, topRight, bottomLeft, bottomRight, triangleDistance, triangleNormal) && triangleDistance <= maxDistance)
+    {
+        distance = triangleDistance;
+        std::copy(triangleNormal, triangleNormal + 3, normal);
+        found = true;
+    }
+    return found;
+}
+
+bool HeightfieldRaycaster::Raycast(const HeightfieldRay& ray, HeightfieldHit& hit) const
+{
+    hit = HeightfieldHit();
+    if (levels.empty())
+        return false;
+
+    float length = std::sqrt(ray.direction[0] * ray.direction[0] + ray.direction[1] * ray.direction[1] + ray.direction[2] * ray.direction[2]);
+    if (length <= 0.0f || ray.maxDistance <= 0.0f)
+        return false;
+
+    float direction[3] = { ray.direction[0] / length, ray.direction[1] / length, ray.direction[2] / length };
+
+    // Children are pushed farthest first so the nearest is searched first, and anything past the closest hit is skipped
+    int flipX = direction[0] < 0.0f ? 1 : 0;
+    int flipZ = direction[2] < 0.0f ? 1 : 0;
+
+    struct Node
+    {
+        int level;
+        int x;
+        int z;
+    };
+    Node stack[4 * 32]; // Each level leaves at most 3 siblings behind
+    int stackSize = 0;
+    stack[stackSize++] = { static_cast<int>(levels.size()) - 1, 0, 0 };
+
+    float closest = ray.maxDistance;
+    while (stackSize > 0)
+    {
+        Node node = stack[--stackSize];
+        const Level& level = levels[node.level];
+        size_t cell = static_cast<size_t>(node.z) * level.width + node.x;
+
+        int size = 1 << node.level;
+        float min[3] = {
+            static_cast<float>(node.x * size) - boundsPadding,
+            level.minHeights[cell] - boundsPadding,
+            static_cast<float>(node.z * size) - boundsPadding
+        };
+        float max[3] = {
+            static_cast<float>(std::min((node.x + 1) * size, width - 1)) + boundsPadding,
+            level.maxHeights[cell] + boundsPadding,
+            static_cast<float>(std::min((node.z + 1) * size, depth - 1)) + boundsPadding
+        };
+
+        float nearDistance;
+        if (!IntersectBounds(ray.origin, direction, min, max, closest, nearDistance))
+            continue;
+
+        if (node.level == 0)
+        {
+            float distance;
+            if (IntersectCell(node.x, node.z, ray.origin, direction, closest, distance, hit.normal))
+            {
+                closest = distance;
+                hit.hit = true;
+            }
+            continue;
+        }
+
+        const Level& children = levels[node.level - 1];
+        for (int i = 3; i >= 0; i--)
+        {
+            int childX = node.x * 2 + ((i & 1) ^ flipX);
+            int childZ = node.z * 2 + (((i >> 1) & 1) ^ flipZ);
+            if (childX < children.width && childZ < children.depth)
+                stack[stackSize++] = { node.level - 1, childX, childZ };
+        }
+    }
+
+    if (!hit.hit)
+        return false;
+
+    hit.distance = closest;
+    for (int axis = 0; axis < 3; axis++)
+        hit.position[axis] = ray.origin[axis] + direction[axis] * closest;
+    return true;
+}
+
+void HeightfieldRaycaster::RaycastBatch(const HeightfieldRay* rays, HeightfieldHit* hits, int count, int threadCount) const
+{
+    if (count <= 0)
+        return;
+
+    if (threadCount <= 0)
+        threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    threadCount = std::min(threadCount, (count + minRaysPerThread - 1) / minRaysPerThread);
+
+    auto raycastRange = [this, rays, hits](int first, int last)
+    {
+        for (int i = first; i < last; i++)
+            Raycast(rays[i], hits[i]);
+    };
+
+    if (threadCount <= 1)
+    {
+        raycastRange(0, count);
+        return;
+    }
+
+    // The calling thread takes the last slice instead of waiting idle
+    int sliceSize = (count + threadCount - 1) / threadCount;
+    std::vector<std::future<void>> slices;
+    for (int first = 0; first + sliceSize < count; first += sliceSize)
+        slices.push_back(std::async(std::launch::async, raycastRange, first, first + sliceSize));
+
+    raycastRange(static_cast<int>(slices.size()) * sliceSize, count);
+    for (std::future<void>& slice : slices)
+        slice.get();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+struct HeightfieldRay
+{
+    float origin[3] = { 0, 0, 0 }; // Relative to the heightfield's first sample
+    float direction[3] = { 0, -1, 0 }; // Doesn't need to be normalized
+    float maxDistance = 1000.0f;
+};
+
+struct HeightfieldHit
+{
+    bool hit = false;
+    float distance = 0.0f; // Along the normalized direction
+    float position[3] = { 0, 0, 0 };
+    float normal[3] = { 0, 1, 0 };
+};
+
+// Exact raycasts against a heightfield's triangles, the same ones TerrainLOD draws at full resolution.
+// A pyramid of the min and max height of each cell skips empty space: the ray only descends into cells whose bounds it passes through,
+// nearest first, so the first triangle hit ends the search.
+// This has no dependency on raylib, so it can be tested against a brute force search on its own.
+class HeightfieldRaycaster
+{
+public:
+    // Heights are row-major, width * depth. They aren't copied, so they must stay valid until the next Build() or Clear().
+    void Build(const float* heights, int width, int depth);
+    // Updates the cells around the changed samples, inclusive
+    void UpdateRegion(int minX, int minZ, int maxX, int maxZ);
+    void Clear();
+
+    bool Raycast(const HeightfieldRay& ray, HeightfieldHit& hit) const;
+    // Splits the rays across threads. threadCount 0 uses every hardware thread.
+    void RaycastBatch(const HeightfieldRay* rays, HeightfieldHit* hits, int count, int threadCount = 0) const;
+
+    bool IsBuilt() const { return !levels.empty(); }
+
+private:
+    struct Level
+    {
+        int width = 0; // In cells
+        int depth = 0;
+        std::vector<float> minHeights;
+        std::vector<float> maxHeights;
+    };
+
+    void UpdateCells(int minCellX, int minCellZ, int maxCellX, int maxCellZ);
+    bool IntersectCell(int cellX, int cellZ, const float origin[3], const float direction[3], float maxDistance, float& distance, float normal[3]) const;
+
+    std::vector<Level> levels; // Level 0 has a cell between every 4 samples, each level above merges 2x2 cells
+    const float* heights = nullptr;
+    int width = 0;
+    int depth = 0;
+};
@@ -0,0 +1,288 @@
+#include "ImpostorBaker.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static const float pi = 3.14159265358979f;
+
+static void GetVertex(const ImpostorSource& source, unsigned int index, const float*& position, const float*& normal, const float*& texcoord)
+{
+    position = &source.positions[index * 3];
+    normal = source.normals.size() >= (index + 1) * 3 ? &source.normals[index * 3] : nullptr;
+    texcoord = source.texcoords.size() >= (index + 1) * 2 ? &source.texcoords[index * 2] : nullptr;
+}
+
+static void SampleTexture(const ImpostorSource& source, float u, float v, float color[4])
+{
+    for (int i = 0; i < 4; i++)
+        color[i] = source.color[i] / 255.0f;
+
+    if (source.texture.empty() || source.textureWidth <= 0 || source.textureHeight <= 0)
+        return;
+
+    // Nearest sample with wrapping
+    u -= std::floor(u);
+    v -= std::floor(v);
+    int x = std::min(static_cast<int>(u * source.textureWidth), source.textureWidth - 1);
+    int y = std::min(static_cast<int>(v * source.textureHeight), source.textureHeight - 1);
+    const uint8_t* texel = &source.texture[(static_cast<size_t>(y) * source.textureWidth + x) * 4];
+    for (int i = 0; i < 4; i++)
+        color[i] *= texel[i] / 255.0f;
+}
+
+// Spreads the color of opaque pixels into the transparent ones around them, so filtering doesn't blend in black at the edges
+static void DilateColors(ImpostorAtlas& atlas, int passes)
+{
+    std::vector<uint8_t> filled(static_cast<size_t>(atlas.width) * atlas.height);
+    for (size_t i = 0; i < filled.size(); i++)
+        filled[i] = atlas.pixels[i * 4 + 3] > 0;
+
+    std::vector<uint8_t> nextFilled = filled;
+    for (int pass = 0; pass < passes; pass++)
+    {
+        for (int y = 0; y < atlas.height; y++)
+        {
+            for (int x = 0; x < atlas.width; x++)
+            {
+                size_t index = static_cast<size_t>(y) * atlas.width + x;
+                if (filled[index])
+                    continue;
+
+                int sum[3] = { 0, 0, 0 };
+                int count = 0;
+                for (int offsetY = -1; offsetY <= 1; offsetY++)
+                {
+                    for (int offsetX = -1; offsetX <= 1; offsetX++)
+                    {
+                        int neighborX = x + offsetX;
+                        int neighborY = y + offsetY;
+                        if (neighborX < 0 || neighborY < 0 || neighborX >= atlas.width || neighborY >= atlas.height)
+                            continue;
+
+                        size_t neighbor = static_cast<size_t>(neighborY) * atlas.width + neighborX;
+                        if (!filled[neighbor])
+                            continue;
+
+                        for (int i = 0; i < 3; i++)
+                            sum[i] += atlas.pixels[neighbor * 4 + i];
+                        count++;
+                    }
+                }
+
+                if (count == 0)
+                    continue;
+
+                for (int i = 0; i < 3; i++)
+                    atlas.pixels[index * 4 + i] = static_cast<uint8_t>(sum[i] / count);
+                nextFilled[index] = 1;
+            }
+        }
+        filled = nextFilled;
+    }
+}
+
+bool ImpostorBaker::Bake(const std::vector<ImpostorSource>& sources, ImpostorAtlas& atlas, int frameCount, int frameSize)
+{
+    frameCount = std::max(frameCount, 1);
+    frameSize = std::max(frameSize, 1);
+
+    // Bounds of every vertex
+    float min[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+    float max[3] = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+    bool hasTriangles = false;
+    for (const ImpostorSource& source : sources)
+    {
+        size_t vertexCount = source.positions.size() / 3;
+        if ((source.indices.empty() ? vertexCount : source.indices.size()) >= 3)
+            hasTriangles = true;
+
+        for (size_t i = 0; i < vertexCount; i++)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                min[axis] = std::min(min[axis], source.positions[i * 3 + axis]);
+                max[axis] = std::max(max[axis], source.positions[i * 3 + axis]);
+            }
+        }
+    }
+
+    if (!hasTriangles)
+        return false;
+
+    atlas.center[0] = (min[0] + max[0]) * 0.5f;
+    atlas.center[1] = (min[1] + max[1]) * 0.5f;
+    atlas.center[2] = (min[2] + max[2]) * 0.5f;
+
+    // The quad has to fit the mesh from every angle, so its width is the diameter of the cylinder around the up axis
+    float radius = 0.0f;
+    for (const ImpostorSource& source : sources)
+    {
+        for (size_t i = 0; i + 2 < source.positions.size(); i += 3)
+        {
+            float x = source.positions[i] - atlas.center[0];
+            float z = source.positions[i + 2] - atlas.center[2];
+            radius = std::max(radius, std::sqrt(x * x + z * z));
+        }
+    }
+    atlas.quadSize = std::max(std::max(radius * 2.0f, max[1] - min[1]), 0.0001f) * 1.02f; // A little padding so the edges aren't clipped
+
+    atlas.frameCount = frameCount;
+    atlas.frameSize = frameSize;
+    atlas.columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(frameCount))));
+    atlas.rows = (frameCount + atlas.columns - 1) / atlas.columns;
+    atlas.width = atlas.columns * frameSize;
+    atlas.height = atlas.rows * frameSize;
+    atlas.pixels.assign(static_cast<size_t>(atlas.width) * atlas.height * 4, 0);
+
+    float light[3] = { 0.4f, 0.8f, 0.45f };
+    float lightLength = std::sqrt(light[0] * light[0] + light[1] * light[1] + light[2] * light[2]);
+    for (float& value : light)
+        value /= lightLength;
+
+    std::vector<float> depthBuffer(static_cast<size_t>(frameSize) * frameSize);
+    std::vector<float> screen; // x, y, depth per vertex
+
+    for (int frame = 0; frame < frameCount; frame++)
+    {
+        float angle = 2.0f * pi * frame / frameCount;
+        float view[3] = { std::sin(angle), 0.0f, std::cos(angle) }; // Towards the viewer
+        float right[3] = { std::cos(angle), 0.0f, -std::sin(angle) };
+        int frameX = (frame % atlas.columns) * frameSize;
+        int frameY = (frame / atlas.columns) * frameSize;
+
+        std::fill(depthBuffer.begin(), depthBuffer.end(), -std::numeric_limits<float>::max());
+
+        for (const ImpostorSource& source : sources)
+        {
+            size_t vertexCount = source.positions.size() / 3;
+            screen.resize(vertexCount * 3);
+            for (size_t i = 0; i < vertexCount; i++)
+            {
+                float x = source.positions[i * 3] - atlas.center[0];
+                float y = source.positions[i * 3 + 1] - atlas.center[1];
+                float z = source.positions[i * 3 + 2] - atlas.center[2];
+                screen[i * 3] = ((x * right[0] + z * right[2]) / atlas.quadSize + 0.5f) * frameSize;
+                screen[i * 3 + 1] = (0.5f - y / atlas.quadSize) * frameSize;
+                screen[i * 3 + 2] = x * view[0] + z * view[2];
+            }
+
+            size_t triangleVertices = source.indices.empty() ? vertexCount - vertexCount % 3 : source.indices.size() - source.indices.size() % 3;
+            for (size_t t = 0; t < triangleVertices; t += 3)
+            {
+                unsigned int indices[3];
+                bool valid = true;
+                for (int i = 0; i < 3; i++)
+                {
+                    indices[i] = source.indices.empty() ? static_cast<unsigned int>(t + i) : source.indices[t + i];
+                    if (indices[i] >= vertexCount)
+                        valid = false;
+                }
+                if (!valid)
+                    continue;
+
+                const float* a = &screen[indices[0] * 3];
+                const float* b = &screen[indices[1] * 3];
+                const float* c = &screen[indices[2] * 3];
+                float area = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+                if (std::abs(area) < 1e-8f)
+                    continue;
+
+                const float* positions[3];
+                const float* normals[3];
+                const float* texcoords[3];
+                for (int i = 0; i < 3; i++)
+                    GetVertex(source, indices[i], positions[i], normals[i], texcoords[i]);
+
+                // Face normal for meshes without normals
+                float faceNormal[3];
+                {
+                    float edge1[3] = { positions[1][0] - positions[0][0], positions[1][1] - positions[0][1], positions[1][2] - positions[0][2] };
+                    float edge2[3] = { positions[2][0] - positions[0][0], positions[2][1] - positions[0][1], positions[2][2] - positions[0][2] };
+                    faceNormal[0] = edge1[1] * edge2[2] - edge1[2] * edge2[1];
+                    faceNormal[1] = edge1[2] * edge2[0] - edge1[0] * edge2[2];
+                    faceNormal[2] = edge1[0] * edge2[1] - edge1[1] * edge2[0];
+                }
+
+                int minX = std::max(static_cast<int>(std::floor(std::min({ a[0], b[0], c[0] }))), 0);
+                int maxX = std::min(static_cast<int>(std::ceil(std::max({ a[0], b[0], c[0] }))), frameSize - 1);
+                int minY = std::max(static_cast<int>(std::floor(std::min({ a[1], b[1], c[1] }))), 0);
+                int maxY = std::min(static_cast<int>(std::ceil(std::max({ a[1], b[1], c[1] }))), frameSize - 1);
+
+                for (int y = minY; y <= maxY; y++)
+                {
+                    for (int x = minX; x <= maxX; x++)
+                    {
+                        // Barycentric weights at the pixel center. Triangles are drawn from both sides.
+                        float pixelX = x + 0.5f;
+                        float pixelY = y + 0.5f;
+                        float weightA = ((b[0] - pixelX) * (c[1] - pixelY) - (b[1] - pixelY) * (c[0] - pixelX)) / area;
+                        float weightB = ((c[0] - pixelX) * (a[1] - pixelY) - (c[1] - pixelY) * (a[0] - pixelX)) / area;
+                        float weightC = 1.0f - weightA - weightB;
+                        if (weightA < 0.0f || weightB < 0.0f || weightC < 0.0f)
+                            continue;
+
+                        float depth = weightA * a[2] + weightB * b[2] + weightC * c[2];
+                        float& storedDepth = depthBuffer[static_cast<size_t>(y) * frameSize + x];
+                        if (depth <= storedDepth)
+                            continue;
+
+                        float weights[3] = { weightA, weightB, weightC };
+                        float u = 0.0f, v = 0.0f;
+                        if (texcoords[0] && texcoords[1] && texcoords[2])
+                        {
+                            for (int i = 0; i < 3; i++)
+                            {
+                                u += weights[i] * texcoords[i][0];
+                                v += weights[i] * texcoords[i][1];
+                            }
+                        }
+
+                        float color[4];
+                        SampleTexture(source, u, v, color);
+                        if (color[3] < 0.5f)
+                            continue;
+
+                        float normal[3] = { faceNormal[0], faceNormal[1], faceNormal[2] };
+                        if (normals[0] && normals[1] && normals[2])
+                        {
+                            for (int axis = 0; axis < 3; axis++)
+                                normal[axis] = weights[0] * normals[0][axis] + weights[1] * normals[1][axis] + weights[2] * normals[2][axis];
+                        }
+                        float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                        float lighting = 1.0f;
+                        if (normalLength > 0.0f)
+                        {
+                            // Back faces are lit as if they faced the viewer
+                            float facing = normal[0] * view[0] + normal[2] * view[2];
+                            float sign = facing < 0.0f ? -1.0f : 1.0f;
+                            float diffuse = sign * (normal[0] * light[0] + normal[1] * light[1] + normal[2] * light[2]) / normalLength;
+                            lighting = 0.45f + 0.55f * std::max(diffuse, 0.0f);
+                        }
+
+                        storedDepth = depth;
+                        uint8_t* pixel = &atlas.pixels[(static_cast<size_t>(frameY + y) * atlas.width + frameX + x) * 4];
+                        for (int i = 0; i < 3; i++)
+                            pixel[i] = static_cast<uint8_t>(std::min(color[i] * lighting, 1.0f) * 255.0f);
+                        pixel[3] = 255;
+                    }
+                }
+            }
+        }
+    }
+
+    DilateColors(atlas, 4);
+    return true;
+}
+
+int ImpostorBaker::GetFrame(const ImpostorAtlas& atlas, float directionX, float directionZ)
+{
+    if (atlas.frameCount <= 1)
+        return 0;
+
+    float angle = std::atan2(directionX, directionZ);
+    if (angle < 0.0f)
+        angle += 2.0f * pi;
+
+    int frame = static_cast<int>(std::round(angle / (2.0f * pi) * atlas.frameCount));
+    return frame % atlas.frameCount;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+// Geometry and albedo of one mesh to bake into an impostor
+struct ImpostorSource
+{
+    std::vector<float> positions; // xyz per vertex
+    std::vector<float> normals; // xyz per vertex, optional
+    std::vector<float> texcoords; // uv per vertex, optional
+    std::vector<unsigned int> indices; // Every 3 vertices is a triangle if this is empty
+    std::vector<uint8_t> texture; // RGBA, optional
+    int textureWidth = 0;
+    int textureHeight = 0;
+    uint8_t color[4] = { 255, 255, 255, 255 };
+};
+
+// Views of a mesh from evenly spaced angles around its up axis, packed into one RGBA atlas.
+// Frame i is seen from the direction (sin(a), 0, cos(a)) in model space, where a = 2 * PI * i / frameCount.
+struct ImpostorAtlas
+{
+    std::vector<uint8_t> pixels;
+    int width = 0;
+    int height = 0;
+    int frameSize = 0; // Frames are square
+    int frameCount = 0;
+    int columns = 0;
+    int rows = 0;
+
+    // Model space center of the quad, and its width and height. Every frame covers the same area.
+    float center[3] = { 0, 0, 0 };
+    float quadSize = 0;
+};
+
+// Bakes impostor atlases on the CPU, so they can be built without a GPU
+class ImpostorBaker
+{
+public:
+    // Rasterizes the sources from each angle with a fixed light. Pixels with an alpha below 0.5 are treated as cutouts.
+    // Returns false if the sources have no triangles.
+    static bool Bake(const std::vector<ImpostorSource>& sources, ImpostorAtlas& atlas, int frameCount = 8, int frameSize = 128);
+
+    // Returns the frame closest to the model space direction from the model to the viewer
+    static int GetFrame(const ImpostorAtlas& atlas, float directionX, float directionZ);
+};
@@ -0,0 +1,113 @@
+#include "InstanceSpatialHash.h"
+#include <cmath>
+
+int InstanceSpatialHash::ToCell(float value) const
+{
+    return static_cast<int>(std::floor(value / cellSize));
+}
+
+uint64_t InstanceSpatialHash::GetKey(int cellX, int cellZ)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cellX)) << 32) | static_cast<uint32_t>(cellZ);
+}
+
+void InstanceSpatialHash::Clear()
+{
+    cells.clear();
+    count = 0;
+}
+
+void InstanceSpatialHash::Insert(int index, float x, float z)
+{
+    cells[GetKey(ToCell(x), ToCell(z))].push_back({ index, x, z });
+    count++;
+}
+
+void InstanceSpatialHash::Remove(int index, float x, float z)
+{
+    auto cell = cells.find(GetKey(ToCell(x), ToCell(z)));
+    if (cell == cells.end())
+        return;
+
+    std::vector<Entry>& entries = cell->second;
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (entries[i].index != index)
+            continue;
+
+        entries[i] = entries.back();
+        entries.pop_back();
+        count--;
+        if (entries.empty())
+            cells.erase(cell);
+        return;
+    }
+}
+
+void InstanceSpatialHash::Renumber(int oldIndex, int newIndex, float x, float z)
+{
+    auto cell = cells.find(GetKey(ToCell(x), ToCell(z)));
+    if (cell == cells.end())
+        return;
+
+    for (Entry& entry : cell->second)
+    {
+        if (entry.index == oldIndex)
+        {
+            entry.index = newIndex;
+            return;
+        }
+    }
+}
+
+template<typename Visit>
+bool InstanceSpatialHash::ForEachWithin(float x, float z, float radius, Visit&& visit) const
+{
+    float radiusSquared = radius * radius;
+    auto visitCell = [&](const std::vector<Entry>& entries)
+    {
+        for (const Entry& entry : entries)
+        {
+            float dx = entry.x - x;
+            float dz = entry.z - z;
+            if (dx * dx + dz * dz < radiusSquared && visit(entry.index))
+                return true;
+        }
+        return false;
+    };
+
+    int minCellX = ToCell(x - radius);
+    int minCellZ = ToCell(z - radius);
+    int maxCellX = ToCell(x + radius);
+    int maxCellZ = ToCell(z + radius);
+
+    // A radius covering more cells than are filled is faster to check by going through the filled ones
+    if (static_cast<double>(maxCellX - minCellX + 1) * (maxCellZ - minCellZ + 1) > static_cast<double>(cells.size()))
+    {
+        for (const auto& cell : cells)
+            if (visitCell(cell.second))
+                return true;
+        return false;
+    }
+
+    for (int cellZ = minCellZ; cellZ <= maxCellZ; cellZ++)
+    {
+        for (int cellX = minCellX; cellX <= maxCellX; cellX++)
+        {
+            auto cell = cells.find(GetKey(cellX, cellZ));
+            if (cell != cells.end() && visitCell(cell->second))
+                return true;
+        }
+    }
+    return false;
+}
+
+bool InstanceSpatialHash::AnyWithin(float x, float z, float radius) const
+{
+    return ForEachWithin(x, z, radius, [](int) { return true; });
+}
+
+void InstanceSpatialHash::QueryRadius(float x, float z, float radius, std::vector<int>& indices) const
+{
+    ForEachWithin(x, z, radius, [&indices](int index) { indices.push_back(index); return false; });
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Buckets instance indices by their XZ position so spacing, erase and paint checks only look at nearby instances instead of all of them.
+// Only the indices and positions are stored. The owner keeps it in sync as instances are added, removed or moved to another index.
+class InstanceSpatialHash
+{
+public:
+    explicit InstanceSpatialHash(float cellSize = 4.0f) : cellSize(cellSize) {}
+
+    void Clear();
+    void Insert(int index, float x, float z);
+    void Remove(int index, float x, float z);
+    // For swap-and-pop removal, where the last instance takes the removed one's index
+    void Renumber(int oldIndex, int newIndex, float x, float z);
+
+    bool AnyWithin(float x, float z, float radius) const;
+    // Appends the indices of the instances within the radius, in no particular order
+    void QueryRadius(float x, float z, float radius, std::vector<int>& indices) const;
+
+    int GetCount() const { return count; }
+
+private:
+    struct Entry
+    {
+        int index;
+        float x;
+        float z;
+    };
+
+    // Stops early when visit returns true
+    template<typename Visit>
+    bool ForEachWithin(float x, float z, float radius, Visit&& visit) const;
+    int ToCell(float value) const;
+    static uint64_t GetKey(int cellX, int cellZ);
+
+    std::unordered_map<uint64_t, std::vector<Entry>> cells;
+    float cellSize;
+    int count = 0;
+};
@@ -0,0 +1,361 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+
+static const int cacheSize = 32; // Close to the post-transform cache of most GPUs, and what the scores below were tuned for
+static const float lastTriangleScore = 0.75f; // The last triangle's vertices score lower, since they were just used with each other
+static const float cacheDecayPower = 1.5f;
+static const float valenceBoostScale = 2.0f; // Vertices with few triangles left are finished first, so they don't get stranded
+static const float valenceBoostPower = 0.5f;
+
+static float VertexScore(int cachePosition, unsigned int remainingTriangles)
+{
+    if (remainingTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        if (cachePosition < 3)
+            score = lastTriangleScore;
+        else
+            score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / (cacheSize - 3), cacheDecayPower);
+    }
+
+    return score + valenceBoostScale * std::pow(static_cast<float>(remainingTriangles), -valenceBoostPower);
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+        return;
+
+    // The triangles using each vertex. The first remainingTriangles[v] of a vertex's list are the ones not emitted yet.
+    std::vector<unsigned int> remainingTriangles(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        remainingTriangles[indices[i]]++;
+
+    std::vector<unsigned int> triangleOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        triangleOffsets[v + 1] = triangleOffsets[v] + remainingTriangles[v];
+
+    std::vector<unsigned int> vertexTriangles(triangleCount * 3);
+    std::vector<unsigned int> fillCounts(vertexCount, 0);
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            vertexTriangles[triangleOffsets[v] + fillCounts[v]++] = static_cast<unsigned int>(t);
+        }
+    }
+
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        vertexScores[v] = VertexScore(-1, remainingTriangles[v]);
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    int best = -1;
+    float bestScore = -1.0f;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+        if (triangleScores[t] > bestScore)
+        {
+            bestScore = triangleScores[t];
+            best = static_cast<int>(t);
+        }
+    }
+
+    // The cache holds 3 extra vertices while the new triangle's vertices push the oldest ones out
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> newCache;
+    cache.reserve(cacheSize + 3);
+    newCache.reserve(cacheSize + 3);
+
+    std::vector<unsigned int> output;
+    output.reserve(triangleCount * 3);
+    size_t scanCursor = 0;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        // Nothing in the cache has triangles left, so the order continues from the next triangle that hasn't been emitted
+        if (best < 0)
+        {
+            while (emitted[scanCursor])
+                scanCursor++;
+            best = static_cast<int>(scanCursor);
+        }
+
+        const unsigned int* triangle = &indices[best * 3];
+        emitted[best] = true;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = triangle[k];
+            output.push_back(v);
+
+            unsigned int* first = &vertexTriangles[triangleOffsets[v]];
+            unsigned int* last = first + remainingTriangles[v];
+            unsigned int* found = std::find(first, last, static_cast<unsigned int>(best));
+            if (found != last)
+            {
+                std::swap(*found, *(last - 1));
+                remainingTriangles[v]--;
+            }
+        }
+
+        newCache.clear();
+        for (int k = 0; k < 3; k++)
+            newCache.push_back(triangle[k]);
+        for (unsigned int v : cache)
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2] && newCache.size() < cacheSize + 3)
+                newCache.push_back(v);
+
+        for (unsigned int v : cache)
+            cachePositions[v] = -1;
+        for (size_t i = 0; i < newCache.size(); i++)
+            cachePositions[newCache[i]] = i < cacheSize ? static_cast<int>(i) : -1;
+
+        for (unsigned int v : newCache)
+            vertexScores[v] = VertexScore(cachePositions[v], remainingTriangles[v]);
+
+        // Only the triangles of vertices in the cache changed score, so the next one is picked from them
+        best = -1;
+        bestScore = -1.0f;
+        for (unsigned int v : newCache)
+        {
+            for (unsigned int i = 0; i < remainingTriangles[v]; i++)
+            {
+                unsigned int t = vertexTriangles[triangleOffsets[v] + i];
+                float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+                triangleScores[t] = score;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = static_cast<int>(t);
+                }
+            }
+        }
+
+        std::swap(cache, newCache);
+    }
+
+    output.insert(output.end(), indices.begin() + triangleCount * 3, indices.end());
+    indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int>& indices, const float* positions, size_t vertexCount)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2 || vertexCount == 0)
+        return;
+
+    // A triangle whose vertices all miss a FIFO cache starts a new cluster, since that's where the cache order jumped
+    std::vector<unsigned int> clusterStarts;
+    std::vector<unsigned int> missTimes(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        int misses = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            if (time - missTimes[v] > cacheSize)
+            {
+                missTimes[v] = time++;
+                misses++;
+            }
+        }
+        if (misses == 3 || t == 0)
+            clusterStarts.push_back(static_cast<unsigned int>(t));
+    }
+
+    if (clusterStarts.size() < 2)
+        return;
+
+    float meshCenter[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        for (int axis = 0; axis < 3; axis++)
+            meshCenter[axis] += positions[indices[i] * 3 + axis];
+    for (int axis = 0; axis < 3; axis++)
+        meshCenter[axis] /= static_cast<float>(triangleCount * 3);
+
+    // Clusters on the outside facing away from the center are the most likely to hide the rest, so they're sorted first
+    struct Cluster
+    {
+        unsigned int first;
+        unsigned int last;
+        float sortKey;
+    };
+    std::vector<Cluster> clusters;
+    clusters.reserve(clusterStarts.size());
+    for (size_t c = 0; c < clusterStarts.size(); c++)
+    {
+        Cluster cluster;
+        cluster.first = clusterStarts[c];
+        cluster.last = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : static_cast<unsigned int>(triangleCount);
+
+        float center[3] = { 0, 0, 0 };
+        float normal[3] = { 0, 0, 0 };
+        for (unsigned int t = cluster.first; t < cluster.last; t++)
+        {
+            const float* a = &positions[indices[t * 3] * 3];
+            const float* b = &positions[indices[t * 3 + 1] * 3];
+            const float* c2 = &positions[indices[t * 3 + 2] * 3];
+            float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            float ac[3] = { c2[0] - a[0], c2[1] - a[1], c2[2] - a[2] };
+            normal[0] += ab[1] * ac[2] - ab[2] * ac[1]; // Not normalized, so larger triangles count for more
+            normal[1] += ab[2] * ac[0] - ab[0] * ac[2];
+            normal[2] += ab[0] * ac[1] - ab[1] * ac[0];
+            for (int axis = 0; axis < 3; axis++)
+                center[axis] += (a[axis] + b[axis] + c2[axis]) / 3.0f;
+        }
+
+        float count = static_cast<float>(cluster.last - cluster.first);
+        float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        cluster.sortKey = 0.0f;
+        if (length > 0.0f)
+            for (int axis = 0; axis < 3; axis++)
+                cluster.sortKey += (center[axis] / count - meshCenter[axis]) * normal[axis] / length;
+        clusters.push_back(cluster);
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    for (const Cluster& cluster : clusters)
+        output.insert(output.end(), indices.begin() + cluster.first * 3, indices.begin() + cluster.last * 3);
+    output.insert(output.end(), indices.begin() + triangleCount * 3, indices.end());
+    indices.swap(output);
+}
+
+size_t MeshOptimizer::OptimizeVertexFetch(std::vector<unsigned int>& indices, size_t vertexCount, std::vector<int>& remap)
+{
+    remap.assign(vertexCount, -1);
+    size_t usedCount = 0;
+    for (unsigned int& index : indices)
+    {
+        if (remap[index] < 0)
+            remap[index] = static_cast<int>(usedCount++);
+        index = static_cast<unsigned int>(remap[index]);
+    }
+    return usedCount;
+}
+
+static int NormalDirection(const float* normal)
+{
+    // Which way the normal mostly points, as one of the 6 axis directions
+    float x = std::abs(normal[0]);
+    float y = std::abs(normal[1]);
+    float z = std::abs(normal[2]);
+    if (x >= y && x >= z)
+        return normal[0] < 0.0f ? 1 : 0;
+    if (y >= z)
+        return normal[1] < 0.0f ? 3 : 2;
+    return normal[2] < 0.0f ? 5 : 4;
+}
+
+void MeshOptimizer::SimplifyClustered(const std::vector<unsigned int>& indices, const float* positions, const float* normals, size_t vertexCount,
+    const float boundsMin[3], float cellSize, std::vector<unsigned int>& result)
+{
+    result.clear();
+    if (indices.size() < 3 || vertexCount == 0 || cellSize <= 0.0f)
+        return;
+
+    const unsigned int unused = 0xFFFFFFFF;
+    const int64_t maxCell = (1 << 20) - 1;
+    std::unordered_map<uint64_t, unsigned int> cellClusters;
+    std::vector<unsigned int> vertexClusters(vertexCount, unused);
+    std::vector<float> clusterSums;
+    std::vector<unsigned int> clusterCounts;
+
+    for (unsigned int v : indices)
+    {
+        if (vertexClusters[v] != unused)
+            continue;
+
+        uint64_t key = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            int64_t cell = static_cast<int64_t>(std::floor((positions[v * 3 + axis] - boundsMin[axis]) / cellSize));
+            key = (key << 20) | static_cast<uint64_t>(std::clamp<int64_t>(cell, 0, maxCell));
+        }
+        if (normals)
+            key = (key << 3) | static_cast<uint64_t>(NormalDirection(&normals[v * 3]));
+
+        auto [it, added] = cellClusters.emplace(key, static_cast<unsigned int>(clusterCounts.size()));
+        if (added)
+        {
+            clusterSums.insert(clusterSums.end(), { 0.0f, 0.0f, 0.0f });
+            clusterCounts.push_back(0);
+        }
+
+        unsigned int cluster = it->second;
+        vertexClusters[v] = cluster;
+        for (int axis = 0; axis < 3; axis++)
+            clusterSums[cluster * 3 + axis] += positions[v * 3 + axis];
+        clusterCounts[cluster]++;
+    }
+
+    // Each cluster becomes the vertex closest to its average position
+    std::vector<unsigned int> representatives(clusterCounts.size(), unused);
+    std::vector<float> representativeDistances(clusterCounts.size(), 0.0f);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        unsigned int cluster = vertexClusters[v];
+        if (cluster == unused)
+            continue;
+
+        float distance = 0.0f;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float difference = positions[v * 3 + axis] - clusterSums[cluster * 3 + axis] / clusterCounts[cluster];
+            distance += difference * difference;
+        }
+        if (representatives[cluster] == unused || distance < representativeDistances[cluster])
+        {
+            representatives[cluster] = static_cast<unsigned int>(v);
+            representativeDistances[cluster] = distance;
+        }
+    }
+
+    // Triangles are rotated to start at their lowest vertex, keeping the winding, so duplicates have the same key
+    std::unordered_set<uint64_t> addedTriangles;
+    bool removeDuplicates = vertexCount < (1u << 21);
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        unsigned int a = representatives[vertexClusters[indices[t]]];
+        unsigned int b = representatives[vertexClusters[indices[t + 1]]];
+        unsigned int c = representatives[vertexClusters[indices[t + 2]]];
+        if (a == b || b == c || a == c)
+            continue;
+
+        if (removeDuplicates)
+        {
+            if (b < a && b < c)
+            {
+                std::swap(a, b);
+                std::swap(b, c);
+            }
+            else if (c < a && c < b)
+            {
+                std::swap(a, c);
+                std::swap(b, c);
+            }
+            uint64_t key = (static_cast<uint64_t>(a) << 42) | (static_cast<uint64_t>(b) << 21) | c;
+            if (!addedTriangles.insert(key).second)
+                continue;
+        }
+
+        result.push_back(a);
+        result.push_back(b);
+        result.push_back(c);
+    }
+}
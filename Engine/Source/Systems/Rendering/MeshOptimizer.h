@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// Index and vertex order optimizations and simplification for cooking meshes. Everything runs on the CPU.
+// Positions are xyz per vertex and every 3 indices is a triangle.
+class MeshOptimizer
+{
+public:
+    // Reorders the triangles so their vertices are still in the GPU's post-transform cache when they're reused (Forsyth's algorithm)
+    static void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount);
+
+    // Sorts the runs of triangles OptimizeVertexCache() started from scratch so the ones facing out of the mesh are drawn first,
+    // which lets early depth testing reject more of what's behind them. Keeps the cache order inside each run, so it costs almost nothing in cache hits.
+    static void OptimizeOverdraw(std::vector<unsigned int>& indices, const float* positions, size_t vertexCount);
+
+    // Renumbers the vertices in the order the indices first use them, so vertex fetches walk through memory in order.
+    // remap[old vertex] is the vertex's new index, or -1 if no triangle uses it. Returns how many vertices are used.
+    static size_t OptimizeVertexFetch(std::vector<unsigned int>& indices, size_t vertexCount, std::vector<int>& remap);
+
+    // Merges the vertices in each cell of a grid with cellSize sized cells into the vertex closest to their average, and drops the triangles that collapse.
+    // The result only uses the original vertices, so it can share their vertex buffer. Vertices whose normals point different ways aren't merged, if normals are given.
+    static void SimplifyClustered(const std::vector<unsigned int>& indices, const float* positions, const float* normals, size_t vertexCount,
+        const float boundsMin[3], float cellSize, std::vector<unsigned int>& result);
+};
@@ -0,0 +1,155 @@
+#include "RenderCommandBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+void RenderCommandBuffer::ApplyMaterial(MeshRenderer* renderer, uint64_t sortKey)
+{
+    RenderCommand command;
+    command.type = RenderCommandType::ApplyMaterial;
+    command.sortKey = sortKey;
+    command.renderer = renderer;
+    commands.push_back(command);
+}
+
+void RenderCommandBuffer::DrawModel(RaylibModel* model, const ModelInstance& instance, uint64_t sortKey)
+{
+    RenderCommand command;
+    command.type = RenderCommandType::DrawModel;
+    command.sortKey = sortKey;
+    command.model = model;
+    command.instance = instance;
+    commands.push_back(command);
+}
+
+void RenderCommandBuffer::DrawModelInstanced(RaylibModel* model, const ModelInstance* instances, size_t count, uint64_t sortKey)
+{
+    RenderCommand command;
+    command.type = RenderCommandType::DrawModelInstanced;
+    command.sortKey = sortKey;
+    command.model = model;
+    command.firstInstance = static_cast<uint32_t>(this->instances.size());
+    command.instanceCount = static_cast<uint32_t>(count);
+    this->instances.insert(this->instances.end(), instances, instances + count);
+    commands.push_back(command);
+}
+
+void RenderCommandBuffer::SetShaderValue(unsigned int shaderId, int* shaderLocs, int location, const void* value, int uniformType, uint64_t sortKey)
+{
+    RenderCommand command;
+    command.type = RenderCommandType::SetShaderValue;
+    command.sortKey = sortKey;
+    command.shaderId = shaderId;
+    command.shaderLocs = shaderLocs;
+    command.location = location;
+    command.uniformType = uniformType;
+    std::memcpy(command.value, value, std::min(GetUniformSize(uniformType), sizeof(command.value)));
+    commands.push_back(command);
+}
+
+void RenderCommandBuffer::Replay(RenderCommandTarget& target) const
+{
+    for (const RenderCommand& command : commands)
+        target.Execute(command, *this);
+}
+
+void RenderCommandBuffer::Clear()
+{
+    commands.clear();
+    instances.clear();
+}
+
+const std::vector<RenderCommand>& RenderCommandBuffer::GetCommands() const
+{
+    return commands;
+}
+
+const std::vector<ModelInstance>& RenderCommandBuffer::GetInstances() const
+{
+    return instances;
+}
+
+size_t RenderCommandBuffer::GetUniformSize(int uniformType)
+{
+    switch (uniformType)
+    {
+    case RaylibWrapper::SHADER_UNIFORM_FLOAT: return sizeof(float);
+    case RaylibWrapper::SHADER_UNIFORM_VEC2: return sizeof(float) * 2;
+    case RaylibWrapper::SHADER_UNIFORM_VEC3: return sizeof(float) * 3;
+    case RaylibWrapper::SHADER_UNIFORM_VEC4: return sizeof(float) * 4;
+    case RaylibWrapper::SHADER_UNIFORM_INT:
+    case RaylibWrapper::SHADER_UNIFORM_SAMPLER2D: return sizeof(int);
+    case RaylibWrapper::SHADER_UNIFORM_IVEC2: return sizeof(int) * 2;
+    case RaylibWrapper::SHADER_UNIFORM_IVEC3: return sizeof(int) * 3;
+    case RaylibWrapper::SHADER_UNIFORM_IVEC4: return sizeof(int) * 4;
+    case RaylibWrapper::SHADER_UNIFORM_UINT: return sizeof(unsigned int);
+    case RaylibWrapper::SHADER_UNIFORM_UIVEC2: return sizeof(unsigned int) * 2;
+    case RaylibWrapper::SHADER_UNIFORM_UIVEC3: return sizeof(unsigned int) * 3;
+    case RaylibWrapper::SHADER_UNIFORM_UIVEC4: return sizeof(unsigned int) * 4;
+    default: return 0;
+    }
+}
+
+void NullCommandTarget::Execute(const RenderCommand& command, const RenderCommandBuffer& buffer)
+{
+    int type = static_cast<int>(command.type);
+    if (type < 0 || type >= static_cast<int>(RenderCommandType::Count))
+    {
+        errors.push_back("Unknown command type " + std::to_string(type));
+        return;
+    }
+    counts[type]++;
+
+    switch (command.type)
+    {
+    case RenderCommandType::ApplyMaterial:
+        if (!command.renderer)
+            errors.push_back("ApplyMaterial has no renderer");
+        break;
+    case RenderCommandType::DrawModel:
+        if (!command.model)
+            errors.push_back("DrawModel has no model");
+        drawnInstances++;
+        break;
+    case RenderCommandType::DrawModelInstanced:
+        if (!command.model)
+            errors.push_back("DrawModelInstanced has no model");
+        if (command.instanceCount == 0)
+            errors.push_back("DrawModelInstanced has no instances");
+        if (static_cast<size_t>(command.firstInstance) + command.instanceCount > buffer.GetInstances().size())
+            errors.push_back("DrawModelInstanced instances are outside of the buffer");
+        drawnInstances += command.instanceCount;
+        break;
+    case RenderCommandType::SetShaderValue:
+        if (command.shaderId == 0 || !command.shaderLocs)
+            errors.push_back("SetShaderValue has no shader");
+        if (command.location < 0)
+            errors.push_back("SetShaderValue has an invalid location");
+        if (RenderCommandBuffer::GetUniformSize(command.uniformType) == 0)
+            errors.push_back("SetShaderValue has an invalid uniform type " + std::to_string(command.uniformType));
+        break;
+    default:
+        break;
+    }
+}
+
+void NullCommandTarget::Reset()
+{
+    std::fill(std::begin(counts), std::end(counts), 0);
+    drawnInstances = 0;
+    errors.clear();
+}
+
+int NullCommandTarget::GetCount(RenderCommandType type) const
+{
+    return counts[static_cast<int>(type)];
+}
+
+int NullCommandTarget::GetDrawnInstanceCount() const
+{
+    return drawnInstances;
+}
+
+const std::vector<std::string>& NullCommandTarget::GetErrors() const
+{
+    return errors;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "Raylib/RaylibModelWrapper.h"
+
+class MeshRenderer;
+class RenderCommandBuffer;
+
+enum class RenderCommandType : uint8_t
+{
+    ApplyMaterial,
+    DrawModel,
+    DrawModelInstanced,
+    SetShaderValue,
+    Count
+};
+
+struct RenderCommand
+{
+    RenderCommandType type;
+    uint64_t sortKey = 0;
+
+    MeshRenderer* renderer = nullptr; // ApplyMaterial
+    RaylibModel* model = nullptr; // DrawModel, DrawModelInstanced
+    ModelInstance instance = {}; // DrawModel
+    uint32_t firstInstance = 0; // DrawModelInstanced, index into the buffer's instances
+    uint32_t instanceCount = 0;
+
+    // SetShaderValue
+    unsigned int shaderId = 0;
+    int* shaderLocs = nullptr;
+    int location = -1;
+    int uniformType = 0;
+    unsigned char value[64] = {};
+};
+
+// Executes the commands of a buffer when it's replayed
+class RenderCommandTarget
+{
+public:
+    virtual ~RenderCommandTarget() = default;
+    virtual void Execute(const RenderCommand& command, const RenderCommandBuffer& buffer) = 0;
+};
+
+// Records draws, material changes and uniform uploads so they can be produced on any thread and replayed later on the render thread.
+// A buffer must only be recorded to by one thread at a time.
+class RenderCommandBuffer
+{
+public:
+    void ApplyMaterial(MeshRenderer* renderer, uint64_t sortKey = 0);
+    void DrawModel(RaylibModel* model, const ModelInstance& instance, uint64_t sortKey = 0);
+    void DrawModelInstanced(RaylibModel* model, const ModelInstance* instances, size_t count, uint64_t sortKey = 0);
+    // The value is copied, so it doesn't need to outlive the buffer
+    void SetShaderValue(unsigned int shaderId, int* shaderLocs, int location, const void* value, int uniformType, uint64_t sortKey = 0);
+
+    void Replay(RenderCommandTarget& target) const;
+    void Clear();
+
+    const std::vector<RenderCommand>& GetCommands() const;
+    const std::vector<ModelInstance>& GetInstances() const;
+
+    // The size in bytes of a uniform value, or 0 if the type is invalid
+    static size_t GetUniformSize(int uniformType);
+
+private:
+    std::vector<RenderCommand> commands;
+    std::vector<ModelInstance> instances;
+};
+
+// Counts and validates the commands without drawing anything, so recording can be checked without a graphics context
+class NullCommandTarget : public RenderCommandTarget
+{
+public:
+    void Execute(const RenderCommand& command, const RenderCommandBuffer& buffer) override;
+    void Reset();
+
+    int GetCount(RenderCommandType type) const;
+    int GetDrawnInstanceCount() const;
+    const std::vector<std::string>& GetErrors() const;
+
+private:
+    int counts[static_cast<int>(RenderCommandType::Count)] = {};
+    int drawnInstances = 0;
+    std::vector<std::string> errors;
+};
@@ -0,0 +1,224 @@
+#include "RenderCulling.h"
+#include <algorithm>
+#include <cmath>
+
+bool RenderCulling::enabled = true;
+CullingTree RenderCulling::tree;
+CullingFrustum RenderCulling::frustum;
+RaylibWrapper::Matrix RenderCulling::view;
+RaylibWrapper::Matrix RenderCulling::projection;
+std::vector<int> RenderCulling::treeProxies;
+std::vector<int> RenderCulling::proxiesByTreeProxy;
+std::vector<int> RenderCulling::freeProxies;
+int RenderCulling::proxyCount = 0;
+std::vector<RenderCulling::PendingChange> RenderCulling::pendingChanges;
+std::unique_ptr<std::atomic<int>[]> RenderCulling::visiblePasses;
+int RenderCulling::visiblePassCapacity = 0;
+int RenderCulling::pass = 0;
+std::atomic<int> RenderCulling::drawnCount = 0;
+std::atomic<int> RenderCulling::culledCount = 0;
+std::mutex RenderCulling::changesMutex;
+
+void RenderCulling::BeginPass()
+{
+    std::lock_guard<std::mutex> lock(changesMutex);
+    pass++;
+    drawnCount = 0;
+    culledCount = 0;
+
+    view = RaylibWrapper::rlGetMatrixModelview();
+    projection = RaylibWrapper::rlGetMatrixProjection();
+    RaylibWrapper::Matrix viewProjection = RaylibWrapper::MatrixMultiply(view, projection);
+    float matrix[16] = {
+        viewProjection.m0, viewProjection.m1, viewProjection.m2, viewProjection.m3,
+        viewProjection.m4, viewProjection.m5, viewProjection.m6, viewProjection.m7,
+        viewProjection.m8, viewProjection.m9, viewProjection.m10, viewProjection.m11,
+        viewProjection.m12, viewProjection.m13, viewProjection.m14, viewProjection.m15
+    };
+    frustum = CullingFrustum::FromMatrix(matrix);
+
+    for (const PendingChange& change : pendingChanges)
+    {
+        switch (change.type)
+        {
+        case ProxyChange::Create:
+        {
+            int treeProxy = tree.CreateProxy(change.bounds);
+            if (treeProxy >= static_cast<int>(proxiesByTreeProxy.size()))
+                proxiesByTreeProxy.resize(treeProxy + 1, -1);
+            proxiesByTreeProxy[treeProxy] = change.proxy;
+            treeProxies[change.proxy] = treeProxy;
+            break;
+        }
+        case ProxyChange::Move:
+            tree.MoveProxy(treeProxies[change.proxy], change.bounds);
+            break;
+        case ProxyChange::Destroy:
+            tree.DestroyProxy(treeProxies[change.proxy]);
+            proxiesByTreeProxy[treeProxies[change.proxy]] = -1;
+            treeProxies[change.proxy] = -1;
+            break;
+        }
+    }
+    pendingChanges.clear();
+
+    // Nothing reads the visible passes while a pass begins, so this is the only place they can grow. Leaves room for proxies added during the pass.
+    if (proxyCount > visiblePassCapacity)
+    {
+        int capacity = std::max(proxyCount * 2, 1024);
+        std::unique_ptr<std::atomic<int>[]> grown(new std::atomic<int>[capacity]);
+        for (int i = 0; i < capacity; i++)
+            grown[i].store(i < visiblePassCapacity ? visiblePasses[i].load(std::memory_order_relaxed) : 0, std::memory_order_relaxed);
+        visiblePasses = std::move(grown);
+        visiblePassCapacity = capacity;
+    }
+
+    tree.Query(frustum, [](int treeProxy) { visiblePasses[proxiesByTreeProxy[treeProxy]].store(pass, std::memory_order_relaxed); });
+}
+
+void RenderCulling::SetVisiblePass(int proxy, const CullingBounds& bounds)
+{
+    // Proxies past the capacity were added during this pass and are always visible until the next one
+    if (proxy < visiblePassCapacity)
+        visiblePasses[proxy].store(frustum.Intersects(bounds) ? pass : 0, std::memory_order_relaxed);
+}
+
+int RenderCulling::AddProxy(const CullingBounds& bounds)
+{
+    std::lock_guard<std::mutex> lock(changesMutex);
+    int proxy;
+    if (!freeProxies.empty())
+    {
+        proxy = freeProxies.back();
+        freeProxies.pop_back();
+    }
+    else
+    {
+        proxy = proxyCount++;
+        treeProxies.push_back(-1);
+    }
+    pendingChanges.push_back({ ProxyChange::Create, proxy, bounds });
+
+    // Added after this pass' query, so it's tested on its own
+    SetVisiblePass(proxy, bounds);
+    return proxy;
+}
+
+void RenderCulling::UpdateProxy(int proxy, const CullingBounds& bounds)
+{
+    if (proxy < 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(changesMutex);
+    pendingChanges.push_back({ ProxyChange::Move, proxy, bounds });
+    SetVisiblePass(proxy, bounds);
+}
+
+void RenderCulling::RemoveProxy(int proxy)
+{
+    if (proxy < 0)
+        return;
+
+    // The proxy can be reused right away, since the changes are applied in order
+    std::lock_guard<std::mutex> lock(changesMutex);
+    pendingChanges.push_back({ ProxyChange::Destroy, proxy, {} });
+    freeProxies.push_back(proxy);
+    if (proxy < visiblePassCapacity)
+        visiblePasses[proxy].store(0, std::memory_order_relaxed);
+}
+
+bool RenderCulling::IsVisible(int proxy)
+{
+    // Nothing is culled before the first pass since there's no frustum yet
+    if (!enabled || pass == 0 || proxy < 0 || proxy >= visiblePassCapacity || visiblePasses[proxy].load(std::memory_order_relaxed) == pass)
+    {
+        drawnCount++;
+        return true;
+    }
+
+    culledCount++;
+    return false;
+}
+
+bool RenderCulling::IsVisible(const CullingBounds& bounds)
+{
+    if (!enabled || pass == 0 || frustum.Intersects(bounds))
+    {
+        drawnCount++;
+        return true;
+    }
+
+    culledCount++;
+    return false;
+}
+
+float RenderCulling::GetScreenSize(const CullingBounds& bounds)
+{
+    float center[3];
+    float radius = 0.0f;
+    for (int i = 0; i < 3; i++)
+    {
+        center[i] = (bounds.min[i] + bounds.max[i]) * 0.5f;
+        radius += (bounds.max[i] - bounds.min[i]) * (bounds.max[i] - bounds.min[i]);
+    }
+    radius = std::sqrt(radius) * 0.5f;
+
+    // Orthographic projections don't shrink with distance
+    if (projection.m15 == 1.0f)
+        return radius * projection.m5;
+
+    // View space depth of the center, the same as the render queue's
+    float depth = -(view.m2 * center[0] + view.m6 * center[1] + view.m10 * center[2] + view.m14);
+    if (depth <= radius)
+        return 1.0f; // The camera is inside or right next to the bounds
+
+    return radius * projection.m5 / depth;
+}
+
+CullingBounds RenderCulling::GetWorldBounds(const RaylibWrapper::BoundingBox& localBounds, const Vector3& position, const Quaternion& rotation, const Vector3& scale)
+{
+    float center[3] = {
+        (localBounds.min.x + localBounds.max.x) * 0.5f * scale.x,
+        (localBounds.min.y + localBounds.max.y) * 0.5f * scale.y,
+        (localBounds.min.z + localBounds.max.z) * 0.5f * scale.z
+    };
+    float extents[3] = {
+        (localBounds.max.x - localBounds.min.x) * 0.5f * std::abs(scale.x),
+        (localBounds.max.y - localBounds.min.y) * 0.5f * std::abs(scale.y),
+        (localBounds.max.z - localBounds.min.z) * 0.5f * std::abs(scale.z)
+    };
+
+    // Rotation matrix from the quaternion
+    float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+    float matrix[3][3] = {
+        { 1 - 2 * (y * y + z * z), 2 * (x * y - z * w), 2 * (x * z + y * w) },
+        { 2 * (x * y + z * w), 1 - 2 * (x * x + z * z), 2 * (y * z - x * w) },
+        { 2 * (x * z - y * w), 2 * (y * z + x * w), 1 - 2 * (x * x + y * y) }
+    };
+
+    float positionValues[3] = { position.x, position.y, position.z };
+    CullingBounds bounds;
+    for (int i = 0; i < 3; i++)
+    {
+        float worldCenter = positionValues[i];
+        float worldExtent = 0.0f;
+        for (int j = 0; j < 3; j++)
+        {
+            worldCenter += matrix[i][j] * center[j];
+            worldExtent += std::abs(matrix[i][j]) * extents[j];
+        }
+        bounds.min[i] = worldCenter - worldExtent;
+        bounds.max[i] = worldCenter + worldExtent;
+    }
+    return bounds;
+}
+
+int RenderCulling::GetDrawnCount()
+{
+    return drawnCount;
+}
+
+int RenderCulling::GetCulledCount()
+{
+    return culledCount;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include "Systems/Rendering/CullingTree.h"
+#include "Raylib/RaylibWrapper.h"
+#include "Core/CryonicCore.h"
+
+// Frustum culling for 3D renderers. Renderers register their world bounds as proxies, then each render pass queries the tree once
+// and renderers check if their proxy was found. Proxies can be added, updated and checked from any thread during a pass.
+// The tree only changes in BeginPass(), so checking visibility never locks. Changes made during a pass are queued and tested against the pass' frustum on their own.
+class RenderCulling
+{
+public:
+    // Must be called after BeginMode3D(). Builds the frustum from the current view and projection matrices and finds the visible proxies.
+    static void BeginPass();
+
+    static int AddProxy(const CullingBounds& bounds);
+    static void UpdateProxy(int proxy, const CullingBounds& bounds);
+    static void RemoveProxy(int proxy);
+
+    // Returns true if the proxy is visible in the current pass, and counts it as drawn or culled
+    static bool IsVisible(int proxy);
+    // Tests bounds that aren't in the tree against the current pass' frustum, and counts them as drawn or culled
+    static bool IsVisible(const CullingBounds& bounds);
+
+    // Transforms local model bounds the same way RaylibModel::DrawModelWrapper() transforms the model
+    static CullingBounds GetWorldBounds(const RaylibWrapper::BoundingBox& localBounds, const Vector3& position, const Quaternion& rotation, const Vector3& scale);
+
+    // How much of the current pass' view height the bounds cover, from their bounding sphere. Used to pick LODs.
+    static float GetScreenSize(const CullingBounds& bounds);
+
+    // Counts for the current/last render pass
+    static int GetDrawnCount();
+    static int GetCulledCount();
+
+    static bool enabled;
+
+private:
+    enum class ProxyChange
+    {
+        Create,
+        Move,
+        Destroy
+    };
+
+    struct PendingChange
+    {
+        ProxyChange type;
+        int proxy;
+        CullingBounds bounds;
+    };
+
+    static void SetVisiblePass(int proxy, const CullingBounds& bounds);
+
+    static CullingTree tree;
+    static CullingFrustum frustum;
+    static RaylibWrapper::Matrix view;
+    static RaylibWrapper::Matrix projection;
+    static std::vector<int> treeProxies; // The tree's proxy for each of our proxies, -1 until it's created
+    static std::vector<int> proxiesByTreeProxy;
+    static std::vector<int> freeProxies;
+    static int proxyCount;
+    static std::vector<PendingChange> pendingChanges; // Applied to the tree in BeginPass()
+    static std::unique_ptr<std::atomic<int>[]> visiblePasses; // The last pass each proxy was visible in. Only reallocated in BeginPass().
+    static int visiblePassCapacity;
+    static int pass;
+    static std::atomic<int> drawnCount;
+    static std::atomic<int> culledCount;
+    static std::mutex changesMutex;
+};
@@ -0,0 +1,201 @@
+#include "RenderQueue.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include "Components/Rendering/MeshRenderer.h"
+#include "Raylib/RaylibWrapper.h"
+
+bool RenderQueue::instancingEnabled = true;
+int RenderQueue::minimumInstances = 2;
+std::vector<DrawPacket> RenderQueue::packets;
+std::vector<ModelInstance> RenderQueue::instances;
+RenderCommandBuffer RenderQueue::commandBuffer;
+RaylibCommandTarget RenderQueue::raylibTarget;
+
+// Packets submitted by one thread. The buffers are owned by the queue instead of the threads, so the packets of a thread that exits before
+// the queue is recorded are still drawn. A thread claims a free buffer on its first submit and frees it again when it exits.
+struct ThreadPacketBuffer
+{
+    std::vector<DrawPacket> packets;
+    bool inUse = false;
+};
+
+static std::mutex threadBuffersMutex; // Only locked when a thread claims or frees a buffer, and when the buffers are collected
+static std::deque<ThreadPacketBuffer> threadBuffers; // A deque so claimed buffers never move
+
+struct ThreadBufferLease
+{
+    ThreadBufferLease()
+    {
+        std::lock_guard<std::mutex> lock(threadBuffersMutex);
+        for (ThreadPacketBuffer& threadBuffer : threadBuffers)
+        {
+            if (!threadBuffer.inUse)
+            {
+                buffer = &threadBuffer;
+                break;
+            }
+        }
+        if (!buffer)
+            buffer = &threadBuffers.emplace_back();
+        buffer->inUse = true;
+    }
+
+    ~ThreadBufferLease()
+    {
+        std::lock_guard<std::mutex> lock(threadBuffersMutex);
+        buffer->inUse = false;
+    }
+
+    ThreadPacketBuffer* buffer = nullptr;
+};
+
+void RenderQueue::Submit(MeshRenderer* renderer, const Vector3& position, const Quaternion& rotation, const Vector3& scale)
+{
+    thread_local ThreadBufferLease lease;
+
+    RaylibModel& model = renderer->GetModel();
+    Material* material = renderer->GetMaterial();
+
+    DrawPacket packet;
+    packet.renderer = renderer;
+    packet.instance = { position.x, position.y, position.z, scale.x, scale.y, scale.z, rotation.x, rotation.y, rotation.z, rotation.w };
+    packet.transparent = material && material->GetAlbedoColor().a < 255;
+    packet.shader = static_cast<unsigned int>(model.GetShaderID(0));
+    packet.material = material ? static_cast<unsigned int>(material->GetID()) : static_cast<unsigned int>(model.GetMaterialID(0));
+    packet.lod = model.GetLOD();
+    packet.mesh = static_cast<unsigned int>(std::hash<const void*>{}(model.GetModelHandle())) + static_cast<unsigned int>(packet.lod); // Each LOD sorts as its own mesh
+
+    // Only this thread writes to the buffer until the queue is recorded, so it doesn't need a lock
+    lease.buffer->packets.push_back(packet);
+}
+
+uint64_t RenderQueue::MakeKey(bool transparent, unsigned int shader, unsigned int material, unsigned int mesh, float depth)
+{
+    // The bits of a positive float sort the same as its value, so the top 20 bits of it are used as the depth
+    depth = std::max(depth, 0.0f);
+    uint32_t depthBits;
+    std::memcpy(&depthBits, &depth, sizeof(depthBits));
+    uint64_t quantizedDepth = (depthBits >> 11) & 0xFFFFF;
+
+    uint64_t shaderBits = shader & 0x3FF;
+    uint64_t materialBits = material & 0xFFFF;
+    uint64_t meshBits = mesh & 0xFFFF;
+
+    if (!transparent)
+        return (shaderBits << 53) | (materialBits << 37) | (meshBits << 21) | (quantizedDepth << 1);
+
+    return (1ull << 63) | ((0xFFFFF - quantizedDepth) << 43) | (shaderBits << 33) | (materialBits << 17) | (meshBits << 1);
+}
+
+void RenderQueue::Record(RenderCommandBuffer& buffer, const RaylibWrapper::Matrix& view)
+{
+    packets.clear();
+    {
+        std::lock_guard<std::mutex> lock(threadBuffersMutex);
+        for (ThreadPacketBuffer& threadBuffer : threadBuffers)
+        {
+            packets.insert(packets.end(), threadBuffer.packets.begin(), threadBuffer.packets.end());
+            threadBuffer.packets.clear();
+        }
+    }
+
+    if (packets.empty())
+        return;
+
+    for (DrawPacket& packet : packets)
+    {
+        // View space depth of the position
+        float depth = -(view.m2 * packet.instance.posX + view.m6 * packet.instance.posY + view.m10 * packet.instance.posZ + view.m14);
+        packet.key = MakeKey(packet.transparent, packet.shader, packet.material, packet.mesh, depth);
+    }
+
+    std::sort(packets.begin(), packets.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.key < b.key; });
+
+    // The key only holds part of the mesh and material IDs, so runs are split by comparing the real ones
+    size_t first = 0;
+    for (size_t i = 1; i <= packets.size(); i++)
+    {
+        if (i < packets.size())
+        {
+            const DrawPacket& a = packets[first];
+            const DrawPacket& b = packets[i];
+            if (!a.transparent && !b.transparent && a.renderer->GetModel().GetModelHandle() == b.renderer->GetModel().GetModelHandle()
+                && a.lod == b.lod && a.renderer->GetMaterial() == b.renderer->GetMaterial())
+                continue;
+        }
+
+        RecordRun(buffer, first, i);
+        first = i;
+    }
+
+    packets.clear();
+}
+
+void RenderQueue::Flush()
+{
+    commandBuffer.Clear();
+    Record(commandBuffer, RaylibWrapper::rlGetMatrixModelview());
+    commandBuffer.Replay(raylibTarget);
+    commandBuffer.Clear();
+}
+
+void RenderQueue::RecordRun(RenderCommandBuffer& buffer, size_t first, size_t last)
+{
+    MeshRenderer* renderer = packets[first].renderer;
+    uint64_t key = packets[first].key;
+    buffer.ApplyMaterial(renderer, key);
+
+    if (!instancingEnabled || last - first < static_cast<size_t>(std::max(minimumInstances, 1)))
+    {
+        for (size_t i = first; i < last; i++)
+            buffer.DrawModel(&renderer->GetModel(), packets[i].instance, packets[i].key);
+        return;
+    }
+
+    instances.clear();
+    for (size_t i = first; i < last; i++)
+        instances.push_back(packets[i].instance);
+
+    // The shader's instancing switch is recorded around the draw instead of being set when the draw is replayed
+    unsigned int shaderId = 0;
+    int* shaderLocs = nullptr;
+    int location = -1;
+    bool instancingUniform = RaylibModel::GetInstancingUniform(shaderId, shaderLocs, location);
+    int useInstancing = 1;
+    if (instancingUniform)
+        buffer.SetShaderValue(shaderId, shaderLocs, location, &useInstancing, RaylibWrapper::SHADER_UNIFORM_INT, key);
+    buffer.DrawModelInstanced(&renderer->GetModel(), instances.data(), instances.size(), key);
+    useInstancing = 0;
+    if (instancingUniform)
+        buffer.SetShaderValue(shaderId, shaderLocs, location, &useInstancing, RaylibWrapper::SHADER_UNIFORM_INT, key);
+}
+
+void RaylibCommandTarget::Execute(const RenderCommand& command, const RenderCommandBuffer& buffer)
+{
+    switch (command.type)
+    {
+    case RenderCommandType::ApplyMaterial:
+        command.renderer->ApplyMaterial();
+        break;
+    case RenderCommandType::DrawModel:
+    {
+        const ModelInstance& instance = command.instance;
+        command.model->DrawModelWrapper(instance.posX, instance.posY, instance.posZ, instance.sizeX, instance.sizeY, instance.sizeZ,
+            instance.rotationX, instance.rotationY, instance.rotationZ, instance.rotationW, 255, 255, 255, 255);
+        break;
+    }
+    case RenderCommandType::DrawModelInstanced:
+    {
+        command.model->DrawModelInstanced(buffer.GetInstances().data() + command.firstInstance, static_cast<int>(command.instanceCount), false);
+        break;
+    }
+    case RenderCommandType::SetShaderValue:
+        RaylibWrapper::SetShaderValue({ command.shaderId, command.shaderLocs }, command.location, command.value, command.uniformType);
+        break;
+    default:
+        break;
+    }
+}
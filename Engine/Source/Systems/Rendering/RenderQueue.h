@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "Core/CryonicCore.h"
+#include "Raylib/RaylibModelWrapper.h"
+#include "Systems/Rendering/RenderCommandBuffer.h"
+
+class MeshRenderer;
+
+// A draw submitted to the render queue
+struct DrawPacket
+{
+    uint64_t key = 0; // Set when the queue is recorded
+    MeshRenderer* renderer;
+    ModelInstance instance;
+    bool transparent;
+    unsigned int shader;
+    unsigned int material;
+    unsigned int mesh;
+    int lod;
+};
+
+// Replays command buffers with raylib
+class RaylibCommandTarget : public RenderCommandTarget
+{
+public:
+    void Execute(const RenderCommand& command, const RenderCommandBuffer& buffer) override;
+};
+
+// Collects the mesh draws for a render pass so they can be drawn sorted by state instead of in scene order.
+// Opaque draws are grouped by shader, material and mesh, then front to back, and each run of the same mesh, LOD and material is drawn instanced.
+// Transparent draws are drawn after, back to front.
+// Draws can be submitted from any thread without locking. Each thread has its own packet buffer, and the buffers are merged when the queue is recorded,
+// so every submit for a pass must be done before it's recorded.
+class RenderQueue
+{
+public:
+    static void Submit(MeshRenderer* renderer, const Vector3& position, const Quaternion& rotation, const Vector3& scale);
+    // Records the submitted draws into the command buffer, sorted and batched, then empties the queue. The view matrix is used for the depth.
+    static void Record(RenderCommandBuffer& buffer, const RaylibWrapper::Matrix& view);
+    // Records and replays everything submitted since the last flush on the render thread. Must be called before the end of the 3D mode the draws were submitted in.
+    static void Flush();
+
+    // Sort key layout, from the most significant bit:
+    // Opaque:      0 | shader (10) | material (16) | mesh (16) | depth (20) | unused (1)
+    // Transparent: 1 | inverted depth (20) | shader (10) | material (16) | mesh (16) | unused (1)
+    static uint64_t MakeKey(bool transparent, unsigned int shader, unsigned int material, unsigned int mesh, float depth);
+
+    static bool instancingEnabled;
+    static int minimumInstances; // The smallest run drawn instanced
+
+private:
+    static void RecordRun(RenderCommandBuffer& buffer, size_t first, size_t last);
+
+    static std::vector<DrawPacket> packets; // The merged packets while recording
+    static std::vector<ModelInstance> instances;
+    static RenderCommandBuffer commandBuffer;
+    static RaylibCommandTarget raylibTarget;
+};
@@ -106,6 +106,16 @@ void ShaderManager::Init()
 		RaylibShader::shaders[ShaderManager::Clouds].Load((std::filesystem::path(exeParent) / "Resources/shaders/glsl330/clouds.vs").string().c_str(), (std::filesystem::path(exeParent) / "Resources/shaders/glsl330/clouds.fs").string().c_str());
 #endif
 
+	// Impostor
+#if defined (EDITOR)
+	RaylibShader::shaders[ShaderManager::Impostor].Load("Resources/shaders/glsl330/impostor.vs", "resources/shaders/glsl330/impostor.fs");
+#else
+	if (exeParent.empty())
+		RaylibShader::shaders[ShaderManager::Impostor].Load("Resources/shaders/glsl330/impostor.vs", "Resources/shaders/glsl330/impostor.fs");
+	else
+		RaylibShader::shaders[ShaderManager::Impostor].Load((std::filesystem::path(exeParent) / "Resources/shaders/glsl330/impostor.vs").string().c_str(), (std::filesystem::path(exeParent) / "Resources/shaders/glsl330/impostor.fs").string().c_str());
+#endif
+
 
     //std::string currentDirectory = GetWorkingDirectory();
     //std::string relativePath = "resources/shaders/glsl330/lighting.vs";
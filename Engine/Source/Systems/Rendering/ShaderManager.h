@@ -14,7 +14,8 @@ public:
 		Cubemap,
 		Skybox,
 		Water,
-		Clouds
+		Clouds,
+		Impostor
 	};
 
 	static void Init();
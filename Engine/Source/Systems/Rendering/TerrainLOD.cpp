@@ -0,0 +1,432 @@
+#include "TerrainLOD.h"
+#include <algorithm>
+#include <cmath>
+
+void TerrainLOD::Build(const float* heights, int width, int depth, int chunkCells, int levels)
+{
+    Clear();
+
+    if (!heights || width < 2 || depth < 2)
+        return;
+
+    this->width = width;
+    this->depth = depth;
+    // Stitching skips every other edge vertex, so chunks need an even number of cells
+    this->chunkCells = std::max(2, std::min(chunkCells, 254)) & ~1;
+
+    // Levels past the one that covers the whole terrain in a single chunk aren't needed
+    int largestSide = std::max(width - 1, depth - 1);
+    int topLevel = 0;
+    while (topLevel < levels - 1 && GetNodeSize(topLevel) < largestSide)
+        topLevel++;
+    this->levels = topLevel + 1;
+
+    int rootSize = GetNodeSize(topLevel);
+    for (int z = 0; z < depth - 1; z += rootSize)
+        for (int x = 0; x < width - 1; x += rootSize)
+            roots.push_back(BuildNode(heights, x, z, topLevel));
+}
+
+void TerrainLOD::Clear()
+{
+    nodes.clear();
+    roots.clear();
+    width = 0;
+    depth = 0;
+}
+
+int TerrainLOD::BuildNode(const float* heights, int x, int z, int level)
+{
+    int index = static_cast<int>(nodes.size());
+    nodes.emplace_back();
+    nodes[index].x = x;
+    nodes[index].z = z;
+    nodes[index].level = level;
+
+    int size = GetNodeSize(level);
+    int lastX = std::min(x + size, width - 1);
+    int lastZ = std::min(z + size, depth - 1);
+
+    if (level == 0)
+    {
+        float minHeight = heights[z * width + x];
+        float maxHeight = minHeight;
+        for (int sampleZ = z; sampleZ <= lastZ; sampleZ++)
+        {
+            for (int sampleX = x; sampleX <= lastX; sampleX++)
+            {
+                float height = heights[sampleZ * width + sampleX];
+                minHeight = std::min(minHeight, height);
+                maxHeight = std::max(maxHeight, height);
+            }
+        }
+        nodes[index].minHeight = minHeight;
+        nodes[index].maxHeight = maxHeight;
+        nodes[index].error = 0.0f;
+        return index;
+    }
+
+    // Children first, nodes can be reallocated while they're built
+    int childSize = size / 2;
+    int children[4] = { -1, -1, -1, -1 };
+    for (int i = 0; i < 4; i++)
+    {
+        int childX = x + (i % 2) * childSize;
+        int childZ = z + (i / 2) * childSize;
+        if (childX < width - 1 && childZ < depth - 1)
+            children[i] = BuildNode(heights, childX, childZ, level - 1);
+    }
+
+    float minHeight = nodes[children[0]].minHeight;
+    float maxHeight = nodes[children[0]].maxHeight;
+    float error = 0.0f;
+    for (int child : children)
+    {
+        if (child == -1)
+            continue;
+        minHeight = std::min(minHeight, nodes[child].minHeight);
+        maxHeight = std::max(maxHeight, nodes[child].maxHeight);
+        error = std::max(error, nodes[child].error);
+    }
+
+    error = std::max(error, GetError(heights, nodes[index], x, z, lastX, lastZ));
+
+    TerrainLODNode& node = nodes[index];
+    std::copy(children, children + 4, node.children);
+    node.minHeight = minHeight;
+    node.maxHeight = maxHeight;
+    node.error = error;
+    return index;
+}
+
+void TerrainLOD::UpdateRegion(const float* heights, int minX, int minZ, int maxX, int maxZ)
+{
+    if (!heights || nodes.empty())
+        return;
+
+    for (int root : roots)
+        UpdateNode(heights, root, minX, minZ, maxX, maxZ);
+}
+
+void TerrainLOD::UpdateNode(const float* heights, int node, int minX, int minZ, int maxX, int maxZ)
+{
+    TerrainLODNode& lodNode = nodes[node];
+    int size = GetNodeSize(lodNode.level);
+    int lastX = std::min(lodNode.x + size, width - 1);
+    int lastZ = std::min(lodNode.z + size, depth - 1);
+
+    // Edge samples are shared with the neighbors, so touching one counts
+    if (maxX < lodNode.x || minX > lastX || maxZ < lodNode.z || minZ > lastZ)
+        return;
+
+    if (lodNode.level == 0)
+    {
+        float minHeight = heights[lodNode.z * width + lodNode.x];
+        float maxHeight = minHeight;
+        for (int sampleZ = lodNode.z; sampleZ <= lastZ; sampleZ++)
+        {
+            for (int sampleX = lodNode.x; sampleX <= lastX; sampleX++)
+            {
+                float height = heights[sampleZ * width + sampleX];
+                minHeight = std::min(minHeight, height);
+                maxHeight = std::max(maxHeight, height);
+            }
+        }
+        lodNode.minHeight = minHeight;
+        lodNode.maxHeight = maxHeight;
+        return;
+    }
+
+    float minHeight = 0.0f;
+    float maxHeight = 0.0f;
+    float error = lodNode.error;
+    bool first = true;
+    for (int child : lodNode.children)
+    {
+        if (child == -1)
+            continue;
+
+        UpdateNode(heights, child, minX, minZ, maxX, maxZ);
+        const TerrainLODNode& childNode = nodes[child];
+        minHeight = first ? childNode.minHeight : std::min(minHeight, childNode.minHeight);
+        maxHeight = first ? childNode.maxHeight : std::max(maxHeight, childNode.maxHeight);
+        error = std::max(error, childNode.error);
+        first = false;
+    }
+
+    // A changed corner moves the whole cell around it, so the range grows by a cell
+    int stride = 1 << lodNode.level;
+    error = std::max(error, GetError(heights, lodNode, minX - stride, minZ - stride, maxX + stride, maxZ + stride));
+
+    lodNode.minHeight = minHeight;
+    lodNode.maxHeight = maxHeight;
+    lodNode.error = error;
+}
+
+float TerrainLOD::GetError(const float* heights, const TerrainLODNode& node, int minX, int minZ, int maxX, int maxZ) const
+{
+    int size = GetNodeSize(node.level);
+    minX = std::max(minX, node.x);
+    minZ = std::max(minZ, node.z);
+    maxX = std::min(maxX, std::min(node.x + size, width - 1));
+    maxZ = std::min(maxZ, std::min(node.z + size, depth - 1));
+
+    // Compare every sample to the surface of this level's triangles, which are split from the top right to the bottom left corner
+    float error = 0.0f;
+    int stride = 1 << node.level;
+    for (int sampleZ = minZ; sampleZ <= maxZ; sampleZ++)
+    {
+        int cellZ = std::min((sampleZ - node.z) / stride, chunkCells - 1);
+        int z0 = std::min(node.z + cellZ * stride, depth - 1);
+        int z1 = std::min(z0 + stride, depth - 1);
+        float fractionZ = z1 > z0 ? static_cast<float>(sampleZ - z0) / (z1 - z0) : 0.0f;
+
+        for (int sampleX = minX; sampleX <= maxX; sampleX++)
+        {
+            int cellX = std::min((sampleX - node.x) / stride, chunkCells - 1);
+            int x0 = std::min(node.x + cellX * stride, width - 1);
+            int x1 = std::min(x0 + stride, width - 1);
+            float fractionX = x1 > x0 ? static_cast<float>(sampleX - x0) / (x1 - x0) : 0.0f;
+
+            float topLeft = heights[z0 * width + x0];
+            float topRight = heights[z0 * width + x1];
+            float bottomLeft = heights[z1 * width + x0];
+            float bottomRight = heights[z1 * width + x1];
+
+            float interpolated;
+            if (fractionX + fractionZ <= 1.0f)
+                interpolated = topLeft + fractionX * (topRight - topLeft) + fractionZ * (bottomLeft - topLeft);
+            else
+                interpolated = bottomRight + (1.0f - fractionX) * (bottomLeft - bottomRight) + (1.0f - fractionZ) * (topRight - bottomRight);
+
+            error = std::max(error, std::abs(heights[sampleZ * width + sampleX] - interpolated));
+        }
+    }
+    return error;
+}
+
+float TerrainLOD::GetDistance(const TerrainLODNode& node, const float viewPosition[3]) const
+{
+    int size = GetNodeSize(node.level);
+    float min[3] = { static_cast<float>(node.x), node.minHeight, static_cast<float>(node.z) };
+    float max[3] = { static_cast<float>(std::min(node.x + size, width - 1)), node.maxHeight, static_cast<float>(std::min(node.z + size, depth - 1)) };
+
+    float distanceSquared = 0.0f;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float distance = std::max({ min[axis] - viewPosition[axis], 0.0f, viewPosition[axis] - max[axis] });
+        distanceSquared += distance * distance;
+    }
+    return std::sqrt(distanceSquared);
+}
+
+void TerrainLOD::SelectNode(int node, const float viewPosition[3], float pixelsPerUnit, float maxScreenError, float fullDetailDistance, std::vector<int>& selected) const
+{
+    const TerrainLODNode& lodNode = nodes[node];
+    if (lodNode.level > 0)
+    {
+        float distance = GetDistance(lodNode, viewPosition);
+        float screenError = lodNode.error * pixelsPerUnit / std::max(distance, 0.0001f);
+        if (distance < fullDetailDistance || screenError > maxScreenError)
+        {
+            for (int child : lodNode.children)
+                if (child != -1)
+                    SelectNode(child, viewPosition, pixelsPerUnit, maxScreenError, fullDetailDistance, selected);
+            return;
+        }
+    }
+
+    selected.push_back(node);
+}
+
+void TerrainLOD::Select(const float viewPosition[3], float pixelsPerUnit, float maxScreenError, float fullDetailDistance, std::vector<TerrainLODSelection>& selection) const
+{
+    selection.clear();
+    if (nodes.empty())
+        return;
+
+    std::vector<int> selected;
+    for (int root : roots)
+        SelectNode(root, viewPosition, pixelsPerUnit, maxScreenError, fullDetailDistance, selected);
+
+    // Level of the selected node covering each full resolution chunk
+    int gridWidth = (width - 2) / chunkCells + 1;
+    int gridDepth = (depth - 2) / chunkCells + 1;
+    std::vector<int> gridLevels(static_cast<size_t>(gridWidth) * gridDepth, 0);
+
+    auto fillGrid = [&]()
+    {
+        for (int node : selected)
+        {
+            const TerrainLODNode& lodNode = nodes[node];
+            int cells = 1 << lodNode.level;
+            int gridX = lodNode.x / chunkCells;
+            int gridZ = lodNode.z / chunkCells;
+            for (int z = gridZ; z < std::min(gridZ + cells, gridDepth); z++)
+                for (int x = gridX; x < std::min(gridX + cells, gridWidth); x++)
+                    gridLevels[z * gridWidth + x] = lodNode.level;
+        }
+    };
+
+    // Calls the callback with the level of every grid cell along the outside of an edge
+    auto forEachNeighbor = [&](const TerrainLODNode& lodNode, int edge, auto&& callback)
+    {
+        int cells = 1 << lodNode.level;
+        int gridX = lodNode.x / chunkCells;
+        int gridZ = lodNode.z / chunkCells;
+        bool alongX = edge == TerrainLODEdgeNegativeZ || edge == TerrainLODEdgePositiveZ;
+        int fixed = edge == TerrainLODEdgeNegativeX ? gridX - 1 : edge == TerrainLODEdgePositiveX ? gridX + cells
+            : edge == TerrainLODEdgeNegativeZ ? gridZ - 1 : gridZ + cells;
+        if (fixed < 0 || fixed >= (alongX ? gridDepth : gridWidth))
+            return;
+
+        int first = alongX ? gridX : gridZ;
+        int last = std::min(first + cells, alongX ? gridWidth : gridDepth);
+        for (int i = first; i < last; i++)
+            callback(alongX ? gridLevels[fixed * gridWidth + i] : gridLevels[i * gridWidth + fixed]);
+    };
+
+    const int edges[4] = { TerrainLODEdgeNegativeX, TerrainLODEdgePositiveX, TerrainLODEdgeNegativeZ, TerrainLODEdgePositiveZ };
+
+    // Split chunks until no chunk is next to one more than a level finer, so stitching one level covers every edge
+    bool changed = true;
+    std::vector<int> next;
+    while (changed)
+    {
+        changed = false;
+        fillGrid();
+
+        next.clear();
+        for (int node : selected)
+        {
+            const TerrainLODNode& lodNode = nodes[node];
+            bool split = false;
+            if (lodNode.level > 1)
+            {
+                for (int edge : edges)
+                    forEachNeighbor(lodNode, edge, [&](int level) { split |= level < lodNode.level - 1; });
+            }
+
+            if (!split)
+            {
+                next.push_back(node);
+                continue;
+            }
+
+            for (int child : lodNode.children)
+                if (child != -1)
+                    next.push_back(child);
+            changed = true;
+        }
+        selected.swap(next);
+    }
+
+    for (int node : selected)
+    {
+        const TerrainLODNode& lodNode = nodes[node];
+        int stitchEdges = 0;
+        for (int edge : edges)
+        {
+            bool coarser = false;
+            forEachNeighbor(lodNode, edge, [&](int level) { coarser |= level > lodNode.level; });
+            if (coarser)
+                stitchEdges |= edge;
+        }
+        selection.push_back({ node, stitchEdges });
+    }
+}
+
+void TerrainLOD::BuildVertices(int node, const float* heights, std::vector<float>& positions, std::vector<float>& normals, std::vector<float>& texcoords) const
+{
+    const TerrainLODNode& lodNode = nodes[node];
+    int stride = 1 << lodNode.level;
+    int vertexCount = (chunkCells + 1) * (chunkCells + 1);
+
+    positions.resize(static_cast<size_t>(vertexCount) * 3);
+    normals.resize(static_cast<size_t>(vertexCount) * 3);
+    texcoords.resize(static_cast<size_t>(vertexCount) * 2);
+
+    int vertex = 0;
+    for (int j = 0; j <= chunkCells; j++)
+    {
+        // Samples past the terrain are clamped to its edge, leaving flat triangles
+        int z = std::min(lodNode.z + j * stride, depth - 1);
+        for (int i = 0; i <= chunkCells; i++, vertex++)
+        {
+            int x = std::min(lodNode.x + i * stride, width - 1);
+
+            positions[vertex * 3] = static_cast<float>(x);
+            positions[vertex * 3 + 1] = heights[z * width + x];
+            positions[vertex * 3 + 2] = static_cast<float>(z);
+
+            float left = heights[z * width + std::max(x - 1, 0)];
+            float right = heights[z * width + std::min(x + 1, width - 1)];
+            float back = heights[std::max(z - 1, 0) * width + x];
+            float front = heights[std::min(z + 1, depth - 1) * width + x];
+            float normal[3] = { left - right, 2.0f, back - front };
+            float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            normals[vertex * 3] = normal[0] / length;
+            normals[vertex * 3 + 1] = normal[1] / length;
+            normals[vertex * 3 + 2] = normal[2] / length;
+
+            texcoords[vertex * 2] = static_cast<float>(x) / width;
+            texcoords[vertex * 2 + 1] = static_cast<float>(z) / depth;
+        }
+    }
+}
+
+void TerrainLOD::BuildIndices(int chunkCells, int stitchEdges, std::vector<unsigned short>& indices)
+{
+    indices.clear();
+    int rowLength = chunkCells + 1;
+
+    // Odd vertices on stitched edges are moved onto the even vertex before them, which matches the coarser neighbor's edge.
+    // The triangles that collapse are skipped.
+    auto getIndex = [&](int i, int j)
+    {
+        if (j % 2 == 1 && ((i == 0 && (stitchEdges & TerrainLODEdgeNegativeX)) || (i == chunkCells && (stitchEdges & TerrainLODEdgePositiveX))))
+            j--;
+        if (i % 2 == 1 && ((j == 0 && (stitchEdges & TerrainLODEdgeNegativeZ)) || (j == chunkCells && (stitchEdges & TerrainLODEdgePositiveZ))))
+            i--;
+        return static_cast<unsigned short>(j * rowLength + i);
+    };
+
+    auto addTriangle = [&](unsigned short a, unsigned short b, unsigned short c)
+    {
+        if (a == b || b == c || a == c)
+            return;
+        indices.push_back(a);
+        indices.push_back(b);
+        indices.push_back(c);
+    };
+
+    for (int j = 0; j < chunkCells; j++)
+    {
+        for (int i = 0; i < chunkCells; i++)
+        {
+            unsigned short topLeft = getIndex(i, j);
+            unsigned short topRight = getIndex(i + 1, j);
+            unsigned short bottomLeft = getIndex(i, j + 1);
+            unsigned short bottomRight = getIndex(i + 1, j + 1);
+
+            // Same winding as RaylibModel::CreateFromHeightData()
+            addTriangle(topLeft, bottomLeft, topRight);
+            addTriangle(topRight, bottomLeft, bottomRight);
+        }
+    }
+}
+
+CullingBounds TerrainLOD::GetBounds(int node, const float offset[3]) const
+{
+    const TerrainLODNode& lodNode = nodes[node];
+    int size = GetNodeSize(lodNode.level);
+
+    CullingBounds bounds;
+    bounds.min[0] = offset[0] + lodNode.x;
+    bounds.min[1] = offset[1] + lodNode.minHeight;
+    bounds.min[2] = offset[2] + lodNode.z;
+    bounds.max[0] = offset[0] + std::min(lodNode.x + size, width - 1);
+    bounds.max[1] = offset[1] + lodNode.maxHeight;
+    bounds.max[2] = offset[2] + std::min(lodNode.z + size, depth - 1);
+    return bounds;
+}
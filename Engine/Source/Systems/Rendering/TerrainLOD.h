@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include "Systems/Rendering/CullingTree.h"
+
+// Edges of a chunk that border a coarser chunk, and have their odd vertices skipped so there are no cracks
+enum TerrainLODEdge
+{
+    TerrainLODEdgeNegativeX = 1,
+    TerrainLODEdgePositiveX = 2,
+    TerrainLODEdgeNegativeZ = 4,
+    TerrainLODEdgePositiveZ = 8
+};
+
+struct TerrainLODNode
+{
+    int x = 0; // First height sample covered by the node
+    int z = 0;
+    int level = 0; // 0 is full resolution, each level above skips every other sample of the one below
+    int children[4] = { -1, -1, -1, -1 };
+    float minHeight = 0.0f;
+    float maxHeight = 0.0f;
+    float error = 0.0f; // Largest height difference between this level and full resolution, including the children
+};
+
+struct TerrainLODSelection
+{
+    int node;
+    int stitchEdges; // TerrainLODEdge flags
+};
+
+// Quadtree of terrain chunks. Every chunk has the same number of vertices, spaced further apart at higher levels.
+// Chunks are picked by their screen-space error, neighbors are kept within one level of each other, and the edges next to a coarser chunk are stitched.
+// This has no dependency on raylib, so selection and mesh generation can be tested on their own.
+class TerrainLOD
+{
+public:
+    // Heights are row-major, width * depth. chunkCells is the number of cells along a chunk's side, and at most 254 so indices fit in 16 bits.
+    void Build(const float* heights, int width, int depth, int chunkCells = 32, int levels = 4);
+    void Clear();
+    // Updates the bounds and errors of the nodes covering the changed samples, inclusive. The heights must keep the size they were built with.
+    // Errors only grow until the next Build(), so chunks can be split more than needed but never too little.
+    void UpdateRegion(const float* heights, int minX, int minZ, int maxX, int maxZ);
+
+    // Picks the chunks to draw so together they cover the whole terrain once. A chunk is split while its error is larger than maxScreenError
+    // pixels, or it's closer than fullDetailDistance. pixelsPerUnit is how many pixels a unit one unit away covers, screenHeight / (2 * tan(fovy / 2)).
+    // The view position is relative to the terrain's first sample.
+    void Select(const float viewPosition[3], float pixelsPerUnit, float maxScreenError, float fullDetailDistance, std::vector<TerrainLODSelection>& selection) const;
+
+    // Chunk vertices relative to the terrain's first sample. Normals come from the full resolution heights so lighting matches across levels.
+    void BuildVertices(int node, const float* heights, std::vector<float>& positions, std::vector<float>& normals, std::vector<float>& texcoords) const;
+    // Triangles for a chunk. The same for every chunk with the same edges.
+    static void BuildIndices(int chunkCells, int stitchEdges, std::vector<unsigned short>& indices);
+
+    // Bounds relative to the terrain's first sample, then moved by the offset
+    CullingBounds GetBounds(int node, const float offset[3]) const;
+
+    const TerrainLODNode& GetNode(int node) const { return nodes[node]; }
+    int GetNodeCount() const { return static_cast<int>(nodes.size()); }
+    int GetChunkCells() const { return chunkCells; }
+    int GetLevels() const { return levels; }
+
+private:
+    int BuildNode(const float* heights, int x, int z, int level);
+    void UpdateNode(const float* heights, int node, int minX, int minZ, int maxX, int maxZ);
+    // Largest difference between the node's triangles and the full resolution samples in the range, which is clamped to the node
+    float GetError(const float* heights, const TerrainLODNode& node, int minX, int minZ, int maxX, int maxZ) const;
+    int GetNodeSize(int level) const { return chunkCells << level; }
+    float GetDistance(const TerrainLODNode& node, const float viewPosition[3]) const;
+    void SelectNode(int node, const float viewPosition[3], float pixelsPerUnit, float maxScreenError, float fullDetailDistance, std::vector<int>& selected) const;
+
+    std::vector<TerrainLODNode> nodes;
+    std::vector<int> roots;
+    int width = 0;
+    int depth = 0;
+    int chunkCells = 32;
+    int levels = 1;
+};
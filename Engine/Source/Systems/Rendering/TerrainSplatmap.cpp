@@ -0,0 +1,37 @@
+#include "TerrainSplatmap.h"
+#include <algorithm>
+#include <cstring>
+
+void TerrainSplatmap::Pack(const float* const* layers, int layerCount, int width, int minX, int minZ, int maxX, int maxZ, unsigned char* pixels)
+{
+    layerCount = std::min(layerCount, maxLayers);
+    int rowWidth = maxX - minX + 1;
+    for (int z = minZ; z <= maxZ; z++)
+    {
+        size_t rowStart = static_cast<size_t>(z) * width + minX;
+        unsigned char* texels = pixels + rowStart * 4;
+        for (int channel = 0; channel < 4; channel++)
+        {
+            if (channel < layerCount)
+            {
+                const float* weights = layers[channel] + rowStart;
+                for (int x = 0; x < rowWidth; x++)
+                    texels[x * 4 + channel] = static_cast<unsigned char>(std::clamp(weights[x], 0.0f, 1.0f) * 255);
+            }
+            else
+            {
+                unsigned char value = channel == 0 ? 255 : 0;
+                for (int x = 0; x < rowWidth; x++)
+                    texels[x * 4 + channel] = value;
+            }
+        }
+    }
+}
+
+void TerrainSplatmap::CopyRect(const unsigned char* pixels, int width, int minX, int minZ, int maxX, int maxZ, std::vector<unsigned char>& rect)
+{
+    size_t rowSize = static_cast<size_t>(maxX - minX + 1) * 4;
+    rect.resize(rowSize * (maxZ - minZ + 1));
+    for (int z = minZ; z <= maxZ; z++)
+        memcpy(rect.data() + (z - minZ) * rowSize, pixels + (static_cast<size_t>(z) * width + minX) * 4, rowSize);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+
+// Converts terrain layer weights into the RGBA8 splatmap the terrain shader samples, a channel for each of the first 4 layers.
+// Only a rectangle is converted at a time so painting can update just the texels under the brush.
+// This has no dependency on raylib, so the packing can be tested against the float weights on its own.
+class TerrainSplatmap
+{
+public:
+    static constexpr int maxLayers = 4;
+
+    // Packs the weights in the rect, inclusive, into the image's texels. The layers and the image are row-major, width wide.
+    // Channels without a layer are 0, except the first which is full.
+    static void Pack(const float* const* layers, int layerCount, int width, int minX, int minZ, int maxX, int maxZ, unsigned char* pixels);
+    // Copies the rect out of the packed image into a tightly packed buffer, the layout a sub-image upload expects
+    static void CopyRect(const unsigned char* pixels, int width, int minX, int minZ, int maxX, int maxZ, std::vector<unsigned char>& rect);
+};
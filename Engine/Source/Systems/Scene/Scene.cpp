@@ -72,6 +72,7 @@ void Scene::RemoveGameObject(GameObject* gameObject)
     auto it = std::find_if(m_GameObjects.begin(), m_GameObjects.end(),
         [gameObject](const GameObject* go) { return go->GetId() == gameObject->GetId(); });
     if (it != m_GameObjects.end()) {
+        removedGameObjectIds.push_back((*it)->GetId());
         delete *it;
         m_GameObjects.erase(it);
     }
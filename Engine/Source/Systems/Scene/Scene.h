@@ -176,6 +176,9 @@ public:
         return m_Path == other.m_Path;
     }
 
+    // Hide in API
+    std::vector<int> removedGameObjectIds; // Game objects removed since the last save. Used by incremental scene saves.
+
 private:
     std::filesystem::path m_Path;
     std::deque<GameObject*> m_GameObjects;
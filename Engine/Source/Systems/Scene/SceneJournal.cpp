@@ -0,0 +1,194 @@
+#include "SceneJournal.h"
+#include <fstream>
+#include <string>
+
+using json = nlohmann::json;
+
+static bool IsJournalRecord(const json& record)
+{
+    if (!record.is_object() || record.size() != 1)
+        return false;
+
+    if (record.contains("upsert"))
+        return record["upsert"].is_object() && record["upsert"].contains("id") && record["upsert"]["id"].is_number_integer();
+    if (record.contains("remove"))
+        return record["remove"].is_number_integer();
+    if (record.contains("commit"))
+        return record["commit"].is_number_unsigned();
+    return record.contains("begin");
+}
+
+// Returns the byte offset right after the last commit record that was completely written, or 0 if there isn't one.
+// Only lines that start like a commit record are parsed, since the upserts hold whole game objects.
+static std::uintmax_t FindCommittedJournalEnd(const std::filesystem::path& journalPath, bool& missingNewline)
+{
+    std::uintmax_t committedEnd = 0;
+    missingNewline = false;
+
+    std::ifstream journal(journalPath, std::ios::binary);
+    std::uintmax_t offset = 0;
+    std::string line;
+    while (std::getline(journal, line))
+    {
+        bool complete = !journal.eof();
+        offset += line.size() + (complete ? 1 : 0);
+
+        if (line.compare(0, 10, "{\"commit\":") != 0)
+            continue;
+
+        json record = json::parse(line, nullptr, false);
+        if (record.is_discarded() || !IsJournalRecord(record))
+            continue;
+
+        committedEnd = offset;
+        missingNewline = !complete;
+    }
+
+    return committedEnd;
+}
+
+SceneJournal SceneJournal::Read(const std::filesystem::path& journalPath)
+{
+    SceneJournal sceneJournal;
+
+    std::ifstream journal(journalPath);
+    if (!journal.is_open())
+        return sceneJournal;
+
+    // Records are grouped per save and only applied once the save's commit record is read
+    std::vector<json> pendingRecords;
+    std::string line;
+    while (std::getline(journal, line))
+    {
+        json record = json::parse(line, nullptr, false);
+        if (record.is_discarded() || !IsJournalRecord(record))
+        {
+            // The save this record belongs to was only partially written. Its commit record won't match what's left of it, so it's dropped.
+            pendingRecords.clear();
+            continue;
+        }
+
+        if (record.contains("begin"))
+        {
+            pendingRecords.clear();
+            continue;
+        }
+
+        if (!record.contains("commit"))
+        {
+            pendingRecords.push_back(std::move(record));
+            continue;
+        }
+
+        // Journals written before saves had begin records can still have an uncommitted save in front of this one, so only the last records count
+        size_t recordCount = record["commit"].get<size_t>();
+        if (recordCount <= pendingRecords.size())
+        {
+            pendingRecords.erase(pendingRecords.begin(), pendingRecords.end() - recordCount);
+            sceneJournal.Commit(pendingRecords);
+        }
+        pendingRecords.clear();
+    }
+
+    return sceneJournal;
+}
+
+bool SceneJournal::Append(const std::filesystem::path& journalPath, const std::vector<json>& records)
+{
+    std::error_code error;
+    bool missingNewline = false;
+    if (std::filesystem::exists(journalPath, error))
+    {
+        std::uintmax_t journalSize = std::filesystem::file_size(journalPath, error);
+        if (error)
+            return false;
+
+        std::uintmax_t committedEnd = FindCommittedJournalEnd(journalPath, missingNewline);
+        if (committedEnd != journalSize)
+        {
+            std::filesystem::resize_file(journalPath, committedEnd, error);
+            if (error)
+                return false;
+        }
+    }
+
+    std::ofstream journal(journalPath, std::ios::app);
+    if (missingNewline)
+        journal << '\n';
+
+    json begin;
+    begin["begin"] = records.size();
+    journal << begin.dump() << '\n';
+    for (const json& record : records)
+        journal << record.dump() << '\n';
+    json commit;
+    commit["commit"] = records.size();
+    journal << commit.dump() << '\n';
+    journal.close();
+
+    return !journal.fail();
+}
+
+void SceneJournal::Apply(json& sceneData, const std::filesystem::path& journalPath)
+{
+    SceneJournal sceneJournal = Read(journalPath);
+
+    json& gameObjects = sceneData["game_objects"];
+    if (!gameObjects.is_array())
+        gameObjects = json::array();
+
+    json appliedGameObjects = json::array();
+    for (json& gameObjectData : gameObjects)
+        if (sceneJournal.Resolve(gameObjectData))
+            appliedGameObjects.push_back(std::move(gameObjectData));
+    sceneJournal.ForEachNewGameObject([&](json& gameObjectData) { appliedGameObjects.push_back(std::move(gameObjectData)); });
+    gameObjects = std::move(appliedGameObjects);
+}
+
+bool SceneJournal::Resolve(json& gameObjectData)
+{
+    int id = gameObjectData["id"].get<int>();
+    if (removed.find(id) != removed.end())
+        return false;
+
+    auto it = upserts.find(id);
+    if (it != upserts.end())
+    {
+        gameObjectData = std::move(it->second);
+        upserts.erase(it);
+    }
+    return true;
+}
+
+void SceneJournal::ForEachNewGameObject(const std::function<void(json&)>& callback)
+{
+    for (int id : upsertOrder)
+    {
+        auto it = upserts.find(id);
+        if (it != upserts.end())
+            callback(it->second);
+    }
+    upserts.clear();
+    upsertOrder.clear();
+}
+
+void SceneJournal::Commit(std::vector<json>& records)
+{
+    for (json& record : records)
+    {
+        if (record.contains("remove"))
+        {
+            int id = record["remove"].get<int>();
+            upserts.erase(id);
+            removed.insert(id);
+        }
+        else
+        {
+            int id = record["upsert"]["id"].get<int>();
+            removed.erase(id);
+            if (upserts.find(id) == upserts.end())
+                upsertOrder.push_back(id);
+            upserts[id] = std::move(record["upsert"]);
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ThirdParty/Misc/json.hpp"
+
+// The journal incremental scene saves are appended to. Each line is a JSON record, and each save writes a begin record,
+// an upsert or remove record per changed game object, and then a commit record holding how many records the save wrote.
+class SceneJournal
+{
+public:
+    // Reads the committed saves of a journal. A save whose records were cut off or damaged is skipped and reading resumes at the next save,
+    // so an interrupted write never hides the saves that were committed after it. Replaying a journal that has already been compacted into the scene is harmless.
+    static SceneJournal Read(const std::filesystem::path& journalPath);
+    // Appends a save. Anything an interrupted save left after the last commit record is cut off first, so the new save is never appended to a torn line.
+    static bool Append(const std::filesystem::path& journalPath, const std::vector<nlohmann::json>& records);
+    // Applies the committed saves on top of the scene data
+    static void Apply(nlohmann::json& sceneData, const std::filesystem::path& journalPath);
+
+    // Replaces the game object data with its journaled version. Returns false if the game object was removed.
+    // Resolved upserts are taken out of the journal, so the ones left over afterwards are game objects that aren't in the scene file yet.
+    bool Resolve(nlohmann::json& gameObjectData);
+    // Calls the callback with each journaled game object that wasn't resolved against the scene file, in the order they were added
+    void ForEachNewGameObject(const std::function<void(nlohmann::json&)>& callback);
+
+private:
+    void Commit(std::vector<nlohmann::json>& records);
+
+    std::unordered_map<int, nlohmann::json> upserts;
+    std::vector<int> upsertOrder; // The order new game objects were added in
+    std::unordered_set<int> removed;
+};
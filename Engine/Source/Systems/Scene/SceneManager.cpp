@@ -2,11 +2,17 @@
 #include <fstream>
 #include <iomanip>
 #include "Utilities/ConsoleLogger.h"
+#include "Utilities/JsonStreamReader.h"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <chrono>
 #include "ThirdParty/Misc/json.hpp"
+#include "SceneJournal.h"
 
 #include "Components/Scripting/ScriptLoader.h"
 #include "Components/Component.h"
@@ -25,6 +31,9 @@
 #include "Components/Physics/Collider3D.h"
 #include "Components/Physics/Rigidbody3D.h"
 #endif
+#if !defined(EDITOR) && defined(IS3D)
+#include "Systems/Physics/ShapeCache.h"
+#endif
 #include "Components/Animation/AnimationPlayer.h"
 #include "Components/Audio/AudioPlayer.h"
 #include "Components/Rendering/TilemapRenderer.h"
@@ -45,6 +54,7 @@ using json = nlohmann::json;
 
 std::deque<Scene> SceneManager::m_scenes;
 Scene* SceneManager::m_activeScene;
+std::deque<std::shared_future<SceneManager::PendingSave>> SceneManager::m_pendingSaves;
 
 SceneManager::SceneManager() {
     m_activeScene = nullptr;
@@ -73,78 +83,115 @@ std::deque<Scene>* SceneManager::GetScenes() {
     return &m_scenes; 
 }
 
-bool SceneManager::SaveScene(Scene* scene)
+// Files starting with a period are hidden in the content browser
+static std::filesystem::path GetSceneJournalPath(const std::filesystem::path& scenePath)
 {
-    json sceneData;
+    return scenePath.parent_path() / ("." + scenePath.filename().string() + ".journal");
+}
 
-    // Save game objects
-    for (GameObject* object : scene->GetGameObjects())
-    {
-        json gameObjectData;
-
-        // Save texture
-        //if (object->GetTexture() != nullptr) {
-        //    gameObjectData["texture_path"] = object->GetPath();
-        //}
-
-        //gameObjectData["model_path"] = object->GetModelPath().string();
-        gameObjectData["name"] = object->GetName();
-        gameObjectData["position"] = { object->transform.GetPosition().x, object->transform.GetPosition().y, object->transform.GetPosition().z };
-        //gameObjectData["real_size"] = { object->GetRealSize().x, object->GetRealSize().y, object->GetRealSize().z };
-        gameObjectData["size"] = { object->transform.GetScale().x, object->transform.GetScale().y, object->transform.GetScale().z};
-        gameObjectData["rotation"] = { object->transform.GetRotation().x, object->transform.GetRotation().y, object->transform.GetRotation().z, object->transform.GetRotation().w };
-        gameObjectData["id"] = object->GetId();
-        gameObjectData["active"] = object->IsActive();
-        gameObjectData["globalActive"] = object->IsGlobalActive();
-
-        //gameObjectData["tint"] = { object->GetTint().Value.x, object->GetTint().Value.y, object->GetTint().Value.z, object->GetTint().Value.w };
-        //gameObjectData["z_order"] = object->GetZOrder();
-
-        if (object->GetParent() != nullptr)
-            gameObjectData["parent_id"] = object->GetParent()->GetId();
-        else
-            gameObjectData["parent_id"] = -1;
+static std::filesystem::path GetSceneTempPath(const std::filesystem::path& scenePath)
+{
+    return scenePath.parent_path() / ("." + scenePath.filename().string() + ".tmp");
+}
 
-        // Save components
-        json componentsData;
-        for (Component* component : object->GetComponents())
-        {
-            json componentData;
-            componentData["name"] = component->name;
-            componentData["active"] = component->IsActive();
-            componentData["id"] = component->id;
-            #if defined(EDITOR)
-            componentData["exposed_variables"] = component->exposedVariables;
-            #endif
-            //componentData["runInEditor"] = component->runInEditor;
+static json SerializeGameObject(GameObject* object, const std::filesystem::path& scenePath)
+{
+    json gameObjectData;
 
-            // Temporary solution
-            // Todo: maybe put these in Exposed Variables (but not visible in Properties), or something similar to ExposedVariables like SerializedVariables
-            if (dynamic_cast<MeshRenderer*>(component))
-            {
-                componentData["model_path"] = dynamic_cast<MeshRenderer*>(component)->GetModelPath();
-            }
-			else if (dynamic_cast<Terrain*>(component))
-			{
-				componentData["data"] = dynamic_cast<Terrain*>(component)->SerializeTerrainData();
-			}
-            else if (dynamic_cast<ScriptComponent*>(component))
-            {
-                auto formatPathForUnix = [](std::string path) {
-                    std::replace(path.begin(), path.end(), '\\', '/');
-                    return path;
-                };
+    // Save texture
+    //if (object->GetTexture() != nullptr) {
+    //    gameObjectData["texture_path"] = object->GetPath();
+    //}
 
-                componentData["cpp_path"] = formatPathForUnix(dynamic_cast<ScriptComponent*>(component)->GetCppPath().string());
-                componentData["header_path"] = formatPathForUnix(dynamic_cast<ScriptComponent*>(component)->GetHeaderPath().string());
-            }
+    //gameObjectData["model_path"] = object->GetModelPath().string();
+    gameObjectData["name"] = object->GetName();
+    gameObjectData["position"] = { object->transform.GetPosition().x, object->transform.GetPosition().y, object->transform.GetPosition().z };
+    //gameObjectData["real_size"] = { object->GetRealSize().x, object->GetRealSize().y, object->GetRealSize().z };
+    gameObjectData["size"] = { object->transform.GetScale().x, object->transform.GetScale().y, object->transform.GetScale().z};
+    gameObjectData["rotation"] = { object->transform.GetRotation().x, object->transform.GetRotation().y, object->transform.GetRotation().z, object->transform.GetRotation().w };
+    gameObjectData["id"] = object->GetId();
+    gameObjectData["active"] = object->IsActive();
+    gameObjectData["globalActive"] = object->IsGlobalActive();
+
+    //gameObjectData["tint"] = { object->GetTint().Value.x, object->GetTint().Value.y, object->GetTint().Value.z, object->GetTint().Value.w };
+    //gameObjectData["z_order"] = object->GetZOrder();
+
+    if (object->GetParent() != nullptr)
+        gameObjectData["parent_id"] = object->GetParent()->GetId();
+    else
+        gameObjectData["parent_id"] = -1;
 
-            componentsData.push_back(componentData);
+    // Save components
+    json componentsData;
+    for (Component* component : object->GetComponents())
+    {
+        json componentData;
+        componentData["name"] = component->name;
+        componentData["active"] = component->IsActive();
+        componentData["id"] = component->id;
+        #if defined(EDITOR)
+        componentData["exposed_variables"] = component->exposedVariables;
+        #endif
+        //componentData["runInEditor"] = component->runInEditor;
+
+        // Temporary solution
+        // Todo: maybe put these in Exposed Variables (but not visible in Properties), or something similar to ExposedVariables like SerializedVariables
+        if (dynamic_cast<MeshRenderer*>(component))
+        {
+            componentData["model_path"] = dynamic_cast<MeshRenderer*>(component)->GetModelPath();
+        }
+        else if (dynamic_cast<Terrain*>(component))
+        {
+            componentData["data"] = dynamic_cast<Terrain*>(component)->SerializeTerrainData(scenePath);
         }
-        gameObjectData["components"] = componentsData;
+        else if (dynamic_cast<ScriptComponent*>(component))
+        {
+            auto formatPathForUnix = [](std::string path) {
+                std::replace(path.begin(), path.end(), '\\', '/');
+                return path;
+            };
+
+            componentData["cpp_path"] = formatPathForUnix(dynamic_cast<ScriptComponent*>(component)->GetCppPath().string());
+            componentData["header_path"] = formatPathForUnix(dynamic_cast<ScriptComponent*>(component)->GetHeaderPath().string());
+        }
+
+        componentsData.push_back(componentData);
+    }
+    gameObjectData["components"] = componentsData;
+
+    return gameObjectData;
+}
+
+// Writes to a temporary file first and renames it over the scene so an interrupted write never leaves a partial scene behind
+static bool WriteSceneFile(const json& sceneData, const std::filesystem::path& scenePath)
+{
+    std::filesystem::path tempPath = GetSceneTempPath(scenePath);
+    std::ofstream file(tempPath);
+    file << std::setw(4) << sceneData << std::endl;
+    file.close();
+
+    std::error_code error;
+    if (file.fail())
+    {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    std::filesystem::rename(tempPath, scenePath, error);
+    return !error;
+}
 
+bool SceneManager::SaveScene(Scene* scene)
+{
+    WaitForPendingSaves();
+
+    json sceneData;
+
+    // Save game objects
+    for (GameObject* object : scene->GetGameObjects())
+    {
         // Add game object data to scene data
-        sceneData["game_objects"].push_back(gameObjectData);
+        sceneData["game_objects"].push_back(SerializeGameObject(object, scene->GetPath()));
     }
 
     //std::cout << sceneData.dump(4) << std::endl;
@@ -165,7 +212,8 @@ bool SceneManager::SaveScene(Scene* scene)
     if (!std::filesystem::exists(scene->GetPath().parent_path()))
         std::filesystem::create_directories(scene->GetPath().parent_path());
 
-    std::ofstream file(formattedPath);
+    // Written to a temporary file which replaces the scene once the write succeeded
+    std::ofstream file(GetSceneTempPath(formattedPath));
     file << std::setw(4) << sceneData << std::endl;
     file.close();
 
@@ -203,12 +251,179 @@ bool SceneManager::SaveScene(Scene* scene)
 #endif
             ConsoleLogger::WarningLog("The scene \"" + scene->GetPath().stem().string() + "\" failed to save. Error: " + std::string(errorMessage));
         }
+        std::error_code error;
+        std::filesystem::remove(GetSceneTempPath(formattedPath), error);
         return false;
     }
+
+    std::error_code error;
+    std::filesystem::rename(GetSceneTempPath(formattedPath), formattedPath, error);
+    if (error)
+    {
+        ConsoleLogger::ErrorLog("The scene \"" + scene->GetPath().stem().string() + "\" failed to save. Error: " + error.message());
+        return false;
+    }
+
+    // The scene file now contains every change, so the journal and the terrain data files it referenced are no longer needed
+    std::filesystem::remove(GetSceneJournalPath(formattedPath), error);
+    for (GameObject* object : scene->GetGameObjects())
+    {
+        object->dirty = false;
+        for (Component* component : object->GetComponents())
+            if (Terrain* terrain = dynamic_cast<Terrain*>(component))
+                terrain->RemoveStaleTerrainDataFiles(scene->GetPath());
+    }
+    scene->removedGameObjectIds.clear();
+
     ConsoleLogger::InfoLog("The scene \"" + scene->GetPath().stem().string() + "\" has been saved");
     return true;
 }
 
+bool SceneManager::SaveSceneIncremental(Scene* scene, std::function<void(bool saved)> onFinished)
+{
+    std::filesystem::path scenePath = scene->GetPath();
+
+    // The journal is applied on top of the scene file, so the first save must be a full one
+    if (!std::filesystem::exists(scenePath))
+    {
+        bool saved = SaveScene(scene);
+        if (onFinished)
+            onFinished(saved);
+        return saved;
+    }
+
+    ReportFinishedSaves();
+
+    // Only the changed game objects are snapshotted here. Writing and compacting happens on the save thread.
+    // The objects are marked clean now so changes made while the save is written are picked up by the next one. ReportSave() marks them again if the write fails.
+    PendingSave save;
+    save.scenePath = scenePath;
+    save.onFinished = std::move(onFinished);
+    std::vector<json> records;
+    for (int id : scene->removedGameObjectIds)
+    {
+        json record;
+        record["remove"] = id;
+        records.push_back(std::move(record));
+    }
+    save.removedIds = std::move(scene->removedGameObjectIds);
+    scene->removedGameObjectIds.clear();
+
+    for (GameObject* object : scene->GetGameObjects())
+    {
+        if (!object->dirty)
+            continue;
+
+        json record;
+        record["upsert"] = SerializeGameObject(object, scenePath);
+        records.push_back(std::move(record));
+        save.savedIds.push_back(object->GetId());
+        object->dirty = false;
+    }
+
+    if (records.empty() && m_pendingSaves.empty())
+    {
+        if (save.onFinished)
+            save.onFinished(true);
+        return true;
+    }
+
+    std::shared_future<PendingSave> previousSave = m_pendingSaves.empty() ? std::shared_future<PendingSave>() : m_pendingSaves.back();
+    m_pendingSaves.push_back(std::async(std::launch::async, [previousSave, save = std::move(save), records = std::move(records)]() mutable -> PendingSave {
+        // Saves must be appended in the order they were made
+        if (previousSave.valid())
+            previousSave.wait();
+
+        // Nothing changed since the save still being written, so this one succeeds if that one does
+        if (records.empty())
+        {
+            save.written = previousSave.get().written;
+            return save;
+        }
+
+        std::filesystem::path journalPath = GetSceneJournalPath(save.scenePath);
+        if (!SceneJournal::Append(journalPath, records))
+        {
+            save.error = "The scene \"" + save.scenePath.stem().string() + "\" failed to save. Unable to write to the scene journal at \"" + journalPath.string() + "\"";
+            return save;
+        }
+        save.written = true;
+
+        // Compact the journal into the scene file once it has grown large compared to the scene
+        std::error_code error;
+        std::uintmax_t journalSize = std::filesystem::file_size(journalPath, error);
+        std::uintmax_t sceneSize = std::filesystem::file_size(save.scenePath, error);
+        if (error || journalSize < std::max<std::uintmax_t>(sceneSize / 4, 1024 * 1024))
+            return save;
+
+        std::ifstream sceneFile(save.scenePath);
+        json sceneData = json::parse(sceneFile, nullptr, false);
+        sceneFile.close();
+        if (sceneData.is_discarded())
+        {
+            save.error = "Failed to compact the scene \"" + save.scenePath.stem().string() + "\". The scene file could not be parsed.";
+            return save;
+        }
+
+        SceneJournal::Apply(sceneData, journalPath);
+        if (!WriteSceneFile(sceneData, save.scenePath))
+        {
+            save.error = "Failed to compact the scene \"" + save.scenePath.stem().string() + "\". The changes are still stored in its journal.";
+            return save;
+        }
+
+        std::filesystem::remove(journalPath, error);
+        return save;
+    }).share());
+
+    return true;
+}
+
+void SceneManager::ReportFinishedSaves()
+{
+    // Saves finish in the order they were made, so the first unfinished one ends the finished ones
+    while (!m_pendingSaves.empty() && m_pendingSaves.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        ReportSave(m_pendingSaves.front().get());
+        m_pendingSaves.pop_front();
+    }
+}
+
+void SceneManager::WaitForPendingSaves()
+{
+    while (!m_pendingSaves.empty())
+    {
+        ReportSave(m_pendingSaves.front().get());
+        m_pendingSaves.pop_front();
+    }
+}
+
+void SceneManager::ReportSave(const PendingSave& save)
+{
+    if (!save.error.empty())
+        ConsoleLogger::ErrorLog(save.error);
+
+    if (save.onFinished)
+        save.onFinished(save.written);
+
+    if (save.written)
+        return;
+
+    // The changes never reached the journal, so they're marked to be written by the next save
+    for (Scene& scene : m_scenes)
+    {
+        if (scene.GetPath() != save.scenePath)
+            continue;
+
+        for (GameObject* object : scene.GetGameObjects())
+            if (std::find(save.savedIds.begin(), save.savedIds.end(), object->GetId()) != save.savedIds.end())
+                object->dirty = true;
+        for (int id : save.removedIds)
+            if (std::find(scene.removedGameObjectIds.begin(), scene.removedGameObjectIds.end(), id) == scene.removedGameObjectIds.end())
+                scene.removedGameObjectIds.push_back(id);
+    }
+}
+
 bool SceneManager::LoadScene(std::filesystem::path filePath)
 {
     if (!std::filesystem::exists(filePath) || filePath.extension() != ".scene")
@@ -223,20 +438,8 @@ bool SceneManager::LoadScene(std::filesystem::path filePath)
 
     // Todo: Check if the scene is already loaded
 
-    // Load file into string
-    std::ifstream file(filePathString);
-    if (!file.is_open()) {
-        ConsoleLogger::WarningLog("Can not open the scene \"" + filePath.stem().string() + "\" at the path \"" + filePath.string() + "\"");
-        return false;
-    }
-    std::stringstream fileStream;
-    fileStream << file.rdbuf();
-    file.close();
-
-    //ConsoleLogger::InfoLog(fileStream.str());
-
-    // Parse JSON data
-    json sceneData = json::parse(fileStream.str());
+    // Make sure a save to this scene isn't still being written
+    WaitForPendingSaves();
 
     // Create new scene
     Scene scene = Scene(filePath, {});
@@ -267,8 +470,8 @@ bool SceneManager::LoadScene(std::filesystem::path filePath)
 #endif
     };
 
-    // Create game objects
-    for (const auto& gameObjectData : sceneData["game_objects"])
+    // Creates a game object from its data
+    auto loadGameObject = [&](const json& gameObjectData)
     {
         // Create new game object
         GameObject* gameObject = scene.AddGameObject(gameObjectData["id"]);
@@ -338,7 +541,7 @@ bool SceneManager::LoadScene(std::filesystem::path filePath)
 			{
 				Terrain& component = gameObject->AddComponentInternal<Terrain>(componentData["id"]);
 				setExposedVariables(component, componentData);
-                component.LoadTerrainData(componentData["data"]);
+                component.LoadTerrainData(componentData["data"], filePath);
 			}
             else if (componentData["name"] == "CameraComponent")
             {
@@ -444,7 +647,32 @@ bool SceneManager::LoadScene(std::filesystem::path filePath)
 
         // Add game object to scene
         //scene.AddGameObject();
+    };
+
+    // Game objects changed or removed by incremental saves that haven't been compacted into the scene file yet are taken from the journal
+    SceneJournal sceneJournal = SceneJournal::Read(GetSceneJournalPath(filePathString));
+
+#if !defined(EDITOR) && defined(IS3D)
+    Rigidbody3D::BeginBodyBatch();
+#endif
+
+    // The game objects are streamed from the file and created one at a time, so the whole scene is never held in memory as a json tree
+    JsonStreamReader sceneReader({ { "game_objects", [&](json& gameObjectData) {
+        if (sceneJournal.Resolve(gameObjectData))
+            loadGameObject(gameObjectData);
+    } } });
+    if (!sceneReader.ParseFile(filePathString))
+    {
+        ConsoleLogger::ErrorLog("Failed to load the scene \"" + filePath.stem().string() + "\". " + sceneReader.GetError());
+        std::deque<GameObject*> loadedGameObjects = scene.GetGameObjects();
+        for (GameObject* gameObject : loadedGameObjects)
+            scene.RemoveGameObject(gameObject);
+#if !defined(EDITOR) && defined(IS3D)
+        Rigidbody3D::EndBodyBatch();
+#endif
+        return false;
     }
+    sceneJournal.ForEachNewGameObject(loadGameObject);
 
     // Moved this below
     //for (GameObject* gameObject : scene.GetGameObjects())
@@ -478,6 +706,10 @@ bool SceneManager::LoadScene(std::filesystem::path filePath)
                 component->gameObject = gameObject;
     }
 
+#if !defined(EDITOR) && defined(IS3D)
+    Collider3D::BeginStaticMerge();
+#endif
+
     for (GameObject* gameObject : scene.GetGameObjects())
     {
         // Set parents
@@ -489,6 +721,9 @@ bool SceneManager::LoadScene(std::filesystem::path filePath)
                     break;
                 }
 
+        // Nothing has changed since the scene was loaded
+        gameObject->dirty = false;
+
 #if !defined(EDITOR)
         if (!gameObject->IsActive() || !gameObject->IsGlobalActive())
             continue;
@@ -502,6 +737,11 @@ bool SceneManager::LoadScene(std::filesystem::path filePath)
 #endif
     }
 
+#if !defined(EDITOR) && defined(IS3D)
+    Collider3D::MergeStaticColliders();
+    Rigidbody3D::EndBodyBatch();
+#endif
+
     ConsoleLogger::InfoLog("The scene \"" + filePath.stem().string() + "\" has been loaded");
 
     return true;
@@ -513,6 +753,11 @@ void SceneManager::UnloadScene(Scene* scene)
     for (GameObject* gameObject : gameObjectsCopy)
         scene->RemoveGameObject(gameObject);
 
+#if !defined(EDITOR) && defined(IS3D)
+    // Shapes only the unloaded scene used aren't kept around
+    ShapeCache::ReleaseUnused();
+#endif
+
     auto it = std::find_if(m_scenes.begin(), m_scenes.end(), [scene](const Scene& s) { return *scene == s; });
     if (it != m_scenes.end())
         m_scenes.erase(it);
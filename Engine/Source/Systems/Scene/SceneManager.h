@@ -1,6 +1,11 @@
 #pragma once
 
 #include "Scene.h"
+#include <functional>
+#include <future>
+#include <string>
+#include <deque>
+#include <vector>
 
 class SceneManager {
 public:
@@ -9,6 +14,15 @@ public:
     static void SetActiveScene(Scene* scene);
     static std::deque<Scene>* GetScenes();
     static bool SaveScene(Scene* scene);
+    // Hide in API
+    // Appends the game objects that changed since the last save to the scene's journal on a background thread. The journal is compacted into the scene file once it grows too large.
+    // onFinished is called on the main thread by ReportFinishedSaves() once the changes are written, with whether they were.
+    static bool SaveSceneIncremental(Scene* scene, std::function<void(bool saved)> onFinished = nullptr);
+    // Hide in API
+    // Reports the saves that finished on the save thread. Called every frame, so results are shown when the save is written rather than at the next save.
+    static void ReportFinishedSaves();
+    // Hide in API
+    static void WaitForPendingSaves();
     static bool LoadScene(std::filesystem::path filePath); // Todo: Should this return the scene?
     static void UnloadScene(Scene* scene);
     static void AddScene(Scene scene);
@@ -19,6 +33,19 @@ public:
 private:
     static std::deque<Scene> m_scenes;
     static Scene* m_activeScene;
+
+    // An incremental save running on the save thread
+    struct PendingSave
+    {
+        std::filesystem::path scenePath;
+        std::vector<int> savedIds;
+        std::vector<int> removedIds;
+        bool written = false; // Whether the changes reached the journal. If not they're marked to be saved again.
+        std::string error;
+        std::function<void(bool saved)> onFinished;
+    };
+    static std::deque<std::shared_future<PendingSave>> m_pendingSaves; // In the order the saves were made
+    static void ReportSave(const PendingSave& save);
 };
 
 
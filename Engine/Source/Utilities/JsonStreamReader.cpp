@@ -0,0 +1,196 @@
+#include "Utilities/JsonStreamReader.h"
+#include "Utilities/MappedFile.h"
+#include <fstream>
+#include <sstream>
+
+JsonStreamReader::JsonStreamReader(std::unordered_map<std::string, ElementCallback> arrayCallbacks)
+	: arrayCallbacks(std::move(arrayCallbacks))
+{
+}
+
+bool JsonStreamReader::ParseFile(const std::filesystem::path& path)
+{
+	MappedFile file;
+	if (file.Open(path))
+		return Parse(file.GetData(), file.GetData() + file.GetSize());
+
+	// Mapping failed, read the file into memory instead
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream.is_open())
+	{
+		error = "Unable to open " + path.string();
+		return false;
+	}
+	std::stringstream buffer;
+	buffer << stream.rdbuf();
+	std::string contents = buffer.str();
+	return Parse(contents.data(), contents.data() + contents.size());
+}
+
+bool JsonStreamReader::Parse(const char* begin, const char* end)
+{
+	remainder = nullptr;
+	element = nullptr;
+	containers.clear();
+	activeCallback = nullptr;
+	error.clear();
+
+	if (begin == nullptr || begin == end)
+	{
+		error = "The file is empty";
+		return false;
+	}
+
+	try
+	{
+		return nlohmann::json::sax_parse(begin, end, this);
+	}
+	catch (const std::exception& e)
+	{
+		error = e.what();
+		return false;
+	}
+}
+
+nlohmann::json& JsonStreamReader::GetRemainder()
+{
+	return remainder;
+}
+
+const std::string& JsonStreamReader::GetError() const
+{
+	return error;
+}
+
+nlohmann::json* JsonStreamReader::Insert(nlohmann::json&& value)
+{
+	if (containers.empty())
+	{
+		remainder = std::move(value);
+		return &remainder;
+	}
+
+	// Direct child of a streamed array
+	if (activeCallback && containers.size() == 1)
+	{
+		element = std::move(value);
+		return &element;
+	}
+
+	nlohmann::json* parent = containers.back();
+	if (parent->is_array())
+	{
+		parent->push_back(std::move(value));
+		return &parent->back();
+	}
+
+	nlohmann::json& child = (*parent)[pendingKey];
+	child = std::move(value);
+	return &child;
+}
+
+bool JsonStreamReader::ElementFinished()
+{
+	if (activeCallback && containers.size() == 1)
+	{
+		(*activeCallback)(element);
+		element = nullptr;
+	}
+	return true;
+}
+
+bool JsonStreamReader::null()
+{
+	Insert(nullptr);
+	return ElementFinished();
+}
+
+bool JsonStreamReader::boolean(bool value)
+{
+	Insert(value);
+	return ElementFinished();
+}
+
+bool JsonStreamReader::number_integer(number_integer_t value)
+{
+	Insert(value);
+	return ElementFinished();
+}
+
+bool JsonStreamReader::number_unsigned(number_unsigned_t value)
+{
+	Insert(value);
+	return ElementFinished();
+}
+
+bool JsonStreamReader::number_float(number_float_t value, const string_t& text)
+{
+	Insert(value);
+	return ElementFinished();
+}
+
+bool JsonStreamReader::string(string_t& value)
+{
+	Insert(std::move(value));
+	return ElementFinished();
+}
+
+bool JsonStreamReader::binary(binary_t& value)
+{
+	Insert(nlohmann::json::binary(std::move(value)));
+	return ElementFinished();
+}
+
+bool JsonStreamReader::start_object(std::size_t elements)
+{
+	containers.push_back(Insert(nlohmann::json::object()));
+	return true;
+}
+
+bool JsonStreamReader::key(string_t& value)
+{
+	pendingKey = std::move(value);
+	return true;
+}
+
+bool JsonStreamReader::end_object()
+{
+	containers.pop_back();
+	return ElementFinished();
+}
+
+bool JsonStreamReader::start_array(std::size_t elements)
+{
+	// Arrays of the root object with a callback are streamed instead of built
+	if (!activeCallback && containers.size() == 1 && containers.back()->is_object())
+	{
+		auto it = arrayCallbacks.find(pendingKey);
+		if (it != arrayCallbacks.end())
+		{
+			activeCallback = &it->second;
+			return true;
+		}
+	}
+
+	containers.push_back(Insert(nlohmann::json::array()));
+	return true;
+}
+
+bool JsonStreamReader::end_array()
+{
+	// The streamed array itself was never added to the containers
+	if (activeCallback && containers.size() == 1)
+	{
+		activeCallback = nullptr;
+		return true;
+	}
+
+	containers.pop_back();
+	return ElementFinished();
+}
+
+bool JsonStreamReader::parse_error(std::size_t position, const std::string& lastToken, const nlohmann::detail::exception& exception)
+{
+	error = exception.what();
+	return false;
+}
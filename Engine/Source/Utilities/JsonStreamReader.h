@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <filesystem>
+#include "ThirdParty/Misc/json.hpp"
+
+// SAX based JSON reader. Elements of the root object's arrays that have a callback are built and passed to the callback one at a time,
+// then freed, so a large array never needs to be held in memory as a whole. Everything else is built into GetRemainder() like a normal parse.
+class JsonStreamReader : public nlohmann::json_sax<nlohmann::json>
+{
+public:
+	using ElementCallback = std::function<void(nlohmann::json& element)>;
+
+	JsonStreamReader(std::unordered_map<std::string, ElementCallback> arrayCallbacks = {});
+
+	// Parses the file from a memory mapping. Returns false if the file couldn't be opened or isn't valid JSON. Exceptions thrown by callbacks are caught and reported as errors.
+	bool ParseFile(const std::filesystem::path& path);
+	bool Parse(const char* begin, const char* end);
+
+	nlohmann::json& GetRemainder();
+	const std::string& GetError() const;
+
+	bool null() override;
+	bool boolean(bool value) override;
+	bool number_integer(number_integer_t value) override;
+	bool number_unsigned(number_unsigned_t value) override;
+	bool number_float(number_float_t value, const string_t& text) override;
+	bool string(string_t& value) override;
+	bool binary(binary_t& value) override;
+	bool start_object(std::size_t elements) override;
+	bool key(string_t& value) override;
+	bool end_object() override;
+	bool start_array(std::size_t elements) override;
+	bool end_array() override;
+	bool parse_error(std::size_t position, const std::string& lastToken, const nlohmann::detail::exception& exception) override;
+
+private:
+	nlohmann::json* Insert(nlohmann::json&& value);
+	bool ElementFinished();
+
+	std::unordered_map<std::string, ElementCallback> arrayCallbacks;
+	ElementCallback* activeCallback = nullptr; // Set while inside a streamed array
+
+	nlohmann::json remainder;
+	nlohmann::json element; // The streamed element currently being built
+	std::vector<nlohmann::json*> containers; // Open objects and arrays. The root object is always first.
+	std::string pendingKey;
+	std::string error;
+};
@@ -0,0 +1,123 @@
+#include "Utilities/MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::filesystem::path& path)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	size = static_cast<size_t>(fileSize.QuadPart);
+	open = true;
+
+	if (size == 0) // Empty files can't be mapped
+		return true;
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+	mappingHandle = mapping;
+
+	data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (data == nullptr)
+	{
+		Close();
+		return false;
+	}
+#else
+	int file = ::open(path.c_str(), O_RDONLY);
+	if (file == -1)
+		return false;
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) == -1)
+	{
+		::close(file);
+		return false;
+	}
+
+	size = static_cast<size_t>(fileStat.st_size);
+	open = true;
+
+	if (size > 0)
+	{
+		void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (mapped == MAP_FAILED)
+		{
+			::close(file);
+			size = 0;
+			open = false;
+			return false;
+		}
+		data = static_cast<const char*>(mapped);
+		madvise(mapped, size, MADV_SEQUENTIAL);
+	}
+
+	::close(file); // The mapping stays valid after the descriptor is closed
+#endif
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (mappingHandle)
+		CloseHandle(mappingHandle);
+	if (fileHandle)
+		CloseHandle(fileHandle);
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+#else
+	if (data)
+		munmap(const_cast<char*>(data), size);
+#endif
+
+	data = nullptr;
+	size = 0;
+	open = false;
+}
+
+bool MappedFile::IsOpen() const
+{
+	return open;
+}
+
+const char* MappedFile::GetData() const
+{
+	return data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return size;
+}
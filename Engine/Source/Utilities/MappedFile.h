@@ -0,0 +1,30 @@
+#pragma once
+
+#include <filesystem>
+#include <cstddef>
+
+// Read-only memory mapped file. Lets large files be parsed in place without copying them into a buffer first.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::filesystem::path& path);
+	void Close();
+	bool IsOpen() const;
+
+	const char* GetData() const;
+	size_t GetSize() const;
+
+private:
+	const char* data = nullptr;
+	size_t size = 0;
+	bool open = false;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,151 @@
+// Compares loading a scene's bodies one at a time through the locking BodyInterface, the way Rigidbody3D and Collider3D used to, against
+// creating them first and adding them in one batch per activation mode followed by OptimizeBroadPhase(), the way Rigidbody3D::EndBodyBatch() does.
+// Reports the load time and the time of the first steps after loading, which pay for an unbalanced broad phase.
+// Needs Jolt v5.2.0, the version Build/3D/CMakeLists.txt fetches. Build and run from the repository root, with JOLT set to its checkout and JOLT_LIB to the folder libJolt.a was built into:
+//   g++ -std=c++17 -O2 -I$JOLT Tests/BodyBatchBenchmark.cpp -L$JOLT_LIB -lJolt -pthread -o BodyBatchBenchmark && ./BodyBatchBenchmark
+
+#include <Jolt/Jolt.h>
+#include <Jolt/RegisterTypes.h>
+#include <Jolt/Core/Factory.h>
+#include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <Jolt/Physics/Collision/Shape/SphereShape.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const JPH::ObjectLayer nonMovingLayer = 0;
+static const JPH::ObjectLayer movingLayer = 1;
+
+class BroadPhaseLayers final : public JPH::BroadPhaseLayerInterface
+{
+public:
+    unsigned int GetNumBroadPhaseLayers() const override { return 2; }
+    JPH::BroadPhaseLayer GetBroadPhaseLayer(JPH::ObjectLayer inLayer) const override { return JPH::BroadPhaseLayer(static_cast<JPH::BroadPhaseLayer::Type>(inLayer)); }
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+    const char* GetBroadPhaseLayerName(JPH::BroadPhaseLayer inLayer) const override { return inLayer == JPH::BroadPhaseLayer(0) ? "NON_MOVING" : "MOVING"; }
+#endif
+};
+
+class ObjectVsBroadPhaseFilter final : public JPH::ObjectVsBroadPhaseLayerFilter
+{
+public:
+    bool ShouldCollide(JPH::ObjectLayer inLayer1, JPH::BroadPhaseLayer inLayer2) const override { return inLayer1 == movingLayer || inLayer2 == JPH::BroadPhaseLayer(movingLayer); }
+};
+
+class ObjectPairFilter final : public JPH::ObjectLayerPairFilter
+{
+public:
+    bool ShouldCollide(JPH::ObjectLayer inObject1, JPH::ObjectLayer inObject2) const override { return inObject1 == movingLayer || inObject2 == movingLayer; }
+};
+
+static const int staticBodyCount = 15000;
+static const int dynamicBodyCount = 5000;
+
+// A level of static walls and props with dynamic crates and balls resting among them
+static std::vector<JPH::BodyCreationSettings> CreateLevel()
+{
+    JPH::RefConst<JPH::Shape> wall = new JPH::BoxShape(JPH::Vec3(1.0f, 2.0f, 0.25f));
+    JPH::RefConst<JPH::Shape> crate = new JPH::BoxShape(JPH::Vec3(0.4f, 0.4f, 0.4f));
+    JPH::RefConst<JPH::Shape> ball = new JPH::SphereShape(0.3f);
+
+    std::vector<JPH::BodyCreationSettings> level;
+    for (int i = 0; i < staticBodyCount; i++)
+    {
+        JPH::RVec3 position(static_cast<float>(i % 150) * 3.0f, 2.0f, static_cast<float>(i / 150) * 3.0f);
+        level.emplace_back(wall, position, JPH::Quat::sRotation(JPH::Vec3::sAxisY(), (i % 4) * 0.785f), JPH::EMotionType::Static, nonMovingLayer);
+    }
+    for (int i = 0; i < dynamicBodyCount; i++)
+    {
+        JPH::RVec3 position(static_cast<float>(i % 100) * 4.5f + 1.5f, 0.5f, static_cast<float>(i / 100) * 6.0f + 1.5f);
+        level.emplace_back(i % 2 == 0 ? crate : ball, position, JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, movingLayer);
+    }
+    return level;
+}
+
+struct Result
+{
+    double loadMilliseconds = 0.0;
+    double stepMilliseconds = 0.0;
+};
+
+static Result Run(bool batched, const std::vector<JPH::BodyCreationSettings>& level, JPH::TempAllocator& tempAllocator, JPH::JobSystem& jobSystem)
+{
+    BroadPhaseLayers broadPhaseLayers;
+    ObjectVsBroadPhaseFilter objectVsBroadPhaseFilter;
+    ObjectPairFilter objectPairFilter;
+    JPH::PhysicsSystem physicsSystem;
+    physicsSystem.Init(32768, 0, 32768, 32768, broadPhaseLayers, objectVsBroadPhaseFilter, objectPairFilter);
+    JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
+
+    Result result;
+    auto start = std::chrono::steady_clock::now();
+    if (batched)
+    {
+        // Indexed by JPH::EActivation, like Rigidbody3D's pending bodies
+        std::vector<JPH::BodyID> pendingBodies[2];
+        for (const JPH::BodyCreationSettings& settings : level)
+        {
+            JPH::Body* body = bodyInterface.CreateBody(settings);
+            JPH::EActivation activation = settings.mMotionType == JPH::EMotionType::Static ? JPH::EActivation::DontActivate : JPH::EActivation::Activate;
+            pendingBodies[static_cast<int>(activation)].push_back(body->GetID());
+        }
+        for (int activation = 0; activation < 2; activation++)
+        {
+            std::vector<JPH::BodyID>& bodies = pendingBodies[activation];
+            if (bodies.empty())
+                continue;
+            JPH::BodyInterface::AddState state = bodyInterface.AddBodiesPrepare(bodies.data(), static_cast<int>(bodies.size()));
+            bodyInterface.AddBodiesFinalize(bodies.data(), static_cast<int>(bodies.size()), state, static_cast<JPH::EActivation>(activation));
+        }
+        physicsSystem.OptimizeBroadPhase();
+    }
+    else
+    {
+        for (const JPH::BodyCreationSettings& settings : level)
+        {
+            JPH::EActivation activation = settings.mMotionType == JPH::EMotionType::Static ? JPH::EActivation::DontActivate : JPH::EActivation::Activate;
+            bodyInterface.CreateAndAddBody(settings, activation);
+        }
+    }
+    result.loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; i++)
+        physicsSystem.Update(1.0f / 60.0f, 1, &tempAllocator, &jobSystem);
+    result.stepMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+static void Print(const std::string& name, const Result& result)
+{
+    std::cout << name << ": loaded in " << result.loadMilliseconds << " ms, first 10 steps in " << result.stepMilliseconds << " ms" << std::endl;
+}
+
+int main()
+{
+    JPH::RegisterDefaultAllocator();
+    JPH::Factory::sInstance = new JPH::Factory();
+    JPH::RegisterTypes();
+
+    {
+        JPH::TempAllocatorImpl tempAllocator(64 * 1024 * 1024);
+        JPH::JobSystemThreadPool jobSystem(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+        std::vector<JPH::BodyCreationSettings> level = CreateLevel();
+
+        std::cout << staticBodyCount + dynamicBodyCount << " bodies, " << dynamicBodyCount << " of them dynamic" << std::endl;
+        Print("One at a time", Run(false, level, tempAllocator, jobSystem));
+        Print("Batched", Run(true, level, tempAllocator, jobSystem));
+    }
+
+    JPH::UnregisterTypes();
+    delete JPH::Factory::sInstance;
+    JPH::Factory::sInstance = nullptr;
+    return 0;
+}
@@ -0,0 +1,216 @@
+// Counts the body pairs Jolt hands to the narrow phase in a scene with debris, characters and triggers, with the two hardcoded layers
+// Game.cpp used to have against the project collision layers and matrix it has now. Also reports the step time of each.
+// Needs Jolt v5.2.0, the version Build/3D/CMakeLists.txt fetches. Build and run from the repository root, with JOLT set to its checkout and JOLT_LIB to the folder libJolt.a was built into:
+//   g++ -std=c++17 -O2 -I$JOLT -IEngine/Source Tests/CollisionLayerBenchmark.cpp Engine/Source/Systems/Physics/CollisionLayers.cpp -L$JOLT_LIB -lJolt -pthread -o CollisionLayerBenchmark && ./CollisionLayerBenchmark
+
+#include <Jolt/Jolt.h>
+#include <Jolt/RegisterTypes.h>
+#include <Jolt/Core/Factory.h>
+#include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <Jolt/Physics/Collision/Shape/SphereShape.h>
+#include <Jolt/Physics/Collision/Shape/CapsuleShape.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include "Systems/Physics/CollisionLayers.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The object layer encoding from Rigidbody3D.h: how the body moves in the low 2 bits and the collision layer above them
+namespace Layers
+{
+    static constexpr JPH::ObjectLayer NON_MOVING = 0;
+    static constexpr JPH::ObjectLayer MOVING = 1;
+    static constexpr JPH::ObjectLayer SENSOR = 2;
+
+    inline JPH::ObjectLayer Get(int collisionLayer, JPH::ObjectLayer motion) { return static_cast<JPH::ObjectLayer>((collisionLayer << 2) | motion); }
+    inline JPH::ObjectLayer GetMotion(JPH::ObjectLayer layer) { return layer & 3; }
+    inline int GetCollisionLayer(JPH::ObjectLayer layer) { return layer >> 2; }
+};
+
+static std::atomic<int> pairTests{ 0 };
+
+// Before: NON_MOVING and MOVING only, with every moving body tested against everything
+class OldBroadPhaseLayers final : public JPH::BroadPhaseLayerInterface
+{
+public:
+    unsigned int GetNumBroadPhaseLayers() const override { return 2; }
+    JPH::BroadPhaseLayer GetBroadPhaseLayer(JPH::ObjectLayer inLayer) const override { return JPH::BroadPhaseLayer(static_cast<JPH::BroadPhaseLayer::Type>(inLayer)); }
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+    const char* GetBroadPhaseLayerName(JPH::BroadPhaseLayer inLayer) const override { return inLayer == JPH::BroadPhaseLayer(0) ? "NON_MOVING" : "MOVING"; }
+#endif
+};
+
+class OldObjectVsBroadPhaseFilter final : public JPH::ObjectVsBroadPhaseLayerFilter
+{
+public:
+    bool ShouldCollide(JPH::ObjectLayer inLayer1, JPH::BroadPhaseLayer inLayer2) const override { return inLayer1 == Layers::MOVING || inLayer2 == JPH::BroadPhaseLayer(Layers::MOVING); }
+};
+
+class OldObjectPairFilter final : public JPH::ObjectLayerPairFilter
+{
+public:
+    bool ShouldCollide(JPH::ObjectLayer inObject1, JPH::ObjectLayer inObject2) const override
+    {
+        bool collides = inObject1 == Layers::MOVING || inObject2 == Layers::MOVING;
+        pairTests += collides ? 1 : 0;
+        return collides;
+    }
+};
+
+// After: the filters from Game.cpp, with a broad phase layer per way of moving and the pairs decided by the collision matrix
+class NewBroadPhaseLayers final : public JPH::BroadPhaseLayerInterface
+{
+public:
+    unsigned int GetNumBroadPhaseLayers() const override { return 3; }
+    JPH::BroadPhaseLayer GetBroadPhaseLayer(JPH::ObjectLayer inLayer) const override { return JPH::BroadPhaseLayer(static_cast<JPH::BroadPhaseLayer::Type>(Layers::GetMotion(inLayer))); }
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+    const char* GetBroadPhaseLayerName(JPH::BroadPhaseLayer inLayer) const override { return inLayer == JPH::BroadPhaseLayer(0) ? "NON_MOVING" : inLayer == JPH::BroadPhaseLayer(1) ? "MOVING" : "SENSOR"; }
+#endif
+};
+
+class NewObjectVsBroadPhaseFilter final : public JPH::ObjectVsBroadPhaseLayerFilter
+{
+public:
+    bool ShouldCollide(JPH::ObjectLayer inLayer1, JPH::BroadPhaseLayer inLayer2) const override
+    {
+        if (Layers::GetMotion(inLayer1) == Layers::MOVING)
+            return true;
+        return inLayer2 == JPH::BroadPhaseLayer(Layers::MOVING);
+    }
+};
+
+class NewObjectPairFilter final : public JPH::ObjectLayerPairFilter
+{
+public:
+    bool ShouldCollide(JPH::ObjectLayer inObject1, JPH::ObjectLayer inObject2) const override
+    {
+        bool collides = (Layers::GetMotion(inObject1) == Layers::MOVING || Layers::GetMotion(inObject2) == Layers::MOVING)
+            && CollisionLayers::Collides(Layers::GetCollisionLayer(inObject1), Layers::GetCollisionLayer(inObject2));
+        pairTests += collides ? 1 : 0;
+        return collides;
+    }
+};
+
+static const int worldLayer = 0;
+static const int debrisLayer = 1;
+static const int characterLayer = 2;
+static const int triggerLayer = 3;
+
+// Debris only lands on the world, characters walk on the world, push each other and set off triggers
+static void SetMatrix()
+{
+    std::vector<uint32_t> masks(4, 0);
+    auto collide = [&masks](int a, int b) { masks[a] |= 1u << b; masks[b] |= 1u << a; };
+    collide(worldLayer, worldLayer);
+    collide(worldLayer, debrisLayer);
+    collide(worldLayer, characterLayer);
+    collide(characterLayer, characterLayer);
+    collide(characterLayer, triggerLayer);
+    CollisionLayers::SetLayers({ "Default", "Debris", "Character", "Trigger" }, masks);
+}
+
+struct Result
+{
+    double pairTestsPerStep = 0.0;
+    double stepMilliseconds = 0.0;
+};
+
+template <typename BroadPhaseLayerType, typename ObjectVsBroadPhaseFilterType, typename ObjectPairFilterType>
+static Result Run(bool useCollisionLayers, JPH::TempAllocator& tempAllocator, JPH::JobSystem& jobSystem)
+{
+    BroadPhaseLayerType broadPhaseLayers;
+    ObjectVsBroadPhaseFilterType objectVsBroadPhaseFilter;
+    ObjectPairFilterType objectPairFilter;
+    JPH::PhysicsSystem physicsSystem;
+    physicsSystem.Init(16384, 0, 65536, 65536, broadPhaseLayers, objectVsBroadPhaseFilter, objectPairFilter);
+    JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
+
+    auto layer = [useCollisionLayers](int collisionLayer, JPH::ObjectLayer motion) {
+        if (useCollisionLayers)
+            return Layers::Get(collisionLayer, motion);
+        return motion == Layers::MOVING ? Layers::MOVING : Layers::NON_MOVING;
+    };
+
+    // A floor split into tiles, so the broad phase has static bodies to sort through
+    JPH::RefConst<JPH::Shape> tile = new JPH::BoxShape(JPH::Vec3(5.0f, 0.5f, 5.0f));
+    for (int z = 0; z < 20; z++)
+        for (int x = 0; x < 20; x++)
+            bodyInterface.CreateAndAddBody(JPH::BodyCreationSettings(tile, JPH::RVec3(x * 10.0f, -0.5f, z * 10.0f), JPH::Quat::sIdentity(), JPH::EMotionType::Static, layer(worldLayer, Layers::NON_MOVING)), JPH::EActivation::DontActivate);
+
+    // Heaps of debris falling onto each other across the floor
+    JPH::RefConst<JPH::Shape> debris = new JPH::BoxShape(JPH::Vec3(0.15f, 0.15f, 0.15f));
+    for (int i = 0; i < 6000; i++)
+    {
+        JPH::RVec3 position(static_cast<float>(i % 40) * 0.5f + (i / 1000) * 30.0f, 0.5f + static_cast<float>((i / 40) % 25) * 0.35f, 20.0f + static_cast<float>((i / 1000) % 3) * 0.4f);
+        bodyInterface.CreateAndAddBody(JPH::BodyCreationSettings(debris, position, JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, layer(debrisLayer, Layers::MOVING)), JPH::EActivation::Activate);
+    }
+
+    // Characters walking through the debris and the triggers
+    JPH::RefConst<JPH::Shape> character = new JPH::CapsuleShape(0.6f, 0.35f);
+    for (int i = 0; i < 200; i++)
+    {
+        JPH::BodyCreationSettings settings(character, JPH::RVec3(static_cast<float>(i % 20) * 9.0f + 4.0f, 1.0f, static_cast<float>(i / 20) * 18.0f + 5.0f), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, layer(characterLayer, Layers::MOVING));
+        settings.mAllowedDOFs = JPH::EAllowedDOFs::TranslationX | JPH::EAllowedDOFs::TranslationY | JPH::EAllowedDOFs::TranslationZ;
+        settings.mLinearVelocity = JPH::Vec3(0.0f, 0.0f, 3.0f);
+        bodyInterface.CreateAndAddBody(settings, JPH::EActivation::Activate);
+    }
+
+    // Large trigger volumes covering most of the floor
+    JPH::RefConst<JPH::Shape> triggerShape = new JPH::BoxShape(JPH::Vec3(8.0f, 3.0f, 8.0f));
+    for (int z = 0; z < 10; z++)
+    {
+        for (int x = 0; x < 10; x++)
+        {
+            JPH::BodyCreationSettings settings(triggerShape, JPH::RVec3(x * 20.0f + 5.0f, 2.0f, z * 20.0f + 5.0f), JPH::Quat::sIdentity(), JPH::EMotionType::Static, layer(triggerLayer, Layers::SENSOR));
+            settings.mIsSensor = true;
+            bodyInterface.CreateAndAddBody(settings, JPH::EActivation::DontActivate);
+        }
+    }
+    physicsSystem.OptimizeBroadPhase();
+
+    const int steps = 120;
+    pairTests = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < steps; i++)
+        physicsSystem.Update(1.0f / 60.0f, 1, &tempAllocator, &jobSystem);
+
+    Result result;
+    result.stepMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / steps;
+    result.pairTestsPerStep = static_cast<double>(pairTests) / steps;
+    return result;
+}
+
+static void Print(const std::string& name, const Result& result)
+{
+    std::cout << name << ": " << result.pairTestsPerStep << " narrow phase pairs per step, " << result.stepMilliseconds << " ms per step" << std::endl;
+}
+
+int main()
+{
+    JPH::RegisterDefaultAllocator();
+    JPH::Factory::sInstance = new JPH::Factory();
+    JPH::RegisterTypes();
+    SetMatrix();
+
+    {
+        JPH::TempAllocatorImpl tempAllocator(64 * 1024 * 1024);
+        JPH::JobSystemThreadPool jobSystem(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+
+        Result before = Run<OldBroadPhaseLayers, OldObjectVsBroadPhaseFilter, OldObjectPairFilter>(false, tempAllocator, jobSystem);
+        Result after = Run<NewBroadPhaseLayers, NewObjectVsBroadPhaseFilter, NewObjectPairFilter>(true, tempAllocator, jobSystem);
+        Print("Two hardcoded layers", before);
+        Print("Collision layers", after);
+    }
+
+    JPH::UnregisterTypes();
+    delete JPH::Factory::sInstance;
+    JPH::Factory::sInstance = nullptr;
+    return 0;
+}
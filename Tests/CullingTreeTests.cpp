@@ -0,0 +1,256 @@
+// Checks CullingTree's frustum queries return the same proxies as testing every proxy's bounds, while proxies are inserted, moved and removed,
+// and checks CullingFrustum against transforming the corners of the bounds into clip space.
+// Build and run from the repository root:
+//   g++ -std=c++17 -IEngine/Source Tests/CullingTreeTests.cpp Engine/Source/Systems/Rendering/CullingTree.cpp -o CullingTreeTests && ./CullingTreeTests
+
+#include "Systems/Rendering/CullingTree.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void Check(bool condition, const std::string& description)
+{
+    if (!condition)
+    {
+        std::cout << "FAILED: " << description << std::endl;
+        failures++;
+    }
+}
+
+// Column major, like raylib's matrices, so element (row, column) is at column * 4 + row
+static void Multiply(const float a[16], const float b[16], float result[16])
+{
+    for (int column = 0; column < 4; column++)
+        for (int row = 0; row < 4; row++)
+        {
+            float sum = 0.0f;
+            for (int i = 0; i < 4; i++)
+                sum += a[i * 4 + row] * b[column * 4 + i];
+            result[column * 4 + row] = sum;
+        }
+}
+
+// A camera at the position looking along the yaw, with a perspective projection and -w to w clip depth like rlgl's
+static void CreateViewProjection(const float position[3], float yaw, float pitch, float fovY, float aspect, float nearPlane, float farPlane, float viewProjection[16])
+{
+    float forward[3] = { std::cos(pitch) * std::sin(yaw), std::sin(pitch), std::cos(pitch) * std::cos(yaw) };
+    float right[3] = { forward[2], 0.0f, -forward[0] };
+    float rightLength = std::sqrt(right[0] * right[0] + right[2] * right[2]);
+    right[0] /= rightLength;
+    right[2] /= rightLength;
+    float up[3] = { right[1] * forward[2] - right[2] * forward[1], right[2] * forward[0] - right[0] * forward[2], right[0] * forward[1] - right[1] * forward[0] };
+
+    float view[16] = {
+        right[0], up[0], -forward[0], 0.0f,
+        right[1], up[1], -forward[1], 0.0f,
+        right[2], up[2], -forward[2], 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+    view[12] = -(right[0] * position[0] + right[1] * position[1] + right[2] * position[2]);
+    view[13] = -(up[0] * position[0] + up[1] * position[1] + up[2] * position[2]);
+    view[14] = forward[0] * position[0] + forward[1] * position[1] + forward[2] * position[2];
+
+    float f = 1.0f / std::tan(fovY / 2.0f);
+    float projection[16] = {};
+    projection[0] = f / aspect;
+    projection[5] = f;
+    projection[10] = (farPlane + nearPlane) / (nearPlane - farPlane);
+    projection[11] = -1.0f;
+    projection[14] = 2.0f * farPlane * nearPlane / (nearPlane - farPlane);
+
+    Multiply(projection, view, viewProjection);
+}
+
+// Which clip planes each corner of the bounds is outside of. The bounds are certainly culled if every corner is outside the same plane,
+// and certainly visible if no corner is outside any plane.
+static void ClassifyCorners(const float viewProjection[16], const CullingBounds& bounds, bool& allOutsideOnePlane, bool& allInside)
+{
+    int outsideAll = 0x3F;
+    int outsideAny = 0;
+    for (int corner = 0; corner < 8; corner++)
+    {
+        float point[3] = {
+            (corner & 1) ? bounds.max[0] : bounds.min[0],
+            (corner & 2) ? bounds.max[1] : bounds.min[1],
+            (corner & 4) ? bounds.max[2] : bounds.min[2]
+        };
+        float clip[4];
+        for (int row = 0; row < 4; row++)
+            clip[row] = viewProjection[row] * point[0] + viewProjection[4 + row] * point[1] + viewProjection[8 + row] * point[2] + viewProjection[12 + row];
+
+        int outside = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (clip[axis] < -clip[3])
+                outside |= 1 << (axis * 2);
+            if (clip[axis] > clip[3])
+                outside |= 1 << (axis * 2 + 1);
+        }
+        outsideAll &= outside;
+        outsideAny |= outside;
+    }
+    allOutsideOnePlane = outsideAll != 0;
+    allInside = outsideAny == 0;
+}
+
+static CullingBounds RandomBounds(std::mt19937& random)
+{
+    std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> size(0.1f, 8.0f);
+    CullingBounds bounds;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        bounds.min[axis] = position(random);
+        bounds.max[axis] = bounds.min[axis] + size(random);
+    }
+    return bounds;
+}
+
+struct Proxy
+{
+    int id = -1;
+    CullingBounds bounds;
+};
+
+// Compares a query against testing the fat bounds of every proxy, and checks every proxy whose real bounds intersect the frustum is returned
+static bool QueryMatchesBruteForce(const CullingTree& tree, const std::vector<Proxy>& proxies, const CullingFrustum& frustum)
+{
+    std::vector<int> found;
+    tree.Query(frustum, [&found](int proxy) { found.push_back(proxy); });
+    std::sort(found.begin(), found.end());
+    if (std::adjacent_find(found.begin(), found.end()) != found.end())
+        return false;
+
+    std::vector<int> expected;
+    for (const Proxy& proxy : proxies)
+    {
+        if (frustum.Intersects(tree.GetFatBounds(proxy.id)))
+            expected.push_back(proxy.id);
+        else if (frustum.Intersects(proxy.bounds))
+            return false;
+    }
+    std::sort(expected.begin(), expected.end());
+    return found == expected;
+}
+
+int main()
+{
+    std::mt19937 random(7);
+
+    // The frustum planes agree with clip space for bounds that are clearly in or clearly out
+    std::uniform_real_distribution<float> angle(-3.14159f, 3.14159f);
+    std::uniform_real_distribution<float> pitch(-1.2f, 1.2f);
+    std::vector<CullingFrustum> frustums;
+    std::vector<std::vector<float>> viewProjections;
+    for (int i = 0; i < 8; i++)
+    {
+        float position[3] = { 0.0f, 10.0f, 0.0f };
+        float viewProjection[16];
+        CreateViewProjection(position, angle(random), pitch(random), 1.0f, 16.0f / 9.0f, 0.1f, 150.0f + i * 20.0f, viewProjection);
+        frustums.push_back(CullingFrustum::FromMatrix(viewProjection));
+        viewProjections.emplace_back(viewProjection, viewProjection + 16);
+    }
+
+    int frustumMismatches = 0;
+    int visibleCount = 0;
+    for (int i = 0; i < 20000; i++)
+    {
+        CullingBounds bounds = RandomBounds(random);
+        size_t frustum = i % frustums.size();
+        bool culled;
+        bool inside;
+        ClassifyCorners(viewProjections[frustum].data(), bounds, culled, inside);
+        if ((culled && frustums[frustum].Intersects(bounds)) || (inside && !frustums[frustum].Contains(bounds)))
+            frustumMismatches++;
+        visibleCount += inside ? 1 : 0;
+    }
+    Check(frustumMismatches == 0, "Frustum tests agree with the bounds' corners in clip space");
+    Check(visibleCount > 100, "Some of the random bounds are inside the frustums");
+
+    // Inserting
+    CullingTree tree;
+    std::vector<Proxy> proxies(3000);
+    for (Proxy& proxy : proxies)
+    {
+        proxy.bounds = RandomBounds(random);
+        proxy.id = tree.CreateProxy(proxy.bounds);
+    }
+    Check(tree.GetProxyCount() == static_cast<int>(proxies.size()), "Every inserted proxy is counted");
+    Check(tree.GetHeight() <= 30, "The tree stays balanced while inserting");
+    bool insertMatches = true;
+    for (const CullingFrustum& frustum : frustums)
+        insertMatches = insertMatches && QueryMatchesBruteForce(tree, proxies, frustum);
+    Check(insertMatches, "Queries match a brute force scan after inserting");
+    int visibleProxies = 0;
+    for (const CullingFrustum& frustum : frustums)
+        tree.Query(frustum, [&visibleProxies](int) { visibleProxies++; });
+    Check(visibleProxies > 100 && visibleProxies < static_cast<int>(proxies.size() * frustums.size()), "The frustums see some of the proxies but not all");
+
+    // Moving, both small moves that stay inside the fat bounds and jumps across the world
+    std::uniform_real_distribution<float> nudge(-0.05f, 0.05f);
+    int reinserted = 0;
+    for (int round = 0; round < 5; round++)
+    {
+        for (size_t i = 0; i < proxies.size(); i++)
+        {
+            Proxy& proxy = proxies[i];
+            if (i % 4 == 0)
+                proxy.bounds = RandomBounds(random);
+            else
+            {
+                float offset[3] = { nudge(random), nudge(random), nudge(random) };
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    proxy.bounds.min[axis] += offset[axis];
+                    proxy.bounds.max[axis] += offset[axis];
+                }
+            }
+            reinserted += tree.MoveProxy(proxy.id, proxy.bounds) ? 1 : 0;
+        }
+    }
+    Check(reinserted < static_cast<int>(proxies.size()) * 5 / 2, "Small moves inside the fat bounds don't re-insert the proxy");
+    Check(tree.GetHeight() <= 30, "The tree stays balanced while moving");
+    bool moveMatches = true;
+    for (const CullingFrustum& frustum : frustums)
+        moveMatches = moveMatches && QueryMatchesBruteForce(tree, proxies, frustum);
+    Check(moveMatches, "Queries match a brute force scan after moving");
+
+    // Removing half, then inserting again so removed IDs are reused
+    std::shuffle(proxies.begin(), proxies.end(), random);
+    for (size_t i = proxies.size() / 2; i < proxies.size(); i++)
+        tree.DestroyProxy(proxies[i].id);
+    proxies.resize(proxies.size() / 2);
+    Check(tree.GetProxyCount() == static_cast<int>(proxies.size()), "Removed proxies aren't counted");
+    bool removeMatches = true;
+    for (const CullingFrustum& frustum : frustums)
+        removeMatches = removeMatches && QueryMatchesBruteForce(tree, proxies, frustum);
+    Check(removeMatches, "Queries match a brute force scan after removing");
+
+    for (int i = 0; i < 500; i++)
+    {
+        Proxy proxy;
+        proxy.bounds = RandomBounds(random);
+        proxy.id = tree.CreateProxy(proxy.bounds);
+        proxies.push_back(proxy);
+    }
+    bool reuseMatches = true;
+    for (const CullingFrustum& frustum : frustums)
+        reuseMatches = reuseMatches && QueryMatchesBruteForce(tree, proxies, frustum);
+    Check(reuseMatches, "Queries match a brute force scan after reusing removed IDs");
+
+    // Removing everything leaves an empty tree
+    for (const Proxy& proxy : proxies)
+        tree.DestroyProxy(proxy.id);
+    int emptyResults = 0;
+    tree.Query(frustums[0], [&emptyResults](int) { emptyResults++; });
+    Check(tree.GetProxyCount() == 0 && tree.GetHeight() == 0 && emptyResults == 0, "Removing every proxy empties the tree");
+
+    if (failures == 0)
+        std::cout << "All culling tree tests passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,218 @@
+// Checks HeightfieldRaycaster's hierarchical search finds the same hits as testing every triangle of the heightfield.
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -IEngine/Source Tests/HeightfieldRaycasterTests.cpp Engine/Source/Systems/Rendering/HeightfieldRaycaster.cpp -pthread -o HeightfieldRaycasterTests && ./HeightfieldRaycasterTests
+
+#include "Systems/Rendering/HeightfieldRaycaster.h"
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void Check(bool condition, const std::string& description)
+{
+    if (!condition)
+    {
+        std::cout << "FAILED: " << description << std::endl;
+        failures++;
+    }
+}
+
+// Moller-Trumbore in doubles, so the reference doesn't share the raycaster's float rounding
+static bool IntersectTriangle(const double origin[3], const double direction[3], const double a[3], const double b[3], const double c[3], double& distance)
+{
+    double edge1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    double edge2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    double p[3] = { direction[1] * edge2[2] - direction[2] * edge2[1], direction[2] * edge2[0] - direction[0] * edge2[2], direction[0] * edge2[1] - direction[1] * edge2[0] };
+    double determinant = edge1[0] * p[0] + edge1[1] * p[1] + edge1[2] * p[2];
+    if (std::abs(determinant) < 1e-15)
+        return false;
+
+    double inverse = 1.0 / determinant;
+    double s[3] = { origin[0] - a[0], origin[1] - a[1], origin[2] - a[2] };
+    double u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse;
+    if (u < 0.0 || u > 1.0)
+        return false;
+
+    double q[3] = { s[1] * edge1[2] - s[2] * edge1[1], s[2] * edge1[0] - s[0] * edge1[2], s[0] * edge1[1] - s[1] * edge1[0] };
+    double v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * inverse;
+    if (v < 0.0 || u + v > 1.0)
+        return false;
+
+    distance = (edge2[0] * q[0] + edge2[1] * q[1] + edge2[2] * q[2]) * inverse;
+    return distance >= 0.0;
+}
+
+// Tests both triangles of every cell, split the same way as HeightfieldRaycaster and TerrainLOD
+static bool BruteForceRaycast(const std::vector<float>& heights, int width, int depth, const HeightfieldRay& ray, double& closest)
+{
+    double length = std::sqrt(double(ray.direction[0]) * ray.direction[0] + double(ray.direction[1]) * ray.direction[1] + double(ray.direction[2]) * ray.direction[2]);
+    double origin[3] = { ray.origin[0], ray.origin[1], ray.origin[2] };
+    double direction[3] = { ray.direction[0] / length, ray.direction[1] / length, ray.direction[2] / length };
+
+    bool found = false;
+    closest = ray.maxDistance;
+    for (int z = 0; z < depth - 1; z++)
+    {
+        for (int x = 0; x < width - 1; x++)
+        {
+            double topLeft[3] = { double(x), heights[z * width + x], double(z) };
+            double topRight[3] = { double(x + 1), heights[z * width + x + 1], double(z) };
+            double bottomLeft[3] = { double(x), heights[(z + 1) * width + x], double(z + 1) };
+            double bottomRight[3] = { double(x + 1), heights[(z + 1) * width + x + 1], double(z + 1) };
+
+            double distance;
+            if (IntersectTriangle(origin, direction, topLeft, bottomLeft, topRight, distance) && distance <= closest)
+            {
+                closest = distance;
+                found = true;
+            }
+            if (IntersectTriangle(origin, direction, topRight, bottomLeft, bottomRight, distance) && distance <= closest)
+            {
+                closest = distance;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+// Rolling hills with a few one sample spikes, which a fixed step ray march would step over
+static std::vector<float> CreateHeights(int width, int depth, std::mt19937& random)
+{
+    std::vector<float> heights(static_cast<size_t>(width) * depth);
+    for (int z = 0; z < depth; z++)
+        for (int x = 0; x < width; x++)
+            heights[z * width + x] = 4.0f * std::sin(x * 0.13f) * std::cos(z * 0.09f) + 2.0f * std::sin((x + z) * 0.31f);
+
+    std::uniform_int_distribution<int> sampleX(0, width - 1);
+    std::uniform_int_distribution<int> sampleZ(0, depth - 1);
+    for (int i = 0; i < 20; i++)
+        heights[sampleZ(random) * width + sampleX(random)] += 15.0f;
+    return heights;
+}
+
+static std::vector<HeightfieldRay> CreateRays(int width, int depth, int count, std::mt19937& random)
+{
+    std::uniform_real_distribution<float> positionX(-10.0f, width + 10.0f);
+    std::uniform_real_distribution<float> positionZ(-10.0f, depth + 10.0f);
+    std::uniform_real_distribution<float> height(-5.0f, 40.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    std::vector<HeightfieldRay> rays(count);
+    for (int i = 0; i < count; i++)
+    {
+        HeightfieldRay& ray = rays[i];
+        ray.origin[0] = positionX(random);
+        ray.origin[1] = height(random);
+        ray.origin[2] = positionZ(random);
+
+        // A mix of rays straight down like ground snapping, steep ones like brush picking, and nearly horizontal ones that cross many cells
+        switch (i % 3)
+        {
+        case 0:
+            ray.direction[0] = 0.0f;
+            ray.direction[1] = -1.0f;
+            ray.direction[2] = 0.0f;
+            break;
+        case 1:
+            ray.direction[0] = unit(random);
+            ray.direction[1] = -1.0f - std::abs(unit(random));
+            ray.direction[2] = unit(random);
+            break;
+        default:
+            ray.direction[0] = unit(random);
+            ray.direction[1] = unit(random) * 0.1f;
+            ray.direction[2] = unit(random);
+            break;
+        }
+        ray.maxDistance = (i % 5 == 0) ? 20.0f : 1000.0f;
+    }
+    return rays;
+}
+
+// Hits with a distance within the tolerance of the reference count as the same, and so do rays that graze a triangle's edge within it
+static int CountMismatches(const HeightfieldRaycaster& raycaster, const std::vector<float>& heights, int width, int depth, const std::vector<HeightfieldRay>& rays)
+{
+    const double tolerance = 0.001;
+    int mismatches = 0;
+    for (const HeightfieldRay& ray : rays)
+    {
+        HeightfieldHit hit;
+        bool found = raycaster.Raycast(ray, hit);
+        double expected;
+        bool expectedFound = BruteForceRaycast(heights, width, depth, ray, expected);
+        if (found != expectedFound)
+        {
+            // Only a hit right at the end of the ray may be missed or found because of rounding
+            double distance = found ? hit.distance : expected;
+            if (std::abs(distance - ray.maxDistance) > tolerance)
+                mismatches++;
+            continue;
+        }
+        if (found && std::abs(hit.distance - expected) > tolerance * std::max(1.0, expected))
+            mismatches++;
+    }
+    return mismatches;
+}
+
+int main()
+{
+    std::mt19937 random(1234);
+
+    // Sizes that aren't powers of two, so the pyramid has cells cut off at its edges
+    const int width = 157;
+    const int depth = 93;
+    std::vector<float> heights = CreateHeights(width, depth, random);
+    std::vector<HeightfieldRay> rays = CreateRays(width, depth, 20000, random);
+
+    HeightfieldRaycaster raycaster;
+    raycaster.Build(heights.data(), width, depth);
+    Check(raycaster.IsBuilt(), "Building the pyramid");
+    Check(CountMismatches(raycaster, heights, width, depth, rays) == 0, "Raycasts match testing every triangle");
+
+    // Enough rays hit and miss for the comparison to mean something
+    int hitCount = 0;
+    for (const HeightfieldRay& ray : rays)
+    {
+        HeightfieldHit hit;
+        hitCount += raycaster.Raycast(ray, hit) ? 1 : 0;
+    }
+    Check(hitCount > static_cast<int>(rays.size()) / 4 && hitCount < static_cast<int>(rays.size()), "The rays are a mix of hits and misses");
+
+    // Sculpting a region only updates the pyramid around it
+    for (int z = 30; z <= 50; z++)
+        for (int x = 70; x <= 100; x++)
+            heights[z * width + x] += 25.0f * std::sin((x - 70) * 0.1f) + 10.0f;
+    raycaster.UpdateRegion(70, 30, 100, 50);
+    Check(CountMismatches(raycaster, heights, width, depth, rays) == 0, "Raycasts match testing every triangle after updating a region");
+
+    // The batch gives exactly the same hits as casting one ray at a time
+    std::vector<HeightfieldHit> hits(rays.size());
+    raycaster.RaycastBatch(rays.data(), hits.data(), static_cast<int>(rays.size()), 4);
+    int batchMismatches = 0;
+    for (size_t i = 0; i < rays.size(); i++)
+    {
+        HeightfieldHit hit;
+        raycaster.Raycast(rays[i], hit);
+        if (hit.hit != hits[i].hit || hit.distance != hits[i].distance)
+            batchMismatches++;
+    }
+    Check(batchMismatches == 0, "Batched raycasts match single raycasts");
+
+    // A flat heightfield the size of one cell
+    std::vector<float> flat = { 1.0f, 1.0f, 1.0f, 1.0f };
+    raycaster.Build(flat.data(), 2, 2);
+    HeightfieldRay down;
+    down.origin[0] = 0.5f;
+    down.origin[1] = 3.0f;
+    down.origin[2] = 0.5f;
+    HeightfieldHit hit;
+    Check(raycaster.Raycast(down, hit) && std::abs(hit.distance - 2.0f) < 0.0001f && std::abs(hit.normal[1] - 1.0f) < 0.0001f, "Hitting a single flat cell");
+
+    if (failures == 0)
+        std::cout << "All heightfield raycaster tests passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,305 @@
+// Measures what cooking does to a mesh: the post-transform cache miss ratio, the overdraw seen from the 6 axis directions and the bytes of
+// vertex memory fetched, before and after MeshOptimizer runs the way RaylibModel::CookModel() runs it. Also reports the LOD chain, the cooked file size
+// against full float vertices, and how long CookedMeshFile::Open() takes. Fails if optimizing loses or changes a triangle.
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -IEngine/Source Tests/MeshCookingBenchmark.cpp Engine/Source/Systems/Rendering/MeshOptimizer.cpp Engine/Source/Resources/CookedMesh.cpp Engine/Source/Utilities/MappedFile.cpp -o MeshCookingBenchmark && ./MeshCookingBenchmark
+
+#include "Systems/Rendering/MeshOptimizer.h"
+#include "Resources/CookedMesh.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+struct Mesh
+{
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> texcoords;
+    std::vector<unsigned int> indices;
+};
+
+// A torus, which hides part of itself from every side, with its triangles shuffled like an exporter that doesn't care about order
+static Mesh CreateTorus(int rings, int sides)
+{
+    const float pi = 3.14159265f;
+    Mesh mesh;
+    for (int ring = 0; ring <= rings; ring++)
+    {
+        float u = ring * 2.0f * pi / rings;
+        for (int side = 0; side <= sides; side++)
+        {
+            float v = side * 2.0f * pi / sides;
+            float normal[3] = { std::cos(u) * std::cos(v), std::sin(v), std::sin(u) * std::cos(v) };
+            mesh.positions.insert(mesh.positions.end(), { std::cos(u) + 0.35f * normal[0], 0.35f * normal[1], std::sin(u) + 0.35f * normal[2] });
+            mesh.normals.insert(mesh.normals.end(), normal, normal + 3);
+            mesh.texcoords.insert(mesh.texcoords.end(), { static_cast<float>(ring) / rings, static_cast<float>(side) / sides });
+        }
+    }
+
+    std::vector<std::array<unsigned int, 3>> triangles;
+    for (int ring = 0; ring < rings; ring++)
+    {
+        for (int side = 0; side < sides; side++)
+        {
+            unsigned int a = ring * (sides + 1) + side;
+            unsigned int b = a + sides + 1;
+            triangles.push_back({ a, a + 1, b });
+            triangles.push_back({ b, a + 1, b + 1 });
+        }
+    }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(11));
+    for (const std::array<unsigned int, 3>& triangle : triangles)
+        mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+    return mesh;
+}
+
+// Vertices transformed per triangle with a FIFO post-transform cache of the given size
+static double CacheMissRatio(const std::vector<unsigned int>& indices, size_t vertexCount, size_t cacheSize)
+{
+    std::vector<size_t> insertedAt(vertexCount, 0);
+    size_t misses = 0;
+    for (unsigned int vertex : indices)
+    {
+        if (insertedAt[vertex] == 0 || misses - insertedAt[vertex] + 1 > cacheSize)
+        {
+            misses++;
+            insertedAt[vertex] = misses;
+        }
+    }
+    return static_cast<double>(misses) / (indices.size() / 3);
+}
+
+// Bytes read from vertex memory per byte of vertices, with 64 byte cache lines and a small cache of recently read lines
+static double FetchOverhead(const std::vector<unsigned int>& indices, size_t vertexCount, size_t stride)
+{
+    const size_t lineSize = 64;
+    std::deque<size_t> recentLines;
+    size_t linesRead = 0;
+    for (unsigned int vertex : indices)
+    {
+        for (size_t line = vertex * stride / lineSize; line <= (vertex * stride + stride - 1) / lineSize; line++)
+        {
+            if (std::find(recentLines.begin(), recentLines.end(), line) != recentLines.end())
+                continue;
+            linesRead++;
+            recentLines.push_back(line);
+            if (recentLines.size() > 64)
+                recentLines.pop_front();
+        }
+    }
+    return static_cast<double>(linesRead * lineSize) / (vertexCount * stride);
+}
+
+// Pixels shaded per visible pixel, rasterizing front faces in draw order with a depth test, averaged over looking down each axis both ways
+static double Overdraw(const std::vector<unsigned int>& indices, const std::vector<float>& positions)
+{
+    const int resolution = 256;
+    float boundsMin[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+    float boundsMax[3] = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        boundsMin[i % 3] = std::min(boundsMin[i % 3], positions[i]);
+        boundsMax[i % 3] = std::max(boundsMax[i % 3], positions[i]);
+    }
+
+    size_t shaded = 0;
+    size_t covered = 0;
+    std::vector<float> depths;
+    for (int view = 0; view < 6; view++)
+    {
+        int axis = view / 2;
+        float sign = view % 2 == 0 ? 1.0f : -1.0f;
+        int uAxis = (axis + 1) % 3;
+        int vAxis = (axis + 2) % 3;
+        depths.assign(static_cast<size_t>(resolution) * resolution, std::numeric_limits<float>::max());
+
+        for (size_t t = 0; t < indices.size(); t += 3)
+        {
+            const float* a = &positions[indices[t] * 3];
+            const float* b = &positions[indices[t + 1] * 3];
+            const float* c = &positions[indices[t + 2] * 3];
+
+            // Back faces point along the view direction
+            float edge1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            float edge2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            float normal = edge1[(axis + 1) % 3] * edge2[(axis + 2) % 3] - edge1[(axis + 2) % 3] * edge2[(axis + 1) % 3];
+            if (normal * sign >= 0.0f)
+                continue;
+
+            float x[3], y[3], z[3];
+            const float* corners[3] = { a, b, c };
+            for (int k = 0; k < 3; k++)
+            {
+                x[k] = (corners[k][uAxis] - boundsMin[uAxis]) / (boundsMax[uAxis] - boundsMin[uAxis]) * resolution;
+                y[k] = (corners[k][vAxis] - boundsMin[vAxis]) / (boundsMax[vAxis] - boundsMin[vAxis]) * resolution;
+                z[k] = corners[k][axis] * sign;
+            }
+            float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+            if (area == 0.0f)
+                continue;
+
+            int minX = std::max(0, static_cast<int>(std::floor(std::min({ x[0], x[1], x[2] }))));
+            int maxX = std::min(resolution - 1, static_cast<int>(std::ceil(std::max({ x[0], x[1], x[2] }))));
+            int minY = std::max(0, static_cast<int>(std::floor(std::min({ y[0], y[1], y[2] }))));
+            int maxY = std::min(resolution - 1, static_cast<int>(std::ceil(std::max({ y[0], y[1], y[2] }))));
+            for (int py = minY; py <= maxY; py++)
+            {
+                for (int px = minX; px <= maxX; px++)
+                {
+                    float sampleX = px + 0.5f;
+                    float sampleY = py + 0.5f;
+                    float w0 = ((x[2] - x[1]) * (sampleY - y[1]) - (y[2] - y[1]) * (sampleX - x[1])) / area;
+                    float w1 = ((x[0] - x[2]) * (sampleY - y[2]) - (y[0] - y[2]) * (sampleX - x[2])) / area;
+                    float w2 = 1.0f - w0 - w1;
+                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                        continue;
+
+                    float depth = w0 * z[0] + w1 * z[1] + w2 * z[2];
+                    float& stored = depths[py * resolution + px];
+                    if (depth < stored)
+                    {
+                        if (stored == std::numeric_limits<float>::max())
+                            covered++;
+                        stored = depth;
+                        shaded++;
+                    }
+                }
+            }
+        }
+    }
+    return covered > 0 ? static_cast<double>(shaded) / covered : 0.0;
+}
+
+// Triangles as sorted lists of their corners' positions, each rotated to start at its smallest corner so the winding is kept
+static std::vector<std::array<float, 9>> TriangleSet(const std::vector<unsigned int>& indices, const std::vector<float>& positions)
+{
+    std::vector<std::array<float, 9>> triangles;
+    for (size_t t = 0; t < indices.size(); t += 3)
+    {
+        std::array<std::array<float, 3>, 3> corners;
+        for (int k = 0; k < 3; k++)
+            corners[k] = { positions[indices[t + k] * 3], positions[indices[t + k] * 3 + 1], positions[indices[t + k] * 3 + 2] };
+        std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+
+        std::array<float, 9> triangle;
+        for (int k = 0; k < 9; k++)
+            triangle[k] = corners[k / 3][k % 3];
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+static double Milliseconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    Mesh mesh = CreateTorus(256, 127);
+    size_t vertexCount = mesh.positions.size() / 3;
+    const size_t floatStride = 32; // Float position, normal and texcoord
+    std::cout << vertexCount << " vertices, " << mesh.indices.size() / 3 << " triangles" << std::endl;
+
+    std::vector<std::array<float, 9>> sourceTriangles = TriangleSet(mesh.indices, mesh.positions);
+    double missRatioBefore = CacheMissRatio(mesh.indices, vertexCount, 16);
+    double fetchBefore = FetchOverhead(mesh.indices, vertexCount, floatStride);
+    double overdrawBefore = Overdraw(mesh.indices, mesh.positions);
+
+    // The same steps as RaylibModel::CookModel()
+    std::vector<unsigned int> indices = mesh.indices;
+    auto start = std::chrono::steady_clock::now();
+    MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+    double cacheMilliseconds = Milliseconds(start);
+    start = std::chrono::steady_clock::now();
+    MeshOptimizer::OptimizeOverdraw(indices, mesh.positions.data(), vertexCount);
+    double overdrawMilliseconds = Milliseconds(start);
+    start = std::chrono::steady_clock::now();
+    std::vector<int> remap;
+    size_t usedVertices = MeshOptimizer::OptimizeVertexFetch(indices, vertexCount, remap);
+    double fetchMilliseconds = Milliseconds(start);
+
+    CookedMeshSource cooked;
+    cooked.positions.resize(usedVertices * 3);
+    cooked.normals.resize(usedVertices * 3);
+    cooked.texcoords.resize(usedVertices * 2);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        if (remap[v] < 0)
+            continue;
+        std::copy_n(&mesh.positions[v * 3], 3, &cooked.positions[remap[v] * 3]);
+        std::copy_n(&mesh.normals[v * 3], 3, &cooked.normals[remap[v] * 3]);
+        std::copy_n(&mesh.texcoords[v * 2], 2, &cooked.texcoords[remap[v] * 2]);
+    }
+
+    std::cout << "Optimizing took " << cacheMilliseconds << " ms for the vertex cache, " << overdrawMilliseconds << " ms for overdraw and " << fetchMilliseconds << " ms for vertex fetch" << std::endl;
+    std::cout << "Cache misses per triangle (16 entry FIFO): " << missRatioBefore << " before, " << CacheMissRatio(indices, usedVertices, 16) << " after" << std::endl;
+    std::cout << "Vertex bytes fetched per vertex byte: " << fetchBefore << " before, " << FetchOverhead(indices, usedVertices, floatStride) << " after" << std::endl;
+    std::cout << "Overdraw: " << overdrawBefore << " before, " << Overdraw(indices, cooked.positions) << " after" << std::endl;
+
+    bool trianglesKept = usedVertices == vertexCount && TriangleSet(indices, cooked.positions) == sourceTriangles;
+
+    // LODs on the same grids and with the same minimum reduction as CookModel()
+    const int lodResolutions[cookedMeshMaxLods - 1] = { 64, 32, 16 };
+    float gridMin[3] = { -1.35f, -0.35f, -1.35f };
+    float longestSide = 2.7f;
+    cooked.lods.emplace_back(indices.begin(), indices.end());
+    size_t previousTriangles = indices.size() / 3;
+    std::cout << "LOD 0: " << previousTriangles << " triangles" << std::endl;
+    for (int resolution : lodResolutions)
+    {
+        std::vector<unsigned int> simplified;
+        MeshOptimizer::SimplifyClustered(indices, cooked.positions.data(), cooked.normals.data(), usedVertices, gridMin, longestSide / resolution, simplified);
+        if (simplified.empty() || simplified.size() / 3 > previousTriangles * 0.75f)
+            continue;
+
+        MeshOptimizer::OptimizeVertexCache(simplified, usedVertices);
+        std::cout << "LOD " << cooked.lods.size() << ": " << simplified.size() / 3 << " triangles on a " << resolution << " cell grid" << std::endl;
+        cooked.lods.emplace_back(simplified.begin(), simplified.end());
+        previousTriangles = simplified.size() / 3;
+    }
+
+    // The cooked file against the same mesh as float vertices with 32 bit indices
+    CookedModelContents contents;
+    contents.boundsMin[0] = gridMin[0];
+    contents.boundsMin[1] = gridMin[1];
+    contents.boundsMin[2] = gridMin[2];
+    contents.boundsMax[0] = 1.35f;
+    contents.boundsMax[1] = 0.35f;
+    contents.boundsMax[2] = 1.35f;
+    for (size_t lod = 1; lod < cooked.lods.size(); lod++)
+        contents.lodScreenSizes[lod] = lodResolutions[lod - 1] / 256.0f;
+    contents.meshes.push_back(cooked);
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "MeshCookingBenchmark.mesh";
+    bool saved = CookedMeshFile::Save(path, contents);
+
+    size_t floatBytes = usedVertices * floatStride + mesh.indices.size() * sizeof(unsigned int);
+    std::cout << "Cooked file: " << std::filesystem::file_size(path) / 1024.0 << " KB with every LOD, against " << floatBytes / 1024.0 << " KB of float vertices and 32 bit indices" << std::endl;
+
+    const int opens = 100;
+    bool opened = true;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < opens; i++)
+    {
+        CookedMeshFile file;
+        opened = opened && file.Open(path) && file.GetMeshCount() == 1 && file.GetMesh(0).lodCount == static_cast<int>(cooked.lods.size());
+    }
+    std::cout << "Opening the cooked file: " << Milliseconds(start) / opens << " ms" << std::endl;
+    std::filesystem::remove(path);
+
+    if (!trianglesKept || !saved || !opened)
+    {
+        std::cout << "FAILED: " << (!trianglesKept ? "optimizing changed the triangles" : !saved ? "saving the cooked file" : "opening the cooked file") << std::endl;
+        return 1;
+    }
+    return 0;
+}
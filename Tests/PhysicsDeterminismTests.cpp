@@ -0,0 +1,142 @@
+// Checks that 3D physics restored from a snapshot re-simulates to bit-identical state. The state is saved and restored the way
+// PhysicsSnapshot does it, as one Jolt recording for the bodies and constraints and another for the contacts.
+// Needs Jolt v5.2.0, the version Build/3D/CMakeLists.txt fetches. Build and run from the repository root, with JOLT set to its checkout and JOLT_LIB to the folder libJolt.a was built into:
+//   g++ -std=c++17 -I$JOLT Tests/PhysicsDeterminismTests.cpp -L$JOLT_LIB -lJolt -pthread -o PhysicsDeterminismTests && ./PhysicsDeterminismTests
+
+#include <Jolt/Jolt.h>
+#include <Jolt/RegisterTypes.h>
+#include <Jolt/Core/Factory.h>
+#include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/StateRecorderImpl.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <Jolt/Physics/Collision/Shape/SphereShape.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+
+static int failures = 0;
+
+static void Check(bool condition, const std::string& description)
+{
+    if (!condition)
+    {
+        std::cout << "FAILED: " << description << std::endl;
+        failures++;
+    }
+}
+
+static const JPH::ObjectLayer nonMovingLayer = 0;
+static const JPH::ObjectLayer movingLayer = 1;
+
+class BroadPhaseLayers final : public JPH::BroadPhaseLayerInterface
+{
+public:
+    unsigned int GetNumBroadPhaseLayers() const override { return 2; }
+    JPH::BroadPhaseLayer GetBroadPhaseLayer(JPH::ObjectLayer inLayer) const override { return JPH::BroadPhaseLayer(static_cast<JPH::BroadPhaseLayer::Type>(inLayer)); }
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+    const char* GetBroadPhaseLayerName(JPH::BroadPhaseLayer inLayer) const override { return inLayer == JPH::BroadPhaseLayer(0) ? "NON_MOVING" : "MOVING"; }
+#endif
+};
+
+class ObjectVsBroadPhaseFilter final : public JPH::ObjectVsBroadPhaseLayerFilter
+{
+public:
+    bool ShouldCollide(JPH::ObjectLayer inLayer1, JPH::BroadPhaseLayer inLayer2) const override { return inLayer1 == movingLayer || inLayer2 == JPH::BroadPhaseLayer(movingLayer); }
+};
+
+class ObjectPairFilter final : public JPH::ObjectLayerPairFilter
+{
+public:
+    bool ShouldCollide(JPH::ObjectLayer inObject1, JPH::ObjectLayer inObject2) const override { return inObject1 == movingLayer || inObject2 == movingLayer; }
+};
+
+// A floor with a pile of boxes and spheres thrown onto it, so bodies keep touching, separating and falling asleep during the steps
+static void CreateScene(JPH::BodyInterface& bodyInterface)
+{
+    JPH::BodyCreationSettings floor(new JPH::BoxShape(JPH::Vec3(50.0f, 1.0f, 50.0f)), JPH::RVec3(0.0f, -1.0f, 0.0f), JPH::Quat::sIdentity(), JPH::EMotionType::Static, nonMovingLayer);
+    bodyInterface.CreateAndAddBody(floor, JPH::EActivation::DontActivate);
+
+    JPH::RefConst<JPH::Shape> box = new JPH::BoxShape(JPH::Vec3(0.5f, 0.5f, 0.5f));
+    JPH::RefConst<JPH::Shape> sphere = new JPH::SphereShape(0.5f);
+    for (int i = 0; i < 64; i++)
+    {
+        float x = static_cast<float>(i % 4) * 1.1f - 1.65f;
+        float z = static_cast<float>((i / 4) % 4) * 1.1f - 1.65f;
+        float y = 1.0f + static_cast<float>(i / 16) * 1.5f;
+        JPH::BodyCreationSettings settings(i % 3 == 0 ? sphere : box, JPH::RVec3(x, y, z), JPH::Quat::sRotation(JPH::Vec3::sAxisY(), 0.1f * i), JPH::EMotionType::Dynamic, movingLayer);
+        settings.mLinearVelocity = JPH::Vec3(static_cast<float>(i % 5) - 2.0f, 0.0f, static_cast<float>(i % 7) - 3.0f);
+        bodyInterface.CreateAndAddBody(settings, JPH::EActivation::Activate);
+    }
+}
+
+static void SaveSnapshot(const JPH::PhysicsSystem& physicsSystem, JPH::StateRecorderImpl& bodies, JPH::StateRecorderImpl& contacts)
+{
+    physicsSystem.SaveState(bodies, JPH::EStateRecorderState::Global | JPH::EStateRecorderState::Bodies | JPH::EStateRecorderState::Constraints);
+    physicsSystem.SaveState(contacts, JPH::EStateRecorderState::Contacts);
+}
+
+static std::string SaveAll(const JPH::PhysicsSystem& physicsSystem)
+{
+    JPH::StateRecorderImpl recorder;
+    physicsSystem.SaveState(recorder);
+    return recorder.GetData();
+}
+
+int main()
+{
+    JPH::RegisterDefaultAllocator();
+    JPH::Factory::sInstance = new JPH::Factory();
+    JPH::RegisterTypes();
+
+    {
+        JPH::TempAllocatorImpl tempAllocator(16 * 1024 * 1024);
+        JPH::JobSystemThreadPool jobSystem(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+        BroadPhaseLayers broadPhaseLayers;
+        ObjectVsBroadPhaseFilter objectVsBroadPhaseFilter;
+        ObjectPairFilter objectPairFilter;
+
+        JPH::PhysicsSystem physicsSystem;
+        physicsSystem.Init(1024, 0, 4096, 4096, broadPhaseLayers, objectVsBroadPhaseFilter, objectPairFilter);
+        CreateScene(physicsSystem.GetBodyInterface());
+
+        const float timeStep = 1.0f / 60.0f;
+        auto step = [&](int steps) {
+            for (int i = 0; i < steps; i++)
+                physicsSystem.Update(timeStep, 1, &tempAllocator, &jobSystem);
+        };
+
+        // Snapshot once the pile is already touching, so the snapshot holds contacts
+        step(30);
+        JPH::StateRecorderImpl bodies;
+        JPH::StateRecorderImpl contacts;
+        SaveSnapshot(physicsSystem, bodies, contacts);
+        std::string snapshotState = SaveAll(physicsSystem);
+
+        step(240);
+        std::string firstRun = SaveAll(physicsSystem);
+
+        bodies.Rewind();
+        contacts.Rewind();
+        Check(physicsSystem.RestoreState(bodies) && !bodies.IsFailed(), "Restoring the bodies and constraints");
+        Check(physicsSystem.RestoreState(contacts) && !contacts.IsFailed(), "Restoring the contacts");
+        Check(SaveAll(physicsSystem) == snapshotState, "Restoring the two recordings in turn gives back the whole state");
+
+        step(240);
+        std::string secondRun = SaveAll(physicsSystem);
+        Check(firstRun.size() == secondRun.size(), "Both runs end with the same size of state");
+        Check(firstRun == secondRun, "Both runs end in bit-identical state");
+        Check(firstRun != snapshotState, "The bodies moved during the steps");
+    }
+
+    JPH::UnregisterTypes();
+    delete JPH::Factory::sInstance;
+    JPH::Factory::sInstance = nullptr;
+
+    if (failures == 0)
+        std::cout << "All physics determinism tests passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,240 @@
+// Times 100,000 raycasts per frame against a level of Jolt bodies, issued one at a time through the locking NarrowPhaseQuery the way scripts
+// used to hand-roll them, against running them in slices on the QueryThreadPool through the no-lock query, the way PhysicsQueries::RaycastBatch() does.
+// Both use the same layer mask and trigger filters as PhysicsQueries and look up the hit's surface normal. Fails if the two give different hits.
+// Needs Jolt v5.2.0, the version Build/3D/CMakeLists.txt fetches. Build and run from the repository root, with JOLT set to its checkout and JOLT_LIB to the folder libJolt.a was built into:
+//   g++ -std=c++17 -O2 -I$JOLT -IEngine/Source Tests/PhysicsQueryBenchmark.cpp -L$JOLT_LIB -lJolt -pthread -o PhysicsQueryBenchmark && ./PhysicsQueryBenchmark
+
+#include <Jolt/Jolt.h>
+#include <Jolt/RegisterTypes.h>
+#include <Jolt/Core/Factory.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/Body/BodyLock.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <Jolt/Physics/Collision/Shape/SphereShape.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include "Systems/Physics/QueryThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The object layer encoding from Rigidbody3D.h: how the body moves in the low 2 bits and the collision layer above them
+namespace Layers
+{
+    static constexpr JPH::ObjectLayer NON_MOVING = 0;
+    static constexpr JPH::ObjectLayer MOVING = 1;
+    static constexpr JPH::ObjectLayer SENSOR = 2;
+
+    inline JPH::ObjectLayer Get(int collisionLayer, JPH::ObjectLayer motion) { return static_cast<JPH::ObjectLayer>((collisionLayer << 2) | motion); }
+    inline JPH::ObjectLayer GetMotion(JPH::ObjectLayer layer) { return layer & 3; }
+    inline int GetCollisionLayer(JPH::ObjectLayer layer) { return layer >> 2; }
+};
+
+class BroadPhaseLayers final : public JPH::BroadPhaseLayerInterface
+{
+public:
+    unsigned int GetNumBroadPhaseLayers() const override { return 3; }
+    JPH::BroadPhaseLayer GetBroadPhaseLayer(JPH::ObjectLayer inLayer) const override { return JPH::BroadPhaseLayer(static_cast<JPH::BroadPhaseLayer::Type>(Layers::GetMotion(inLayer))); }
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+    const char* GetBroadPhaseLayerName(JPH::BroadPhaseLayer inLayer) const override { return inLayer == JPH::BroadPhaseLayer(0) ? "NON_MOVING" : inLayer == JPH::BroadPhaseLayer(1) ? "MOVING" : "SENSOR"; }
+#endif
+};
+
+class ObjectVsBroadPhaseFilter final : public JPH::ObjectVsBroadPhaseLayerFilter
+{
+public:
+    bool ShouldCollide(JPH::ObjectLayer inLayer1, JPH::BroadPhaseLayer inLayer2) const override { return Layers::GetMotion(inLayer1) == Layers::MOVING || inLayer2 == JPH::BroadPhaseLayer(Layers::MOVING); }
+};
+
+class ObjectPairFilter final : public JPH::ObjectLayerPairFilter
+{
+public:
+    bool ShouldCollide(JPH::ObjectLayer inObject1, JPH::ObjectLayer inObject2) const override { return Layers::GetMotion(inObject1) == Layers::MOVING || Layers::GetMotion(inObject2) == Layers::MOVING; }
+};
+
+// The same filters PhysicsQueries uses
+class QueryLayerFilter final : public JPH::ObjectLayerFilter
+{
+public:
+    explicit QueryLayerFilter(uint32_t layerMask) : layerMask(layerMask) {}
+
+    bool ShouldCollide(JPH::ObjectLayer inLayer) const override
+    {
+        return ((layerMask >> Layers::GetCollisionLayer(inLayer)) & 1) != 0;
+    }
+
+private:
+    uint32_t layerMask;
+};
+
+class QueryBodyFilter final : public JPH::BodyFilter
+{
+public:
+    explicit QueryBodyFilter(bool hitTriggers) : hitTriggers(hitTriggers) {}
+
+    bool ShouldCollideLocked(const JPH::Body& inBody) const override
+    {
+        return hitTriggers || !inBody.IsSensor();
+    }
+
+private:
+    bool hitTriggers;
+};
+
+struct Ray
+{
+    JPH::RRayCast cast;
+    uint32_t layerMask;
+};
+
+struct Hit
+{
+    bool hit = false;
+    float fraction = 0.0f;
+    JPH::Vec3 normal = JPH::Vec3::sZero();
+};
+
+static const int rayCount = 100000;
+static const int minQueriesPerThread = 256; // As in PhysicsQueries.cpp
+
+// Static walls, dynamic crates and triggers on layers 0 to 2, spread over a level
+static void CreateLevel(JPH::BodyInterface& bodyInterface)
+{
+    JPH::RefConst<JPH::Shape> floor = new JPH::BoxShape(JPH::Vec3(150.0f, 0.5f, 150.0f));
+    bodyInterface.CreateAndAddBody(JPH::BodyCreationSettings(floor, JPH::RVec3(0.0f, -0.5f, 0.0f), JPH::Quat::sIdentity(), JPH::EMotionType::Static, Layers::Get(0, Layers::NON_MOVING)), JPH::EActivation::DontActivate);
+
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> position(-140.0f, 140.0f);
+    JPH::RefConst<JPH::Shape> wall = new JPH::BoxShape(JPH::Vec3(2.0f, 2.0f, 0.25f));
+    JPH::RefConst<JPH::Shape> crate = new JPH::BoxShape(JPH::Vec3(0.5f, 0.5f, 0.5f));
+    JPH::RefConst<JPH::Shape> trigger = new JPH::SphereShape(3.0f);
+    for (int i = 0; i < 3000; i++)
+    {
+        JPH::RVec3 wallPosition(position(random), 2.0f, position(random));
+        bodyInterface.CreateAndAddBody(JPH::BodyCreationSettings(wall, wallPosition, JPH::Quat::sRotation(JPH::Vec3::sAxisY(), (i % 8) * 0.39f), JPH::EMotionType::Static, Layers::Get(0, Layers::NON_MOVING)), JPH::EActivation::DontActivate);
+    }
+    for (int i = 0; i < 2000; i++)
+        bodyInterface.CreateAndAddBody(JPH::BodyCreationSettings(crate, JPH::RVec3(position(random), 0.5f, position(random)), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, Layers::Get(1, Layers::MOVING)), JPH::EActivation::DontActivate);
+    for (int i = 0; i < 200; i++)
+    {
+        JPH::BodyCreationSettings settings(trigger, JPH::RVec3(position(random), 1.0f, position(random)), JPH::Quat::sIdentity(), JPH::EMotionType::Static, Layers::Get(2, Layers::SENSOR));
+        settings.mIsSensor = true;
+        bodyInterface.CreateAndAddBody(settings, JPH::EActivation::DontActivate);
+    }
+}
+
+// Line of sight checks between agents and ground checks below them, some of which skip the crates' layer
+static std::vector<Ray> CreateRays()
+{
+    std::mt19937 random(9);
+    std::uniform_real_distribution<float> position(-140.0f, 140.0f);
+    std::uniform_real_distribution<float> offset(-30.0f, 30.0f);
+    std::vector<Ray> rays(rayCount);
+    for (int i = 0; i < rayCount; i++)
+    {
+        JPH::RVec3 origin(position(random), 1.5f, position(random));
+        JPH::Vec3 direction = i % 2 == 0 ? JPH::Vec3(0.0f, -3.0f, 0.0f) : JPH::Vec3(offset(random), 0.0f, offset(random));
+        rays[i] = { JPH::RRayCast(origin, direction), i % 4 == 1 ? 0x1u : 0xFFFFFFFFu };
+    }
+    return rays;
+}
+
+static void CastLocking(const JPH::PhysicsSystem& physicsSystem, const Ray& ray, Hit& hit)
+{
+    hit = Hit();
+    JPH::RayCastResult result;
+    QueryLayerFilter layerFilter(ray.layerMask);
+    QueryBodyFilter bodyFilter(false);
+    if (!physicsSystem.GetNarrowPhaseQuery().CastRay(ray.cast, result, {}, layerFilter, bodyFilter))
+        return;
+
+    JPH::BodyLockRead lock(physicsSystem.GetBodyLockInterface(), result.mBodyID);
+    if (!lock.Succeeded())
+        return;
+    hit.hit = true;
+    hit.fraction = result.mFraction;
+    hit.normal = lock.GetBody().GetWorldSpaceSurfaceNormal(result.mSubShapeID2, ray.cast.GetPointOnRay(result.mFraction));
+}
+
+static void CastNoLock(const JPH::PhysicsSystem& physicsSystem, const Ray& ray, Hit& hit)
+{
+    hit = Hit();
+    JPH::RayCastResult result;
+    QueryLayerFilter layerFilter(ray.layerMask);
+    QueryBodyFilter bodyFilter(false);
+    if (!physicsSystem.GetNarrowPhaseQueryNoLock().CastRay(ray.cast, result, {}, layerFilter, bodyFilter))
+        return;
+
+    const JPH::Body* body = physicsSystem.GetBodyLockInterfaceNoLock().TryGetBody(result.mBodyID);
+    if (!body)
+        return;
+    hit.hit = true;
+    hit.fraction = result.mFraction;
+    hit.normal = body->GetWorldSpaceSurfaceNormal(result.mSubShapeID2, ray.cast.GetPointOnRay(result.mFraction));
+}
+
+int main()
+{
+    JPH::RegisterDefaultAllocator();
+    JPH::Factory::sInstance = new JPH::Factory();
+    JPH::RegisterTypes();
+
+    int failures = 0;
+    {
+        BroadPhaseLayers broadPhaseLayers;
+        ObjectVsBroadPhaseFilter objectVsBroadPhaseFilter;
+        ObjectPairFilter objectPairFilter;
+        JPH::PhysicsSystem physicsSystem;
+        physicsSystem.Init(8192, 0, 8192, 8192, broadPhaseLayers, objectVsBroadPhaseFilter, objectPairFilter);
+        CreateLevel(physicsSystem.GetBodyInterface());
+        physicsSystem.OptimizeBroadPhase();
+
+        std::vector<Ray> rays = CreateRays();
+        std::vector<Hit> lockingHits(rays.size());
+        std::vector<Hit> batchedHits(rays.size());
+        QueryThreadPool queryThreadPool;
+        const int frames = 10;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+            for (size_t i = 0; i < rays.size(); i++)
+                CastLocking(physicsSystem, rays[i], lockingHits[i]);
+        double lockingMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+        // Sliced the way PhysicsQueries' RunBatch() does it
+        int threadCount = std::min(std::max(1, static_cast<int>(std::thread::hardware_concurrency())), (rayCount + minQueriesPerThread - 1) / minQueriesPerThread);
+        auto raycastRange = [&](int first, int last)
+        {
+            for (int i = first; i < last; i++)
+                CastNoLock(physicsSystem, rays[i], batchedHits[i]);
+        };
+        start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+            queryThreadPool.Run(rayCount, threadCount, raycastRange);
+        double batchedMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+        int hitCount = 0;
+        for (size_t i = 0; i < rays.size(); i++)
+        {
+            hitCount += lockingHits[i].hit ? 1 : 0;
+            if (lockingHits[i].hit != batchedHits[i].hit || lockingHits[i].fraction != batchedHits[i].fraction || lockingHits[i].normal != batchedHits[i].normal)
+                failures++;
+        }
+
+        std::cout << rayCount << " rays per frame, " << hitCount << " hits, " << threadCount << " threads" << std::endl;
+        std::cout << "One at a time with locks: " << lockingMilliseconds << " ms per frame" << std::endl;
+        std::cout << "Batched on the query thread pool: " << batchedMilliseconds << " ms per frame" << std::endl;
+        if (failures > 0)
+            std::cout << "FAILED: " << failures << " rays hit differently when batched" << std::endl;
+    }
+
+    JPH::UnregisterTypes();
+    delete JPH::Factory::sInstance;
+    JPH::Factory::sInstance = nullptr;
+    return failures == 0 ? 0 : 1;
+}
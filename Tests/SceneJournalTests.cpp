@@ -0,0 +1,104 @@
+// Checks the scene journal keeps committed saves when a save was interrupted half way through writing.
+// Build and run from the repository root:
+//   g++ -std=c++17 -IEngine -IEngine/Source Tests/SceneJournalTests.cpp Engine/Source/Systems/Scene/SceneJournal.cpp -o SceneJournalTests && ./SceneJournalTests
+
+#include "Systems/Scene/SceneJournal.h"
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using json = nlohmann::json;
+
+static int failures = 0;
+
+static void Check(bool condition, const std::string& description)
+{
+    if (!condition)
+    {
+        std::cout << "FAILED: " << description << std::endl;
+        failures++;
+    }
+}
+
+static json Upsert(int id, const std::string& name)
+{
+    json record;
+    record["upsert"]["id"] = id;
+    record["upsert"]["name"] = name;
+    return record;
+}
+
+static json LoadScene(const std::filesystem::path& journalPath)
+{
+    json sceneData;
+    sceneData["game_objects"].push_back({ { "id", 1 }, { "name", "Original" } });
+    SceneJournal::Apply(sceneData, journalPath);
+    return sceneData;
+}
+
+static std::string GetName(const json& sceneData, int id)
+{
+    for (const json& gameObjectData : sceneData["game_objects"])
+        if (gameObjectData["id"] == id)
+            return gameObjectData["name"];
+    return "";
+}
+
+// Writes the start of a save the way it looks when the editor is closed in the middle of writing it
+static void WriteTornSave(const std::filesystem::path& journalPath, const std::string& tornLine)
+{
+    std::ofstream journal(journalPath, std::ios::app);
+    journal << "{\"begin\":2}\n";
+    journal << Upsert(1, "Torn").dump() << '\n';
+    journal << tornLine;
+}
+
+int main()
+{
+    std::filesystem::path journalPath = std::filesystem::temp_directory_path() / ".SceneJournalTests.scene.journal";
+    std::filesystem::remove(journalPath);
+
+    // A torn write followed by a good save loads the good save
+    Check(SceneJournal::Append(journalPath, { Upsert(1, "First") }), "Appending the first save");
+    WriteTornSave(journalPath, "{\"upsert\":{\"id\":2,\"na");
+    Check(SceneJournal::Append(journalPath, { Upsert(2, "Second") }), "Appending after a torn save");
+    json sceneData = LoadScene(journalPath);
+    Check(GetName(sceneData, 1) == "First", "The save before the torn one is kept");
+    Check(GetName(sceneData, 2) == "Second", "The save after the torn one is loaded");
+    Check(sceneData["game_objects"].size() == 2, "Nothing from the torn save is loaded");
+
+    // Appending cuts off the torn save, so the journal only holds committed saves
+    std::ifstream journal(journalPath);
+    std::string contents((std::istreambuf_iterator<char>(journal)), std::istreambuf_iterator<char>());
+    journal.close();
+    Check(contents.find("Torn") == std::string::npos, "The torn save is removed from the journal");
+
+    // Journals that were torn without being repaired, like ones written by older versions, resync at the next save
+    std::filesystem::remove(journalPath);
+    {
+        std::ofstream oldJournal(journalPath);
+        oldJournal << Upsert(1, "First").dump() << '\n' << "{\"commit\":1}\n";
+        oldJournal << Upsert(1, "Torn").dump() << '\n' << "{\"upsert\":{\"id\":1,\"na\n";
+        oldJournal << Upsert(1, "Uncommitted").dump() << '\n';
+        oldJournal << Upsert(2, "Second").dump() << '\n' << "{\"commit\":1}\n";
+    }
+    sceneData = LoadScene(journalPath);
+    Check(GetName(sceneData, 1) == "First", "Saves before the torn line are kept when reading an unrepaired journal");
+    Check(GetName(sceneData, 2) == "Second", "Saves after the torn line are loaded when reading an unrepaired journal");
+
+    // A commit record that lost its newline is still committed, and the next save starts on a new line
+    std::filesystem::remove(journalPath);
+    {
+        std::ofstream oldJournal(journalPath);
+        oldJournal << "{\"begin\":1}\n" << Upsert(1, "First").dump() << '\n' << "{\"commit\":1}";
+    }
+    Check(SceneJournal::Append(journalPath, { Upsert(2, "Second") }), "Appending after a commit without a newline");
+    sceneData = LoadScene(journalPath);
+    Check(GetName(sceneData, 1) == "First" && GetName(sceneData, 2) == "Second", "Both saves load when the commit record lost its newline");
+
+    std::filesystem::remove(journalPath);
+
+    if (failures == 0)
+        std::cout << "All scene journal tests passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
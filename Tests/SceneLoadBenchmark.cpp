@@ -0,0 +1,201 @@
+// Compares loading a large scene by streaming its game objects from a memory mapping with JsonStreamReader against the old way of
+// reading the whole file into a string and parsing it into one json tree. Reports the time and the most heap memory held by each.
+// Build and run from the repository root, optionally passing the scene size in megabytes (50 by default):
+//   g++ -std=c++17 -O2 -IEngine -IEngine/Source Tests/SceneLoadBenchmark.cpp Engine/Source/Utilities/JsonStreamReader.cpp Engine/Source/Utilities/MappedFile.cpp -o SceneLoadBenchmark && ./SceneLoadBenchmark
+
+#include "Utilities/JsonStreamReader.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+
+using json = nlohmann::json;
+
+// Every allocation is prefixed with its size so the heap in use can be tracked
+static std::atomic<size_t> heapUsed{ 0 };
+static std::atomic<size_t> heapPeak{ 0 };
+static const size_t headerSize = alignof(std::max_align_t);
+
+void* operator new(size_t size)
+{
+    char* memory = static_cast<char*>(std::malloc(size + headerSize));
+    if (!memory)
+        throw std::bad_alloc();
+    *reinterpret_cast<size_t*>(memory) = size;
+    size_t used = heapUsed += size;
+    size_t peak = heapPeak;
+    while (used > peak && !heapPeak.compare_exchange_weak(peak, used)) {}
+    return memory + headerSize;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (!pointer)
+        return;
+    char* memory = static_cast<char*>(pointer) - headerSize;
+    heapUsed -= *reinterpret_cast<size_t*>(memory);
+    std::free(memory);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+// Game objects laid out the way SceneManager saves them, each with a transform and a few components with exposed variables
+static void WriteScene(const std::filesystem::path& path, size_t targetBytes, int& gameObjectCount)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << "{\"version\":1,\"game_objects\":[";
+    size_t written = 0;
+    gameObjectCount = 0;
+    while (written < targetBytes)
+    {
+        int id = gameObjectCount;
+        json gameObjectData;
+        gameObjectData["name"] = "GameObject " + std::to_string(id);
+        gameObjectData["position"] = { id * 0.5f, (id % 17) * 0.25f, -id * 0.125f };
+        gameObjectData["size"] = { 1.0f, 1.0f + (id % 3), 1.0f };
+        gameObjectData["rotation"] = { 0.0f, 0.3826834f, 0.0f, 0.9238795f };
+        gameObjectData["id"] = id;
+        gameObjectData["active"] = true;
+        gameObjectData["globalActive"] = true;
+        gameObjectData["parent_id"] = id % 10 == 0 ? -1 : id - id % 10;
+
+        json componentsData = json::array();
+        json meshRenderer;
+        meshRenderer["name"] = "MeshRenderer";
+        meshRenderer["active"] = true;
+        meshRenderer["id"] = id * 4;
+        meshRenderer["model_path"] = "Models/Props/Crate" + std::to_string(id % 12) + ".gltf";
+        meshRenderer["exposed_variables"] = { 1, { { { "name", "Tint" }, { "type", "Color" }, { "value", { 255, 255, 255, 255 } } },
+            { { "name", "Cast Shadows" }, { "type", "bool" }, { "value", true } } } };
+        componentsData.push_back(meshRenderer);
+
+        json collider;
+        collider["name"] = "Collider3D";
+        collider["active"] = true;
+        collider["id"] = id * 4 + 1;
+        collider["exposed_variables"] = { 1, { { { "name", "Shape" }, { "type", "string" }, { "value", "Box" } },
+            { { "name", "Size" }, { "type", "Vector3" }, { "value", { 1.0f, 1.0f, 1.0f } } },
+            { { "name", "Is Trigger" }, { "type", "bool" }, { "value", false } } } };
+        componentsData.push_back(collider);
+
+        json script;
+        script["name"] = "ScriptComponent";
+        script["active"] = id % 2 == 0;
+        script["id"] = id * 4 + 2;
+        script["cpp_path"] = "Scripts/Spinner.cpp";
+        script["header_path"] = "Scripts/Spinner.h";
+        script["exposed_variables"] = { 1, { { { "name", "Speed" }, { "type", "float" }, { "value", 45.0f + id % 90 } } } };
+        componentsData.push_back(script);
+        gameObjectData["components"] = componentsData;
+
+        std::string text = gameObjectData.dump(4);
+        if (gameObjectCount > 0)
+            file << ',';
+        file << text;
+        written += text.size() + 1;
+        gameObjectCount++;
+    }
+    file << "]}";
+}
+
+// Roughly what loading a game object reads, so neither path can skip the data
+static size_t ReadGameObject(const json& gameObjectData)
+{
+    size_t checksum = gameObjectData["id"].get<int>() + gameObjectData["name"].get<std::string>().size();
+    for (const json& componentData : gameObjectData["components"])
+        checksum += componentData["id"].get<int>() + componentData["exposed_variables"][1].size();
+    return checksum;
+}
+
+struct Result
+{
+    double milliseconds = 0.0;
+    size_t peakBytes = 0;
+    size_t checksum = 0;
+    int gameObjects = 0;
+};
+
+static Result LoadWholeTree(const std::filesystem::path& path)
+{
+    heapPeak = heapUsed.load();
+    size_t baseline = heapUsed;
+    auto start = std::chrono::steady_clock::now();
+
+    Result result;
+    {
+        std::ifstream file(path);
+        std::stringstream fileStream;
+        fileStream << file.rdbuf();
+        json sceneData = json::parse(fileStream.str());
+        for (const json& gameObjectData : sceneData["game_objects"])
+        {
+            result.checksum += ReadGameObject(gameObjectData);
+            result.gameObjects++;
+        }
+    }
+
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.peakBytes = heapPeak - baseline;
+    return result;
+}
+
+static Result LoadStreamed(const std::filesystem::path& path)
+{
+    heapPeak = heapUsed.load();
+    size_t baseline = heapUsed;
+    auto start = std::chrono::steady_clock::now();
+
+    Result result;
+    {
+        JsonStreamReader sceneReader({ { "game_objects", [&](json& gameObjectData) {
+            result.checksum += ReadGameObject(gameObjectData);
+            result.gameObjects++;
+        } } });
+        if (!sceneReader.ParseFile(path))
+            std::cout << "Streaming the scene failed: " << sceneReader.GetError() << std::endl;
+    }
+
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.peakBytes = heapPeak - baseline;
+    return result;
+}
+
+static void Print(const std::string& name, const Result& result)
+{
+    std::cout << name << ": " << result.milliseconds << " ms, " << result.peakBytes / (1024.0 * 1024.0) << " MB peak heap, " << result.gameObjects << " game objects" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50;
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "SceneLoadBenchmark.scene";
+
+    int gameObjectCount;
+    WriteScene(path, megabytes * 1024 * 1024, gameObjectCount);
+    std::cout << "Scene of " << std::filesystem::file_size(path) / (1024.0 * 1024.0) << " MB with " << gameObjectCount << " game objects" << std::endl;
+
+    // Each path runs twice and the second run is reported, so both read the file from the page cache
+    LoadWholeTree(path);
+    Result whole = LoadWholeTree(path);
+    LoadStreamed(path);
+    Result streamed = LoadStreamed(path);
+    Print("Whole json tree", whole);
+    Print("Streamed", streamed);
+
+    std::filesystem::remove(path);
+
+    if (whole.gameObjects != gameObjectCount || streamed.gameObjects != gameObjectCount || whole.checksum != streamed.checksum)
+    {
+        std::cout << "FAILED: Both paths read the same game objects" << std::endl;
+        return 1;
+    }
+    return 0;
+}
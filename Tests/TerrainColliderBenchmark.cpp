@@ -0,0 +1,264 @@
+// Compares a terrain collider built as one Jolt HeightFieldShape, the way Collider3D builds it, against approximating the terrain with
+// a static box body per patch of cells. Reports the memory Jolt allocates for each, the time of a batch of raycasts, and the time of
+// stepping a pile of spheres resting on the terrain.
+// Needs Jolt v5.2.0, the version Build/3D/CMakeLists.txt fetches. Build and run from the repository root, with JOLT set to its checkout and JOLT_LIB to the folder libJolt.a was built into:
+//   g++ -std=c++17 -O2 -I$JOLT Tests/TerrainColliderBenchmark.cpp -L$JOLT_LIB -lJolt -pthread -o TerrainColliderBenchmark && ./TerrainColliderBenchmark
+
+#include <Jolt/Jolt.h>
+#include <Jolt/RegisterTypes.h>
+#include <Jolt/Core/Factory.h>
+#include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <Jolt/Physics/Collision/Shape/SphereShape.h>
+#include <Jolt/Physics/Collision/Shape/HeightFieldShape.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Jolt's allocations are prefixed with their size so the memory held by each terrain can be measured
+static std::atomic<size_t> joltMemory{ 0 };
+static const size_t allocationHeader = 16;
+
+static void* CountingAllocate(size_t size)
+{
+    char* memory = static_cast<char*>(std::malloc(size + allocationHeader));
+    *reinterpret_cast<size_t*>(memory) = size;
+    joltMemory += size;
+    return memory + allocationHeader;
+}
+
+static void CountingFree(void* block)
+{
+    if (!block)
+        return;
+    char* memory = static_cast<char*>(block) - allocationHeader;
+    joltMemory -= *reinterpret_cast<size_t*>(memory);
+    std::free(memory);
+}
+
+static void* CountingReallocate(void* block, size_t oldSize, size_t newSize)
+{
+    void* newBlock = CountingAllocate(newSize);
+    if (block)
+    {
+        std::memcpy(newBlock, block, std::min(oldSize, newSize));
+        CountingFree(block);
+    }
+    return newBlock;
+}
+
+// The offset back to the start of the malloc'd block is stored right before the aligned pointer, with the size before that
+static void* CountingAlignedAllocate(size_t size, size_t alignment)
+{
+    alignment = std::max<size_t>(alignment, allocationHeader);
+    char* memory = static_cast<char*>(std::malloc(size + alignment + allocationHeader));
+    char* aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(memory) + allocationHeader + alignment - 1) & ~(uintptr_t(alignment) - 1));
+    reinterpret_cast<size_t*>(aligned)[-1] = static_cast<size_t>(aligned - memory);
+    reinterpret_cast<size_t*>(aligned)[-2] = size;
+    joltMemory += size;
+    return aligned;
+}
+
+static void CountingAlignedFree(void* block)
+{
+    if (!block)
+        return;
+    char* aligned = static_cast<char*>(block);
+    joltMemory -= reinterpret_cast<size_t*>(aligned)[-2];
+    std::free(aligned - reinterpret_cast<size_t*>(aligned)[-1]);
+}
+
+static const JPH::ObjectLayer nonMovingLayer = 0;
+static const JPH::ObjectLayer movingLayer = 1;
+
+class BroadPhaseLayers final : public JPH::BroadPhaseLayerInterface
+{
+public:
+    unsigned int GetNumBroadPhaseLayers() const override { return 2; }
+    JPH::BroadPhaseLayer GetBroadPhaseLayer(JPH::ObjectLayer inLayer) const override { return JPH::BroadPhaseLayer(static_cast<JPH::BroadPhaseLayer::Type>(inLayer)); }
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+    const char* GetBroadPhaseLayerName(JPH::BroadPhaseLayer inLayer) const override { return inLayer == JPH::BroadPhaseLayer(0) ? "NON_MOVING" : "MOVING"; }
+#endif
+};
+
+class ObjectVsBroadPhaseFilter final : public JPH::ObjectVsBroadPhaseLayerFilter
+{
+public:
+    bool ShouldCollide(JPH::ObjectLayer inLayer1, JPH::BroadPhaseLayer inLayer2) const override { return inLayer1 == movingLayer || inLayer2 == JPH::BroadPhaseLayer(movingLayer); }
+};
+
+class ObjectPairFilter final : public JPH::ObjectLayerPairFilter
+{
+public:
+    bool ShouldCollide(JPH::ObjectLayer inObject1, JPH::ObjectLayer inObject2) const override { return inObject1 == movingLayer || inObject2 == movingLayer; }
+};
+
+static const int terrainSize = 513;
+static const int patchCells = 16; // Cells per side of each box in the box approximation
+static const JPH::uint blockSize = 4;
+
+static std::vector<float> CreateHeights()
+{
+    std::vector<float> heights(static_cast<size_t>(terrainSize) * terrainSize);
+    for (int z = 0; z < terrainSize; z++)
+        for (int x = 0; x < terrainSize; x++)
+            heights[z * terrainSize + x] = 12.0f * std::sin(x * 0.02f) * std::cos(z * 0.015f) + 2.0f * std::sin((x + z) * 0.1f);
+    return heights;
+}
+
+// Padded to a multiple of the block size with no collision samples, and quantized with headroom for sculpting, like Collider3D::CreateTerrainShape()
+static void AddHeightField(JPH::BodyInterface& bodyInterface, const std::vector<float>& heights)
+{
+    JPH::uint sampleCount = (terrainSize + blockSize - 1) / blockSize * blockSize;
+    JPH::HeightFieldShapeSettings settings;
+    settings.mOffset = JPH::Vec3(-terrainSize * 0.5f, 0.0f, -terrainSize * 0.5f);
+    settings.mScale = JPH::Vec3::sReplicate(1.0f);
+    settings.mSampleCount = sampleCount;
+    settings.mBlockSize = blockSize;
+    settings.mHeightSamples.resize(static_cast<size_t>(sampleCount) * sampleCount, JPH::HeightFieldShapeConstants::cNoCollisionValue);
+    for (int z = 0; z < terrainSize; z++)
+        for (int x = 0; x < terrainSize; x++)
+            settings.mHeightSamples[z * sampleCount + x] = heights[z * terrainSize + x];
+
+    auto [lowest, highest] = std::minmax_element(heights.begin(), heights.end());
+    float headroom = std::max(*highest - *lowest, 1.0f) * 0.5f;
+    settings.mMinHeightValue = *lowest - headroom;
+    settings.mMaxHeightValue = *highest + headroom;
+
+    JPH::BodyCreationSettings bodySettings(settings.Create().Get(), JPH::RVec3::sZero(), JPH::Quat::sIdentity(), JPH::EMotionType::Static, nonMovingLayer);
+    bodyInterface.CreateAndAddBody(bodySettings, JPH::EActivation::DontActivate);
+}
+
+// A static box per patch, from below the terrain up to the patch's average height
+static int AddBoxes(JPH::BodyInterface& bodyInterface, const std::vector<float>& heights)
+{
+    int boxCount = 0;
+    for (int patchZ = 0; patchZ < terrainSize - 1; patchZ += patchCells)
+    {
+        for (int patchX = 0; patchX < terrainSize - 1; patchX += patchCells)
+        {
+            float total = 0.0f;
+            for (int z = patchZ; z <= patchZ + patchCells; z++)
+                for (int x = patchX; x <= patchX + patchCells; x++)
+                    total += heights[z * terrainSize + x];
+            float top = total / ((patchCells + 1) * (patchCells + 1));
+            float bottom = -30.0f;
+
+            JPH::Vec3 halfExtent(patchCells * 0.5f, (top - bottom) * 0.5f, patchCells * 0.5f);
+            JPH::RVec3 center(patchX + patchCells * 0.5f - terrainSize * 0.5f, (top + bottom) * 0.5f, patchZ + patchCells * 0.5f - terrainSize * 0.5f);
+            JPH::BodyCreationSettings bodySettings(new JPH::BoxShape(halfExtent), center, JPH::Quat::sIdentity(), JPH::EMotionType::Static, nonMovingLayer);
+            bodyInterface.CreateAndAddBody(bodySettings, JPH::EActivation::DontActivate);
+            boxCount++;
+        }
+    }
+    return boxCount;
+}
+
+struct Result
+{
+    size_t memory = 0;
+    double raycastMilliseconds = 0.0;
+    int raycastHits = 0;
+    double stepMilliseconds = 0.0;
+};
+
+static Result Run(bool useHeightField, const std::vector<float>& heights, JPH::TempAllocator& tempAllocator, JPH::JobSystem& jobSystem)
+{
+    BroadPhaseLayers broadPhaseLayers;
+    ObjectVsBroadPhaseFilter objectVsBroadPhaseFilter;
+    ObjectPairFilter objectPairFilter;
+    JPH::PhysicsSystem physicsSystem;
+    physicsSystem.Init(4096, 0, 8192, 8192, broadPhaseLayers, objectVsBroadPhaseFilter, objectPairFilter);
+    JPH::BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
+
+    Result result;
+    size_t memoryBefore = joltMemory;
+    if (useHeightField)
+        AddHeightField(bodyInterface, heights);
+    else
+        AddBoxes(bodyInterface, heights);
+    physicsSystem.OptimizeBroadPhase();
+    result.memory = joltMemory - memoryBefore;
+
+    // Ground checks straight down and longer sloped rays, like line of sight checks across the terrain
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> position(-terrainSize * 0.45f, terrainSize * 0.45f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<JPH::RRayCast> rays;
+    for (int i = 0; i < 100000; i++)
+    {
+        JPH::RVec3 origin(position(random), 30.0f, position(random));
+        JPH::Vec3 direction = i % 2 == 0 ? JPH::Vec3(0.0f, -60.0f, 0.0f) : JPH::Vec3(unit(random) * 100.0f, -40.0f, unit(random) * 100.0f);
+        rays.push_back({ origin, direction });
+    }
+
+    const JPH::NarrowPhaseQuery& query = physicsSystem.GetNarrowPhaseQueryNoLock();
+    auto start = std::chrono::steady_clock::now();
+    for (const JPH::RRayCast& ray : rays)
+    {
+        JPH::RayCastResult hit;
+        result.raycastHits += query.CastRay(ray, hit) ? 1 : 0;
+    }
+    result.raycastMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // Spheres dropped across the terrain, so most of the step is spent on contacts against it
+    JPH::RefConst<JPH::Shape> sphere = new JPH::SphereShape(0.5f);
+    for (int i = 0; i < 1000; i++)
+    {
+        JPH::BodyCreationSettings settings(sphere, JPH::RVec3(position(random), 20.0f, position(random)), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, movingLayer);
+        bodyInterface.CreateAndAddBody(settings, JPH::EActivation::Activate);
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 300; i++)
+        physicsSystem.Update(1.0f / 60.0f, 1, &tempAllocator, &jobSystem);
+    result.stepMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+static void Print(const std::string& name, const Result& result)
+{
+    std::cout << name << ": " << result.memory / 1024.0 << " KB, 100000 raycasts in " << result.raycastMilliseconds << " ms (" << result.raycastHits << " hits), "
+        << "300 steps in " << result.stepMilliseconds << " ms" << std::endl;
+}
+
+int main()
+{
+    JPH::Allocate = CountingAllocate;
+    JPH::Reallocate = CountingReallocate;
+    JPH::Free = CountingFree;
+    JPH::AlignedAllocate = CountingAlignedAllocate;
+    JPH::AlignedFree = CountingAlignedFree;
+    JPH::Factory::sInstance = new JPH::Factory();
+    JPH::RegisterTypes();
+
+    {
+        JPH::TempAllocatorImpl tempAllocator(32 * 1024 * 1024);
+        JPH::JobSystemThreadPool jobSystem(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+        std::vector<float> heights = CreateHeights();
+
+        int patches = (terrainSize - 1) / patchCells;
+        std::cout << "Terrain of " << terrainSize << "x" << terrainSize << " samples, approximated with " << patches * patches << " boxes" << std::endl;
+        Print("Height field", Run(true, heights, tempAllocator, jobSystem));
+        Print("Boxes", Run(false, heights, tempAllocator, jobSystem));
+    }
+
+    JPH::UnregisterTypes();
+    delete JPH::Factory::sInstance;
+    JPH::Factory::sInstance = nullptr;
+    return 0;
+}
@@ -0,0 +1,217 @@
+// Checks TerrainLOD's selected chunks cover the whole terrain exactly once, with neighbors at most a level apart, and that the stitched chunk meshes
+// have no T-junctions along the borders between levels. Also checks UpdateRegion() keeps the bounds exact and the errors at least as large as a rebuild.
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -IEngine/Source Tests/TerrainLODTests.cpp Engine/Source/Systems/Rendering/TerrainLOD.cpp -o TerrainLODTests && ./TerrainLODTests
+
+#include "Systems/Rendering/TerrainLOD.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+static int failures = 0;
+
+static void Check(bool condition, const std::string& description)
+{
+    if (!condition)
+    {
+        std::cout << "FAILED: " << description << std::endl;
+        failures++;
+    }
+}
+
+static std::vector<float> CreateHeights(int width, int depth)
+{
+    std::vector<float> heights(static_cast<size_t>(width) * depth);
+    for (int z = 0; z < depth; z++)
+        for (int x = 0; x < width; x++)
+            heights[z * width + x] = 20.0f * std::sin(x * 0.05f) * std::cos(z * 0.04f) + 3.0f * std::sin(x * 0.7f + z * 0.3f);
+    return heights;
+}
+
+struct ChunkExtent
+{
+    int minX;
+    int minZ;
+    int maxX;
+    int maxZ;
+    int level;
+};
+
+static ChunkExtent GetExtent(const TerrainLOD& lod, int node, int width, int depth)
+{
+    const TerrainLODNode& lodNode = lod.GetNode(node);
+    int size = lod.GetChunkCells() << lodNode.level;
+    return { lodNode.x, lodNode.z, std::min(lodNode.x + size, width - 1), std::min(lodNode.z + size, depth - 1), lodNode.level };
+}
+
+// Every full resolution cell is covered by exactly one chunk
+static bool CoversOnce(const TerrainLOD& lod, const std::vector<TerrainLODSelection>& selection, int width, int depth)
+{
+    std::vector<int> coverage(static_cast<size_t>(width - 1) * (depth - 1), 0);
+    for (const TerrainLODSelection& selected : selection)
+    {
+        ChunkExtent extent = GetExtent(lod, selected.node, width, depth);
+        for (int z = extent.minZ; z < extent.maxZ; z++)
+            for (int x = extent.minX; x < extent.maxX; x++)
+                coverage[z * (width - 1) + x]++;
+    }
+    return std::all_of(coverage.begin(), coverage.end(), [](int count) { return count == 1; });
+}
+
+// Chunks sharing part of an edge are at most a level apart
+static bool NeighborsWithinOneLevel(const TerrainLOD& lod, const std::vector<TerrainLODSelection>& selection, int width, int depth)
+{
+    std::vector<ChunkExtent> extents;
+    for (const TerrainLODSelection& selected : selection)
+        extents.push_back(GetExtent(lod, selected.node, width, depth));
+
+    for (const ChunkExtent& a : extents)
+    {
+        for (const ChunkExtent& b : extents)
+        {
+            bool sharesX = (a.maxX == b.minX || b.maxX == a.minX) && std::min(a.maxZ, b.maxZ) > std::max(a.minZ, b.minZ);
+            bool sharesZ = (a.maxZ == b.minZ || b.maxZ == a.minZ) && std::min(a.maxX, b.maxX) > std::max(a.minX, b.minX);
+            if ((sharesX || sharesZ) && std::abs(a.level - b.level) > 1)
+                return false;
+        }
+    }
+    return true;
+}
+
+// Builds every selected chunk's triangles and checks no vertex lies inside a triangle edge running along a chunk's border,
+// which is where a finer chunk's extra vertex would leave a crack next to a coarser chunk
+static int CountTJunctions(const TerrainLOD& lod, const std::vector<TerrainLODSelection>& selection, const std::vector<float>& heights, int width, int depth)
+{
+    std::set<std::pair<int, int>> vertices;
+    struct Segment
+    {
+        int fixed; // The x or z the segment runs along
+        bool alongZ;
+        int from;
+        int to;
+    };
+    std::vector<Segment> segments;
+
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> texcoords;
+    std::vector<unsigned short> indices;
+    for (const TerrainLODSelection& selected : selection)
+    {
+        ChunkExtent extent = GetExtent(lod, selected.node, width, depth);
+        lod.BuildVertices(selected.node, heights.data(), positions, normals, texcoords);
+        TerrainLOD::BuildIndices(lod.GetChunkCells(), selected.stitchEdges, indices);
+
+        for (size_t triangle = 0; triangle < indices.size(); triangle += 3)
+        {
+            for (int corner = 0; corner < 3; corner++)
+            {
+                int a = indices[triangle + corner];
+                int b = indices[triangle + (corner + 1) % 3];
+                int ax = static_cast<int>(positions[a * 3]);
+                int az = static_cast<int>(positions[a * 3 + 2]);
+                int bx = static_cast<int>(positions[b * 3]);
+                int bz = static_cast<int>(positions[b * 3 + 2]);
+                vertices.insert({ ax, az });
+
+                // Edges along the terrain's outside have no neighbor to crack against
+                if (ax == bx && az != bz && (ax == extent.minX || ax == extent.maxX) && ax != 0 && ax != width - 1)
+                    segments.push_back({ ax, true, std::min(az, bz), std::max(az, bz) });
+                if (az == bz && ax != bx && (az == extent.minZ || az == extent.maxZ) && az != 0 && az != depth - 1)
+                    segments.push_back({ az, false, std::min(ax, bx), std::max(ax, bx) });
+            }
+        }
+    }
+
+    int tJunctions = 0;
+    for (const Segment& segment : segments)
+        for (int i = segment.from + 1; i < segment.to; i++)
+            if (vertices.count(segment.alongZ ? std::make_pair(segment.fixed, i) : std::make_pair(i, segment.fixed)))
+                tJunctions++;
+    return tJunctions;
+}
+
+// Checks a selection and returns how many levels it used
+static int CheckSelection(const TerrainLOD& lod, const std::vector<float>& heights, int width, int depth, const float viewPosition[3], float maxScreenError, float fullDetailDistance, const std::string& name)
+{
+    std::vector<TerrainLODSelection> selection;
+    lod.Select(viewPosition, 20.0f, maxScreenError, fullDetailDistance, selection);
+
+    Check(CoversOnce(lod, selection, width, depth), name + ": the chunks cover every cell once");
+    Check(NeighborsWithinOneLevel(lod, selection, width, depth), name + ": neighboring chunks are at most a level apart");
+    Check(CountTJunctions(lod, selection, heights, width, depth) == 0, name + ": there are no T-junctions between chunks");
+
+    std::set<int> levels;
+    for (const TerrainLODSelection& selected : selection)
+        levels.insert(lod.GetNode(selected.node).level);
+    return static_cast<int>(levels.size());
+}
+
+int main()
+{
+    // Sizes that don't fill the top level's chunks, so chunks along the far edges are cut off
+    const int width = 301;
+    const int depth = 205;
+    std::vector<float> heights = CreateHeights(width, depth);
+
+    TerrainLOD lod;
+    lod.Build(heights.data(), width, depth, 16, 5);
+    Check(lod.GetNodeCount() > 0 && lod.GetLevels() == 5, "Building the quadtree");
+
+    float corner[3] = { 0.0f, 30.0f, 0.0f };
+    float middle[3] = { width / 2.0f, 25.0f, depth / 2.0f };
+    float edge[3] = { width - 1.0f, 10.0f, depth / 3.0f };
+    float above[3] = { width / 2.0f, 2000.0f, depth / 2.0f };
+
+    Check(CheckSelection(lod, heights, width, depth, corner, 2.0f, 20.0f, "Viewed from a corner") >= 3, "Viewed from a corner: several levels are used");
+    Check(CheckSelection(lod, heights, width, depth, middle, 2.0f, 20.0f, "Viewed from the middle") >= 3, "Viewed from the middle: several levels are used");
+    CheckSelection(lod, heights, width, depth, edge, 0.5f, 5.0f, "Viewed from an edge with a strict error");
+    CheckSelection(lod, heights, width, depth, above, 4.0f, 0.0f, "Viewed from far above");
+    CheckSelection(lod, heights, width, depth, middle, 1000000.0f, 0.0f, "With no detail needed");
+    Check(CheckSelection(lod, heights, width, depth, middle, 0.0f, 0.0f, "With full detail everywhere") == 1, "With full detail everywhere: only full resolution chunks are used");
+
+    // Stitching every combination of edges keeps each chunk's own triangles covering its square once
+    for (int stitchEdges = 0; stitchEdges < 16; stitchEdges++)
+    {
+        std::vector<unsigned short> indices;
+        TerrainLOD::BuildIndices(8, stitchEdges, indices);
+        double area = 0.0;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            int a[2] = { indices[i] % 9, indices[i] / 9 };
+            int b[2] = { indices[i + 1] % 9, indices[i + 1] / 9 };
+            int c[2] = { indices[i + 2] % 9, indices[i + 2] / 9 };
+            area += std::abs((b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1])) / 2.0;
+        }
+        Check(area == 64.0, "Stitching edges " + std::to_string(stitchEdges) + " keeps the chunk's area");
+    }
+
+    // Sculpting keeps the bounds exact and never leaves an error lower than rebuilding would
+    for (int z = 40; z <= 90; z++)
+        for (int x = 100; x <= 170; x++)
+            heights[z * width + x] += 40.0f * std::sin((x - 100) * 0.3f) * std::sin((z - 40) * 0.2f);
+    lod.UpdateRegion(heights.data(), 100, 40, 170, 90);
+
+    TerrainLOD rebuilt;
+    rebuilt.Build(heights.data(), width, depth, 16, 5);
+    bool boundsMatch = rebuilt.GetNodeCount() == lod.GetNodeCount();
+    bool errorsCovered = boundsMatch;
+    for (int node = 0; boundsMatch && node < lod.GetNodeCount(); node++)
+    {
+        const TerrainLODNode& updated = lod.GetNode(node);
+        const TerrainLODNode& fresh = rebuilt.GetNode(node);
+        boundsMatch = updated.minHeight == fresh.minHeight && updated.maxHeight == fresh.maxHeight;
+        errorsCovered = errorsCovered && updated.error >= fresh.error - 0.0001f;
+    }
+    Check(boundsMatch, "Updating a region keeps every node's bounds the same as a rebuild");
+    Check(errorsCovered, "Updating a region never leaves an error lower than a rebuild");
+    CheckSelection(lod, heights, width, depth, middle, 2.0f, 20.0f, "After sculpting");
+
+    if (failures == 0)
+        std::cout << "All terrain LOD tests passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+// Checks the packed splatmap matches converting every texel from the float layer weights, the way the terrain did before it kept a packed image,
+// including after painting only updates the brush's rectangle.
+// Build and run from the repository root:
+//   g++ -std=c++17 -IEngine/Source Tests/TerrainSplatmapTests.cpp Engine/Source/Systems/Rendering/TerrainSplatmap.cpp -o TerrainSplatmapTests && ./TerrainSplatmapTests
+
+#include "Systems/Rendering/TerrainSplatmap.h"
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void Check(bool condition, const std::string& description)
+{
+    if (!condition)
+    {
+        std::cout << "FAILED: " << description << std::endl;
+        failures++;
+    }
+}
+
+// The float path: every texel converted from the weights, red full and the rest empty for channels without a layer
+static std::vector<unsigned char> ConvertAll(const std::vector<std::vector<float>>& layers, int width, int depth)
+{
+    int layerCount = std::min(static_cast<int>(layers.size()), TerrainSplatmap::maxLayers);
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * depth * 4);
+    for (int index = 0; index < width * depth; index++)
+    {
+        for (int channel = 0; channel < 4; channel++)
+        {
+            if (channel < layerCount)
+                pixels[index * 4 + channel] = static_cast<unsigned char>(layers[channel][index] * 255);
+            else
+                pixels[index * 4 + channel] = channel == 0 ? 255 : 0;
+        }
+    }
+    return pixels;
+}
+
+// Random weights that sum to 1 at every sample, like Terrain::NormalizeSplatmaps() leaves them
+static std::vector<std::vector<float>> CreateLayers(int layerCount, int width, int depth, std::mt19937& random)
+{
+    std::uniform_real_distribution<float> weight(0.0f, 1.0f);
+    std::vector<std::vector<float>> layers(layerCount, std::vector<float>(static_cast<size_t>(width) * depth));
+    for (int index = 0; index < width * depth; index++)
+    {
+        float total = 0.0f;
+        for (std::vector<float>& layer : layers)
+            total += layer[index] = weight(random);
+        for (std::vector<float>& layer : layers)
+            layer[index] /= total;
+    }
+    return layers;
+}
+
+static void Pack(const std::vector<std::vector<float>>& layers, int width, int minX, int minZ, int maxX, int maxZ, std::vector<unsigned char>& pixels)
+{
+    const float* layerWeights[TerrainSplatmap::maxLayers] = {};
+    int layerCount = std::min(static_cast<int>(layers.size()), TerrainSplatmap::maxLayers);
+    for (int i = 0; i < layerCount; i++)
+        layerWeights[i] = layers[i].data();
+    TerrainSplatmap::Pack(layerWeights, layerCount, width, minX, minZ, maxX, maxZ, pixels.data());
+}
+
+// Paints a layer in a square the way a brush does, then renormalizes the samples under it
+static void Paint(std::vector<std::vector<float>>& layers, int width, int minX, int minZ, int maxX, int maxZ, int paintedLayer)
+{
+    for (int z = minZ; z <= maxZ; z++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            int index = z * width + x;
+            layers[paintedLayer][index] += 0.5f;
+            float total = 0.0f;
+            for (std::vector<float>& layer : layers)
+                total += layer[index];
+            for (std::vector<float>& layer : layers)
+                layer[index] /= total;
+        }
+    }
+}
+
+int main()
+{
+    std::mt19937 random(42);
+    const int width = 67;
+    const int depth = 45;
+
+    // Packing everything matches the float path for every layer count, including ones past the 4 the image holds
+    for (int layerCount = 0; layerCount <= 6; layerCount++)
+    {
+        std::vector<std::vector<float>> layers = CreateLayers(layerCount, width, depth, random);
+        std::vector<unsigned char> pixels(static_cast<size_t>(width) * depth * 4, 7);
+        Pack(layers, width, 0, 0, width - 1, depth - 1, pixels);
+        Check(pixels == ConvertAll(layers, width, depth), "Packing the whole splatmap with " + std::to_string(layerCount) + " layers matches the float path");
+    }
+
+    // Painting and only repacking the brush's rectangle ends with the same image as converting everything again
+    std::vector<std::vector<float>> layers = CreateLayers(3, width, depth, random);
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * depth * 4);
+    Pack(layers, width, 0, 0, width - 1, depth - 1, pixels);
+    std::uniform_int_distribution<int> positionX(0, width - 1);
+    std::uniform_int_distribution<int> positionZ(0, depth - 1);
+    for (int stroke = 0; stroke < 50; stroke++)
+    {
+        int minX = positionX(random);
+        int minZ = positionZ(random);
+        int maxX = std::min(width - 1, minX + stroke % 9);
+        int maxZ = std::min(depth - 1, minZ + stroke % 6);
+        Paint(layers, width, minX, minZ, maxX, maxZ, stroke % 3);
+        Pack(layers, width, minX, minZ, maxX, maxZ, pixels);
+    }
+    Check(pixels == ConvertAll(layers, width, depth), "Packing only painted rectangles matches converting the whole splatmap");
+
+    // Packing a rectangle leaves the texels outside of it alone
+    std::vector<unsigned char> untouched(static_cast<size_t>(width) * depth * 4, 9);
+    Pack(layers, width, 10, 5, 20, 8, untouched);
+    bool outsideUntouched = true;
+    for (int z = 0; z < depth; z++)
+        for (int x = 0; x < width; x++)
+            if ((x < 10 || x > 20 || z < 5 || z > 8) && untouched[(z * width + x) * 4] != 9)
+                outsideUntouched = false;
+    Check(outsideUntouched, "Texels outside the packed rectangle aren't changed");
+
+    // Weights outside 0 to 1 are clamped instead of wrapping around
+    std::vector<std::vector<float>> outOfRange = { std::vector<float>(4, 1.5f), std::vector<float>(4, -0.5f) };
+    std::vector<unsigned char> clamped(16);
+    Pack(outOfRange, 2, 0, 0, 1, 1, clamped);
+    Check(clamped[0] == 255 && clamped[1] == 0, "Weights outside 0 to 1 are clamped");
+
+    // The copied rectangle holds the rows of the rectangle back to back
+    std::vector<unsigned char> rect;
+    TerrainSplatmap::CopyRect(pixels.data(), width, 30, 12, 34, 15, rect);
+    bool rectMatches = rect.size() == 5 * 4 * 4;
+    for (int z = 12; z <= 15 && rectMatches; z++)
+        rectMatches = std::equal(rect.begin() + (z - 12) * 5 * 4, rect.begin() + (z - 11) * 5 * 4, pixels.begin() + (z * width + 30) * 4);
+    Check(rectMatches, "Copying a rectangle out of the packed image");
+
+    if (failures == 0)
+        std::cout << "All terrain splatmap tests passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}